@@ -1,5 +1,7 @@
 #include "arch/io/disk/stats.hpp"
 
+#include "perfmon/load_signals.hpp"
+
 stats_diskmgr_t::stats_diskmgr_t(perfmon_collection_t *stats, const std::string &name) :
     read_sampler(secs_to_ticks(1)),
     write_sampler(secs_to_ticks(1)),
@@ -14,6 +16,7 @@ void stats_diskmgr_t::submit(action_t *a) {
     } else {
         write_sampler.begin(&a->start_time);
     }
+    get_disk_ops_in_flight()->add(1);
     submit_fun(a);
 }
 
@@ -24,5 +27,6 @@ void stats_diskmgr_t::done(conflict_resolving_diskmgr_action_t *p) {
     } else {
         write_sampler.end(&a->start_time);
     }
+    get_disk_ops_in_flight()->add(-1);
     done_fun(a);
 }
@@ -13,11 +13,13 @@
 #include <iphlpapi.h> // NOLINT
 #else
 #include <arpa/inet.h>
+#include <limits.h>
 #include <net/if.h>
 #include <netdb.h>
 #include <netinet/tcp.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #endif
 
 #include "arch/runtime/runtime.hpp"
@@ -27,6 +29,7 @@
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/exponential_backoff.hpp"
 #include "concurrency/wait_any.hpp"
+#include "containers/buffer_group.hpp"
 #include "containers/printf_buffer.hpp"
 #include "logger.hpp"
 #include "perfmon/perfmon.hpp"
@@ -521,7 +524,9 @@ linux_tcp_conn_t::write_handler_t::write_handler_t(linux_tcp_conn_t *_parent) :
 { }
 
 void linux_tcp_conn_t::write_handler_t::coro_pool_callback(write_queue_op_t *operation, UNUSED signal_t *interruptor) {
-    if (operation->buffer != nullptr) {
+    if (operation->buffers != nullptr) {
+        parent->perform_write_buffers(operation->buffers);
+    } else if (operation->buffer != nullptr) {
         parent->perform_write(operation->buffer, operation->size);
         if (operation->dealloc != nullptr) {
             parent->release_write_buffer(operation->dealloc);
@@ -546,6 +551,7 @@ void linux_tcp_conn_t::internal_flush_write_buffer() {
        released once the write is over. */
     op->buffer = current_write_buffer->buffer;
     op->size = current_write_buffer->size;
+    op->buffers = nullptr;
     op->dealloc = current_write_buffer.release();
     op->cond = nullptr;
     op->keepalive = auto_drainer_t::lock_t(drainer.get());
@@ -648,6 +654,89 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
 #endif
 }
 
+void linux_tcp_conn_t::perform_write_buffers(const const_buffer_group_t *buffers) {
+    assert_thread();
+
+#ifdef _WIN32
+    for (size_t i = 0; i < buffers->num_buffers(); ++i) {
+        const_buffer_group_t::buffer_t b = buffers->get_buffer(i);
+        perform_write(b.data, b.size);
+    }
+#else
+    if (write_closed.is_pulsed()) {
+        return;
+    }
+
+    /* `iov` holds the part of `buffers` that hasn't been written yet, at most
+    `IOV_MAX` entries at a time. */
+    std::vector<struct iovec> iov;
+    size_t next_buffer = 0;
+    size_t first_iov = 0;
+    for (;;) {
+        if (first_iov == iov.size()) {
+            iov.clear();
+            first_iov = 0;
+            while (next_buffer < buffers->num_buffers() && iov.size() < static_cast<size_t>(IOV_MAX)) {
+                const_buffer_group_t::buffer_t b = buffers->get_buffer(next_buffer);
+                ++next_buffer;
+                if (b.size > 0) {
+                    struct iovec v;
+                    v.iov_base = const_cast<void *>(b.data);
+                    v.iov_len = b.size;
+                    iov.push_back(v);
+                }
+            }
+            if (iov.empty()) {
+                break;
+            }
+        }
+
+        ssize_t res = ::writev(sock.get(), iov.data() + first_iov,
+                               iov.size() - first_iov);
+
+        if (res == -1 && (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK)) {
+            linux_event_watcher_t::watch_t watch(event_watcher.get(), poll_event_out);
+            wait_any_t waiter(&watch, &write_closed);
+            waiter.wait_lazily_unordered();
+
+            if (write_closed.is_pulsed()) {
+                break;
+            }
+        } else if (res == -1 && (get_errno() == EPIPE || get_errno() == ENOTCONN || get_errno() == EHOSTUNREACH ||
+                                 get_errno() == ENETDOWN || get_errno() == EHOSTDOWN || get_errno() == ECONNRESET)) {
+            on_shutdown_write();
+            break;
+        } else if (res == -1) {
+            logERR("Could not write to socket: %s", errno_string(get_errno()).c_str());
+            on_shutdown_write();
+            break;
+        } else if (res == 0) {
+            logERR("Didn't expect writev() to return 0.");
+            on_shutdown_write();
+            break;
+        } else {
+            if (write_perfmon) {
+                write_perfmon->record(res);
+            }
+            /* Skip over whatever was written, which might end in the middle of a
+            buffer. */
+            size_t written = res;
+            while (written > 0) {
+                struct iovec *v = &iov[first_iov];
+                if (written >= v->iov_len) {
+                    written -= v->iov_len;
+                    ++first_iov;
+                } else {
+                    v->iov_base = static_cast<char *>(v->iov_base) + written;
+                    v->iov_len -= written;
+                    written = 0;
+                }
+            }
+        }
+    }
+#endif
+}
+
 void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
     write_op_wrapper_t sentry(this, closer);
 
@@ -665,6 +754,7 @@ void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THR
     /* Enqueue the write so it will happen eventually */
     op.buffer = buf;
     op.size = size;
+    op.buffers = nullptr;
     op.dealloc = nullptr;
     op.cond = &to_signal_when_done;
     write_queue.push(&op);
@@ -679,6 +769,31 @@ void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THR
     }
 }
 
+void linux_tcp_conn_t::write(const const_buffer_group_t *buffers, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
+    write_op_wrapper_t sentry(this, closer);
+
+    write_queue_op_t op;
+    cond_t to_signal_when_done;
+
+    /* Flush out any data that's been buffered, so that things don't get out of order */
+    if (current_write_buffer->size > 0) {
+        internal_flush_write_buffer();
+    }
+
+    op.buffer = nullptr;
+    op.size = 0;
+    op.buffers = buffers;
+    op.dealloc = nullptr;
+    op.cond = &to_signal_when_done;
+    write_queue.push(&op);
+
+    to_signal_when_done.wait();
+
+    if (write_closed.is_pulsed()) {
+        throw tcp_conn_write_closed_exc_t();
+    }
+}
+
 void linux_tcp_conn_t::write_buffered(const void *vbuf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
     write_op_wrapper_t sentry(this, closer);
 
@@ -737,6 +852,7 @@ void linux_tcp_conn_t::flush_buffer(signal_t *closer) THROWS_ONLY(tcp_conn_write
     write_queue_op_t op;
     cond_t to_signal_when_done;
     op.buffer = nullptr;
+    op.buffers = nullptr;
     op.dealloc = nullptr;
     op.cond = &to_signal_when_done;
     write_queue.push(&op);
@@ -1044,6 +1160,14 @@ size_t linux_secure_tcp_conn_t::read_internal(void *buffer, size_t size)
     }
 }
 
+void linux_secure_tcp_conn_t::perform_write_buffers(
+        const const_buffer_group_t *buffers) {
+    for (size_t i = 0; i < buffers->num_buffers(); ++i) {
+        const_buffer_group_t::buffer_t b = buffers->get_buffer(i);
+        perform_write(b.data, b.size);
+    }
+}
+
 void linux_secure_tcp_conn_t::perform_write(const void *buffer, size_t size) {
     assert_thread();
 
@@ -45,6 +45,8 @@
 #include "crypto/error.hpp"
 #include "perfmon/types.hpp"
 
+class const_buffer_group_t;
+
 /* linux_tcp_conn_t provides a disgusting wrapper around a TCP network connection. */
 
 class linux_tcp_conn_t :
@@ -136,6 +138,12 @@ public:
     void write(const void *buf, size_t size, signal_t *closer)
         THROWS_ONLY(tcp_conn_write_closed_exc_t);
 
+    /* Like write(), but writes the concatenation of the buffers in `buffers`, using
+    as few system calls as possible. The buffers are not copied, so they must stay
+    valid until write() returns. */
+    void write(const const_buffer_group_t *buffers, signal_t *closer)
+        THROWS_ONLY(tcp_conn_write_closed_exc_t);
+
     /* write_buffered() is like write(), but it might not send the data until
     flush_buffer*() or write() is called. Internally, it bundles together the
     buffered writes; this may improve performance. */
@@ -279,6 +287,9 @@ private:
         write_buffer_t *dealloc;
         const void *buffer;
         size_t size;
+        /* If non-null, `buffer` and `size` are ignored and these buffers are written
+        instead. */
+        const const_buffer_group_t *buffers;
         cond_t *cond;
         auto_drainer_t::lock_t keepalive;
     };
@@ -345,6 +356,9 @@ private:
     /* Used to actually perform a write. If the write end of the connection is open, then
     writes `size` bytes from `buffer` to the socket. */
     virtual void perform_write(const void *buffer, size_t size);
+
+    /* Like `perform_write()`, but writes all of `buffers`. */
+    virtual void perform_write_buffers(const const_buffer_group_t *buffers);
 };
 
 #ifdef ENABLE_TLS
@@ -409,6 +423,10 @@ private:
     writes `size` bytes from `buffer` to the socket. */
     virtual void perform_write(const void *buffer, size_t size);
 
+    /* TLS records are built per `SSL_write()`, so this just writes the buffers one
+    at a time. */
+    virtual void perform_write_buffers(const const_buffer_group_t *buffers);
+
     void shutdown();
     void shutdown_socket();
 
@@ -83,7 +83,8 @@ void coro_profiler_t::record_sample(size_t levels_to_strip_from_backtrace) {
         ticks_t ticks_since_resume = ticks_on_entry - coro_mixin.last_resumed_at;
         execution_point_samples.samples.push_back(coro_sample_t(ticks_since_resume,
                                                                 ticks_since_previous,
-                                                                coro_t::self()->get_priority()));
+                                                                coro_t::self()->get_priority(),
+                                                                coroutine_stack_space_used()));
         coro_mixin.last_sample_at = ticks_on_entry;
     }
 
@@ -268,12 +269,15 @@ void coro_profiler_t::per_execution_point_collected_report_t::compute_stats() {
                                 &time_since_resume);
         accumulate_sample_pass1(static_cast<double>(sample->priority),
                                 &priority);
+        accumulate_sample_pass1(static_cast<double>(sample->stack_used),
+                                &stack_used);
 
         ++num_samples;
     }
     divide_mean(&time_since_previous);
     divide_mean(&time_since_resume);
     divide_mean(&priority);
+    divide_mean(&stack_used);
 
     // Pass 2: Compute standard deviation
     for (auto sample = collected_samples.begin(); sample != collected_samples.end(); ++sample) {
@@ -283,10 +287,13 @@ void coro_profiler_t::per_execution_point_collected_report_t::compute_stats() {
                                 &time_since_resume);
         accumulate_sample_pass2(static_cast<double>(sample->priority),
                                 &priority);
+        accumulate_sample_pass2(static_cast<double>(sample->stack_used),
+                                &stack_used);
     }
     divide_stddev(&time_since_previous);
     divide_stddev(&time_since_resume);
     divide_stddev(&priority);
+    divide_stddev(&stack_used);
 }
 
 void coro_profiler_t::print_to_reql(
@@ -316,8 +323,11 @@ void coro_profiler_t::print_to_reql(
                 "\t\t'since_resume': %s,\n",
                 distribution_to_object_str(report->second.time_since_resume).c_str());
         fprintf(reql_output_file,
-                "\t\t'priority': %s\n",
+                "\t\t'priority': %s,\n",
                 distribution_to_object_str(report->second.priority).c_str());
+        fprintf(reql_output_file,
+                "\t\t'stack_used': %s\n",
+                distribution_to_object_str(report->second.stack_used).c_str());
         fprintf(reql_output_file,
                 "\t}).run(conn, durability='soft')\n");
     }
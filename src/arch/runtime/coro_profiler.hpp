@@ -55,6 +55,10 @@
  *      - How much time has passed on a coroutine since the previous recording
  *        point
  *      - The priority of the coroutine
+ *      - How many bytes of the coroutine's stack are in use. The maximum over all
+ *        execution points of a coro_type is a lower bound for how much stack
+ *        that spawn site needs, which tells whether it could use a
+ *        `coro_stack_class_t::SMALL` stack.
  *
  * A combination of coro_type (signature of the function that spawned the coroutine)
  * and a limited-depth backtrace (see `CORO_PROFILER_BACKTRACE_DEPTH`) is used to
@@ -87,13 +91,16 @@ private:
     // a small_trace_t of its current execution point.
     typedef std::pair<std::string, small_trace_t> coro_execution_point_key_t;
     struct coro_sample_t {
-        coro_sample_t(ticks_t _ticks_since_resume, ticks_t _ticks_since_previous, int _priority) :
+        coro_sample_t(ticks_t _ticks_since_resume, ticks_t _ticks_since_previous, int _priority,
+                      size_t _stack_used) :
             ticks_since_resume(_ticks_since_resume),
             ticks_since_previous(_ticks_since_previous),
-            priority(_priority) { }
+            priority(_priority),
+            stack_used(_stack_used) { }
         ticks_t ticks_since_resume;
         ticks_t ticks_since_previous;
         int priority;
+        size_t stack_used;
     };
     struct per_execution_point_samples_t {
         per_execution_point_samples_t() : num_samples_total(0) { }
@@ -126,6 +133,7 @@ private:
         data_distribution_t time_since_previous;
         data_distribution_t time_since_resume;
         data_distribution_t priority;
+        data_distribution_t stack_used;
 
     private:
         // Helper functions for compute_stats
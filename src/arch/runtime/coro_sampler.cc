@@ -0,0 +1,238 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/runtime/coro_sampler.hpp"
+
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "backtrace.hpp"
+#include "concurrency/cache_line_padded.hpp"
+#include "config/args.hpp"
+#include "perfmon/perfmon.hpp"
+#include "rethinkdb_backtrace.hpp"
+#include "time.hpp"
+#include "utils.hpp"
+
+struct coro_sampler_spawn_site_t {
+    coro_sampler_spawn_site_t()
+        : num_samples(0), total_run_ticks(0), max_run_ticks(0), total_priority(0) { }
+    uint64_t num_samples;
+    ticks_t total_run_ticks;
+    ticks_t max_run_ticks;
+    int64_t total_priority;
+};
+
+struct coro_sampler_long_run_t {
+    const char *spawn_site;
+    ticks_t finished_at;
+    ticks_t run_ticks;
+    int priority;
+    std::vector<void *> backtrace;
+};
+
+/* The sampler state of one thread.  It's only ever accessed on its own thread. */
+struct coro_sampler_thread_t {
+    coro_sampler_thread_t()
+        : runs_until_sample(CORO_SAMPLER_INTERVAL),
+          sampled_coro(nullptr),
+          sample_started_at(0) { }
+
+    int runs_until_sample;
+    coro_t *sampled_coro;
+    ticks_t sample_started_at;
+
+    std::map<const char *, coro_sampler_spawn_site_t> spawn_sites;
+    std::deque<coro_sampler_long_run_t> long_runs;
+};
+
+struct coro_sampler_thread_report_t {
+    coro_sampler_thread_report_t() : thread(-1) { }
+    int thread;
+    std::vector<std::pair<const char *, coro_sampler_spawn_site_t> > spawn_sites;
+    std::deque<coro_sampler_long_run_t> long_runs;
+};
+
+class coro_sampler_perfmon_t :
+    public perfmon_perthread_t<coro_sampler_thread_report_t,
+                               std::vector<coro_sampler_thread_report_t> > {
+public:
+    coro_sampler_perfmon_t() : thread_data(new padded_thread_t[MAX_THREADS]) { }
+    ~coro_sampler_perfmon_t() {
+        delete[] thread_data;
+    }
+
+    coro_sampler_thread_t *get_thread() {
+        rassert(get_thread_id().threadnum >= 0);
+        return &thread_data[get_thread_id().threadnum].value;
+    }
+
+private:
+    void get_thread_stat(coro_sampler_thread_report_t *stat) {
+        const coro_sampler_thread_t *thread = get_thread();
+        stat->thread = get_thread_id().threadnum;
+        stat->spawn_sites.assign(thread->spawn_sites.begin(), thread->spawn_sites.end());
+        // Only the spawn sites that took up the most time are interesting, and
+        // symbolizing the rest would be expensive.
+        auto by_total_time = [](const std::pair<const char *, coro_sampler_spawn_site_t> &a,
+                                const std::pair<const char *, coro_sampler_spawn_site_t> &b) {
+            return a.second.total_run_ticks > b.second.total_run_ticks;
+        };
+        if (stat->spawn_sites.size() > CORO_SAMPLER_MAX_REPORTED_SPAWN_SITES) {
+            std::partial_sort(stat->spawn_sites.begin(),
+                              stat->spawn_sites.begin()
+                                  + CORO_SAMPLER_MAX_REPORTED_SPAWN_SITES,
+                              stat->spawn_sites.end(),
+                              by_total_time);
+            stat->spawn_sites.resize(CORO_SAMPLER_MAX_REPORTED_SPAWN_SITES);
+        } else {
+            std::sort(stat->spawn_sites.begin(), stat->spawn_sites.end(), by_total_time);
+        }
+        stat->long_runs = thread->long_runs;
+    }
+
+    std::vector<coro_sampler_thread_report_t> combine_stats(
+            const coro_sampler_thread_report_t *data) {
+        return std::vector<coro_sampler_thread_report_t>(data, data + get_num_threads());
+    }
+
+    ql::datum_t output_stat(const std::vector<coro_sampler_thread_report_t> &reports) {
+        const ticks_t now = get_ticks();
+        ql::datum_array_builder_t spawn_sites(ql::configured_limits_t::unlimited);
+        ql::datum_array_builder_t long_runs(ql::configured_limits_t::unlimited);
+        for (const coro_sampler_thread_report_t &report : reports) {
+            for (const auto &pair : report.spawn_sites) {
+                const coro_sampler_spawn_site_t &site = pair.second;
+                const double num_samples = static_cast<double>(site.num_samples);
+                ql::datum_object_builder_t builder;
+                builder.overwrite("thread", ql::datum_t(static_cast<double>(report.thread)));
+                builder.overwrite("spawn_site",
+                    ql::datum_t(datum_string_t(describe_coro_spawn_site(pair.first))));
+                builder.overwrite("samples", ql::datum_t(num_samples));
+                builder.overwrite("mean_run_time",
+                    ql::datum_t(ticks_to_secs(site.total_run_ticks) / num_samples));
+                builder.overwrite("max_run_time",
+                    ql::datum_t(ticks_to_secs(site.max_run_ticks)));
+                builder.overwrite("mean_priority",
+                    ql::datum_t(static_cast<double>(site.total_priority) / num_samples));
+                spawn_sites.add(std::move(builder).to_datum());
+            }
+            for (const coro_sampler_long_run_t &long_run : report.long_runs) {
+                ql::datum_array_builder_t backtrace(ql::configured_limits_t::unlimited);
+                for (void *addr : long_run.backtrace) {
+                    backtrace.add(ql::datum_t(datum_string_t(describe_frame(addr))));
+                }
+                ql::datum_object_builder_t builder;
+                builder.overwrite("thread", ql::datum_t(static_cast<double>(report.thread)));
+                builder.overwrite("spawn_site",
+                    ql::datum_t(datum_string_t(
+                        describe_coro_spawn_site(long_run.spawn_site))));
+                builder.overwrite("run_time",
+                    ql::datum_t(ticks_to_secs(long_run.run_ticks)));
+                builder.overwrite("priority",
+                    ql::datum_t(static_cast<double>(long_run.priority)));
+                builder.overwrite("seconds_ago",
+                    ql::datum_t(ticks_to_secs(now - std::min(now, long_run.finished_at))));
+                builder.overwrite("backtrace", std::move(backtrace).to_datum());
+                long_runs.add(std::move(builder).to_datum());
+            }
+        }
+
+        ql::datum_object_builder_t result;
+        result.overwrite("sampling_interval",
+                         ql::datum_t(static_cast<double>(CORO_SAMPLER_INTERVAL)));
+        result.overwrite("spawn_sites", std::move(spawn_sites).to_datum());
+        result.overwrite("long_runs", std::move(long_runs).to_datum());
+        return std::move(result).to_datum();
+    }
+
+    static std::string describe_frame(void *addr) {
+        backtrace_frame_t frame(addr);
+        frame.initialize_symbols();
+        std::string name;
+        try {
+            name = frame.get_demangled_name();
+        } catch (const demangle_failed_exc_t &) {
+            name = frame.get_name();
+        }
+        return strprintf("%p %s", addr, name.c_str());
+    }
+
+    typedef cache_line_padded_t<coro_sampler_thread_t> padded_thread_t;
+    padded_thread_t *thread_data;
+
+    DISABLE_COPYING(coro_sampler_perfmon_t);
+};
+
+static coro_sampler_perfmon_t pm_coro_sampler;
+static perfmon_membership_t pm_coro_sampler_membership(
+    &get_global_perfmon_collection(), &pm_coro_sampler, "coro_profile");
+
+void coro_sampler_on_resume(coro_t *coro) {
+    coro_sampler_thread_t *thread = pm_coro_sampler.get_thread();
+    if (--thread->runs_until_sample > 0) {
+        return;
+    }
+    thread->runs_until_sample = CORO_SAMPLER_INTERVAL;
+    thread->sampled_coro = coro;
+    thread->sample_started_at = get_ticks();
+}
+
+void coro_sampler_on_yield(coro_t *coro) {
+    coro_sampler_thread_t *thread = pm_coro_sampler.get_thread();
+    if (thread->sampled_coro != coro) {
+        return;
+    }
+    thread->sampled_coro = nullptr;
+
+    const ticks_t now = get_ticks();
+    const ticks_t run_ticks = now - std::min(now, thread->sample_started_at);
+    coro_sampler_spawn_site_t *site = &thread->spawn_sites[coro->get_spawn_site()];
+    ++site->num_samples;
+    site->total_run_ticks += run_ticks;
+    site->max_run_ticks = std::max(site->max_run_ticks, run_ticks);
+    site->total_priority += coro->get_priority();
+
+    if (ticks_to_secs(run_ticks) > CORO_SAMPLER_LONG_RUN_SECS) {
+        void *buffer[CORO_SAMPLER_BACKTRACE_DEPTH];
+        int size = rethinkdb_backtrace(buffer, CORO_SAMPLER_BACKTRACE_DEPTH);
+        if (thread->long_runs.size() >= CORO_SAMPLER_MAX_LONG_RUNS) {
+            thread->long_runs.pop_front();
+        }
+        coro_sampler_long_run_t long_run;
+        long_run.spawn_site = coro->get_spawn_site();
+        long_run.finished_at = now;
+        long_run.run_ticks = run_ticks;
+        long_run.priority = coro->get_priority();
+        // Skip the frame of this function and the ones inside `rethinkdb_backtrace()`.
+        const int num_frames_to_skip = NUM_FRAMES_INSIDE_RETHINKDB_BACKTRACE + 1;
+        if (size > num_frames_to_skip) {
+            long_run.backtrace.assign(buffer + num_frames_to_skip, buffer + size);
+        }
+        thread->long_runs.push_back(std::move(long_run));
+    }
+}
+
+std::string describe_coro_spawn_site(const char *spawn_site) {
+    // The spawn site is the pretty-printed signature of `coro_t::get_and_init_coro()`,
+    // the interesting part of which is the type of the callable it was given.
+    const char *marker = "callable_t = ";
+    const char *begin = strstr(spawn_site, marker);
+    if (begin == nullptr) {
+        return spawn_site;
+    }
+    begin += strlen(marker);
+    std::string description(begin);
+    if (!description.empty() && description.back() == ']') {
+        description.pop_back();
+    }
+    size_t semicolon = description.find("; ");
+    if (semicolon != std::string::npos) {
+        description.resize(semicolon);
+    }
+    return description;
+}
@@ -0,0 +1,41 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_CORO_SAMPLER_HPP_
+#define ARCH_RUNTIME_CORO_SAMPLER_HPP_
+
+#include <string>
+
+#include "errors.hpp"
+
+class coro_t;
+
+/* The coro sampler is a cheap, always-on counterpart to the `coro_profiler_t`.  It
+finds out which coroutines keep the event loop busy, even in release builds.
+
+Every `CORO_SAMPLER_INTERVAL`th time a coroutine starts running on a thread, the
+sampler times how long the coroutine runs before it yields, and records this together
+with the coroutine's priority under the coroutine's spawn site.  A sampled run that
+takes longer than `CORO_SAMPLER_LONG_RUN_SECS` is also recorded with a backtrace of
+the point where the coroutine finally yielded.
+
+Samples are aggregated per thread and exported through the perfmon system as
+`coro_profile`, which is what the `rethinkdb._debug_coro_profile` table shows. */
+
+#define CORO_SAMPLER_INTERVAL                   32
+#define CORO_SAMPLER_LONG_RUN_SECS              0.02
+
+// How many long runs are kept per thread.  Older ones get dropped.
+#define CORO_SAMPLER_MAX_LONG_RUNS              16
+// How many spawn sites with the highest total run time are reported per thread.
+#define CORO_SAMPLER_MAX_REPORTED_SPAWN_SITES   50
+#define CORO_SAMPLER_BACKTRACE_DEPTH            16
+
+/* These are called by the coroutine implementation whenever `coro` starts running
+and right before it stops running on the current thread. */
+void coro_sampler_on_resume(coro_t *coro);
+void coro_sampler_on_yield(coro_t *coro);
+
+/* Turns the `CURRENT_FUNCTION_PRETTY` string that `coro_t` records for its spawn site
+into a shorter, human readable description. */
+std::string describe_coro_spawn_site(const char *spawn_site);
+
+#endif  // ARCH_RUNTIME_CORO_SAMPLER_HPP_
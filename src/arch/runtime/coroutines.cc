@@ -13,6 +13,7 @@
 
 #include "arch/runtime/context_switching.hpp"
 #include "arch/runtime/coro_profiler.hpp"
+#include "arch/runtime/coro_sampler.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "config/args.hpp"
@@ -28,7 +29,7 @@
 size_t coro_stack_size = COROUTINE_STACK_SIZE;
 
 // How many unused coroutine stacks to keep around (at most), before they are
-// freed. This value is per thread.
+// freed. This value is per thread and stack class.
 const size_t COROUTINE_FREE_LIST_SIZE = 64;
 
 // In debug mode, we print a warning if more than this many coroutines have been
@@ -68,8 +69,8 @@ struct coro_globals_t {
     /* The previous context. */
     coro_t *prev_coro;
 
-    /* A list of coro_t objects that are not in use. */
-    intrusive_list_t<coro_t> free_coros;
+    /* Lists of coro_t objects that are not in use, one for each stack class. */
+    intrusive_list_t<coro_t> free_coros[NUM_CORO_STACK_CLASSES];
 
     /* A list of coroutines that currently have protected stacks. The least recently
     used protected coroutine is always at the front of the list. */
@@ -120,9 +121,11 @@ struct coro_globals_t {
         rassert(!current_coro);
 
         /* Destroy remaining coroutines */
-        while (coro_t *s = free_coros.head()) {
-            free_coros.remove(s);
-            delete s;
+        for (size_t i = 0; i < NUM_CORO_STACK_CLASSES; ++i) {
+            while (coro_t *s = free_coros[i].head()) {
+                free_coros[i].remove(s);
+                delete s;
+            }
         }
     }
 
@@ -162,11 +165,22 @@ void coro_runtime_t::get_coroutine_counts(std::map<std::string, size_t> *dest) {
 TLS_with_init(int64_t, coro_selfname_counter, 0);
 #endif
 
-coro_t::coro_t() :
-    stack(&coro_t::run, coro_stack_size),
+static size_t stack_size_for_class(coro_stack_class_t stack_class) {
+    switch (stack_class) {
+    case coro_stack_class_t::DEFAULT: return coro_stack_size;
+    case coro_stack_class_t::SMALL: return COROUTINE_SMALL_STACK_SIZE;
+    default: unreachable();
+    }
+}
+
+coro_t::coro_t(coro_stack_class_t stack_class) :
+    stack_class_(stack_class),
+    stack_size_(stack_size_for_class(stack_class)),
+    stack(&coro_t::run, stack_size_),
     current_thread_(linux_thread_pool_t::get_thread_id()),
     notified_(false),
     waiting_(false),
+    spawn_site_(nullptr),
     protected_stack_lru_entry_(this)
 #ifndef NDEBUG
     , selfname_number(get_thread_id().threadnum + MAX_THREADS *
@@ -199,13 +213,15 @@ void coro_t::return_coro_to_free_list(coro_t *coro) {
     // This is important because when we call `return_coro_to_free_list` in
     // `coro_t::run`, that coroutine is still active and must not be deleted yet.
     static_assert(COROUTINE_FREE_LIST_SIZE > 0, "COROUTINE_FREE_LIST_SIZE cannot be 0");
-    if (cglobals->free_coros.size() >= COROUTINE_FREE_LIST_SIZE) {
-        coro_t *coro_to_delete = cglobals->free_coros.tail();
-        cglobals->free_coros.remove(coro_to_delete);
+    intrusive_list_t<coro_t> *free_coros =
+        &cglobals->free_coros[static_cast<size_t>(coro->stack_class_)];
+    if (free_coros->size() >= COROUTINE_FREE_LIST_SIZE) {
+        coro_t *coro_to_delete = free_coros->tail();
+        free_coros->remove(coro_to_delete);
         delete coro_to_delete;
     }
-    rassert(cglobals->free_coros.size() < COROUTINE_FREE_LIST_SIZE);
-    cglobals->free_coros.push_back(coro);
+    rassert(free_coros->size() < COROUTINE_FREE_LIST_SIZE);
+    free_coros->push_back(coro);
 }
 
 coro_t::~coro_t() {
@@ -274,7 +290,9 @@ void coro_t::run() {
         TLS_get_cglobals()->active_coroutines.insert(coro);
 #endif
         PROFILER_CORO_RESUME;
+        coro_sampler_on_resume(coro);
         coro->action_wrapper.run();
+        coro_sampler_on_yield(coro);
         PROFILER_CORO_YIELD(0);
 #ifndef NDEBUG
         TLS_get_cglobals()->running_coroutine_counts[coro->coroutine_type]--;
@@ -361,12 +379,14 @@ void coro_t::wait() {   /* class method */
     self()->waiting_ = true;
 
     PROFILER_CORO_YIELD(1);
+    coro_sampler_on_yield(self());
     if (TLS_get_cglobals()->prev_coro) {
         TLS_get_cglobals()->prev_coro->switch_to_coro_with_protection(
             &self()->stack.context);
     } else {
         switch_to_scheduler(&self()->stack.context, &TLS_get_cglobals()->scheduler);
     }
+    coro_sampler_on_resume(self());
     PROFILER_CORO_RESUME;
 
     rassert(self());
@@ -404,6 +424,7 @@ void coro_t::notify_now_deprecated() {
 
     if (coro_t::self() != nullptr) {
         PROFILER_CORO_YIELD(1);
+        coro_sampler_on_yield(coro_t::self());
     }
     coro_t *prev_prev_coro = TLS_get_cglobals()->prev_coro;
     TLS_get_cglobals()->prev_coro = TLS_get_cglobals()->current_coro;
@@ -419,6 +440,7 @@ void coro_t::notify_now_deprecated() {
     TLS_get_cglobals()->current_coro = TLS_get_cglobals()->prev_coro;
     TLS_get_cglobals()->prev_coro = prev_prev_coro;
     if (coro_t::self() != nullptr) {
+        coro_sampler_on_resume(coro_t::self());
         PROFILER_CORO_RESUME;
     }
 
@@ -510,19 +532,36 @@ bool has_n_bytes_free_stack_space(size_t n) {
     return current_coro->stack.free_space_below(&tester) >= n;
 }
 
+size_t coroutine_stack_space_used() {
+    char tester;
+    const coro_t *current_coro = coro_t::self();
+    guarantee(current_coro != nullptr);
+#ifdef _WIN32
+    if (!current_coro->stack.has_stack_info) {
+        return 0;
+    }
+    const char *stack_base = current_coro->stack.stack_base;
+#else
+    const char *stack_base = static_cast<const char *>(current_coro->stack.get_stack_base());
+#endif
+    return stack_base - &tester;
+}
+
 bool coroutines_have_been_initialized() {
     return TLS_get_cglobals() != nullptr;
 }
 
-coro_t * coro_t::get_coro() {
+coro_t * coro_t::get_coro(coro_stack_class_t stack_class) {
     rassert(coroutines_have_been_initialized());
     coro_t *coro;
 
-    if (TLS_get_cglobals()->free_coros.size() == 0) {
-        coro = new coro_t();
+    intrusive_list_t<coro_t> *free_coros =
+        &TLS_get_cglobals()->free_coros[static_cast<size_t>(stack_class)];
+    if (free_coros->size() == 0) {
+        coro = new coro_t(stack_class);
     } else {
-        coro = TLS_get_cglobals()->free_coros.tail();
-        TLS_get_cglobals()->free_coros.remove(coro);
+        coro = free_coros->tail();
+        free_coros->remove(coro);
     }
 
     rassert(!coro->intrusive_list_node_t<coro_t>::in_a_list());
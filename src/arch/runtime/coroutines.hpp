@@ -36,6 +36,21 @@ struct coro_profiler_mixin_t {
 #endif
 };
 
+/* Every coroutine gets its stack from one of these size classes, and each class
+has its own per-thread free list.  Most coroutines should use the default stack.
+Spawn sites that only run shallow code, and of which there can be very many at a
+time (for example coroutines that spend their life waiting for a signal), can ask
+for a `SMALL` stack of `COROUTINE_SMALL_STACK_SIZE` bytes instead.  Overflowing a
+small stack is caught by the same guard page as for default stacks, so code that
+might need more space should move to a fresh coroutine using
+`call_with_enough_stack()`.  The coro profiler reports how much stack each spawn
+site actually uses. */
+enum class coro_stack_class_t {
+    DEFAULT = 0,
+    SMALL = 1
+};
+const size_t NUM_CORO_STACK_CLASSES = 2;
+
 /* The `coro_lru_entry_t` is used to keep track of coroutines that have protected
 stacks and to eventually unprotect them using a least-recently-used strategy. */
 struct coro_lru_entry_t : public intrusive_list_node_t<coro_lru_entry_t> {
@@ -56,16 +71,21 @@ class coro_t : private coro_profiler_mixin_t,
 public:
     friend bool is_coroutine_stack_overflow(void *);
     friend bool has_n_bytes_free_stack_space(size_t);
+    friend size_t coroutine_stack_space_used();
 
     template<class callable_t>
-    static void spawn_now_dangerously(callable_t &&action) {
-        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action));
+    static void spawn_now_dangerously(
+            callable_t &&action,
+            coro_stack_class_t stack_class = coro_stack_class_t::DEFAULT) {
+        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action), stack_class);
         coro->notify_now_deprecated();
     }
 
     template<class callable_t>
-    static coro_t *spawn_sometime(callable_t &&action) {
-        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action));
+    static coro_t *spawn_sometime(
+            callable_t &&action,
+            coro_stack_class_t stack_class = coro_stack_class_t::DEFAULT) {
+        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action), stack_class);
         coro->notify_sometime();
         return coro;
     }
@@ -74,8 +94,11 @@ public:
     It avoids two thread messages, since it doesn't have to run on the original
     thread first, and also doesn't switch back at the end of the coro's lifetime. */
     template<class callable_t>
-    static coro_t *spawn_on_thread(callable_t &&action, threadnum_t thread) {
-        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action));
+    static coro_t *spawn_on_thread(
+            callable_t &&action,
+            threadnum_t thread,
+            coro_stack_class_t stack_class = coro_stack_class_t::DEFAULT) {
+        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action), stack_class);
         coro->current_thread_ = thread;
         coro->notify_sometime();
         return coro;
@@ -85,8 +108,10 @@ public:
     `spawn_later_ordered()` (or `spawn_ordered()`). `spawn_later_ordered()` does not
     honor scheduler priorities. */
     template<class callable_t>
-    static coro_t *spawn_later_ordered(callable_t &&action) {
-        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action));
+    static coro_t *spawn_later_ordered(
+            callable_t &&action,
+            coro_stack_class_t stack_class = coro_stack_class_t::DEFAULT) {
+        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action), stack_class);
         coro->notify_later_ordered();
         return coro;
     }
@@ -148,10 +173,19 @@ public:
     const std::string& get_coroutine_type() { return coroutine_type; }
 #endif
 
+    // Sets the size of `coro_stack_class_t::DEFAULT` stacks allocated from now on.
     static void set_coroutine_stack_size(size_t size);
 
     coro_stack_t *get_stack();
 
+    coro_stack_class_t get_stack_class() const { return stack_class_; }
+
+    /* Identifies where the coroutine was spawned from.  This is the pretty-printed
+    signature of `get_and_init_coro()`, which includes the type of the callable the
+    coroutine runs.  See `describe_coro_spawn_site()`. */
+    const char *get_spawn_site() const { return spawn_site_; }
+    size_t get_stack_size() const { return stack_size_; }
+
     void set_priority(int _priority) {
         linux_thread_message_t::set_priority(_priority);
     }
@@ -174,7 +208,7 @@ private:
 
     // Constructor sets up the stack, get_and_init_coro will load a function to be run
     //  at which point the coroutine can be notified
-    coro_t();
+    explicit coro_t(coro_stack_class_t stack_class);
 
     // Generates a spawn-time backtrace and stores it into `spawn_backtrace`.
     void grab_spawn_backtrace();
@@ -185,8 +219,10 @@ private:
 
     // If this function footprint ever changes, you may need to update the parse_coroutine_info function
     template<class callable_t>
-    static coro_t *get_and_init_coro(callable_t &&action) {
-        coro_t *coro = get_coro();
+    static coro_t *get_and_init_coro(callable_t &&action,
+                                     coro_stack_class_t stack_class) {
+        coro_t *coro = get_coro(stack_class);
+        coro->spawn_site_ = CURRENT_FUNCTION_PRETTY;
 #ifndef NDEBUG
         coro->parse_coroutine_type(CURRENT_FUNCTION_PRETTY);
 #endif
@@ -205,7 +241,7 @@ private:
         return coro;
     }
 
-    static coro_t *get_coro();
+    static coro_t *get_coro(coro_stack_class_t stack_class);
 
     static void return_coro_to_free_list(coro_t *coro);
 
@@ -217,6 +253,8 @@ private:
 
     virtual void on_thread_switch();
 
+    coro_stack_class_t stack_class_;
+    size_t stack_size_;
     coro_stack_t stack;
 
     threadnum_t current_thread_;
@@ -226,6 +264,7 @@ private:
     bool waiting_;
 
     callable_action_wrapper_t action_wrapper;
+    const char *spawn_site_;
 
     /* Used to eventually unprotect the coroutine if it has been inactive for a while. */
     coro_lru_entry_t protected_stack_lru_entry_;
@@ -248,6 +287,8 @@ private:
 bool is_coroutine_stack_overflow(void *addr);
 /* Returns true if at least n bytes are available on the stack of the current coroutine. */
 bool has_n_bytes_free_stack_space(size_t n);
+/* Returns how many bytes of the current coroutine's stack are in use. */
+size_t coroutine_stack_space_used();
 bool coroutines_have_been_initialized();
 
 /* Checks that there are at least n bytes of stack space available on the current
@@ -15,6 +15,38 @@ perfmon_duration_sampler_t *pm_eventloop_singleton_t::get() {
     return &pm_eventloop;
 }
 
+struct pm_busy_poll_t {
+    pm_busy_poll_t()
+        : hits_membership(&collection, &hits, "hits"),
+          misses_membership(&collection, &misses, "misses"),
+          hit_spin_membership(&collection, &hit_spin_nanos, "hit_spin_nanos"),
+          miss_spin_membership(&collection, &miss_spin_nanos, "miss_spin_nanos"),
+          collection_membership(&get_global_perfmon_collection(), &collection,
+                                "eventloop_busy_poll") { }
+
+    perfmon_collection_t collection;
+    perfmon_counter_t hits;
+    perfmon_counter_t misses;
+    perfmon_counter_t hit_spin_nanos;
+    perfmon_counter_t miss_spin_nanos;
+    perfmon_membership_t hits_membership;
+    perfmon_membership_t misses_membership;
+    perfmon_membership_t hit_spin_membership;
+    perfmon_membership_t miss_spin_membership;
+    perfmon_membership_t collection_membership;
+};
+
+void record_busy_poll(bool hit, int64_t spin_nanos) {
+    static pm_busy_poll_t pm_busy_poll;
+    if (hit) {
+        ++pm_busy_poll.hits;
+        pm_busy_poll.hit_spin_nanos += spin_nanos;
+    } else {
+        ++pm_busy_poll.misses;
+        pm_busy_poll.miss_spin_nanos += spin_nanos;
+    }
+}
+
 std::string format_poll_event(int event) {
     std::string s;
     if (event & poll_event_in) {
@@ -21,6 +21,12 @@ struct pm_eventloop_singleton_t {
     static perfmon_duration_sampler_t *get();
 };
 
+/* Stats for event queues that busy-poll, under `eventloop_busy_poll`.  A hit is a poll
+that found something to do before its budget ran out, which saved a trip through the
+kernel scheduler.  A miss is a poll that gave up and blocked, so the time it spun was
+CPU time spent for nothing.  Initialized on first use, like the stats above. */
+void record_busy_poll(bool hit, int64_t spin_nanos);
+
 /* Pick the queue now*/
 
 #if defined(_WIN32)
@@ -53,13 +53,48 @@ epoll_event_queue_t::epoll_event_queue_t(linux_queue_parent_t *_parent)
     guarantee_err(epoll_fd >= 0, "Could not create epoll fd");
 }
 
+int epoll_event_queue_t::busy_poll(int64_t budget_nanos) {
+    ticks_t start = get_ticks();
+    for (;;) {
+        // Other threads don't wake us up while we're polling, so we have to look for
+        // their messages ourselves.
+        if (parent->poll_messages()) {
+            record_busy_poll(true, get_ticks() - start);
+            start = get_ticks();
+        }
+        int res = epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, 0);
+        const ticks_t now = get_ticks();
+        if (res != 0) {
+            if (res > 0) {
+                record_busy_poll(true, now - start);
+            }
+            return res;
+        }
+        if (static_cast<int64_t>(now - start) >= budget_nanos) {
+            record_busy_poll(false, now - start);
+            return 0;
+        }
+    }
+}
+
 void epoll_event_queue_t::run() {
     int res;
+    const int64_t busy_poll_nanos = parent->get_busy_poll_nanos();
 
     // Now, start the loop
     while (!parent->should_shut_down()) {
-        // Grab the events from the kernel!
-        res = epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, -1);
+        res = 0;
+        if (busy_poll_nanos > 0) {
+            res = busy_poll(busy_poll_nanos);
+            if (res == 0) {
+                // Nothing came up, so we're going to block after all.
+                parent->pump();
+            }
+        }
+        if (res == 0) {
+            // Grab the events from the kernel!
+            res = epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, -1);
+        }
 
         // epoll_wait might return with EINTR in some cases (in
         // particular under GDB), we just need to retry.
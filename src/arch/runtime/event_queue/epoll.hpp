@@ -30,6 +30,11 @@ public:
     void forget_event(system_event_t *, linux_event_callback_t *cb);
 
 private:
+    /* Polls for events until there are some, or until `budget_nanos` have passed
+    without any events or incoming messages.  Returns the number of events, 0 if there
+    weren't any, or -1 if `epoll_wait()` failed. */
+    int busy_poll(int64_t budget_nanos);
+
     linux_queue_parent_t *parent;
 
     fd_t epoll_fd;
@@ -3,6 +3,7 @@
 #define ARCH_RUNTIME_EVENT_QUEUE_TYPES_HPP_
 
 #include <signal.h>
+#include <stdint.h>
 
 // Types that are used, in particular, by poll.hpp and epoll.hpp.
 
@@ -13,8 +14,17 @@ struct linux_event_callback_t {
 };
 
 struct linux_queue_parent_t {
+    // Called before the event queue waits for new events.
     virtual void pump() = 0;
     virtual bool should_shut_down() = 0;
+
+    /* How long the event queue should keep polling for events before it blocks, or
+    zero if it shouldn't poll at all.  Only the epoll queue supports this. */
+    virtual int64_t get_busy_poll_nanos() = 0;
+    /* Called instead of `pump()` while the event queue is polling.  Delivers messages
+    to other threads and handles incoming messages, without having them signaled
+    through the event queue.  Returns true if there were incoming messages. */
+    virtual bool poll_messages() = 0;
     virtual ~linux_queue_parent_t() {}
 };
 
@@ -94,16 +94,17 @@ void linux_message_hub_t::store_message_sometime(threadnum_t nthread, linux_thre
 
 
 void linux_message_hub_t::insert_external_message(linux_thread_message_t *msg) {
-    bool do_wake_up;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        do_wake_up = !check_and_set_is_woken_up();
-        incoming_messages_.push_back(msg);
+    // If the list wasn't empty, whoever made it non-empty takes care of waking us up.
+    if (incoming_messages_.push(msg)) {
+        wake_up_if_idle();
     }
+}
 
-    // Wakey wakey eggs and bakey
-    if (do_wake_up) {
-        event_.wakey_wakey();
+void linux_message_hub_t::check_incoming_before_waiting() {
+    is_woken_up_.store(false);
+    // A message might have come in while we were still marked as awake.
+    if (!incoming_messages_.empty()) {
+        wake_up_if_idle();
     }
 }
 
@@ -125,6 +126,32 @@ void linux_message_hub_t::on_event(int events) {
     // Sort incoming messages into the respective priority_msg_lists_
     sort_incoming_messages_by_priority();
 
+    if (process_messages()) {
+        // Place wakey_wakey and then yield to the event processing.
+        // It will wake us up again immediately, but can handle a few
+        // OS events (such as timers, network messages etc.) in the meantime.
+        // `is_woken_up_` is still set, so we have to do this unconditionally.
+        event_.wakey_wakey();
+    }
+}
+
+bool linux_message_hub_t::poll_incoming() {
+    // We're awake, so other threads don't need to signal us.
+    is_woken_up_.store(true);
+    if (incoming_messages_.empty()) {
+        return false;
+    }
+    sort_incoming_messages_by_priority();
+    if (process_messages()) {
+        // As in `on_event()`, we get back to the rest after the event queue has had a
+        // chance to handle some OS events.
+        event_.wakey_wakey();
+    }
+    return true;
+}
+
+bool linux_message_hub_t::process_messages() {
+
     // Compute how many messages of MESSAGE_SCHEDULER_MAX_PRIORITY we process
     // before we check the incoming queues for new messages.
     // We call this the granularity of the message scheduler, and it is
@@ -172,38 +199,19 @@ void linux_message_hub_t::on_event(int events) {
     }
 
     // We might have left some messages unprocessed.
-    // Check if that is the case, and if yes, make sure we are called again.
     for (int i = 0; i < NUM_SCHEDULER_PRIORITIES; ++i) {
         if (!priority_msg_lists_[i].empty()) {
-            // Place wakey_wakey and then yield to the event processing.
-            // It will wake us up again immediately, but can handle a few
-            // OS events (such as timers, network messages etc.) in the meantime.
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&incoming_messages_lock_);
-                do_wake_up = !check_and_set_is_woken_up();
-            }
-            if (do_wake_up) {
-                event_.wakey_wakey();
-            }
-            break;
+            return true;
         }
     }
+    return false;
 }
 
 void linux_message_hub_t::sort_incoming_messages_by_priority() {
-    // We do this in two steps to release the spinlock faster.
-    // append_and_clear is a very cheap operation, while
-    // assigning each message to a different priority queue
-    // is more expensive.
-
-    // 1. Pull the messages
+    // 1. Pull the messages.  We leave `is_woken_up_` set, so other threads don't
+    // signal `event_` again while we're processing them.
     msg_list_t new_messages;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        new_messages.append_and_clear(&incoming_messages_);
-        is_woken_up_ = false;
-    }
+    incoming_messages_.pop_all(&new_messages);
 
     // 2. Sort the messages into their respective priority queues
     while (linux_thread_message_t *m = new_messages.head()) {
@@ -221,10 +229,11 @@ void linux_message_hub_t::sort_incoming_messages_by_priority() {
     }
 }
 
-bool linux_message_hub_t::check_and_set_is_woken_up() {
-    const bool was_woken_up = is_woken_up_;
-    is_woken_up_ = true;
-    return was_woken_up;
+void linux_message_hub_t::wake_up_if_idle() {
+    if (!is_woken_up_.exchange(true)) {
+        // Wakey wakey eggs and bakey
+        event_.wakey_wakey();
+    }
 }
 
 // Pushes messages collected locally global lists available to all
@@ -235,23 +244,11 @@ void linux_message_hub_t::push_messages() {
         // message list.
         thread_queue_t *queue = &queues_[i];
         if (!queue->msg_local_list.empty()) {
-            // Transfer messages to the other core
-
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&thread_pool_->threads[i]->message_hub.incoming_messages_lock_);
-
-                // We only need to do a wake up if we're the first people to do a
-                // wake up.
-                do_wake_up =
-                    !thread_pool_->threads[i]->message_hub.check_and_set_is_woken_up();
-
-                thread_pool_->threads[i]->message_hub.incoming_messages_.append_and_clear(&queue->msg_local_list);
-            }
-
-            // Wakey wakey, perhaps eggs and bakey
-            if (do_wake_up) {
-                thread_pool_->threads[i]->message_hub.event_.wakey_wakey();
+            // Transfer messages to the other core.  We only need to do a wake up if
+            // we're the first ones to give it new messages.
+            linux_message_hub_t *hub = &thread_pool_->threads[i]->message_hub;
+            if (hub->incoming_messages_.push_all(&queue->msg_local_list)) {
+                hub->wake_up_if_idle();
             }
         }
     }
@@ -4,12 +4,14 @@
 
 #include <pthread.h>
 
+#include <atomic>
+
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/runtime_utils.hpp"
 #include "arch/runtime/system_event.hpp"
-#include "arch/spinlock.hpp"
 #include "config/args.hpp"
 #include "containers/intrusive_list.hpp"
+#include "containers/mpsc_list.hpp"
 #include "threading.hpp"
 
 
@@ -48,6 +50,19 @@ public:
     // (which does not have an event queue)
     void insert_external_message(linux_thread_message_t *msg);
 
+    /* Called by the thread pool on this hub's thread before its event queue waits for
+    new events.  From then on, other threads will signal `event_` when they send us
+    messages.  While we're busy they don't bother, since we'll look for new messages
+    here anyway. */
+    void check_incoming_before_waiting();
+
+    /* Handles incoming messages directly, rather than after `event_` has been
+    signaled, for a thread that's polling for events instead of waiting.  Returns true
+    if there were any.  While the thread doesn't call `check_incoming_before_waiting()`,
+    other threads don't signal `event_`, so this is the only way it sees new
+    messages. */
+    bool poll_incoming();
+
     ~linux_message_hub_t();
 
 private:
@@ -59,6 +74,10 @@ private:
     // priority_msg_lists, depending on the messages' priorities.
     void sort_incoming_messages_by_priority();
 
+    // Processes messages from priority_msg_lists_.  Returns true if it left some of them
+    // for later.
+    bool process_messages();
+
     msg_list_t &get_priority_msg_list(int priority);
 
     linux_event_queue_t *const queue_;
@@ -68,16 +87,18 @@ private:
     struct thread_queue_t {
         //TODO this doesn't need to be a class anymore
 
-        /* Messages are cached here before being pushed to the global list so that we don't
-        have to acquire the spinlock as often */
+        /* Messages are cached here before being pushed to the other thread's incoming
+        list so that we touch its shared state (and wake it up) less often */
         msg_list_t msg_local_list;
     } queues_[MAX_THREADS];
 
-    // Must only be used with acquired incoming_messages_lock_
-    bool check_and_set_is_woken_up();
-    bool is_woken_up_;
-    msg_list_t incoming_messages_;
-    spinlock_t incoming_messages_lock_;
+    // Signals `event_` unless this hub's thread is already awake, or has already been
+    // woken up.  Called after pushing messages onto `incoming_messages_`.
+    void wake_up_if_idle();
+    // True while this hub's thread is going to look at `incoming_messages_` before
+    // waiting for events.
+    std::atomic<bool> is_woken_up_;
+    mpsc_list_t<linux_thread_message_t> incoming_messages_;
 
     // Use `sort_incoming_messages_by_priority()` to sort incoming_messages_ into
     // these lists.
@@ -89,8 +110,8 @@ private:
 
     void on_event(int events);
 
-    // The eventfd (or pipe-based alternative) notified after the first incoming
-    // message is put onto incoming_messages_.
+    // The eventfd (or pipe-based alternative) notified when messages are put onto
+    // incoming_messages_ while this thread is idle.
     system_event_t event_;
 
     /* The thread that we queue messages originating from. (Recall that there is one
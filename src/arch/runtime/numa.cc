@@ -0,0 +1,232 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/runtime/numa.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "arch/runtime/runtime_utils.hpp"
+#include "perfmon/perfmon.hpp"
+#include "utils.hpp"
+
+#ifdef __linux__
+static const char *const numa_node_dir = "/sys/devices/system/node";
+
+static bool read_sysfs_file(const std::string &path, std::string *contents_out) {
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return false;
+    }
+    contents_out->clear();
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents_out->append(buffer, n);
+    }
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    return ok;
+}
+
+/* Returns the ids of the NUMA nodes in increasing order, or an empty vector if the
+topology can't be read. */
+static std::vector<int> get_numa_node_ids() {
+    std::vector<int> ids;
+    DIR *dir = opendir(numa_node_dir);
+    if (dir == nullptr) {
+        return ids;
+    }
+    while (struct dirent *entry = readdir(dir)) {
+        int id;
+        char trailing;
+        if (sscanf(entry->d_name, "node%d%c", &id, &trailing) == 1 && id >= 0) {
+            ids.push_back(id);
+        }
+    }
+    closedir(dir);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+#endif  // __linux__
+
+/* Returns the CPUs this process is allowed to run on, in increasing order, or an empty
+vector if they can't be determined. */
+static std::vector<int> get_allowed_cpus() {
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &mask)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+bool parse_cpu_list(const std::string &cpu_list, std::vector<int> *cpus_out) {
+    cpus_out->clear();
+    const char *p = cpu_list.c_str();
+    while (*p != '\0' && *p != '\n') {
+        char *end;
+        long first = strtol(p, &end, 10);  // NOLINT(runtime/int)
+        if (end == p || first < 0) {
+            return false;
+        }
+        long last = first;  // NOLINT(runtime/int)
+        p = end;
+        if (*p == '-') {
+            ++p;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first) {
+                return false;
+            }
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {  // NOLINT(runtime/int)
+            cpus_out->push_back(static_cast<int>(cpu));
+        }
+        if (*p == ',') {
+            ++p;
+        } else if (*p != '\0' && *p != '\n') {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::vector<int> > restrict_node_cpus(
+        const std::vector<std::vector<int> > &node_cpus,
+        const std::vector<int> &allowed_cpus) {
+    std::vector<std::vector<int> > res;
+    for (const std::vector<int> &cpus : node_cpus) {
+        std::vector<int> allowed;
+        std::set_intersection(cpus.begin(), cpus.end(),
+                              allowed_cpus.begin(), allowed_cpus.end(),
+                              std::back_inserter(allowed));
+        if (!allowed.empty()) {
+            res.push_back(std::move(allowed));
+        }
+    }
+    return res;
+}
+
+std::vector<std::vector<int> > get_numa_node_cpus() {
+    std::vector<int> allowed_cpus = get_allowed_cpus();
+    if (allowed_cpus.empty()) {
+        for (int cpu = 0; cpu < get_cpu_count(); ++cpu) {
+            allowed_cpus.push_back(cpu);
+        }
+    }
+
+    std::vector<std::vector<int> > node_cpus;
+#ifdef __linux__
+    for (int id : get_numa_node_ids()) {
+        std::string contents;
+        std::vector<int> cpus;
+        if (!read_sysfs_file(strprintf("%s/node%d/cpulist", numa_node_dir, id),
+                             &contents)
+            || !parse_cpu_list(contents, &cpus)) {
+            node_cpus.clear();
+            break;
+        }
+        std::sort(cpus.begin(), cpus.end());
+        node_cpus.push_back(std::move(cpus));
+    }
+#endif
+    // Memory-only nodes, and nodes whose CPUs we aren't allowed to use (because of
+    // `taskset` or a cpuset cgroup, for example), don't matter for thread placement.
+    node_cpus = restrict_node_cpus(node_cpus, allowed_cpus);
+    if (node_cpus.empty()) {
+        node_cpus.push_back(std::move(allowed_cpus));
+    }
+    return node_cpus;
+}
+
+std::vector<int> assign_threads_to_cpus(
+        int num_threads, const std::vector<std::vector<int> > &node_cpus) {
+    guarantee(!node_cpus.empty());
+    size_t total_cpus = 0;
+    for (const std::vector<int> &cpus : node_cpus) {
+        guarantee(!cpus.empty());
+        total_cpus += cpus.size();
+    }
+
+    std::vector<int> thread_cpus;
+    thread_cpus.reserve(num_threads);
+    std::vector<size_t> used_per_node(node_cpus.size(), 0);
+    for (int i = 0; i < num_threads; ++i) {
+        // Thread `i` goes to the node that owns the corresponding fraction of all the
+        // CPUs, so that consecutive threads end up on the same node.
+        size_t position = static_cast<size_t>(i) * total_cpus / num_threads;
+        size_t node = 0;
+        while (position >= node_cpus[node].size()) {
+            position -= node_cpus[node].size();
+            ++node;
+        }
+        const std::vector<int> &cpus = node_cpus[node];
+        thread_cpus.push_back(cpus[used_per_node[node] % cpus.size()]);
+        ++used_per_node[node];
+    }
+    return thread_cpus;
+}
+
+/* Reports the kernel's per-node allocation counters.  `numa_miss` and `other_node`
+count pages that had to be allocated on (or for a process running on) a different
+node than the preferred one.
+
+These counters are node-wide: they cover every process on the machine, not just this
+one, and they aren't reset when we start.  The stat is called `system_numa` to make
+that clear. */
+class perfmon_numa_t : public perfmon_t {
+public:
+    perfmon_numa_t() { }
+
+    void *begin_stats() {
+        return nullptr;
+    }
+    void visit_stats(void *) { }
+    ql::datum_t end_stats(void *) {
+        ql::datum_object_builder_t result;
+#ifdef __linux__
+        // These are tiny in-memory files, so reading them doesn't need to go through
+        // the blocker pool.
+        for (int id : get_numa_node_ids()) {
+            std::string contents;
+            if (!read_sysfs_file(strprintf("%s/node%d/numastat", numa_node_dir, id),
+                                 &contents)) {
+                continue;
+            }
+            ql::datum_object_builder_t node;
+            const char *p = contents.c_str();
+            char name[64];
+            unsigned long long value;  // NOLINT(runtime/int)
+            int consumed;
+            while (sscanf(p, "%63s %llu%n", name, &value, &consumed) == 2) {
+                node.overwrite(name, ql::datum_t(static_cast<double>(value)));
+                p += consumed;
+            }
+            result.overwrite(datum_string_t(strprintf("node%d", id)),
+                             std::move(node).to_datum());
+        }
+#endif
+        return std::move(result).to_datum();
+    }
+
+private:
+    DISABLE_COPYING(perfmon_numa_t);
+};
+
+static perfmon_numa_t pm_numa;
+static perfmon_membership_t pm_numa_membership(
+    &get_global_perfmon_collection(), &pm_numa, "system_numa");
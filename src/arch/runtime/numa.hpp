@@ -0,0 +1,42 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_NUMA_HPP_
+#define ARCH_RUNTIME_NUMA_HPP_
+
+#include <string>
+#include <vector>
+
+#include "errors.hpp"
+
+/* NUMA support without a dependency on libnuma.  The topology is read from
+`/sys/devices/system/node`.
+
+We don't place memory explicitly.  Instead, when threads are pinned, each one is
+pinned before it starts running, so that its event queue, coroutine stacks and the
+page cache of the stores on it are all first touched (and therefore allocated) on the
+NUMA node the thread runs on. */
+
+/* `get_numa_node_cpus()` returns the CPUs of each NUMA node that this process is
+allowed to run on (as reported by `sched_getaffinity()`), leaving out nodes that have
+none.  If the topology can't be read (or the platform has no NUMA support), all the
+allowed CPUs are reported as a single node. */
+std::vector<std::vector<int> > get_numa_node_cpus();
+
+/* Intersects each node's CPUs with `allowed_cpus` and drops the nodes that end up
+empty.  Both `allowed_cpus` and each node's CPUs have to be sorted. */
+std::vector<std::vector<int> > restrict_node_cpus(
+    const std::vector<std::vector<int> > &node_cpus,
+    const std::vector<int> &allowed_cpus);
+
+/* Parses a CPU list as found in `/sys/devices/system/node/node*\/cpulist`, such as
+"0-3,8-11".  Returns false if the list is malformed. */
+bool parse_cpu_list(const std::string &cpu_list, std::vector<int> *cpus_out);
+
+/* `assign_threads_to_cpus()` picks a CPU for each of `num_threads` threads.  The
+threads are split into contiguous blocks, one per NUMA node, with block sizes
+proportional to how many CPUs the node has.  Since the CPU shards of a table are
+spread over the threads, this spreads the CPU shards over the NUMA nodes, and keeps
+each thread on the same node as its memory. */
+std::vector<int> assign_threads_to_cpus(
+    int num_threads, const std::vector<std::vector<int> > &node_cpus);
+
+#endif  // ARCH_RUNTIME_NUMA_HPP_
@@ -8,8 +8,12 @@
 
 /* `run_in_thread_pool()` starts a RethinkDB thread pool, runs the given
 function in a coroutine inside of it, waits for the function to return, and then
-shuts down the thread pool. */
+shuts down the thread pool.  If `pin_threads` is true, each worker thread is pinned
+to a CPU, with consecutive threads kept on the same NUMA node.  If `busy_poll_usecs` is
+non-zero, the worker threads poll for that long before they block waiting for
+events. */
 
-void run_in_thread_pool(const std::function<void()> &fun, int worker_threads);
+void run_in_thread_pool(const std::function<void()> &fun, int worker_threads,
+                        bool pin_threads = false, int busy_poll_usecs = 0);
 
 #endif  // ARCH_RUNTIME_STARTER_HPP_
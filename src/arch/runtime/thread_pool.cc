@@ -10,11 +10,14 @@
 #include <sys/time.h>
 #endif
 
+#include <vector>
+
 #include "arch/compiler.hpp"
 #include "arch/barrier.hpp"
 #include "arch/os_signal.hpp"
 #include "arch/io/timer_provider.hpp"
 #include "arch/runtime/event_queue.hpp"
+#include "arch/runtime/numa.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/timing.hpp"
 #include "errors.hpp"
@@ -62,14 +65,16 @@ void linux_thread_pool_t::set_thread(linux_thread_t *val) {
     thread = val;
 }
 
-linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affinity) :
+linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affinity,
+                                         int64_t _busy_poll_nanos) :
 #ifndef NDEBUG
       coroutine_summary(false),
 #endif
       interrupt_message(nullptr),
       generic_blocker_pool(nullptr),
       n_threads(worker_threads + 1),    // we create an extra utility thread
-      do_set_affinity(_do_set_affinity)
+      do_set_affinity(_do_set_affinity),
+      busy_poll_nanos(_busy_poll_nanos)
 {
     rassert(n_threads > 1);             // we want at least one non-utility thread
     rassert(n_threads <= MAX_THREADS);
@@ -215,6 +220,15 @@ void linux_thread_pool_t::run_thread_pool(linux_thread_message_t *initial_messag
     // Start child threads
     thread_barrier_t barrier(n_threads + 1);
 
+#ifdef _GNU_SOURCE
+    // Consecutive db threads are kept on the same NUMA node.  The utility thread
+    // doesn't get pinned.
+    std::vector<int> thread_cpus;
+    if (do_set_affinity) {
+        thread_cpus = assign_threads_to_cpus(n_threads - 1, get_numa_node_cpus());
+    }
+#endif
+
     for (int i = 0; i < n_threads; i++) {
         bool is_utility_thread = (i == n_threads - 1);
         thread_data_t *tdata = new thread_data_t();
@@ -224,22 +238,47 @@ void linux_thread_pool_t::run_thread_pool(linux_thread_message_t *initial_messag
         // The initial message gets sent to the utility thread.
         tdata->initial_message = is_utility_thread ? initial_message : nullptr;
 
-        int res = pthread_create(&pthreads[i], nullptr, &start_thread, tdata);
-        guarantee_xerr(res == 0, res, "Could not create thread");
+        pthread_attr_t attr;
+        int res = pthread_attr_init(&attr);
+        guarantee_xerr(res == 0, res, "Could not initialize thread attributes");
 
-        // Don't set affinity for the utility thread
-        if (do_set_affinity && !is_utility_thread) {
-            // On Apple, the thread affinity API has awful documentation, so we don't even bother.
+        // On Apple, the thread affinity API has awful documentation, so we don't even
+        // bother.
+        bool pinned = false;
 #ifdef _GNU_SOURCE
-            // Distribute threads evenly among CPUs
-            int ncpus = get_cpu_count();
+        if (do_set_affinity && !is_utility_thread) {
+            // The affinity is set before the thread starts, so everything the thread
+            // allocates (its event queue, coroutine stacks and the page cache of the
+            // stores on it) is first touched on the thread's own NUMA node.
             cpu_set_t mask;
             CPU_ZERO(&mask);
-            CPU_SET(i % ncpus, &mask);
-            res = pthread_setaffinity_np(pthreads[i], sizeof(cpu_set_t), &mask);
-            guarantee_xerr(res == 0, res, "Could not set thread affinity");
+            CPU_SET(thread_cpus[i], &mask);
+            res = pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &mask);
+            if (res == 0) {
+                pinned = true;
+            } else {
+                logWRN("Could not pin thread %d to CPU %d (%s).  It will run unpinned.",
+                       i, thread_cpus[i], errno_string(res).c_str());
+            }
+        }
 #endif
+
+        res = pthread_create(&pthreads[i], &attr, &start_thread, tdata);
+        if (res != 0 && pinned) {
+            // The CPU may have gone offline or been taken away from us since we read
+            // the topology.  Pinning is only an optimization, so we carry on without.
+            logWRN("Could not start thread %d pinned to CPU %d (%s).  Starting it "
+                   "unpinned instead.", i, thread_cpus[i], errno_string(res).c_str());
+            res = pthread_attr_destroy(&attr);
+            guarantee_xerr(res == 0, res, "Could not destroy thread attributes");
+            res = pthread_attr_init(&attr);
+            guarantee_xerr(res == 0, res, "Could not initialize thread attributes");
+            res = pthread_create(&pthreads[i], &attr, &start_thread, tdata);
         }
+        guarantee_xerr(res == 0, res, "Could not create thread");
+
+        res = pthread_attr_destroy(&attr);
+        guarantee_xerr(res == 0, res, "Could not destroy thread attributes");
     }
 
     // Mark the main thread (for use in assertions etc.)
@@ -458,6 +497,9 @@ linux_thread_t::linux_thread_t(linux_thread_pool_t *parent_pool, int thread_id)
     : queue(this),
       message_hub(&queue, parent_pool, threadnum_t(thread_id)),
       timer_handler(&queue),
+      // The utility thread is mostly idle, so it's not worth spinning on.
+      busy_poll_nanos(thread_id == parent_pool->n_threads - 1
+                      ? 0 : parent_pool->busy_poll_nanos),
       do_shutdown(false)
 #ifndef NDEBUG
       , coroutine_counts_at_shutdown(NULL)
@@ -486,6 +528,17 @@ linux_thread_t::~linux_thread_t() {
 
 void linux_thread_t::pump() {
     message_hub.push_messages();
+    message_hub.check_incoming_before_waiting();
+}
+
+int64_t linux_thread_t::get_busy_poll_nanos() {
+    return busy_poll_nanos;
+}
+
+bool linux_thread_t::poll_messages() {
+    bool got_messages = message_hub.poll_incoming();
+    message_hub.push_messages();
+    return got_messages;
 }
 
 void linux_thread_t::on_event(int events) {
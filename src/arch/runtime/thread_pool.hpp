@@ -16,6 +16,7 @@
 #include "arch/runtime/coroutines.hpp"
 #include "arch/io/blocker_pool.hpp"
 #include "arch/io/timer_provider.hpp"
+#include "arch/spinlock.hpp"
 #include "arch/timer.hpp"
 
 class linux_thread_t;
@@ -41,7 +42,10 @@ and shutting down the threads and event queues. */
 
 class linux_thread_pool_t {
 public:
-    linux_thread_pool_t(int worker_threads, bool do_set_affinity);
+    /* If `busy_poll_nanos` is non-zero, the worker threads poll for events for that
+    long before they block, which trades CPU time for lower latency. */
+    linux_thread_pool_t(int worker_threads, bool do_set_affinity,
+                        int64_t busy_poll_nanos = 0);
 
     // When the process receives a SIGINT or SIGTERM, interrupt_message will be delivered to the
     // same thread that initial_message was delivered to, and interrupt_message will be set to
@@ -102,6 +106,7 @@ public:
 
     int n_threads;
     bool do_set_affinity;
+    int64_t busy_poll_nanos;
 
 #ifdef _WIN32
     static linux_thread_pool_t *get_global_thread_pool();
@@ -190,6 +195,8 @@ public:
 
     void pump();   // Called by the event queue
     bool should_shut_down();   // Called by the event queue
+    int64_t get_busy_poll_nanos();   // Called by the event queue
+    bool poll_messages();   // Called by the event queue
 #ifndef NDEBUG
     void initiate_shut_down(std::map<std::string, size_t> *coroutine_counts); // Can be called from any thread
 #else
@@ -198,6 +205,8 @@ public:
     void on_event(int events);
 
 private:
+    const int64_t busy_poll_nanos;
+
     volatile bool do_shutdown;
     pthread_mutex_t do_shutdown_mutex;
     system_event_t shutdown_notify_event;
@@ -7,68 +7,87 @@
 #include "time.hpp"
 #include "utils.hpp"
 
-class timer_token_t : public intrusive_priority_queue_node_t<timer_token_t> {
+// The resolution of the timer wheel.  Timers never fire early, but they might fire up
+// to this much late.
+const int64_t timer_wheel_tick_nanos = MILLION;
+
+class timer_token_t : public timer_wheel_entry_t {
     friend class timer_handler_t;
 
 private:
-    timer_token_t() : interval_nanos(-1), next_time_in_nanos(-1), callback(nullptr) { }
-
-    friend bool left_is_higher_priority(const timer_token_t *left, const timer_token_t *right);
+    timer_token_t() : interval_nanos(-1), callback(nullptr) { }
 
     // The time between rings, if a repeating timer, otherwise zero.
     int64_t interval_nanos;
 
-    // The time of the next 'ring'.
-    int64_t next_time_in_nanos;
-
     // The callback we call upon each 'ring'.
     timer_callback_t *callback;
 
     DISABLE_COPYING(timer_token_t);
 };
 
-bool left_is_higher_priority(const timer_token_t *left, const timer_token_t *right) {
-    return left->next_time_in_nanos < right->next_time_in_nanos;
+// The first tick of the wheel that is no earlier than `nanos`.
+static int64_t timer_wheel_tick_after(int64_t nanos) {
+    return (nanos + timer_wheel_tick_nanos - 1) / timer_wheel_tick_nanos;
 }
 
 timer_handler_t::timer_handler_t(linux_event_queue_t *queue)
     : timer_provider(queue),
-      expected_oneshot_time_in_nanos(0) {
+      expected_oneshot_time_in_nanos(0),
+      scheduled_wheel_tick(-1),
+      token_wheel(get_ticks() / timer_wheel_tick_nanos) {
     // Right now, we have no tokens.  So we don't ask the timer provider to do anything for us.
 }
 
 timer_handler_t::~timer_handler_t() {
-    guarantee(token_queue.empty());
+    guarantee(token_wheel.empty());
 }
 
 void timer_handler_t::on_oneshot() {
     // If the timer_provider tends to return its callback a touch early, we don't want to make a
     // bunch of calls to it, returning a tad early over and over again, leading up to a ticks
-    // threshold.  So we bump the real time up to the threshold when processing the priority queue.
+    // threshold.  So we bump the real time up to the threshold when processing timers.
     int64_t real_ticks = get_ticks();
     int64_t ticks = std::max(real_ticks, expected_oneshot_time_in_nanos);
-
-    while (!token_queue.empty() && token_queue.peek()->next_time_in_nanos <= ticks) {
-        timer_token_t *token = token_queue.pop();
-
-        // Put the repeating timer back on the queue before the callback can be called (so that it
-        // may be canceled).
-        if (token->interval_nanos != 0) {
-            token->next_time_in_nanos = real_ticks + token->interval_nanos;
-            token_queue.push(token);
+    const int64_t now_wheel_tick = ticks / timer_wheel_tick_nanos;
+    scheduled_wheel_tick = -1;
+
+    while (timer_wheel_entry_t *entry = token_wheel.pop_expired(now_wheel_tick)) {
+        timer_token_t *token = static_cast<timer_token_t *>(entry);
+        // The callback may cancel a repeating timer, so we can't look at the token
+        // afterwards.
+        const bool once = token->interval_nanos == 0;
+
+        // Put the repeating timer back on the wheel before the callback can be called
+        // (so that it may be canceled).
+        if (!once) {
+            token_wheel.insert(token, std::max(now_wheel_tick + 1,
+                timer_wheel_tick_after(real_ticks + token->interval_nanos)));
         }
 
         token->callback->on_timer();
 
         // Delete nonrepeating timer tokens.
-        if (token->interval_nanos == 0) {
+        if (once) {
             delete token;
         }
     }
 
     // We've processed young tokens.  Now schedule a new one-shot (if necessary).
-    if (!token_queue.empty()) {
-        timer_provider.schedule_oneshot(token_queue.peek()->next_time_in_nanos, this);
+    schedule_oneshot();
+}
+
+void timer_handler_t::schedule_oneshot() {
+    if (token_wheel.empty()) {
+        return;
+    }
+    // The next event might be earlier than any expiry time, when the wheel needs to
+    // cascade entries.
+    const int64_t wheel_tick = token_wheel.next_event_tick();
+    if (wheel_tick != scheduled_wheel_tick) {
+        expected_oneshot_time_in_nanos = wheel_tick * timer_wheel_tick_nanos;
+        timer_provider.schedule_oneshot(expected_oneshot_time_in_nanos, this);
+        scheduled_wheel_tick = wheel_tick;
     }
 }
 
@@ -80,25 +99,23 @@ timer_token_t *timer_handler_t::add_timer_internal(const int64_t ms, timer_callb
 
     timer_token_t *const token = new timer_token_t;
     token->interval_nanos = once ? 0 : nanos;
-    token->next_time_in_nanos = next_time_in_nanos;
     token->callback = callback;
 
-    const timer_token_t *top_entry = token_queue.peek();
-    token_queue.push(token);
-
-    if (top_entry == nullptr || next_time_in_nanos < top_entry->next_time_in_nanos) {
-        timer_provider.schedule_oneshot(next_time_in_nanos, this);
-    }
+    token_wheel.insert(token, timer_wheel_tick_after(next_time_in_nanos));
+    schedule_oneshot();
 
     return token;
 }
 
 void timer_handler_t::cancel_timer(timer_token_t *token) {
-    token_queue.remove(token);
+    token_wheel.remove(token);
     delete token;
 
-    if (token_queue.empty()) {
+    // If there are other timers left, the one-shot stays as it is.  At worst it wakes
+    // us up for nothing.
+    if (token_wheel.empty()) {
         timer_provider.unschedule_oneshot();
+        scheduled_wheel_tick = -1;
     }
 }
 
@@ -2,8 +2,8 @@
 #ifndef ARCH_TIMER_HPP_
 #define ARCH_TIMER_HPP_
 
-#include "containers/intrusive_priority_queue.hpp"
 #include "arch/io/timer_provider.hpp"
+#include "containers/timer_wheel.hpp"
 
 class timer_token_t;
 
@@ -26,6 +26,7 @@ public:
 
 private:
     void on_oneshot();
+    void schedule_oneshot();
 
     // The timer provider, a platform-dependent typedef for interfacing with the OS.
     timer_provider_t timer_provider;
@@ -34,8 +35,12 @@ private:
     // than this time, we pretend that it had arrived on time.
     int64_t expected_oneshot_time_in_nanos;
 
-    // A priority queue of timer tokens, ordered by the soonest.
-    intrusive_priority_queue_t<timer_token_t> token_queue;
+    // The tick of the wheel at which the timer provider will call us next, or -1.
+    int64_t scheduled_wheel_tick;
+
+    // The timer tokens.  Their expiry times are rounded up to whole milliseconds, so
+    // that inserting and canceling timers takes constant time.
+    timer_wheel_t token_wheel;
 
     DISABLE_COPYING(timer_handler_t);
 };
@@ -2,6 +2,7 @@
 
 #include "arch/runtime/coroutines.hpp"
 #include "buffer_cache/page_cache.hpp"
+#include "perfmon/load_signals.hpp"
 #include "serializer/serializer.hpp"
 
 namespace alt {
@@ -415,9 +416,13 @@ void page_t::add_waiter(page_acq_t *acq, cache_account_t *account) {
         = acq->page_cache()->evicter().correct_eviction_category(this);
     waiters_.push_front(acq);
     acq->page_cache()->evicter().change_to_correct_eviction_bag(old_bag, this);
+    get_cache_page_acquisitions()->add(1);
     if (buf_.has()) {
         acq->buf_ready_signal_.pulse();
-    } else if (loader_ != nullptr) {
+        return;
+    }
+    get_cache_page_misses()->add(1);
+    if (loader_ != nullptr) {
         loader_->added_waiter(acq->page_cache(), account);
     } else if (block_token_.has()) {
         coro_t::spawn_now_dangerously(std::bind(&page_t::load_using_block_token,
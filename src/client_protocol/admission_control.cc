@@ -0,0 +1,224 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "client_protocol/admission_control.hpp"
+
+#include <algorithm>
+
+#include "arch/timing.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/interruptor.hpp"
+#include "concurrency/wait_any.hpp"
+#include "containers/intrusive_list.hpp"
+#include "perfmon/load_signals.hpp"
+#include "time.hpp"
+
+// How often every thread re-estimates the load and releases queued queries.
+const int64_t ADMISSION_TICK_MS = 50;
+
+// Each of the load signals is divided by its limit, and the node counts as saturated
+// once any of the results reaches 1.
+const double EVENT_LOOP_LAG_LIMIT_MS = 50.0;
+const double DISK_OPS_IN_FLIGHT_LIMIT = 512.0;
+const double CACHE_MISS_RATIO_LIMIT = 0.5;
+
+// Below this many page acquisitions in a tick, the miss ratio says too little to act on.
+const int64_t MIN_CACHE_ACQUISITIONS_PER_TICK = 100;
+
+// The most queries that wait to be admitted on each thread.
+const size_t MAX_QUEUED_QUERIES_PER_THREAD = 1000;
+
+// The number of queued queries released per tick grows by this much while the node
+// isn't saturated, and is halved while it is.
+const size_t RELEASE_RATE_INCREASE = 16;
+const size_t MAX_RELEASE_RATE = 4096;
+
+static bool parse_query_priority(const std::string &str, query_priority_t *out) {
+    if (str == "high") {
+        *out = query_priority_t::HIGH;
+    } else if (str == "normal") {
+        *out = query_priority_t::NORMAL;
+    } else if (str == "low") {
+        *out = query_priority_t::LOW;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool query_priority_rules_t::add_rule(const std::string &rule,
+                                      std::string *error_out) {
+    size_t colon = rule.find(':');
+    size_t equals = rule.rfind('=');
+    if (colon == std::string::npos || equals == std::string::npos
+        || equals <= colon + 1) {
+        *error_out = strprintf("Invalid query priority rule `%s`.  Expected "
+                               "`user:<name>=<priority>` or `db:<name>=<priority>`.",
+                               rule.c_str());
+        return false;
+    }
+    std::string kind = rule.substr(0, colon);
+    std::string name = rule.substr(colon + 1, equals - colon - 1);
+    query_priority_t priority;
+    if (!parse_query_priority(rule.substr(equals + 1), &priority)) {
+        *error_out = strprintf("Invalid priority in query priority rule `%s`.  "
+                               "Expected `high`, `normal` or `low`.", rule.c_str());
+        return false;
+    }
+    if (kind == "user") {
+        user_rules[name] = priority;
+    } else if (kind == "db") {
+        db_rules[name] = priority;
+    } else {
+        *error_out = strprintf("Invalid query priority rule `%s`.  Rules must start "
+                               "with `user:` or `db:`.", rule.c_str());
+        return false;
+    }
+    return true;
+}
+
+query_priority_t query_priority_rules_t::classify(
+        const std::string &user, const optional<std::string> &db) const {
+    auto user_it = user_rules.find(user);
+    if (user_it != user_rules.end()) {
+        return user_it->second;
+    }
+    if (db) {
+        auto db_it = db_rules.find(*db);
+        if (db_it != db_rules.end()) {
+            return db_it->second;
+        }
+    }
+    return query_priority_t::NORMAL;
+}
+
+class admission_controller_t::waiter_t : public intrusive_list_node_t<waiter_t> {
+public:
+    cond_t admitted;
+};
+
+class admission_controller_t::thread_state_t {
+public:
+    thread_state_t() :
+        lag_ms(0.0),
+        saturated(false),
+        release_rate(RELEASE_RATE_INCREASE),
+        last_tick(get_ticks()),
+        last_acquisitions(get_cache_page_acquisitions()->get_total()),
+        last_misses(get_cache_page_misses()->get_total()),
+        timer(ADMISSION_TICK_MS, [this]() { on_tick(); }) { }
+
+    ~thread_state_t() {
+        // Anything still waiting gets in; the server is going away anyway.
+        while (!queue.empty()) {
+            waiter_t *waiter = queue.head();
+            queue.pop_front();
+            waiter->admitted.pulse();
+        }
+    }
+
+    void on_tick() {
+        // The timer rings late by however long the event loop was busy with other
+        // things, so the delay is a direct measure of how far behind this thread is.
+        ticks_t now = get_ticks();
+        double late_ms = ticks_to_secs(now - last_tick) * 1000.0 - ADMISSION_TICK_MS;
+        last_tick = now;
+        lag_ms = 0.8 * lag_ms + 0.2 * std::max(0.0, late_ms);
+
+        int64_t acquisitions = get_cache_page_acquisitions()->get_total();
+        int64_t misses = get_cache_page_misses()->get_total();
+        double miss_ratio = 0.0;
+        if (acquisitions - last_acquisitions >= MIN_CACHE_ACQUISITIONS_PER_TICK) {
+            miss_ratio = static_cast<double>(misses - last_misses)
+                / static_cast<double>(acquisitions - last_acquisitions);
+        }
+        last_acquisitions = acquisitions;
+        last_misses = misses;
+
+        double load = std::max(
+            lag_ms / EVENT_LOOP_LAG_LIMIT_MS,
+            std::max(get_disk_ops_in_flight()->get_total() / DISK_OPS_IN_FLIGHT_LIMIT,
+                     miss_ratio / CACHE_MISS_RATIO_LIMIT));
+        saturated.set_value(load >= 1.0);
+
+        if (saturated.get()) {
+            release_rate = std::max<size_t>(1, release_rate / 2);
+        } else {
+            release_rate = std::min(MAX_RELEASE_RATE,
+                                    release_rate + RELEASE_RATE_INCREASE);
+        }
+        for (size_t i = 0; i < release_rate && !queue.empty(); ++i) {
+            waiter_t *waiter = queue.head();
+            queue.pop_front();
+            waiter->admitted.pulse();
+        }
+    }
+
+    double lag_ms;
+    watchable_variable_t<bool> saturated;
+    size_t release_rate;
+    ticks_t last_tick;
+    int64_t last_acquisitions;
+    int64_t last_misses;
+    intrusive_list_t<waiter_t> queue;
+
+    // This must be destroyed first, so that it doesn't ring during destruction.
+    repeating_timer_t timer;
+
+    DISABLE_COPYING(thread_state_t);
+};
+
+admission_controller_t::admission_controller_t(const admission_config_t &config,
+                                               perfmon_collection_t *parent_stats) :
+    priority_rules(config.priority_rules),
+    max_queue_wait_ms(config.max_queue_wait_ms),
+    stats_membership(parent_stats, &stats_collection, "admission_control"),
+    queued_membership(&stats_collection, &queued, "queries_queued"),
+    rejected_membership(&stats_collection, &rejected, "queries_rejected") { }
+
+admission_controller_t::~admission_controller_t() { }
+
+query_priority_t admission_controller_t::classify(
+        const std::string &user, const optional<std::string> &db) const {
+    return priority_rules.classify(user, db);
+}
+
+clone_ptr_t<watchable_t<bool> > admission_controller_t::get_saturated() {
+    return thread_states.get()->saturated.get_watchable();
+}
+
+bool admission_controller_t::admit(query_priority_t priority, signal_t *interruptor) {
+    if (priority == query_priority_t::HIGH) {
+        return true;
+    }
+
+    thread_state_t *state = thread_states.get();
+    // Queries don't get to jump the queue just because the load dropped for a moment.
+    bool saturated = state->saturated.get();
+    if (!saturated && state->queue.empty()) {
+        return true;
+    }
+    if ((priority == query_priority_t::LOW && saturated)
+        || state->queue.size() >= MAX_QUEUED_QUERIES_PER_THREAD) {
+        ++rejected;
+        return false;
+    }
+
+    ++queued;
+    waiter_t waiter;
+    state->queue.push_back(&waiter);
+    signal_timer_t timeout(max_queue_wait_ms);
+    wait_any_t admitted_or_timeout(&waiter.admitted, &timeout);
+    try {
+        wait_interruptible(&admitted_or_timeout, interruptor);
+    } catch (const interrupted_exc_t &) {
+        if (waiter.in_a_list()) {
+            state->queue.remove(&waiter);
+        }
+        throw;
+    }
+    if (waiter.admitted.is_pulsed()) {
+        return true;
+    }
+    state->queue.remove(&waiter);
+    ++rejected;
+    return false;
+}
@@ -0,0 +1,95 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLIENT_PROTOCOL_ADMISSION_CONTROL_HPP_
+#define CLIENT_PROTOCOL_ADMISSION_CONTROL_HPP_
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+
+#include "concurrency/one_per_thread.hpp"
+#include "concurrency/watchable.hpp"
+#include "containers/optional.hpp"
+#include "perfmon/perfmon.hpp"
+
+enum class query_priority_t {
+    HIGH,
+    NORMAL,
+    LOW
+};
+
+/* `query_priority_rules_t` assigns queries to a priority class by the user that runs
+them or by their default database.  A rule for the user takes precedence over a rule
+for the database; queries that no rule matches are `NORMAL`. */
+class query_priority_rules_t {
+public:
+    /* Parses a rule of the form `user:<name>=<priority>` or `db:<name>=<priority>`,
+    where `<priority>` is one of `high`, `normal` or `low`.  Returns `false` and sets
+    `error_out` if the rule is malformed. */
+    bool add_rule(const std::string &rule, std::string *error_out);
+
+    query_priority_t classify(const std::string &user,
+                              const optional<std::string> &db) const;
+
+private:
+    std::map<std::string, query_priority_t> user_rules;
+    std::map<std::string, query_priority_t> db_rules;
+};
+
+class admission_config_t {
+public:
+    admission_config_t() : enabled(false), max_queue_wait_ms(5000) { }
+
+    bool enabled;
+    query_priority_rules_t priority_rules;
+    /* How long a query may wait in the queue before it's rejected. */
+    int64_t max_queue_wait_ms;
+};
+
+/* `admission_controller_t` decides whether the server is too busy to start a new
+query.  Every thread estimates how saturated the node is from its own event loop lag
+and from the node-wide disk queue depth and buffer cache miss rate (see
+`perfmon/load_signals.hpp`).  While the node is saturated, `LOW` priority queries are
+rejected right away and `NORMAL` priority queries wait in a bounded queue, which is
+drained at a rate that backs off while the node stays saturated.  `HIGH` priority
+queries are always admitted.
+
+A rejected query should fail with a retryable error, so that the client can back off
+and try again instead of piling on. */
+class admission_controller_t {
+public:
+    admission_controller_t(const admission_config_t &config,
+                           perfmon_collection_t *parent_stats);
+    ~admission_controller_t();
+
+    query_priority_t classify(const std::string &user,
+                              const optional<std::string> &db) const;
+
+    /* Blocks until the query may run, and returns `true`; or returns `false` if the
+    query should be rejected.  May throw `interrupted_exc_t`. */
+    bool admit(query_priority_t priority, signal_t *interruptor);
+
+    /* Whether the current thread counts the node as saturated as of its last load
+    estimate. */
+    clone_ptr_t<watchable_t<bool> > get_saturated();
+
+private:
+    class waiter_t;
+    class thread_state_t;
+
+    const query_priority_rules_t priority_rules;
+    const int64_t max_queue_wait_ms;
+
+    perfmon_collection_t stats_collection;
+    perfmon_membership_t stats_membership;
+    perfmon_counter_t queued;
+    perfmon_membership_t queued_membership;
+    perfmon_counter_t rejected;
+    perfmon_membership_t rejected_membership;
+
+    one_per_thread_t<thread_state_t> thread_states;
+
+    DISABLE_COPYING(admission_controller_t);
+};
+
+#endif  // CLIENT_PROTOCOL_ADMISSION_CONTROL_HPP_
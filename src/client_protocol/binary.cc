@@ -0,0 +1,121 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "client_protocol/binary.hpp"
+
+#include "arch/io/network.hpp"
+#include "client_protocol/client_server_error.hpp"
+#include "client_protocol/protocols.hpp"
+#include "containers/archive/archive.hpp"
+#include "containers/buffer_group.hpp"
+#include "containers/chunked_string_buffer.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/ql2.pb.h"
+#include "rdb_protocol/rdb_backtrace.hpp"
+#include "rdb_protocol/query_params.hpp"
+#include "rdb_protocol/response.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
+#include "rdb_protocol/term_storage.hpp"
+
+bool binary_protocol_t::parse_result_format(const ql::datum_t &handshake_message) {
+    ql::datum_t result_format =
+        handshake_message.get_field("result_format", ql::NOTHROW);
+    if (!result_format.has()) {
+        return false;
+    }
+    if (result_format.get_type() != ql::datum_t::R_STR) {
+        throw client_protocol::client_server_error_t(
+            6, "Expected a string for `result_format`.");
+    }
+    if (result_format.as_str() == "binary") {
+        return true;
+    } else if (result_format.as_str() == "json") {
+        return false;
+    } else {
+        throw client_protocol::client_server_error_t(
+            6, "Unsupported `result_format`.");
+    }
+}
+
+scoped_ptr_t<ql::query_params_t> binary_protocol_t::parse_query(
+        tcp_conn_t *conn,
+        signal_t *interruptor,
+        ql::query_cache_t *query_cache) {
+    return json_protocol_t::read_query(conn, interruptor, query_cache,
+                                       &binary_protocol_t::send_response);
+}
+
+static ql::datum_t response_to_datum(ql::response_t *response) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("t", ql::datum_t(static_cast<double>(response->type())));
+    if (response->type() == Response::RUNTIME_ERROR &&
+        response->error_type()) {
+        builder.overwrite("e",
+                          ql::datum_t(static_cast<double>(*response->error_type())));
+    }
+    // The data vector is copied here, but that only copies the references to the
+    // rows, not the rows themselves.
+    std::vector<ql::datum_t> data = response->data();
+    builder.overwrite("r", ql::datum_t(std::move(data),
+        ql::datum_t::no_array_size_limit_check_t()));
+    if (response->backtrace()) {
+        builder.overwrite("b", *response->backtrace());
+    }
+    if (response->profile()) {
+        builder.overwrite("p", *response->profile());
+    }
+    if (response->type() == Response::SUCCESS_PARTIAL ||
+        response->type() == Response::SUCCESS_SEQUENCE) {
+        std::vector<ql::datum_t> notes;
+        notes.reserve(response->notes().size());
+        for (const auto &note : response->notes()) {
+            notes.push_back(ql::datum_t(static_cast<double>(note)));
+        }
+        builder.overwrite("n", ql::datum_t(std::move(notes),
+            ql::datum_t::no_array_size_limit_check_t()));
+    }
+    return std::move(builder).to_datum();
+}
+
+void binary_protocol_t::serialize_response(ql::response_t *response,
+                                           int64_t token,
+                                           chunked_string_buffer_t *buffer_out) {
+    write_message_t wm;
+    // The result is ignored because responses are allowed to contain arrays that
+    // would be too large to write to disk, as well as `r.minval` and `r.maxval`.
+    datum_serialize(&wm, response_to_datum(response),
+                    ql::check_datum_serialization_errors_t::NO);
+    size_t payload_size = wm.size();
+
+    if (payload_size >= wire_protocol_t::TOO_LARGE_RESPONSE_SIZE) {
+        response->fill_error(Response::RUNTIME_ERROR,
+                             Response::RESOURCE_LIMIT,
+                             wire_protocol_t::too_large_response_message(payload_size),
+                             ql::backtrace_registry_t::EMPTY_BACKTRACE);
+        serialize_response(response, token, buffer_out);
+        return;
+    }
+
+    uint32_t data_size = static_cast<uint32_t>(payload_size);
+#ifdef __s390x__
+    token = __builtin_bswap64(token);
+    data_size = __builtin_bswap32(data_size);
+#endif
+    buffer_out->append(reinterpret_cast<const char *>(&token), sizeof(token));
+    buffer_out->append(reinterpret_cast<const char *>(&data_size), sizeof(data_size));
+
+    intrusive_list_t<write_buffer_t> *list = wm.unsafe_expose_buffers();
+    for (write_buffer_t *p = list->head(); p != nullptr; p = list->next(p)) {
+        buffer_out->append(p->data, p->size);
+    }
+}
+
+void binary_protocol_t::send_response(ql::response_t *response,
+                                      int64_t token,
+                                      tcp_conn_t *conn,
+                                      signal_t *interruptor) {
+    chunked_string_buffer_t buffer;
+    serialize_response(response, token, &buffer);
+
+    const_buffer_group_t buffers;
+    buffer.append_to_group(&buffers);
+    conn->write(&buffers, interruptor);
+}
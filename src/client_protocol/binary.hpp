@@ -0,0 +1,50 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLIENT_PROTOCOL_BINARY_HPP_
+#define CLIENT_PROTOCOL_BINARY_HPP_
+
+#include <stdint.h>
+
+#include "arch/types.hpp"
+#include "containers/scoped.hpp"
+
+class chunked_string_buffer_t;
+class signal_t;
+
+namespace ql {
+class datum_t;
+class response_t;
+class query_cache_t;
+class query_params_t;
+}
+
+// Queries are read exactly as in `json_protocol_t`, but responses are sent in the
+// stable datum serialization format of `rdb_protocol/serialize_datum.hpp` rather
+// than as JSON.  Clients opt into this during the V1_0 handshake by passing
+// `"result_format": "binary"`.  Each response is framed like a JSON response (an
+// 8-byte token and a 4-byte size, both little-endian) and the payload is a
+// serialized object with the same `t`, `e`, `r`, `b`, `p` and `n` fields as the
+// JSON response.  Rows that are still backed by their on-disk serialization are
+// copied into the response as they are, without being decoded first.
+class binary_protocol_t {
+public:
+    // Returns whether the first V1_0 handshake message asks for binary responses.
+    // Throws `client_protocol::client_server_error_t` if its `result_format` field
+    // isn't "json" or "binary".
+    static bool parse_result_format(const ql::datum_t &handshake_message);
+
+    static scoped_ptr_t<ql::query_params_t> parse_query(tcp_conn_t *conn,
+                                                        signal_t *interruptor,
+                                                        ql::query_cache_t *query_cache);
+
+    // Appends the response, including the token and size prefix, to `buffer_out`.
+    static void serialize_response(ql::response_t *response,
+                                   int64_t token,
+                                   chunked_string_buffer_t *buffer_out);
+
+    static void send_response(ql::response_t *response,
+                              int64_t token,
+                              tcp_conn_t *conn,
+                              signal_t *interruptor);
+};
+
+#endif // CLIENT_PROTOCOL_BINARY_HPP_
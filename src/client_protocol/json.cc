@@ -5,6 +5,8 @@
 #include "arch/timing.hpp"
 #include "client_protocol/protocols.hpp"
 #include "concurrency/pmap.hpp"
+#include "containers/buffer_group.hpp"
+#include "containers/chunked_string_buffer.hpp"
 #include "containers/scoped.hpp"
 #include "rapidjson/document.h"
 #include "rapidjson/stringbuffer.h"
@@ -49,6 +51,14 @@ scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query(
         tcp_conn_t *conn,
         signal_t *interruptor,
         ql::query_cache_t *query_cache) {
+    return read_query(conn, interruptor, query_cache, &json_protocol_t::send_response);
+}
+
+scoped_ptr_t<ql::query_params_t> json_protocol_t::read_query(
+        tcp_conn_t *conn,
+        signal_t *interruptor,
+        ql::query_cache_t *query_cache,
+        send_response_fn_t send_error) {
     int64_t token;
     uint32_t size;
     conn->read_buffered(&token, sizeof(token), interruptor);
@@ -75,7 +85,7 @@ scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query(
             conn->pop(size, &pop_interruptor);
         }
 
-        send_response(&error, token, conn, interruptor);
+        send_error(&error, token, conn, interruptor);
         throw tcp_conn_read_closed_exc_t();
     }
 
@@ -91,15 +101,26 @@ scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query(
         parse_query_from_buffer(std::move(data), 0, query_cache, token, &error);
 
     if (!res.has()) {
-        send_response(&error, token, conn, interruptor);
+        send_error(&error, token, conn, interruptor);
     }
     return res;
 }
 
+void splice_array(rapidjson::Writer<rapidjson::StringBuffer> *writer,
+                  rapidjson::StringBuffer *buffer) {
+    writer->SpliceArray(*buffer);
+}
+
+void splice_array(rapidjson::Writer<chunked_string_buffer_t> *writer,
+                  chunked_string_buffer_t *buffer) {
+    writer->SpliceChunkedArray(buffer);
+}
+
+template <class buffer_t>
 void write_response_internal(ql::response_t *response,
-                             rapidjson::StringBuffer *buffer_out,
+                             buffer_t *buffer_out,
                              bool throw_errors) {
-    rapidjson::Writer<rapidjson::StringBuffer> writer(*buffer_out);
+    rapidjson::Writer<buffer_t> writer(*buffer_out);
     size_t start_offset = buffer_out->GetSize();
 
     try {
@@ -118,16 +139,15 @@ void write_response_internal(ql::response_t *response,
         if (response->data().size() > PARALLELIZATION_THRESHOLD) {
             int64_t num_threads = std::min<int64_t>(16, get_num_db_threads());
             int32_t thread_offset = get_thread_id().threadnum;
-            std::vector<rapidjson::StringBuffer> buffers(num_threads);
+            std::vector<buffer_t> buffers(num_threads);
 
             size_t per_thread = response->data().size() / num_threads;
             pmap(num_threads, [&](int64_t m) {
                     int32_t target_thread =
                         (thread_offset + static_cast<int32_t>(m)) % get_num_db_threads();
                     on_thread_t rethreader((threadnum_t(target_thread)));
-                    rapidjson::StringBuffer *thread_buffer = &buffers[m];
-                    rapidjson::Writer<rapidjson::StringBuffer>
-                        thread_writer(*thread_buffer);
+                    buffer_t *thread_buffer = &buffers[m];
+                    rapidjson::Writer<buffer_t> thread_writer(*thread_buffer);
 
                     thread_writer.StartArray();
                     size_t offset = per_thread * m;
@@ -145,8 +165,8 @@ void write_response_internal(ql::response_t *response,
                     thread_writer.EndArray();
                 });
 
-            for (const auto &buffer : buffers) {
-                writer.SpliceArray(buffer);
+            for (auto &buffer : buffers) {
+                splice_array(&writer, &buffer);
             }
         } else {
             for (const auto &item : response->data()) {
@@ -192,8 +212,8 @@ void write_response_internal(ql::response_t *response,
 }
 
 // Small wrapper - in debug mode we would rather crash than send the error back
-void json_protocol_t::write_response_to_buffer(ql::response_t *response,
-                                               rapidjson::StringBuffer *buffer_out) {
+template <class buffer_t>
+void write_response_checked(ql::response_t *response, buffer_t *buffer_out) {
 #ifdef NDEBUG
     write_response_internal(response, buffer_out, false);
 #else
@@ -201,19 +221,25 @@ void json_protocol_t::write_response_to_buffer(ql::response_t *response,
 #endif
 }
 
-void json_protocol_t::send_response(ql::response_t *response,
-                                    int64_t token,
-                                    tcp_conn_t *conn,
-                                    signal_t *interruptor) {
+void json_protocol_t::write_response_to_buffer(ql::response_t *response,
+                                               rapidjson::StringBuffer *buffer_out) {
+    write_response_checked(response, buffer_out);
+}
+
+void json_protocol_t::serialize_response(ql::response_t *response,
+                                         int64_t token,
+                                         chunked_string_buffer_t *buffer_out) {
     uint32_t data_size; // filled in below
     const size_t prefix_size = sizeof(token) + sizeof(data_size);
 
-    // Reserve space for the token and the size
-    rapidjson::StringBuffer buffer;
-    buffer.Push(prefix_size);
+    // Reserve space for the token and the size.  The response is serialized into
+    // fixed-size chunks which are handed to the connection as they are, so large
+    // responses are never copied into one contiguous buffer.
+    size_t start_offset = buffer_out->GetSize();
+    char *prefix_buffer = buffer_out->Push(prefix_size);
 
-    write_response_to_buffer(response, &buffer);
-    int64_t payload_size = buffer.GetSize() - prefix_size;
+    write_response_checked(response, buffer_out);
+    int64_t payload_size = buffer_out->GetSize() - start_offset - prefix_size;
     guarantee(payload_size > 0);
 
     static_assert(std::is_same<decltype(wire_protocol_t::TOO_LARGE_RESPONSE_SIZE),
@@ -221,16 +247,17 @@ void json_protocol_t::send_response(ql::response_t *response,
                   "The largest response must fit in 32 bits.");
 
     if (payload_size >= wire_protocol_t::TOO_LARGE_RESPONSE_SIZE) {
+        buffer_out->Pop(buffer_out->GetSize() - start_offset);
         response->fill_error(Response::RUNTIME_ERROR,
                              Response::RESOURCE_LIMIT,
                              wire_protocol_t::too_large_response_message(payload_size),
                              ql::backtrace_registry_t::EMPTY_BACKTRACE);
-        send_response(response, token, conn, interruptor);
+        serialize_response(response, token, buffer_out);
         return;
     }
 
     // Fill in the token and size
-    char *mutable_buffer = buffer.GetMutableBuffer();
+    char *mutable_buffer = prefix_buffer;
 #ifdef __s390x__
     token = __builtin_bswap64(token);
 #endif
@@ -246,7 +273,16 @@ void json_protocol_t::send_response(ql::response_t *response,
         mutable_buffer[i + sizeof(token)] =
             reinterpret_cast<const char *>(&data_size)[i];
     }
-
-    conn->write(buffer.GetString(), buffer.GetSize(), interruptor);
 }
 
+void json_protocol_t::send_response(ql::response_t *response,
+                                    int64_t token,
+                                    tcp_conn_t *conn,
+                                    signal_t *interruptor) {
+    chunked_string_buffer_t buffer;
+    serialize_response(response, token, &buffer);
+
+    const_buffer_group_t buffers;
+    buffer.append_to_group(&buffers);
+    conn->write(&buffers, interruptor);
+}
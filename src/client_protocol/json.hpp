@@ -8,6 +8,7 @@
 #include "containers/scoped.hpp"
 #include "rapidjson/stringbuffer.h"
 
+class chunked_string_buffer_t;
 class signal_t;
 
 namespace ql {
@@ -29,10 +30,27 @@ public:
                                                         signal_t *interruptor,
                                                         ql::query_cache_t *query_cache);
 
+    // Reads a query from the connection like `parse_query`, but reports errors
+    // through `send_error`.  This lets protocols that only differ in how they
+    // encode responses share the query parsing.
+    typedef void (*send_response_fn_t)(ql::response_t *response,
+                                       int64_t token,
+                                       tcp_conn_t *conn,
+                                       signal_t *interruptor);
+    static scoped_ptr_t<ql::query_params_t> read_query(tcp_conn_t *conn,
+                                                       signal_t *interruptor,
+                                                       ql::query_cache_t *query_cache,
+                                                       send_response_fn_t send_error);
+
     // Used by the HTTP ReQL server to write the query response into the HTTP response
     static void write_response_to_buffer(ql::response_t *response,
                                          rapidjson::StringBuffer *buffer_out);
 
+    // Appends the response, including the token and size prefix, to `buffer_out`.
+    static void serialize_response(ql::response_t *response,
+                                   int64_t token,
+                                   chunked_string_buffer_t *buffer_out);
+
     static void send_response(ql::response_t *response,
                               int64_t token,
                               tcp_conn_t *conn,
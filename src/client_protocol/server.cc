@@ -27,7 +27,11 @@
 #include "clustering/administration/metadata.hpp"
 #include "concurrency/coro_pool.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/new_mutex.hpp"
+#include "concurrency/new_semaphore.hpp"
 #include "concurrency/queue/limited_fifo.hpp"
+#include "containers/buffer_group.hpp"
+#include "containers/chunked_string_buffer.hpp"
 #include "crypto/error.hpp"
 #include "perfmon/perfmon.hpp"
 #include "rapidjson/document.h"
@@ -191,13 +195,19 @@ query_server_t::query_server_t(rdb_context_t *_rdb_ctx,
                                int port,
                                query_handler_t *_handler,
                                uint32_t http_timeout_sec,
-                               tls_ctx_t *_tls_ctx) :
+                               tls_ctx_t *_tls_ctx,
+                               const admission_config_t &admission_config) :
         tls_ctx(_tls_ctx),
         rdb_ctx(_rdb_ctx),
         handler(_handler),
         http_conn_cache(http_timeout_sec),
-        next_thread(0) {
+        next_thread(0),
+        next_connection_id(0) {
     rassert(rdb_ctx != nullptr);
+    if (admission_config.enabled) {
+        admission_controller.init(new admission_controller_t(
+            admission_config, &rdb_ctx->stats.qe_stats_collection));
+    }
     try {
         tcp_listener.init(new tcp_listener_t(local_addresses, port,
             std::bind(&query_server_t::handle_conn,
@@ -253,6 +263,7 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
                                  auto_drainer_t::lock_t keepalive) {
     threadnum_t chosen_thread = threadnum_t(next_thread);
     next_thread = (next_thread + 1) % get_num_db_threads();
+    uint64_t connection_id = next_connection_id++;
 
     cross_thread_signal_t ct_keepalive(keepalive.get_drain_signal(), chosen_thread);
     on_thread_t rethreader(chosen_thread);
@@ -271,6 +282,7 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
     }
 
     uint8_t version = 0;
+    bool binary_results = false;
     std::unique_ptr<auth::base_authenticator_t> authenticator;
     uint32_t error_code = 0;
     std::string error_message;
@@ -409,12 +421,22 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
                         5, "Expected a string for `authentication`.");
                 }
 
+                // `result_format` is optional, and older servers ignore it.  That's
+                // why we echo it back below, so a client only switches to decoding
+                // binary responses once the server has confirmed it.
+                binary_results = binary_protocol_t::parse_result_format(datum);
+                ql::datum_t result_format =
+                    datum.get_field("result_format", ql::NOTHROW);
+
                 ql::datum_object_builder_t datum_object_builder;
                 datum_object_builder.overwrite("success", ql::datum_t::boolean(true));
                 datum_object_builder.overwrite(
                     "authentication",
                     ql::datum_t(
                         authenticator->next_message(authentication.as_str().to_std())));
+                if (result_format.has()) {
+                    datum_object_builder.overwrite("result_format", result_format);
+                }
 
                 write_datum(
                     conn.get(),
@@ -458,13 +480,19 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
                 : ql::return_empty_normal_batches_t::NO,
             auth::user_context_t(authenticator->get_authenticated_username()));
 
-        connection_loop<json_protocol_t>(
-            conn.get(),
-            (version < 4)
-                ? 1
-                : 1024,
-            &query_cache,
-            &ct_keepalive);
+        if (binary_results) {
+            connection_loop<binary_protocol_t>(
+                conn.get(), connection_id, 1024, &query_cache, &ct_keepalive);
+        } else {
+            connection_loop<json_protocol_t>(
+                conn.get(),
+                connection_id,
+                (version < 4)
+                    ? 1
+                    : 1024,
+                &query_cache,
+                &ct_keepalive);
+        }
     } catch (client_protocol::client_server_error_t const &error) {
         // We can't write the response here due to coroutine switching inside an
         // exception handler
@@ -542,6 +570,18 @@ void query_server_t::make_error_response(bool is_draining,
     }
 }
 
+bool query_server_t::admit_query(ql::query_params_t *query, signal_t *interruptor) {
+    // Only new queries are throttled.  Continuing or stopping a query that is already
+    // running doesn't add any load, and makes room for the queries that are waiting.
+    if (!admission_controller.has() || query->type != Query::START) {
+        return true;
+    }
+    query_priority_t priority = admission_controller->classify(
+        query->query_cache->get_user_context().to_string(),
+        query->term_storage->global_db_name());
+    return admission_controller->admit(priority, interruptor);
+}
+
 template <class Callable>
 void save_exception(std::exception_ptr *err,
                     std::string *err_str,
@@ -558,17 +598,232 @@ void save_exception(std::exception_ptr *err,
     }
 }
 
+/* Stats for a single client connection.  Each connection adds a collection named
+after the client's address and a connection id to `query_engine/connections`, which
+is reported in the server rows of the `rethinkdb.stats` table.  The address alone
+isn't unique, since connections coming through a proxy all share it.
+
+The collection lives on the connection's thread, which is where its counters are
+updated. */
+class connection_stats_t {
+public:
+    connection_stats_t(perfmon_collection_t *parent,
+                       threadnum_t home_thread,
+                       const ip_and_port_t &peer,
+                       uint64_t connection_id)
+        : collection(home_thread),
+          membership(parent,
+                     &collection,
+                     strprintf("%s#%" PRIu64, peer.to_string().c_str(), connection_id)),
+          queries_in_flight_membership(
+              &collection, &queries_in_flight, "queries_in_flight"),
+          concurrency_limit_membership(
+              &collection, &concurrency_limit, "concurrency_limit"),
+          responses_total_membership(
+              &collection, &responses_total, "responses_total"),
+          writes_total_membership(&collection, &writes_total, "writes_total") { }
+
+    perfmon_collection_t collection;
+    perfmon_membership_t membership;
+    perfmon_counter_t queries_in_flight;
+    perfmon_membership_t queries_in_flight_membership;
+    perfmon_counter_t concurrency_limit;
+    perfmon_membership_t concurrency_limit_membership;
+    perfmon_counter_t responses_total;
+    perfmon_membership_t responses_total_membership;
+    perfmon_counter_t writes_total;
+    perfmon_membership_t writes_total_membership;
+
+private:
+    DISABLE_COPYING(connection_stats_t);
+};
+
+/* `response_coalescer_t` gathers the responses of queries that finish at about the
+same time and writes them to the connection with a single `writev`.  A response is
+held back for at most one pass of the scheduler, and only while other queries are
+still running on the connection.
+
+It also adapts the number of queries the connection may run at once.  If the client
+doesn't read its responses as fast as we produce them, a write blocks and the
+responses of queries finishing in the meantime pile up in memory behind it.  After
+every write we look at how many bytes are waiting for the next one.  When that
+backlog is too large the limit is halved, and once it has drained the limit grows
+back by one for every write. */
+template <class protocol_t>
+class response_coalescer_t {
+public:
+    response_coalescer_t(tcp_conn_t *_conn,
+                         new_semaphore_t *_semaphore,
+                         int64_t _min_limit,
+                         int64_t _max_limit,
+                         connection_stats_t *_stats)
+        : conn(_conn),
+          semaphore(_semaphore),
+          min_limit(_min_limit),
+          max_limit(_max_limit),
+          limit(_max_limit),
+          backing_off(false),
+          stats(_stats),
+          running_queries(0),
+          pending_bytes(0),
+          blocked_bytes(0),
+          queued_seq(0),
+          written_seq(0),
+          write_failed(false) {
+        guarantee(min_limit > 0 && min_limit <= max_limit);
+        stats->concurrency_limit += limit;
+    }
+
+    ~response_coalescer_t() {
+        stats->concurrency_limit -= limit;
+    }
+
+    void query_started() { ++running_queries; }
+    void query_finished() { --running_queries; }
+
+    // Serializes the response and blocks until it has been written to the
+    // connection, possibly by another query's coroutine.
+    void send(ql::response_t *response,
+              int64_t token,
+              signal_t *lock_interruptor,
+              signal_t *write_interruptor) {
+        chunked_string_buffer_t buffer;
+        protocol_t::serialize_response(response, token, &buffer);
+        const size_t size = buffer.GetSize();
+
+        uint64_t seq;
+        {
+            // The response is only queued once we hold the lock, so if we're
+            // interrupted while waiting for it, nothing gets written on our behalf.
+            // Until then it counts towards the backlog behind the current write.
+            new_mutex_in_line_t lock(&write_mutex);
+            blocked_bytes += size;
+            try {
+                wait_interruptible(lock.acq_signal(), lock_interruptor);
+            } catch (const interrupted_exc_t &) {
+                blocked_bytes -= size;
+                throw;
+            }
+            blocked_bytes -= size;
+            if (write_failed) {
+                throw tcp_conn_write_closed_exc_t();
+            }
+            pending_bytes += size;
+            pending.push_back(std::move(buffer));
+            seq = ++queued_seq;
+
+            if (running_queries <= 1 || pending_bytes >= MAX_COALESCED_BYTES) {
+                flush(write_interruptor);
+                return;
+            }
+        }
+
+        // Give queries that are about to finish a chance to add their responses.
+        coro_t::yield();
+
+        // Our response is already queued, so this wait isn't interruptible: we have
+        // to find out whether it has been written.  The write that holds the lock is
+        // interrupted when the connection goes away.
+        new_mutex_acq_t lock(&write_mutex);
+        if (written_seq >= seq) {
+            // Someone else wrote our response as part of their batch.
+            return;
+        }
+        if (write_failed) {
+            throw tcp_conn_write_closed_exc_t();
+        }
+        flush(write_interruptor);
+    }
+
+private:
+    static const size_t MAX_COALESCED_BYTES = MEGABYTE;
+    static const size_t BACKLOG_HIGH_WATER = 16 * MEGABYTE;
+    static const size_t BACKLOG_LOW_WATER = 256 * KILOBYTE;
+
+    void flush(signal_t *interruptor) {
+        std::vector<chunked_string_buffer_t> batch;
+        batch.swap(pending);
+        pending_bytes = 0;
+        uint64_t batch_seq = queued_seq;
+
+        const_buffer_group_t buffers;
+        for (const auto &buffer : batch) {
+            buffer.append_to_group(&buffers);
+        }
+        try {
+            conn->write(&buffers, interruptor);
+        } catch (...) {
+            // Part of the batch might have been written, so we must not write
+            // anything else to this connection.
+            write_failed = true;
+            throw;
+        }
+        written_seq = batch_seq;
+        ++stats->writes_total;
+        stats->responses_total += batch.size();
+
+        // Whatever piled up while the write was blocked is the client's backlog.
+        update_limit(blocked_bytes);
+    }
+
+    void update_limit(size_t backlog_bytes) {
+        int64_t new_limit = limit;
+        if (backlog_bytes >= BACKLOG_HIGH_WATER) {
+            if (!backing_off) {
+                new_limit = std::max(min_limit, limit / 2);
+                backing_off = true;
+            }
+        } else if (backlog_bytes <= BACKLOG_LOW_WATER) {
+            backing_off = false;
+            new_limit = std::min(max_limit, limit + 1);
+        }
+        if (new_limit != limit) {
+            stats->concurrency_limit += new_limit - limit;
+            limit = new_limit;
+            semaphore->set_capacity(limit);
+        }
+    }
+
+    tcp_conn_t *const conn;
+    new_semaphore_t *const semaphore;
+    const int64_t min_limit;
+    const int64_t max_limit;
+    int64_t limit;
+    bool backing_off;
+    connection_stats_t *const stats;
+
+    size_t running_queries;
+    std::vector<chunked_string_buffer_t> pending;
+    size_t pending_bytes;
+    // The size of the responses whose queries are waiting for `write_mutex`.
+    size_t blocked_bytes;
+    uint64_t queued_seq;
+    uint64_t written_seq;
+    bool write_failed;
+    new_mutex_t write_mutex;
+
+    DISABLE_COPYING(response_coalescer_t);
+};
+
 template <class protocol_t>
 void query_server_t::connection_loop(tcp_conn_t *conn,
+                                     uint64_t connection_id,
                                      size_t max_concurrent_queries,
                                      ql::query_cache_t *query_cache,
                                      signal_t *drain_signal) {
     std::exception_ptr err;
     std::string err_str;
     cond_t abort;
-    new_mutex_t send_mutex;
     scoped_perfmon_counter_t connection_counter(&rdb_ctx->stats.client_connections);
 
+    ip_and_port_t peer(ip_address_t::any(AF_INET), port_t(0));
+    UNUSED bool peer_res = conn->getpeername(&peer);
+    conn->assert_thread();
+    connection_stats_t connection_stats(&rdb_ctx->stats.connections_collection,
+                                        conn->home_thread(),
+                                        peer,
+                                        connection_id);
+
 #ifdef __linux
     linux_event_watcher_t *ew = conn->get_event_watcher();
     linux_event_watcher_t::watch_t conn_interrupted(ew, poll_event_rdhup);
@@ -578,6 +833,17 @@ void query_server_t::connection_loop(tcp_conn_t *conn,
 #endif  // __linux
 
     new_semaphore_t sem(max_concurrent_queries);
+    // The coalescer only lowers the concurrency limit while the client is falling
+    // behind on reading its responses.  It never goes below
+    // `MIN_ADAPTIVE_CONCURRENT_QUERIES`, so that clients with many open changefeeds
+    // keep being able to start new queries.
+    const size_t MIN_ADAPTIVE_CONCURRENT_QUERIES = 64;
+    response_coalescer_t<protocol_t> coalescer(
+        conn,
+        &sem,
+        std::min(MIN_ADAPTIVE_CONCURRENT_QUERIES, max_concurrent_queries),
+        max_concurrent_queries,
+        &connection_stats);
     auto_drainer_t coro_drainer;
     while (!err) {
         scoped_ptr_t<ql::query_params_t> outer_query =
@@ -595,13 +861,22 @@ void query_server_t::connection_loop(tcp_conn_t *conn,
                                           &interruptor);
                 ql::response_t response;
                 bool replied = false;
+                scoped_perfmon_counter_t in_flight(&connection_stats.queries_in_flight);
+                coalescer.query_started();
 
                 save_exception(&err, &err_str, &abort, [&]() {
-                    handler->run_query(query.get(), &response, &cb_interruptor);
+                    if (admit_query(query.get(), &cb_interruptor)) {
+                        handler->run_query(query.get(), &response, &cb_interruptor);
+                    } else {
+                        response.fill_error(
+                            Response::RUNTIME_ERROR, Response::OP_FAILED,
+                            "The server is overloaded and could not start the query.  "
+                            "Please retry it later.",
+                            ql::backtrace_registry_t::EMPTY_BACKTRACE);
+                    }
                     if (!query->noreply) {
-                        new_mutex_acq_t send_lock(&send_mutex, &cb_interruptor);
-                        protocol_t::send_response(&response, query->token,
-                                                  conn, &cb_interruptor);
+                        coalescer.send(&response, query->token,
+                                       &cb_interruptor, &cb_interruptor);
                         replied = true;
                     }
                 });
@@ -609,11 +884,11 @@ void query_server_t::connection_loop(tcp_conn_t *conn,
                     if (!replied && !query->noreply) {
                         make_error_response(drain_signal->is_pulsed(), *conn,
                                             err_str, &response);
-                        new_mutex_acq_t send_lock(&send_mutex, drain_signal);
-                        protocol_t::send_response(&response, query->token,
-                                                  conn, &cb_interruptor);
+                        coalescer.send(&response, query->token,
+                                       drain_signal, &cb_interruptor);
                     }
                 });
+                coalescer.query_finished();
             });
             guarantee(!outer_query.has());
             // Since we're using `spawn_now_dangerously` above, we need to yield
@@ -14,6 +14,7 @@
 #include "arch/io/openssl.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/timing.hpp"
+#include "client_protocol/admission_control.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 #include "containers/archive/archive.hpp"
@@ -103,7 +104,8 @@ public:
         int port,
         query_handler_t *_handler,
         uint32_t http_timeout_sec,
-        tls_ctx_t* tls_ctx);
+        tls_ctx_t* tls_ctx,
+        const admission_config_t &admission_config = admission_config_t());
     ~query_server_t();
 
     int get_port() const;
@@ -114,6 +116,9 @@ private:
                              const std::string &err,
                              ql::response_t *response_out);
 
+    // Returns `false` if the node is too busy to start `query` right now.
+    bool admit_query(ql::query_params_t *query, signal_t *interruptor);
+
     // For the client driver socket
     void handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn,
                      auto_drainer_t::lock_t);
@@ -121,6 +126,7 @@ private:
     // This is templatized based on the wire protocol requested by the client
     template<class protocol_t>
     void connection_loop(tcp_conn_t *conn,
+                         uint64_t connection_id,
                          size_t max_concurrent_queries,
                          ql::query_cache_t *query_cache,
                          signal_t *interruptor);
@@ -134,12 +140,18 @@ private:
     rdb_context_t *const rdb_ctx;
     query_handler_t *const handler;
 
+    // Empty unless admission control is enabled.
+    scoped_ptr_t<admission_controller_t> admission_controller;
+
     /* WARNING: The order here is fragile. */
     auto_drainer_t drainer;
     http_conn_cache_t http_conn_cache;
     scoped_ptr_t<tcp_listener_t> tcp_listener;
 
     int next_thread;
+
+    // Distinguishes the stats of connections that come from the same address.
+    uint64_t next_connection_id;
 };
 
 #endif /* CLIENT_PROTOCOL_SERVER_HPP_ */
@@ -107,6 +107,7 @@ bool artificial_reql_cluster_interface_t::table_create(
         const table_generate_config_params_t &config_params,
         const std::string &primary_key,
         write_durability_t durability,
+        size_t num_cpu_shards,
         signal_t *interruptor,
         ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -124,6 +125,7 @@ bool artificial_reql_cluster_interface_t::table_create(
         config_params,
         primary_key,
         durability,
+        num_cpu_shards,
         interruptor,
         result_out,
         error_out);
@@ -373,6 +375,7 @@ bool artificial_reql_cluster_interface_t::table_rebalance(
         auth::user_context_t const &user_context,
         counted_t<const ql::db_t> db,
         const name_string_t &name,
+        rebalance_mode_t mode,
         signal_t *interruptor,
         ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -384,12 +387,13 @@ bool artificial_reql_cluster_interface_t::table_rebalance(
         return false;
     }
     return next_or_error(error_out) && m_next->table_rebalance(
-        user_context, db, name, interruptor, result_out, error_out);
+        user_context, db, name, mode, interruptor, result_out, error_out);
 }
 
 bool artificial_reql_cluster_interface_t::db_rebalance(
         auth::user_context_t const &user_context,
         counted_t<const ql::db_t> db,
+        rebalance_mode_t mode,
         signal_t *interruptor,
         ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -401,7 +405,7 @@ bool artificial_reql_cluster_interface_t::db_rebalance(
         return false;
     }
     return next_or_error(error_out) && m_next->db_rebalance(
-        user_context, db, interruptor, result_out, error_out);
+        user_context, db, mode, interruptor, result_out, error_out);
 }
 
 bool artificial_reql_cluster_interface_t::grant_global(
@@ -842,6 +846,8 @@ artificial_reql_cluster_backends_t::artificial_reql_cluster_backends_t(
 
     debug_stats_backend.init(
         new debug_stats_artificial_table_backend_t(
+            name_string_t::guarantee_valid("_debug_stats"),
+            std::vector<stat_manager_t::stat_id_t>(),
             rdb_context,
             name_resolver,
             directory_map_view,
@@ -852,6 +858,21 @@ artificial_reql_cluster_backends_t::artificial_reql_cluster_backends_t(
         name_string_t::guarantee_valid("_debug_stats"),
         std::make_pair(debug_stats_backend.get(), debug_stats_backend.get()));
 
+    debug_coro_profile_backend.init(
+        new debug_stats_artificial_table_backend_t(
+            name_string_t::guarantee_valid("_debug_coro_profile"),
+            std::vector<stat_manager_t::stat_id_t>{"coro_profile"},
+            rdb_context,
+            name_resolver,
+            directory_map_view,
+            server_config_client,
+            mailbox_manager));
+    debug_coro_profile_sentry = backend_sentry_t(
+        artificial_reql_cluster_interface->get_table_backends_map_mutable(),
+        name_string_t::guarantee_valid("_debug_coro_profile"),
+        std::make_pair(debug_coro_profile_backend.get(),
+                       debug_coro_profile_backend.get()));
+
     debug_table_status_backend.init(
         new debug_table_status_artificial_table_backend_t(
             rdb_context,
@@ -85,6 +85,7 @@ public:
             const table_generate_config_params_t &config_params,
             const std::string &primary_key,
             write_durability_t durability,
+            size_t num_cpu_shards,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out);
@@ -171,12 +172,14 @@ public:
             auth::user_context_t const &user_context,
             counted_t<const ql::db_t> db,
             const name_string_t &name,
+            rebalance_mode_t mode,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out);
     bool db_rebalance(
             auth::user_context_t const &user_context,
             counted_t<const ql::db_t> db,
+            rebalance_mode_t mode,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out);
@@ -345,6 +348,9 @@ private:
     scoped_ptr_t<debug_stats_artificial_table_backend_t> debug_stats_backend;
     backend_sentry_t debug_stats_sentry;
 
+    scoped_ptr_t<debug_stats_artificial_table_backend_t> debug_coro_profile_backend;
+    backend_sentry_t debug_coro_profile_sentry;
+
     scoped_ptr_t<debug_table_status_artificial_table_backend_t>
         debug_table_status_backend;
     backend_sentry_t debug_table_status_sentry;
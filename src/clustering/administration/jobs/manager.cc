@@ -89,7 +89,7 @@ void jobs_manager_t::on_get_job_reports(
 
                     std::string render = pprint::pretty_print_as_js(
                         printed_query_columns,
-                        pair.second->term_storage->root_term());
+                        pair.second->get_term_storage()->root_term());
 
                     query_job_reports_inner.emplace_back(
                         pair.second->job_id,
@@ -97,7 +97,10 @@ void jobs_manager_t::on_get_job_reports(
                         server_id,
                         query_cache->get_client_addr_port(),
                         std::move(render),
-                        query_cache->get_user_context());
+                        query_cache->get_user_context(),
+                        pair.second->memory_tracker.has()
+                            ? pair.second->memory_tracker->get_usage()
+                            : 0);
                 }
             }
         }
@@ -140,7 +140,8 @@ public:
             server_id_t const &server_id,
             ip_and_port_t const &client_addr_port,
             std::string const &query,
-            auth::user_context_t const &user_context);
+            auth::user_context_t const &user_context,
+            uint64_t memory_usage);
 
     void merge_derived(query_job_report_t const &job_report);
 
@@ -154,6 +155,8 @@ public:
     ip_and_port_t client_addr_port;
     std::string query;
     auth::user_context_t user_context;
+    // The memory the query's big in-memory structures hold, in bytes.
+    uint64_t memory_usage;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(query_job_report_t);
 
@@ -64,6 +64,7 @@
 #include "containers/scoped.hpp"
 #include "crypto/random.hpp"
 #include "logger.hpp"
+#include "rdb_protocol/memory_tracker.hpp"
 
 #define RETHINKDB_EXPORT_SCRIPT "rethinkdb-export"
 #define RETHINKDB_IMPORT_SCRIPT "rethinkdb-import"
@@ -512,6 +513,23 @@ optional<optional<uint64_t> > parse_total_cache_size_option(
     }
 }
 
+uint64_t parse_query_memory_limit_option(
+        const std::map<std::string, options::values_t> &opts) {
+    optional<std::string> limit_opt = get_optional_option(opts, "--query-memory-limit");
+    if (!limit_opt.has_value()) {
+        return ql::memory_tracker_t::unlimited;
+    }
+    uint64_t limit_megs;
+    if (!strtou64_strict(*limit_opt, 10, &limit_megs)
+        || limit_megs == 0
+        || limit_megs > ql::memory_tracker_t::unlimited / MEGABYTE) {
+        throw std::runtime_error(strprintf(
+            "ERROR: query-memory-limit should be a positive number, got '%s'",
+            limit_opt->c_str()));
+    }
+    return limit_megs * MEGABYTE;
+}
+
 // Note that this defaults to the peer port if no port is specified
 //  (at the moment, this is only used for parsing --join directives)
 // Possible formats:
@@ -666,6 +684,19 @@ const std::vector<std::string> &all_options(const std::map<std::string, options:
     return all_options(opts, name, &source);
 }
 
+admission_config_t parse_admission_config_options(
+        const std::map<std::string, options::values_t> &opts) {
+    admission_config_t config;
+    config.enabled = exists_option(opts, "--admission-control");
+    for (const std::string &rule : all_options(opts, "--query-priority")) {
+        std::string error;
+        if (!config.priority_rules.add_rule(rule, &error)) {
+            throw std::runtime_error(strprintf("ERROR: %s", error.c_str()));
+        }
+    }
+    return config;
+}
+
 // Gets a single integer option, often an optional integer option with a default value.
 int get_single_int(const std::map<std::string, options::values_t> &opts, const std::string &name) {
     const std::string value = get_single_option(opts, name);
@@ -1417,6 +1448,11 @@ options::help_section_t get_file_options(std::vector<options::option_t> *options
                                              options::OPTIONAL));
     help.add("--cache-size mb", "total cache size (in megabytes) for the process. Can "
         "be 'auto'.");
+    options_out->push_back(options::option_t(options::names_t("--shared-table-storage"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--shared-table-storage", "store new tables together in a single shared "
+        "file instead of one file per table, which saves disk space, file descriptors "
+        "and memory when there are many small tables");
     return help;
 }
 
@@ -1607,6 +1643,25 @@ options::help_section_t get_network_options(const bool join_required, std::vecto
                                              options::OPTIONAL));
     help.add("--reql-http-proxy [protocol://]host[:port]", "HTTP proxy to use for performing `r.http(...)` queries, default port is 1080");
 
+    options_out->push_back(options::option_t(options::names_t("--query-memory-limit"),
+                                             options::OPTIONAL));
+    help.add("--query-memory-limit mb", "how much memory (in megabytes) a single "
+             "query may use for sorting, grouping and joining before it is aborted; "
+             "queries can override this with the `memory_limit` option to `run`. "
+             "Unlimited by default");
+
+    options_out->push_back(options::option_t(options::names_t("--admission-control"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--admission-control", "queue or reject new queries while the server is "
+             "overloaded, instead of letting all queries slow down together");
+
+    options_out->push_back(options::option_t(options::names_t("--query-priority"),
+                                             options::OPTIONAL_REPEAT));
+    help.add("--query-priority user:name=priority | db:name=priority",
+             "priority (`high`, `normal` or `low`) of the queries run by a user or "
+             "against a database when admission control is enabled, can be specified "
+             "multiple times");
+
     options_out->push_back(options::option_t(options::names_t("--canonical-address"),
                                              options::OPTIONAL_REPEAT));
     help.add("--canonical-address addr", "address that other rethinkdb instances will use to connect to us, can be specified multiple times");
@@ -1633,6 +1688,15 @@ options::help_section_t get_cpu_options(std::vector<options::option_t> *options_
                                              options::OPTIONAL,
                                              strprintf("%d", get_cpu_count())));
     help.add("-c [ --cores ] n", "the number of cores to use");
+    options_out->push_back(options::option_t(options::names_t("--pin-threads"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--pin-threads", "pin each thread to a core, keeping neighboring threads "
+             "on the same NUMA node");
+    options_out->push_back(options::option_t(options::names_t("--busy-poll"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--busy-poll usecs", "how long each thread keeps polling for work before "
+             "it goes to sleep; trades CPU time for lower latency");
     return help;
 }
 
@@ -1647,6 +1711,18 @@ MUST_USE bool parse_cores_option(const std::map<std::string, options::values_t>
     return true;
 }
 
+MUST_USE bool parse_busy_poll_option(const std::map<std::string, options::values_t> &opts,
+                                     int *busy_poll_usecs_out) {
+    int busy_poll_usecs = get_single_int(opts, "--busy-poll");
+    if (busy_poll_usecs < 0 || busy_poll_usecs > MAX_BUSY_POLL_USECS) {
+        fprintf(stderr, "ERROR: busy-poll time must be between 0 and %d microseconds\n",
+                MAX_BUSY_POLL_USECS);
+        return false;
+    }
+    *busy_poll_usecs_out = busy_poll_usecs;
+    return true;
+}
+
 options::help_section_t get_service_options(std::vector<options::option_t> *options_out) {
     options::help_section_t help("Service options");
     options_out->push_back(options::option_t(options::names_t("--pid-file"),
@@ -2052,6 +2128,11 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        int busy_poll_usecs;
+        if (!parse_busy_poll_option(opts, &busy_poll_usecs)) {
+            return EXIT_FAILURE;
+        }
+
         int max_concurrent_io_requests;
         if (!parse_io_threads_option(opts, &max_concurrent_io_requests)) {
             return EXIT_FAILURE;
@@ -2100,6 +2181,9 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
 
         serve_info_t serve_info(std::move(joins),
                                 get_reql_http_proxy_option(opts),
+                                parse_query_memory_limit_option(opts),
+                                parse_admission_config_options(opts),
+                                exists_option(opts, "--shared-table-storage"),
                                 std::move(web_path),
                                 do_update_checking,
                                 address_ports,
@@ -2124,7 +2208,9 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                      static_cast<cluster_semilattice_metadata_t*>(nullptr),
                                      &data_directory_lock,
                                      &result),
-                           num_workers);
+                           num_workers,
+                           exists_option(opts, "--pin-threads"),
+                           busy_poll_usecs);
         return result ? EXIT_SUCCESS : EXIT_FAILURE;
     } catch (const options::named_error_t &ex) {
         output_named_error(ex, help);
@@ -2203,6 +2289,9 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
 
         serve_info_t serve_info(std::move(joins),
                                 get_reql_http_proxy_option(opts),
+                                parse_query_memory_limit_option(opts),
+                                parse_admission_config_options(opts),
+                                false,
                                 std::move(web_path),
                                 update_check_t::do_not_perform,
                                 address_ports,
@@ -2323,6 +2412,11 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        int busy_poll_usecs;
+        if (!parse_busy_poll_option(opts, &busy_poll_usecs)) {
+            return EXIT_FAILURE;
+        }
+
         int max_concurrent_io_requests;
         if (!parse_io_threads_option(opts, &max_concurrent_io_requests)) {
             return EXIT_FAILURE;
@@ -2393,6 +2487,9 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
 
         serve_info_t serve_info(std::move(joins),
                                 get_reql_http_proxy_option(opts),
+                                parse_query_memory_limit_option(opts),
+                                parse_admission_config_options(opts),
+                                exists_option(opts, "--shared-table-storage"),
                                 std::move(web_path),
                                 do_update_checking,
                                 address_ports,
@@ -2417,7 +2514,9 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                      &serve_info,
                                      &data_directory_lock,
                                      &result),
-                           num_workers);
+                           num_workers,
+                           exists_option(opts, "--pin-threads"),
+                           busy_poll_usecs);
 
         return result ? EXIT_SUCCESS : EXIT_FAILURE;
     } catch (const options::named_error_t &ex) {
@@ -283,7 +283,10 @@ bool do_serve(io_backender_t *io_backender,
                               nullptr,   /* we'll fill this in later */
                               semilattice_manager_auth.get_root_view(),
                               &get_global_perfmon_collection(),
-                              serve_info.reql_http_proxy);
+                              serve_info.reql_http_proxy,
+                              serve_info.query_memory_limit,
+                              io_backender,
+                              base_path);
         {
             /* Extract a subview of the directory with all the table meta manager
             business cards. */
@@ -312,7 +315,8 @@ bool do_serve(io_backender_t *io_backender,
                         cache_balancer.get(),
                         base_path,
                         &rdb_ctx,
-                        metadata_file));
+                        metadata_file,
+                        serve_info.shared_table_storage));
                 multi_table_manager.init(new multi_table_manager_t(
                     server_id,
                     &mailbox_manager,
@@ -543,7 +547,8 @@ bool do_serve(io_backender_t *io_backender,
                     &rdb_ctx,
                     &server_config_client,
                     server_id,
-                    serve_info.tls_configs.driver.get());
+                    serve_info.tls_configs.driver.get(),
+                    serve_info.admission_config);
                 logNTC("Listening for client driver connections on port %d\n",
                        rdb_query_server.get_port());
                 /* If `serve_info.ports.reql_port` was zero then the OS assigned us a
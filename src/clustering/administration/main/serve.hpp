@@ -13,6 +13,7 @@
 #include "clustering/administration/main/version_check.hpp"
 #include "arch/address.hpp"
 #include "arch/io/openssl.hpp"
+#include "client_protocol/admission_control.hpp"
 
 class os_signal_cond_t;
 
@@ -113,6 +114,9 @@ class serve_info_t {
 public:
     serve_info_t(std::vector<host_and_port_t> &&_joins,
                  std::string &&_reql_http_proxy,
+                 uint64_t _query_memory_limit,
+                 const admission_config_t &_admission_config,
+                 bool _shared_table_storage,
                  std::string &&_web_assets,
                  update_check_t _do_version_checking,
                  service_address_ports_t _ports,
@@ -123,6 +127,9 @@ public:
                  tls_configs_t _tls_configs) :
         joins(std::move(_joins)),
         reql_http_proxy(std::move(_reql_http_proxy)),
+        query_memory_limit(_query_memory_limit),
+        admission_config(_admission_config),
+        shared_table_storage(_shared_table_storage),
         web_assets(std::move(_web_assets)),
         do_version_checking(_do_version_checking),
         ports(_ports),
@@ -141,6 +148,9 @@ public:
     const std::vector<host_and_port_t> joins;
     peer_address_set_t peers;
     std::string reql_http_proxy;
+    uint64_t query_memory_limit;
+    admission_config_t admission_config;
+    bool shared_table_storage;
     std::string web_assets;
     update_check_t do_version_checking;
     service_address_ports_t ports;
@@ -49,6 +49,11 @@ metadata_file_t::key_t<table_raft_stored_snapshot_t>
     return metadata_file_t::key_t<table_raft_stored_snapshot_t>("table.snapshot/");
 }
 
+metadata_file_t::key_t<uint64_t>
+        mdprefix_table_shared_storage_slot() {
+    return metadata_file_t::key_t<uint64_t>("table.shared_slot/");
+}
+
 metadata_file_t::key_t<raft_log_entry_t<table_raft_state_t> >
         mdprefix_table_raft_log() {
     return metadata_file_t::key_t<raft_log_entry_t<table_raft_state_t> >("table.log/");
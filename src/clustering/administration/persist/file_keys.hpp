@@ -43,6 +43,11 @@ metadata_file_t::key_t<table_raft_stored_header_t>
 metadata_file_t::key_t<table_raft_stored_snapshot_t>
     mdprefix_table_raft_snapshot();
 
+/* The slot of the table in the shared table storage file, for the tables that are
+stored there. */
+metadata_file_t::key_t<uint64_t>
+    mdprefix_table_shared_storage_slot();
+
 /* This prefix should be followed by a string of the form `TABLE/LOG_INDEX`, where
 `TABLE` is a UUID as before, and `LOG_INDEX` is a 16-digit hexadecimal. */
 metadata_file_t::key_t<raft_log_entry_t<table_raft_state_t> >
@@ -350,7 +350,8 @@ void migrate_table(const server_id_t &this_server_id,
         }
     }
 
-    table_raft_state_t raft_state = make_new_table_raft_state(config);
+    table_raft_state_t raft_state =
+        make_new_table_raft_state(config, CPU_SHARDING_FACTOR);
     raft_state.branch_history = branch_history;
     auto own_membership = raft_state.member_ids.find(this_server_id);
 
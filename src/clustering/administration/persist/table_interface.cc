@@ -3,6 +3,8 @@
 
 #include <algorithm>
 #include <array>
+#include <limits>
+#include <set>
 
 #include "clustering/administration/persist/branch_history_manager.hpp"
 #include "clustering/administration/persist/file_keys.hpp"
@@ -12,14 +14,100 @@
 #include "rdb_protocol/store.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "serializer/merger.hpp"
+#include "serializer/shared.hpp"
 #include "serializer/translator.hpp"
 
+/* `shared_table_storage_t` is the serializer file that holds the tables that were
+created while `--shared-table-storage` was enabled. Each of those tables has a slot in
+the file. A slot has `CPU_SHARDING_FACTOR` namespaces, of which the table uses one per
+CPU shard. Tables with more CPU shards than that always get a file of their own. */
+class shared_table_storage_t {
+public:
+    shared_table_storage_t(
+            const serializer_filepath_t &path,
+            io_backender_t *io_backender,
+            scoped_ptr_t<thread_allocation_t> &&serializer_thread) :
+        serializer_thread_allocation(std::move(serializer_thread)),
+        stats_membership(
+            &get_global_perfmon_collection(), &stats, "shared_table_storage") {
+        int res = access(path.permanent_path().c_str(), R_OK | W_OK);
+        bool create = (res != 0);
+
+        on_thread_t thread_switcher(serializer_thread_allocation->get_thread());
+        filepath_file_opener_t file_opener(path, io_backender);
+
+        if (create) {
+            log_serializer_t::create(
+                &file_opener,
+                log_serializer_t::static_config_t());
+        }
+
+        scoped_ptr_t<serializer_t> inner_serializer(new log_serializer_t(
+            log_serializer_t::dynamic_config_t(),
+            &file_opener,
+            &stats));
+        serializer.init(new merger_serializer_t(
+            std::move(inner_serializer),
+            MERGER_SERIALIZER_MAX_ACTIVE_WRITES));
+
+        if (create) {
+            shared_serializer_t::create(serializer.get());
+        }
+        shared_serializer.init(new shared_serializer_t(serializer.get()));
+
+        if (create) {
+            file_opener.move_serializer_file_to_permanent_location();
+        }
+    }
+
+    ~shared_table_storage_t() {
+        on_thread_t thread_switcher(serializer->home_thread());
+        shared_serializer.reset();
+        serializer.reset();
+    }
+
+    serializer_t *get_serializer() {
+        return serializer.get();
+    }
+
+    shared_serializer_t *get_shared_serializer() {
+        return shared_serializer.get();
+    }
+
+    static serializer_namespace_id_t namespace_for(uint64_t slot, size_t ix) {
+        guarantee(ix < CPU_SHARDING_FACTOR);
+        guarantee(slot < std::numeric_limits<serializer_namespace_id_t>::max()
+                         / CPU_SHARDING_FACTOR);
+        return slot * CPU_SHARDING_FACTOR + ix;
+    }
+
+    /* Deletes the blocks of all namespaces of the slot. */
+    void drop_slot(uint64_t slot) {
+        on_thread_t thread_switcher(shared_serializer->home_thread());
+        for (size_t ix = 0; ix < CPU_SHARDING_FACTOR; ++ix) {
+            shared_serializer->drop_namespace(namespace_for(slot, ix));
+        }
+    }
+
+private:
+    scoped_ptr_t<thread_allocation_t> serializer_thread_allocation;
+    perfmon_collection_t stats;
+    perfmon_membership_t stats_membership;
+    scoped_ptr_t<serializer_t> serializer;
+    scoped_ptr_t<shared_serializer_t> shared_serializer;
+
+    DISABLE_COPYING(shared_table_storage_t);
+};
+
 class real_multistore_ptr_t :
     public multistore_ptr_t {
 public:
     real_multistore_ptr_t(
             const namespace_id_t &table_id,
             const serializer_filepath_t &path,
+            size_t num_cpu_shards,
+            shared_table_storage_t *shared_storage,
+            uint64_t shared_slot,
             scoped_ptr_t<real_branch_history_manager_t> &&bhm,
             const base_path_t &base_path,
             io_backender_t *io_backender,
@@ -32,6 +120,9 @@ public:
                 namespace_id_t, std::pair<real_multistore_ptr_t *, auto_drainer_t::lock_t>
             > *real_multistores) :
         branch_history_manager(std::move(bhm)),
+        shared_inner_serializer(nullptr),
+        namespace_serializers(num_cpu_shards),
+        stores(num_cpu_shards),
         serializer_thread_allocation(std::move(serializer_thread)),
         store_thread_allocations(std::move(store_threads)),
         map_insertion_sentry(
@@ -47,45 +138,72 @@ public:
         // TODO: We should use N slices on M serializers, not N slices
         // on 1 serializer.
 
-        int res = access(path.permanent_path().c_str(), R_OK | W_OK);
-        bool create = (res != 0);
+        bool create;
+        guarantee(store_thread_allocations.size() == num_cpu_shards);
+        std::vector<serializer_t *> proxies(num_cpu_shards);
+        scoped_ptr_t<filepath_file_opener_t> file_opener;
+        if (shared_storage != nullptr) {
+            shared_serializer_t *shared_serializer =
+                shared_storage->get_shared_serializer();
+            on_thread_t thread_switcher(shared_serializer->home_thread());
+
+            /* The table is new if none of its namespaces has any blocks yet. */
+            create = true;
+            for (size_t ix = 0; ix < num_cpu_shards; ++ix) {
+                serializer_namespace_id_t ns =
+                    shared_table_storage_t::namespace_for(shared_slot, ix);
+                create = create && shared_serializer->namespace_is_empty(ns);
+                namespace_serializers[ix].init(shared_serializer->open_namespace(ns));
+                proxies[ix] = namespace_serializers[ix].get();
+            }
+            shared_inner_serializer = shared_storage->get_serializer();
+        } else {
+            int res = access(path.permanent_path().c_str(), R_OK | W_OK);
+            create = (res != 0);
 
-        on_thread_t thread_switcher(serializer_thread_allocation->get_thread());
-        filepath_file_opener_t file_opener(path, io_backender);
+            on_thread_t thread_switcher(serializer_thread_allocation->get_thread());
+            file_opener.init(new filepath_file_opener_t(path, io_backender));
 
-        if (create) {
-            log_serializer_t::create(
-                &file_opener,
-                log_serializer_t::static_config_t());
-        }
+            if (create) {
+                log_serializer_t::create(
+                    file_opener.get(),
+                    log_serializer_t::static_config_t());
+            }
 
-        // TODO: Could we handle failure when loading the serializer?  Right
-        // now, we don't.
+            // TODO: Could we handle failure when loading the serializer?  Right
+            // now, we don't.
 
-        scoped_ptr_t<serializer_t> inner_serializer(new log_serializer_t(
-            log_serializer_t::dynamic_config_t(),
-            &file_opener,
-            perfmon_collection_serializers));
-        serializer.init(new merger_serializer_t(
-            std::move(inner_serializer),
-            MERGER_SERIALIZER_MAX_ACTIVE_WRITES));
+            scoped_ptr_t<serializer_t> inner_serializer(new log_serializer_t(
+                log_serializer_t::dynamic_config_t(),
+                file_opener.get(),
+                perfmon_collection_serializers));
+            serializer.init(new merger_serializer_t(
+                std::move(inner_serializer),
+                MERGER_SERIALIZER_MAX_ACTIVE_WRITES));
 
-        std::vector<serializer_t *> ptrs;
-        ptrs.push_back(serializer.get());
-        if (create) {
-            serializer_multiplexer_t::create(ptrs, CPU_SHARDING_FACTOR);
+            std::vector<serializer_t *> ptrs;
+            ptrs.push_back(serializer.get());
+            if (create) {
+                serializer_multiplexer_t::create(ptrs, num_cpu_shards);
+            }
+            multiplexer.init(new serializer_multiplexer_t(ptrs));
+            guarantee(multiplexer->proxies.size() == num_cpu_shards,
+                "The table's file has %zu CPU shards, but its contracts have %zu.",
+                multiplexer->proxies.size(), num_cpu_shards);
+            for (size_t ix = 0; ix < num_cpu_shards; ++ix) {
+                proxies[ix] = multiplexer->proxies[ix];
+            }
         }
-        multiplexer.init(new serializer_multiplexer_t(ptrs));
 
-        pmap(CPU_SHARDING_FACTOR, [&](int ix) {
+        pmap(num_cpu_shards, [&](int ix) {
             // TODO: Exceptions? If exceptions are being thrown in here, nothing is
             // handling them.
 
             on_thread_t thread_switcher_2(store_thread_allocations[ix]->get_thread());
 
             stores[ix].init(new store_t(
-                cpu_sharding_subspace(ix),
-                multiplexer->proxies[ix],
+                cpu_sharding_subspace(ix, num_cpu_shards),
+                proxies[ix],
                 cache_balancer,
                 strprintf("shard_%d", ix),
                 create,
@@ -113,8 +231,12 @@ public:
             }
         });
 
-        if (create) {
-            file_opener.move_serializer_file_to_permanent_location();
+        if (file_opener.has()) {
+            on_thread_t thread_switcher(serializer->home_thread());
+            if (create) {
+                file_opener->move_serializer_file_to_permanent_location();
+            }
+            file_opener.reset();
         }
     }
 
@@ -123,7 +245,7 @@ public:
         store_thread_allocations.clear();
         map_insertion_sentry.reset();
         drainer.drain();
-        pmap(CPU_SHARDING_FACTOR, [this](int ix) {
+        pmap(stores.size(), [this](int ix) {
             if (stores[ix].has()) {
                 on_thread_t thread_switcher(stores[ix]->home_thread());
                 stores[ix].reset();
@@ -136,14 +258,22 @@ public:
             }
             serializer.reset();
         }
+        if (shared_inner_serializer != nullptr) {
+            on_thread_t thread_switcher(shared_inner_serializer->home_thread());
+            namespace_serializers.clear();
+        }
     }
 
     branch_history_manager_t *get_branch_history_manager() {
         return branch_history_manager.get();
     }
 
+    size_t num_cpu_shards() {
+        return stores.size();
+    }
+
     serializer_t *get_serializer() {
-        return serializer.get_or_null();
+        return serializer.has() ? serializer.get() : shared_inner_serializer;
     }
 
     store_view_t *get_cpu_sharded_store(size_t i) {
@@ -156,8 +286,9 @@ public:
 
     bool is_gc_active() {
         rassert(!drainer.is_draining());
-        if (serializer.has()) {
-            return serializer->is_gc_active();
+        serializer_t *ser = get_serializer();
+        if (ser != nullptr) {
+            return ser->is_gc_active();
         } else {
             return false;
         }
@@ -167,7 +298,10 @@ private:
     scoped_ptr_t<real_branch_history_manager_t> branch_history_manager;
     scoped_ptr_t<serializer_t> serializer;
     scoped_ptr_t<serializer_multiplexer_t> multiplexer;
-    scoped_ptr_t<store_t> stores[CPU_SHARDING_FACTOR];
+    // Used instead of the two above if the table is in the shared storage file.
+    serializer_t *shared_inner_serializer;
+    std::vector<scoped_ptr_t<namespace_serializer_t> > namespace_serializers;
+    std::vector<scoped_ptr_t<store_t> > stores;
 
     scoped_ptr_t<thread_allocation_t> serializer_thread_allocation;
     std::vector<scoped_ptr_t<thread_allocation_t> > store_thread_allocations;
@@ -180,6 +314,29 @@ private:
     DISABLE_COPYING(real_multistore_ptr_t);
 };
 
+real_table_persistence_interface_t::real_table_persistence_interface_t(
+        io_backender_t *_io_backender,
+        cache_balancer_t *_cache_balancer,
+        const base_path_t &_base_path,
+        rdb_context_t *_rdb_context,
+        metadata_file_t *_metadata_file,
+        bool _shared_table_storage) :
+    io_backender(_io_backender),
+    cache_balancer(_cache_balancer),
+    base_path(_base_path),
+    rdb_context(_rdb_context),
+    metadata_file(_metadata_file),
+    shared_table_storage(_shared_table_storage),
+    /* We assign threads from the lowest thread number upwards. This is to reduce
+    the potential for conflicting with cluster connection threads, which are
+    assigned from the highest thread number downwards. */
+    thread_allocator([](threadnum_t a, threadnum_t b) {
+        return a.threadnum < b.threadnum;
+    })
+    { }
+
+real_table_persistence_interface_t::~real_table_persistence_interface_t() { }
+
 void real_table_persistence_interface_t::read_all_metadata(
         const std::function<void(
             const namespace_id_t &table_id,
@@ -274,6 +431,7 @@ void real_table_persistence_interface_t::delete_metadata(
 
 void real_table_persistence_interface_t::load_multistore(
         const namespace_id_t &table_id,
+        size_t num_cpu_shards,
         metadata_file_t::read_txn_t *metadata_read_txn,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
@@ -282,16 +440,31 @@ void real_table_persistence_interface_t::load_multistore(
         new real_branch_history_manager_t(
             table_id, metadata_file, metadata_read_txn, interruptor));
 
-    scoped_ptr_t<thread_allocation_t> serializer_thread(
-        new thread_allocation_t(&thread_allocator));
+    uint64_t shared_slot = 0;
+    shared_table_storage_t *shared = nullptr;
+    if (metadata_read_txn->read_maybe(
+            mdprefix_table_shared_storage_slot().suffix(uuid_to_str(table_id)),
+            &shared_slot,
+            interruptor)) {
+        shared = get_shared_storage();
+        shared_slots[table_id] = shared_slot;
+    }
+
+    scoped_ptr_t<thread_allocation_t> serializer_thread;
+    if (shared == nullptr) {
+        serializer_thread.init(new thread_allocation_t(&thread_allocator));
+    }
     std::vector<scoped_ptr_t<thread_allocation_t> > store_threads;
-    for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+    for (size_t i = 0; i < num_cpu_shards; ++i) {
         store_threads.emplace_back(new thread_allocation_t(&thread_allocator));
     }
 
     multistore_ptr_out->init(new real_multistore_ptr_t(
         table_id,
         file_name_for(table_id),
+        num_cpu_shards,
+        shared,
+        shared_slot,
         std::move(bhm),
         base_path,
         io_backender,
@@ -305,12 +478,38 @@ void real_table_persistence_interface_t::load_multistore(
 
 void real_table_persistence_interface_t::create_multistore(
         const namespace_id_t &table_id,
+        size_t num_cpu_shards,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers) {
+    if (shared_table_storage && num_cpu_shards <= CPU_SHARDING_FACTOR) {
+        new_mutex_acq_t slots_acq(&shared_slots_mutex, interruptor);
+        metadata_file_t::write_txn_t write_txn(metadata_file, interruptor);
+        metadata_file_t::key_t<uint64_t> key =
+            mdprefix_table_shared_storage_slot().suffix(uuid_to_str(table_id));
+        uint64_t slot;
+        if (!write_txn.read_maybe(key, &slot, interruptor)) {
+            std::set<uint64_t> used_slots;
+            write_txn.read_many<uint64_t>(
+                mdprefix_table_shared_storage_slot(),
+                [&](const std::string &, const uint64_t &used_slot) {
+                    used_slots.insert(used_slot);
+                },
+                interruptor);
+            slot = 0;
+            while (used_slots.count(slot) != 0) {
+                ++slot;
+            }
+            /* A crash while a table was being dropped can leave some of its blocks
+            behind in the slot. */
+            get_shared_storage()->drop_slot(slot);
+            write_txn.write(key, slot, interruptor);
+            write_txn.commit();
+        }
+    }
     metadata_file_t::read_txn_t read_txn(metadata_file, interruptor);
     load_multistore(
-        table_id, &read_txn, multistore_ptr_out, interruptor,
+        table_id, num_cpu_shards, &read_txn, multistore_ptr_out, interruptor,
         perfmon_collection_serializers);
 }
 
@@ -320,6 +519,24 @@ void real_table_persistence_interface_t::destroy_multistore(
     guarantee(multistore_ptr_in->has());
     multistore_ptr_in->reset();
 
+    if (shared_slots.count(table_id) != 0) {
+        cond_t non_interruptor;
+        new_mutex_acq_t slots_acq(&shared_slots_mutex);
+        uint64_t slot = shared_slots.at(table_id);
+        shared_slots.erase(table_id);
+        {
+            metadata_file_t::write_txn_t write_txn(metadata_file, &non_interruptor);
+            write_txn.erase(
+                mdprefix_table_shared_storage_slot().suffix(uuid_to_str(table_id)),
+                &non_interruptor);
+            write_txn.commit();
+        }
+        logNTC("Removing table %s from the shared table storage file\n",
+               uuid_to_str(table_id).c_str());
+        get_shared_storage()->drop_slot(slot);
+        return;
+    }
+
     std::string filepath = file_name_for(table_id).permanent_path();
     logNTC("Removing file %s\n", filepath.c_str());
     const int res = ::unlink(filepath.c_str());
@@ -332,6 +549,19 @@ serializer_filepath_t real_table_persistence_interface_t::file_name_for(
     return serializer_filepath_t(base_path, uuid_to_str(table_id));
 }
 
+shared_table_storage_t *real_table_persistence_interface_t::get_shared_storage() {
+    new_mutex_acq_t acq(&shared_storage_mutex);
+    if (!shared_storage.has()) {
+        scoped_ptr_t<thread_allocation_t> serializer_thread(
+            new thread_allocation_t(&thread_allocator));
+        shared_storage.init(new shared_table_storage_t(
+            serializer_filepath_t(base_path, "shared_tables"),
+            io_backender,
+            std::move(serializer_thread)));
+    }
+    return shared_storage.get();
+}
+
 bool real_table_persistence_interface_t::is_gc_active() const {
     for (int thread = 0; thread < get_num_db_threads(); ++thread) {
         std::map<serializer_t *, auto_drainer_t::lock_t> serializers_copy;
@@ -5,10 +5,12 @@
 #include "clustering/administration/perfmon_collection_repo.hpp"
 #include "clustering/administration/persist/raft_storage_interface.hpp"
 #include "clustering/table_manager/table_metadata.hpp"
+#include "concurrency/new_mutex.hpp"
 
 class cache_balancer_t;
 class metadata_file_t;
 class real_multistore_ptr_t;
+class shared_table_storage_t;
 class table_raft_storage_interface_t;
 
 class real_table_persistence_interface_t :
@@ -19,19 +21,9 @@ public:
             cache_balancer_t *_cache_balancer,
             const base_path_t &_base_path,
             rdb_context_t *_rdb_context,
-            metadata_file_t *_metadata_file) :
-        io_backender(_io_backender),
-        cache_balancer(_cache_balancer),
-        base_path(_base_path),
-        rdb_context(_rdb_context),
-        metadata_file(_metadata_file),
-        /* We assign threads from the lowest thread number upwards. This is to reduce
-        the potential for conflicting with cluster connection threads, which are
-        assigned from the highest thread number downwards. */
-        thread_allocator([](threadnum_t a, threadnum_t b) {
-            return a.threadnum < b.threadnum;
-        })
-        { }
+            metadata_file_t *_metadata_file,
+            bool _shared_table_storage);
+    ~real_table_persistence_interface_t();
 
     void read_all_metadata(
         const std::function<void(
@@ -57,12 +49,14 @@ public:
 
     void load_multistore(
         const namespace_id_t &table_id,
+        size_t num_cpu_shards,
         metadata_file_t::read_txn_t *metadata_read_txn,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers);
     void create_multistore(
         const namespace_id_t &table_id,
+        size_t num_cpu_shards,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers);
@@ -76,12 +70,26 @@ private:
     serializer_filepath_t file_name_for(const namespace_id_t &table_id);
     threadnum_t pick_thread();
 
+    /* Opens the shared storage file on first use. */
+    shared_table_storage_t *get_shared_storage();
+
     io_backender_t * const io_backender;
     cache_balancer_t * const cache_balancer;
     base_path_t const base_path;
     rdb_context_t * const rdb_context;
     metadata_file_t * const metadata_file;
 
+    /* If this is set, new tables are put into the shared storage file instead of
+    getting a file of their own. */
+    bool const shared_table_storage;
+    scoped_ptr_t<shared_table_storage_t> shared_storage;
+    new_mutex_t shared_storage_mutex;
+
+    /* The slots in the shared storage file of the tables that are loaded from it.
+    `shared_slots_mutex` is held while slots are assigned or freed. */
+    std::map<namespace_id_t, uint64_t> shared_slots;
+    new_mutex_t shared_slots_mutex;
+
     std::map<
         namespace_id_t, std::pair<real_multistore_ptr_t *, auto_drainer_t::lock_t>
     > real_multistores;
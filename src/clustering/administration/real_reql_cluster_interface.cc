@@ -292,6 +292,7 @@ bool real_reql_cluster_interface_t::table_create(
         const table_generate_config_params_t &config_params,
         const std::string &primary_key,
         write_durability_t durability,
+        size_t num_cpu_shards,
         signal_t *interruptor_on_caller,
         ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -337,7 +338,8 @@ bool real_reql_cluster_interface_t::table_create(
         config.config.user_data = default_user_data();
 
         table_id = generate_uuid();
-        m_table_meta_client->create(table_id, config, &interruptor_on_home);
+        m_table_meta_client->create(
+            table_id, config, num_cpu_shards, &interruptor_on_home);
 
         new_config = convert_table_config_to_datum(table_id,
             convert_name_to_datum(db->name), config.config,
@@ -982,6 +984,7 @@ bool real_reql_cluster_interface_t::table_emergency_repair(
 void real_reql_cluster_interface_t::rebalance_internal(
         auth::user_context_t const &user_context,
         const namespace_id_t &table_id,
+        rebalance_mode_t mode,
         signal_t *interruptor_on_home,
         ql::datum_t *results_out)
         THROWS_ONLY(interrupted_exc_t, no_such_table_exc_t,
@@ -1010,13 +1013,24 @@ void real_reql_cluster_interface_t::rebalance_internal(
         throw no_such_table_exc_t();
     }
 
-    std::map<store_key_t, int64_t> counts;
-    fetch_distribution(table_id, this, interruptor_on_home, &counts);
-
     /* If there's not enough data to rebalance, return `rebalanced: 0` but don't report
     an error */
-    bool actually_rebalanced = calculate_split_points_with_distribution(
-        counts, config.config.shards.size(), &config.shard_scheme);
+    bool actually_rebalanced;
+    if (mode == rebalance_mode_t::LOAD) {
+        std::map<store_key_t, double> loads;
+        fetch_load_distribution(table_id, this, interruptor_on_home, &loads);
+        table_shard_scheme_t old_shard_scheme = config.shard_scheme;
+        bool split_points_changed = calculate_split_points_with_load(
+            loads, config.config.shards.size(), old_shard_scheme, &config.shard_scheme);
+        bool primaries_changed = choose_primaries_with_load(
+            calculate_shard_loads(loads, config.shard_scheme), &config.config.shards);
+        actually_rebalanced = split_points_changed || primaries_changed;
+    } else {
+        std::map<store_key_t, int64_t> counts;
+        fetch_distribution(table_id, this, interruptor_on_home, &counts);
+        actually_rebalanced = calculate_split_points_with_distribution(
+            counts, config.config.shards.size(), &config.shard_scheme);
+    }
     if (actually_rebalanced) {
         table_config_and_shards_change_t table_config_and_shards_change(
             table_config_and_shards_change_t::set_table_config_and_shards_t{ config });
@@ -1045,6 +1059,7 @@ bool real_reql_cluster_interface_t::table_rebalance(
         auth::user_context_t const &user_context,
         counted_t<const ql::db_t> db,
         const name_string_t &name,
+        rebalance_mode_t mode,
         signal_t *interruptor_on_caller,
         ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -1059,7 +1074,8 @@ bool real_reql_cluster_interface_t::table_rebalance(
 
         user_context.require_config_permission(m_rdb_context, db->id, table_id);
 
-        rebalance_internal(user_context, table_id, &interruptor_on_home, result_out);
+        rebalance_internal(
+            user_context, table_id, mode, &interruptor_on_home, result_out);
         return true;
     } catch (const admin_op_exc_t &admin_op_exc) {
         *error_out = admin_op_exc.to_admin_err();
@@ -1073,6 +1089,7 @@ bool real_reql_cluster_interface_t::table_rebalance(
 bool real_reql_cluster_interface_t::db_rebalance(
         auth::user_context_t const &user_context,
         counted_t<const ql::db_t> db,
+        rebalance_mode_t mode,
         signal_t *interruptor_on_caller,
         ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -1096,7 +1113,8 @@ bool real_reql_cluster_interface_t::db_rebalance(
     for (const auto &table_id : table_ids) {
         ql::datum_t stats;
         try {
-            rebalance_internal(user_context, table_id, &interruptor_on_home, &stats);
+            rebalance_internal(
+                user_context, table_id, mode, &interruptor_on_home, &stats);
         } catch (const no_such_table_exc_t &) {
             /* This table was deleted while we were iterating over the tables list. So
             just ignore it to avoid making a confusing error message. */
@@ -86,6 +86,7 @@ public:
             const table_generate_config_params_t &config_params,
             const std::string &primary_key,
             write_durability_t durability,
+            size_t num_cpu_shards,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out);
@@ -176,12 +177,14 @@ public:
             auth::user_context_t const &user_context,
             counted_t<const ql::db_t> db,
             const name_string_t &name,
+            rebalance_mode_t mode,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out);
     bool db_rebalance(
             auth::user_context_t const &user_context,
             counted_t<const ql::db_t> db,
+            rebalance_mode_t mode,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out);
@@ -336,6 +339,7 @@ private:
     void rebalance_internal(
             auth::user_context_t const &user_context,
             const namespace_id_t &table_id,
+            rebalance_mode_t mode,
             signal_t *interruptor,
             ql::datum_t *results_out)
             THROWS_ONLY(interrupted_exc_t, no_such_table_exc_t,
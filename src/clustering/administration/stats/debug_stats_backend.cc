@@ -6,17 +6,21 @@
 #include "clustering/administration/main/watchable_fields.hpp"
 
 debug_stats_artificial_table_backend_t::debug_stats_artificial_table_backend_t(
+        const name_string_t &_table_name,
+        const std::vector<stat_manager_t::stat_id_t> &_stat_path,
         rdb_context_t *rdb_context,
         lifetime_t<name_resolver_t const &> name_resolver,
         watchable_map_t<peer_id_t, cluster_directory_metadata_t> *_directory_view,
         server_config_client_t *_server_config_client,
         mailbox_manager_t *_mailbox_manager)
     : common_server_artificial_table_backend_t(
-        name_string_t::guarantee_valid("_debug_stats"),
+        _table_name,
         rdb_context,
         name_resolver,
         _server_config_client,
         _directory_view),
+      table_name(_table_name),
+      stat_path(_stat_path),
       directory_view(_directory_view),
       mailbox_manager(_mailbox_manager) {
 }
@@ -35,7 +39,8 @@ bool debug_stats_artificial_table_backend_t::write_row(
     user_context.require_admin_user();
 
     *error_out = admin_err_t{
-        "It's illegal to write to the `rethinkdb._debug_stats` table.",
+        strprintf("It's illegal to write to the `rethinkdb.%s` table.",
+                  table_name.c_str()),
         query_state_t::FAILED};
     return false;
 }
@@ -58,7 +63,19 @@ bool debug_stats_artificial_table_backend_t::format_row(
     ql::datum_t stats;
     admin_err_t stats_error;
     if (stats_for_server(server_id, interruptor_on_home, &stats, &stats_error)) {
-        builder.overwrite("stats", stats);
+        if (stat_path.empty()) {
+            builder.overwrite("stats", stats);
+        } else {
+            for (const auto &stat_id : stat_path) {
+                stats = stats.get_field(datum_string_t(stat_id), ql::NOTHROW);
+                if (!stats.has()) {
+                    break;
+                }
+            }
+            builder.overwrite(
+                datum_string_t(stat_path.back()),
+                stats.has() ? stats : ql::datum_t::null());
+        }
     } else {
         builder.overwrite("error", ql::datum_t(datum_string_t(stats_error.msg)));
     }
@@ -90,9 +107,9 @@ bool debug_stats_artificial_table_backend_t::stats_for_server(
         return false;
     }
 
-    /* Make a filter that includes everything */
+    /* Make a filter that includes everything under `stat_path` */
     std::set<std::vector<std::string> > filter;
-    filter.insert(std::vector<stat_manager_t::stat_id_t>());
+    filter.insert(stat_path);
 
     return fetch_stats_from_server(
         mailbox_manager,
@@ -14,11 +14,18 @@
 
 class server_config_client_t;
 
+/* `debug_stats_artificial_table_backend_t` implements `rethinkdb._debug_stats`, which
+has one row per server with all of its stats.  If `stat_path` is non-empty, the rows
+only contain the stats under that path instead, in a field named after the last
+component of the path.  `rethinkdb._debug_coro_profile` uses this for the
+`coro_profile` stats. */
 class debug_stats_artificial_table_backend_t :
     public common_server_artificial_table_backend_t
 {
 public:
     debug_stats_artificial_table_backend_t(
+            const name_string_t &table_name,
+            const std::vector<stat_manager_t::stat_id_t> &stat_path,
             rdb_context_t *rdb_context,
             lifetime_t<name_resolver_t const &> name_resolver,
             watchable_map_t<peer_id_t, cluster_directory_metadata_t> *_directory,
@@ -50,6 +57,8 @@ private:
             ql::datum_t *stats_out,
             admin_err_t *error_out);
 
+    name_string_t table_name;
+    std::vector<stat_manager_t::stat_id_t> stat_path;
     watchable_map_t<peer_id_t, cluster_directory_metadata_t> *directory_view;
     mailbox_manager_t *mailbox_manager;
 };
@@ -1,6 +1,8 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "clustering/administration/stats/request.hpp"
 
+#include <algorithm>
+
 #include "clustering/administration/datum_adapter.hpp"
 #include "clustering/administration/servers/config_client.hpp"
 #include "clustering/table_manager/table_meta_client.hpp"
@@ -125,6 +127,11 @@ void parsed_stats_t::store_shard_values(const ql::datum_t &shard_perf,
                 } else if (key == "cache") {
                     add_perfmon_value(sub_pair.second, "in_use_bytes",
                                       &stats_out->in_use_bytes);
+                } else if (key == "key_load") {
+                    r_sanity_check(sub_pair.second.get_type() == ql::datum_t::R_ARRAY);
+                    for (size_t k = 0; k < sub_pair.second.arr_size(); ++k) {
+                        stats_out->hot_key_ranges.push_back(sub_pair.second.get(k));
+                    }
                 }
             }
         }
@@ -167,6 +174,21 @@ void parsed_stats_t::store_query_engine_stats(const ql::datum_t &qe_perf,
     store_perfmon_value(qe_perf, "queries_total", &stats_out->queries_total);
     store_perfmon_value(qe_perf, "client_connections", &stats_out->client_connections);
     store_perfmon_value(qe_perf, "clients_active", &stats_out->clients_active);
+
+    ql::datum_t conns_perf = qe_perf.get_field("connections",
+                                               ql::throw_bool_t::NOTHROW);
+    if (conns_perf.has()) {
+        r_sanity_check(conns_perf.get_type() == ql::datum_t::R_OBJECT);
+        ql::datum_array_builder_t conns_builder(ql::configured_limits_t::unlimited);
+        for (size_t i = 0; i < conns_perf.obj_size(); ++i) {
+            std::pair<datum_string_t, ql::datum_t> pair = conns_perf.get_pair(i);
+            r_sanity_check(pair.second.get_type() == ql::datum_t::R_OBJECT);
+            ql::datum_object_builder_t conn_builder(pair.second);
+            conn_builder.overwrite("client_address", ql::datum_t(pair.first));
+            conns_builder.add(std::move(conn_builder).to_datum());
+        }
+        stats_out->connections = std::move(conns_builder).to_datum();
+    }
 }
 
 void parsed_stats_t::store_table_stats(const namespace_id_t &table_id,
@@ -452,6 +474,9 @@ bool server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_STAT(qe_builder, server_stats, clients_active);
         ADD_STAT(qe_builder, server_stats, queries_per_sec);
         ADD_STAT(qe_builder, server_stats, queries_total);
+        if (server_stats.connections.has()) {
+            qe_builder.overwrite("connections", server_stats.connections);
+        }
         ADD_SERVER_STAT(qe_builder, stats, server_id, read_docs_per_sec);
         ADD_SERVER_STAT(qe_builder, stats, server_id, read_docs_total);
         ADD_SERVER_STAT(qe_builder, stats, server_id, written_docs_per_sec);
@@ -550,6 +575,18 @@ bool table_server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_STAT(qe_builder, table_stats, written_docs_per_sec);
         ADD_STAT(qe_builder, table_stats, written_docs_total);
 
+        std::vector<ql::datum_t> hot_key_ranges = table_stats.hot_key_ranges;
+        auto range_load = [](const ql::datum_t &d) {
+            return d.get_field("reads_per_sec").as_num()
+                + d.get_field("writes_per_sec").as_num();
+        };
+        std::sort(hot_key_ranges.begin(), hot_key_ranges.end(),
+            [&](const ql::datum_t &a, const ql::datum_t &b) {
+                return range_load(a) > range_load(b);
+            });
+        qe_builder.overwrite("hot_key_ranges", ql::datum_t(
+            std::move(hot_key_ranges), ql::configured_limits_t::unlimited));
+
         ql::datum_object_builder_t se_cache_builder;
         ADD_STAT(se_cache_builder, table_stats, in_use_bytes);
 
@@ -36,6 +36,9 @@ public:
         double read_bytes_total;
         double written_bytes_per_sec;
         double written_bytes_total;
+        // The busiest key ranges of every shard on the server, as reported by the
+        // `key_load_sampler_t`s. Only filled in for `table_server` requests.
+        std::vector<ql::datum_t> hot_key_ranges;
     };
 
     struct server_stats_t {
@@ -46,6 +49,9 @@ public:
         double queries_total;
         double client_connections;
         double clients_active;
+        // An array with the stats of every client connection, or an empty datum if
+        // they weren't requested.
+        ql::datum_t connections;
 
         std::map<namespace_id_t, table_stats_t> tables;
     };
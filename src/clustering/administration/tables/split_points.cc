@@ -1,5 +1,9 @@
 #include "clustering/administration/tables/split_points.hpp"
 
+#include <math.h>
+
+#include <algorithm>
+
 #include "clustering/administration/real_reql_cluster_interface.hpp"
 #include "math.hpp"   /* for `clamp()` */
 #include "rdb_protocol/real_table.hpp"
@@ -85,11 +89,12 @@ static void ensure_distinct(std::vector<store_key_t> *split_points) {
     }
 }
 
-void fetch_distribution(
+static void do_distribution_read(
         const namespace_id_t &table_id,
         real_reql_cluster_interface_t *reql_cluster_interface,
+        read_mode_t read_mode,
         signal_t *interruptor,
-        std::map<store_key_t, int64_t> *counts_out)
+        distribution_read_response_t *response_out)
         THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t, no_such_table_exc_t) {
     namespace_interface_access_t ns_if_access =
         reql_cluster_interface->get_namespace_repo()->get_namespace_interface(
@@ -97,7 +102,7 @@ void fetch_distribution(
     static const int depth = 2;
     static const int limit = 128;
     distribution_read_t inner_read(depth, limit);
-    read_t read(inner_read, profile_bool_t::DONT_PROFILE, read_mode_t::OUTDATED);
+    read_t read(inner_read, profile_bool_t::DONT_PROFILE, read_mode);
     read_response_t resp;
     try {
         ns_if_access.get()->read(
@@ -113,8 +118,31 @@ void fetch_distribution(
         /* If `get_name()` didn't throw, the table exists but is inaccessible */
         throw failed_table_op_exc_t();
     }
-    *counts_out = std::move(
-        boost::get<distribution_read_response_t>(resp.response).key_counts);
+    *response_out = std::move(boost::get<distribution_read_response_t>(resp.response));
+}
+
+void fetch_distribution(
+        const namespace_id_t &table_id,
+        real_reql_cluster_interface_t *reql_cluster_interface,
+        signal_t *interruptor,
+        std::map<store_key_t, int64_t> *counts_out)
+        THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t, no_such_table_exc_t) {
+    distribution_read_response_t resp;
+    do_distribution_read(table_id, reql_cluster_interface, read_mode_t::OUTDATED,
+        interruptor, &resp);
+    *counts_out = std::move(resp.key_counts);
+}
+
+void fetch_load_distribution(
+        const namespace_id_t &table_id,
+        real_reql_cluster_interface_t *reql_cluster_interface,
+        signal_t *interruptor,
+        std::map<store_key_t, double> *loads_out)
+        THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t, no_such_table_exc_t) {
+    distribution_read_response_t resp;
+    do_distribution_read(table_id, reql_cluster_interface, read_mode_t::SINGLE,
+        interruptor, &resp);
+    *loads_out = std::move(resp.key_loads);
 }
 
 bool calculate_split_points_with_distribution(
@@ -156,6 +184,156 @@ bool calculate_split_points_with_distribution(
     return true;
 }
 
+/* A shard or a server is only considered overloaded if it has this many times the
+average load. */
+static const double load_rebalance_threshold = 1.5;
+
+/* The new split points or primaries are only used if they bring the load of the busiest
+shard or server down to this fraction of what it was before. */
+static const double load_rebalance_min_improvement = 0.8;
+
+/* Below this many operations per second, the load isn't worth rebalancing for, and the
+samples are too sparse to go by. */
+static const double load_rebalance_min_total = 10.0;
+
+std::vector<double> calculate_shard_loads(
+        const std::map<store_key_t, double> &loads,
+        const table_shard_scheme_t &split_points) {
+    std::vector<double> shard_loads(split_points.num_shards(), 0.0);
+    for (const auto &pair : loads) {
+        shard_loads[split_points.find_shard_for_key(pair.first)] += pair.second;
+    }
+    return shard_loads;
+}
+
+bool calculate_split_points_with_load(
+        const std::map<store_key_t, double> &loads,
+        size_t num_shards,
+        const table_shard_scheme_t &old_split_points,
+        table_shard_scheme_t *split_points_out) {
+    /* Most of the load samples are for individual keys, so unlike with the key counts
+    in `calculate_split_points_with_distribution()`, we treat each sample as the load of
+    its key rather than spreading it over the range up to the next sample. So we only
+    ever split right before a sampled key. `boundaries[i]` is the load of the samples
+    before `keys[i]`. */
+    std::vector<store_key_t> keys;
+    std::vector<double> boundaries;
+    double total_load = 0;
+    for (const auto &pair : loads) {
+        if (pair.second > 0) {
+            keys.push_back(pair.first);
+            boundaries.push_back(total_load);
+            total_load += pair.second;
+        }
+    }
+    if (total_load < load_rebalance_min_total || keys.size() < num_shards) {
+        return false;
+    }
+
+    double old_max = 0;
+    if (old_split_points.num_shards() == num_shards) {
+        std::vector<double> old_loads = calculate_shard_loads(loads, old_split_points);
+        old_max = *std::max_element(old_loads.begin(), old_loads.end());
+        if (old_max <= load_rebalance_threshold * total_load / num_shards) {
+            return false;
+        }
+    }
+
+    /* Split before the sampled key whose boundary is closest to the ideal one, leaving
+    enough keys for the remaining split points. */
+    table_shard_scheme_t new_split_points;
+    size_t next_key = 1;
+    for (size_t split_index = 1; split_index < num_shards; ++split_index) {
+        double target = (split_index * total_load) / num_shards;
+        size_t last_key = keys.size() - (num_shards - split_index);
+        size_t best = next_key;
+        for (size_t i = next_key; i <= last_key; ++i) {
+            if (fabs(boundaries[i] - target) < fabs(boundaries[best] - target)) {
+                best = i;
+            }
+            if (boundaries[i] > target) {
+                break;
+            }
+        }
+        new_split_points.split_points.push_back(keys[best]);
+        next_key = best + 1;
+    }
+
+    if (old_split_points.num_shards() == num_shards) {
+        std::vector<double> new_loads = calculate_shard_loads(loads, new_split_points);
+        double new_max = *std::max_element(new_loads.begin(), new_loads.end());
+        if (new_max > load_rebalance_min_improvement * old_max) {
+            return false;
+        }
+    }
+    *split_points_out = std::move(new_split_points);
+    return true;
+}
+
+bool choose_primaries_with_load(
+        const std::vector<double> &shard_loads,
+        std::vector<table_config_t::shard_t> *shards) {
+    guarantee(shard_loads.size() == shards->size());
+    std::map<server_id_t, double> old_server_loads;
+    double total_load = 0;
+    for (size_t i = 0; i < shards->size(); ++i) {
+        for (const server_id_t &server : shards->at(i).voting_replicas()) {
+            old_server_loads.insert(std::make_pair(server, 0.0));
+        }
+        old_server_loads[shards->at(i).primary_replica] += shard_loads[i];
+        total_load += shard_loads[i];
+    }
+    if (total_load < load_rebalance_min_total) {
+        return false;
+    }
+    double old_max = 0;
+    for (const auto &pair : old_server_loads) {
+        old_max = std::max(old_max, pair.second);
+    }
+    if (old_max <= load_rebalance_threshold * total_load / old_server_loads.size()) {
+        return false;
+    }
+
+    /* Hand out the busiest shards first, each to the least busy of its voting replicas.
+    On a tie we keep the current primary. */
+    std::vector<size_t> order(shards->size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return shard_loads[a] > shard_loads[b];
+    });
+    std::map<server_id_t, double> new_server_loads;
+    std::vector<server_id_t> new_primaries(shards->size());
+    for (size_t i : order) {
+        const table_config_t::shard_t &shard = shards->at(i);
+        server_id_t best = shard.primary_replica;
+        for (const server_id_t &server : shard.voting_replicas()) {
+            if (new_server_loads[server] < new_server_loads[best]) {
+                best = server;
+            }
+        }
+        new_primaries[i] = best;
+        new_server_loads[best] += shard_loads[i];
+    }
+    double new_max = 0;
+    for (const auto &pair : new_server_loads) {
+        new_max = std::max(new_max, pair.second);
+    }
+    if (new_max > load_rebalance_min_improvement * old_max) {
+        return false;
+    }
+
+    bool changed = false;
+    for (size_t i = 0; i < shards->size(); ++i) {
+        if (shards->at(i).primary_replica != new_primaries[i]) {
+            shards->at(i).primary_replica = new_primaries[i];
+            changed = true;
+        }
+    }
+    return changed;
+}
+
 store_key_t key_for_uuid(uint64_t first_8_bytes) {
     uuid_u uuid;
     memset(uuid.data(), 0, uuid_u::static_size());
@@ -7,12 +7,12 @@
 #include <vector>
 
 #include "btree/keys.hpp"
+#include "clustering/administration/tables/table_metadata.hpp"
 #include "clustering/table_manager/table_meta_client.hpp"
 #include "containers/uuid.hpp"
 
 class real_reql_cluster_interface_t;
 class signal_t;
-class table_shard_scheme_t;
 
 /* `fetch_distribution` fetches the distribution information from the database. */
 void fetch_distribution(
@@ -31,6 +31,43 @@ bool calculate_split_points_with_distribution(
         size_t num_shards,
         table_shard_scheme_t *split_points_out);
 
+/* `fetch_load_distribution` fetches the recent reads and writes per second in different
+parts of the table, as sampled by the stores. It reads from the primary replicas, because
+they serve all of the writes and all of the up-to-date reads. */
+void fetch_load_distribution(
+        const namespace_id_t &table_id,
+        real_reql_cluster_interface_t *reql_cluster_interface,
+        signal_t *interruptor,
+        std::map<store_key_t, double> *loads_out)
+        THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t, no_such_table_exc_t);
+
+/* `calculate_shard_loads` adds up the results of `fetch_load_distribution()` for each
+shard of the given scheme. */
+std::vector<double> calculate_shard_loads(
+        const std::map<store_key_t, double> &loads,
+        const table_shard_scheme_t &split_points);
+
+/* `calculate_split_points_with_load` generates a set of split points that divide the
+load approximately evenly, using the results of `fetch_load_distribution()`. Moving
+shard boundaries means moving data around, so this has some hysteresis: it only returns
+`true` if the busiest shard under `old_split_points` has noticeably more than its share
+of the load, and the new split points take a good part of that away from it. Otherwise,
+or if there's too little load to go by, it returns `false`. */
+bool calculate_split_points_with_load(
+        const std::map<store_key_t, double> &loads,
+        size_t num_shards,
+        const table_shard_scheme_t &old_split_points,
+        table_shard_scheme_t *split_points_out);
+
+/* `choose_primaries_with_load` moves the primary replicas of the shards between their
+voting replicas, so that the load of the shards is spread evenly over the servers. Like
+`calculate_split_points_with_load()`, it leaves the primaries alone unless that's a
+clear improvement. It only considers this table's load. Returns `true` if it changed
+any primary. */
+bool choose_primaries_with_load(
+        const std::vector<double> &shard_loads,
+        std::vector<table_config_t::shard_t> *shards);
+
 /* `calculate_split_points_for_uuids` generates a set of split points that will divide
 the range of UUIDs evenly. */
 void calculate_split_points_for_uuids(
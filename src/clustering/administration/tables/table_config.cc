@@ -711,7 +711,7 @@ void table_config_artificial_table_backend_t::do_create(
     calculate_split_points_for_uuids(
         new_config.config.shards.size(), &new_config.shard_scheme);
 
-    table_meta_client->create(table_id, new_config, interruptor);
+    table_meta_client->create(table_id, new_config, CPU_SHARDING_FACTOR, interruptor);
 }
 
 bool table_config_artificial_table_backend_t::write_row(
@@ -34,6 +34,11 @@ public:
     /* The maximum size, in bytes, of a chunk of pre-items sent over the network from the
     backfillee to the backfiller. */
     size_t pre_item_chunk_mem_size;
+
+    /* The number of sub-ranges that the backfiller traverses concurrently within one
+    backfill session. The items are still sent to the backfillee in lexicographical
+    order. */
+    size_t num_streams;
 };
 
 RDB_DECLARE_SERIALIZABLE(backfill_config_t);
@@ -1,6 +1,10 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/backfiller.hpp"
 
+#include <algorithm>
+#include <deque>
+#include <vector>
+
 #include "clustering/immediate_consistency/history.hpp"
 #include "rdb_protocol/distribution_progress.hpp"
 #include "rdb_protocol/protocol.hpp"
@@ -89,6 +93,7 @@ backfiller_t::client_t::client_t(
     /* Fetch the key distribution from the store, this is used by the backfillee to
     calculate the progress of backfill jobs. */
     distribution_progress_estimator_t progress_estimator(parent->store, interruptor);
+    key_distribution = progress_estimator;
 
     /* Estimate the total number of changes that will need to be backfilled, by comparing
     `our_version`, `intro.initial_version`, and `common_version`. We estimate the number
@@ -211,215 +216,321 @@ private:
     key_range_t::right_bound_t last_cursor;
 };
 
+/* `copy_pre_items()` returns a copy of the part of `pre_items` between `left` and
+`right`, or between `left` and the right-hand end of `pre_items` if that comes first. */
+static backfill_item_seq_t<backfill_pre_item_t> copy_pre_items(
+        const backfill_item_seq_t<backfill_pre_item_t> &pre_items,
+        const key_range_t::right_bound_t &left,
+        const key_range_t::right_bound_t &right) {
+    guarantee(pre_items.get_left_key() <= left);
+    guarantee(pre_items.get_right_key() >= left);
+    key_range_t::right_bound_t limit = std::min(right, pre_items.get_right_key());
+    backfill_item_seq_t<backfill_pre_item_t> copy(
+        pre_items.get_beg_hash(), pre_items.get_end_hash(), left);
+    for (const backfill_pre_item_t &pre_item : pre_items) {
+        if (pre_item.range.right <= left) {
+            continue;
+        }
+        if (key_range_t::right_bound_t(pre_item.range.left) >= limit) {
+            break;
+        }
+        backfill_pre_item_t masked = pre_item;
+        if (key_range_t::right_bound_t(masked.range.left) < left) {
+            masked.range.left = left.key();
+        }
+        if (masked.range.right > limit) {
+            masked.range.right = limit;
+        }
+        copy.push_back(std::move(masked));
+    }
+    copy.push_back_nothing(limit);
+    return copy;
+}
+
 /* When the `client_t` receives a begin-session message from the backfillee, it creates a
 `session_t`. The `session_t` is responsible for sending items to the backfillee. When the
 session is over, the backfillee will send an end-session message to the `client_t`, which
 will destroy the `session_t` and then send an ack-end-session message back to the
-backfillee. */
+backfillee.
+
+Nearly all of the work of a session goes into traversing the B-tree, which mostly means
+waiting for the disk. So the `session_t` splits the range it has to backfill into up to
+`intro.config.num_streams` sub-ranges and starts a `stream_t` for each of them. Every
+stream traverses its own sub-range ahead of time into a queue of chunks, with its own
+limit on the queue's size. The session then sends the chunks to the backfillee in
+lexicographical order, which is the order the backfillee expects them in. */
 class backfiller_t::client_t::session_t {
 public:
     session_t(client_t *_parent, const key_range_t::right_bound_t &_threshold) :
-        parent(_parent), threshold(_threshold), pulse_when_pre_items_arrive(nullptr)
+        parent(_parent), threshold(_threshold),
+        max_sent_timestamp(state_timestamp_t::zero())
     {
         guarantee(parent->pre_items.empty_of_items() ||
             key_range_t::right_bound_t(parent->pre_items.front().range.left)
                 >= threshold,
             "Every key must be backfilled at least once; it's not OK to start a new "
             "session after the end of the furthest-right previous session");
+        if (threshold != parent->full_region.inner.right) {
+            key_range_t remaining = parent->full_region.inner;
+            remaining.left = threshold.key();
+            std::vector<store_key_t> split_points =
+                parent->key_distribution.split_range(
+                    remaining, parent->intro.config.num_streams);
+            key_range_t::right_bound_t left = threshold;
+            for (const store_key_t &key : split_points) {
+                streams.emplace_back(
+                    new stream_t(this, left, key_range_t::right_bound_t(key)));
+                left = key_range_t::right_bound_t(key);
+            }
+            streams.emplace_back(
+                new stream_t(this, left, parent->full_region.inner.right));
+            for (const scoped_ptr_t<stream_t> &stream : streams) {
+                coro_t::spawn_sometime(
+                    std::bind(&stream_t::run, stream.get(), drainer.lock()));
+            }
+        }
         coro_t::spawn_sometime(std::bind(&session_t::run, this, drainer.lock()));
     }
 
     /* Every time the `client_t` receives more pre-items from the backfillee, it calls
     `on_pre_items()` to notify us. */
     void on_pre_items() {
-        if (pulse_when_pre_items_arrive != nullptr) {
-            pulse_when_pre_items_arrive->pulse_if_not_already_pulsed();
+        for (const scoped_ptr_t<stream_t> &stream : streams) {
+            stream->on_pre_items();
         }
     }
 
 private:
-    void run(auto_drainer_t::lock_t keepalive) {
-        with_priority_t p(CORO_PRIORITY_BACKFILL_SENDER);
-        try {
-            while (threshold != parent->full_region.inner.right) {
-                /* Wait until there's room in the semaphore for the chunk we're about to
-                process.
-                We acquire the maximum size that we want to put in this chunk first,
-                and then adjust the semaphore acquisition to the actual size of the
-                chunk later. */
-                new_semaphore_in_line_t sem_acq(
-                    &parent->item_throttler, parent->intro.config.item_chunk_mem_size);
-                wait_interruptible(
-                    sem_acq.acquisition_signal(), keepalive.get_drain_signal());
-
-                /* Wait until we have some pre items, or else we won't be able to make
-                any progress on the backfill */
-                while (parent->pre_items.get_right_key() == threshold) {
-                    cond_t cond;
-                    assignment_sentry_t<cond_t *> sentry(
-                        &pulse_when_pre_items_arrive, &cond);
-                    wait_interruptible(&cond, keepalive.get_drain_signal());
-                }
+    /* A `chunk_t` is a chunk of items that a `stream_t` has traversed but that hasn't
+    been sent to the backfillee yet. */
+    class chunk_t {
+    public:
+        chunk_t(backfill_item_seq_t<backfill_item_t> &&_items,
+                region_map_t<version_t> &&_metainfo,
+                new_semaphore_in_line_t &&_throttler_acq) :
+            items(std::move(_items)), metainfo(std::move(_metainfo)),
+            throttler_acq(std::move(_throttler_acq)) { }
+        backfill_item_seq_t<backfill_item_t> items;
+        region_map_t<version_t> metainfo;
+        /* Holds the chunk's mem size on the `throttler` of the stream it came from */
+        new_semaphore_in_line_t throttler_acq;
+    };
+
+    /* A `stream_t` traverses the range from `left` to `right`, one chunk at a time. */
+    class stream_t {
+    public:
+        stream_t(session_t *_session,
+                 const key_range_t::right_bound_t &left,
+                 const key_range_t::right_bound_t &_right) :
+            session(_session), cursor(left), right(_right),
+            throttler(std::max(
+                session->parent->intro.config.item_queue_mem_size
+                    / std::max<size_t>(1, session->parent->intro.config.num_streams),
+                session->parent->intro.config.item_chunk_mem_size)),
+            pulse_when_pre_items_arrive(nullptr),
+            pulse_when_chunk_ready(nullptr) { }
+
+        void on_pre_items() {
+            if (pulse_when_pre_items_arrive != nullptr) {
+                pulse_when_pre_items_arrive->pulse_if_not_already_pulsed();
+            }
+        }
 
-                /* Set up a `region_t` describing the range that still needs to be
-                backfilled */
-                region_t subregion = parent->full_region;
-                subregion.inner.left = threshold.key();
-
-                /* Copy items from the store into `chunk` until the total size hits
-                `item_chunk_mem_size`; we finish the backfill range; or we run out of
-                pre-items. */
-
-                backfill_item_seq_t<backfill_item_t> chunk(
-                    parent->full_region.beg, parent->full_region.end,
-                    threshold);
-                region_map_t<version_t> metainfo = region_map_t<version_t>::empty();
-
-                {
-                    /* `producer` will pop items off of `parent->pre_items` as
-                    `send_backfill()` requests them, but it will restore them all when it
-                    goes out of scope. Restoring them is important because when we
-                    interrupt `send_backfill()`, it might not yet have produced items
-                    corresponding to all of the pre-items it consumed, so those pre-items
-                    might be needed again in a later call to `send_backfill()`. It's a
-                    little sketchy that `producer` modifies `pre_items` like this, but
-                    it's safe because only one `session_t` can exist at once and because
-                    `client_t::on_pre_items` only touches the right-hand end of
-                    `parent->pre_items`. */
-                    item_seq_pre_item_producer_t producer(
-                        &parent->pre_items, threshold);
-
-                    /* `consumer_t` is responsible for receiving backfill items and
-                    the corresponding metainfo from `send_backfill()` and storing them in
-                    `chunk` and in `metainfo`. */
-                    class consumer_t : public store_view_t::backfill_item_consumer_t {
-                    public:
-                        consumer_t(
-                                backfill_item_seq_t<backfill_item_t> *_chunk,
-                                region_map_t<version_t> *_metainfo) :
-                            chunk(_chunk), metainfo(_metainfo) {
-                                guarantee(chunk->get_mem_size() == 0);
-                            }
-                        void on_item(
-                                const region_map_t<binary_blob_t> &item_metainfo,
-                                backfill_item_t &&item) THROWS_NOTHING {
-                            rassert(key_range_t::right_bound_t(item.range.left) >=
-                                chunk->get_right_key());
-                            rassert(!item.range.is_empty());
-                            on_metainfo(item_metainfo, item.range.right);
-                            chunk->push_back(std::move(item));
-                        }
-                        void on_empty_range(
-                                const region_map_t<binary_blob_t> &range_metainfo,
-                                const key_range_t::right_bound_t &new_threshold)
-                                THROWS_NOTHING {
-                            rassert(new_threshold >= chunk->get_right_key());
-                            on_metainfo(range_metainfo, new_threshold);
-                            chunk->push_back_nothing(new_threshold);
-                        }
-                    private:
-                        void on_metainfo(
-                                const region_map_t<binary_blob_t> &new_metainfo,
-                                const key_range_t::right_bound_t &new_threshold) {
-                            if (new_threshold == chunk->get_right_key()) {
-                                /* This is a no-op. But if `chunk->get_right_key()` is
-                                already unbounded, calling `key()` on it will crash. So
-                                the normal code path might break on certain no-ops and we
-                                should just return instead. */
-                                return;
-                            }
-                            region_t mask;
-                            mask.beg = chunk->get_beg_hash();
-                            mask.end = chunk->get_end_hash();
-                            mask.inner.left = chunk->get_right_key().key();
-                            mask.inner.right = new_threshold;
-                            metainfo->extend_keys_right(
-                                to_version_map(new_metainfo.mask(mask)));
-                        }
-                        backfill_item_seq_t<backfill_item_t> *const chunk;
-                        region_map_t<version_t> *const metainfo;
-                    } consumer(&chunk, &metainfo);
+        void run(auto_drainer_t::lock_t keepalive) {
+            with_priority_t p(CORO_PRIORITY_BACKFILL_SENDER);
+            const backfill_config_t &config = session->parent->intro.config;
+            try {
+                while (cursor != right) {
+                    /* Wait until there's room in our queue for another chunk. As in
+                    `session_t::send_chunk()`, we acquire the maximum size first and
+                    adjust it to the chunk's actual size later. */
+                    new_semaphore_in_line_t sem_acq(
+                        &throttler, config.item_chunk_mem_size);
+                    wait_interruptible(
+                        sem_acq.acquisition_signal(), keepalive.get_drain_signal());
+
+                    /* Wait until the pre items reach our position, or else we won't be
+                    able to make any progress on the backfill */
+                    while (session->parent->pre_items.get_right_key() <= cursor) {
+                        cond_t cond;
+                        assignment_sentry_t<cond_t *> sentry(
+                            &pulse_when_pre_items_arrive, &cond);
+                        wait_interruptible(&cond, keepalive.get_drain_signal());
+                    }
 
-                    backfill_item_memory_tracker_t memory_tracker(
-                        parent->intro.config.item_chunk_mem_size);
+                    backfill_item_seq_t<backfill_item_t> items(
+                        session->parent->full_region.beg,
+                        session->parent->full_region.end,
+                        cursor);
+                    region_map_t<version_t> metainfo = region_map_t<version_t>::empty();
+                    session->traverse(right, keepalive.get_drain_signal(),
+                        &items, &metainfo);
+                    if (items.empty_domain()) {
+                        continue;
+                    }
 
-                    parent->parent->store->send_backfill(
-                        parent->common_version.mask(subregion),
-                        &producer, &consumer, &memory_tracker,
-                        keepalive.get_drain_signal());
+                    sem_acq.change_count(items.get_mem_size());
+                    cursor = items.get_right_key();
+                    chunks.emplace_back(new chunk_t(
+                        std::move(items), std::move(metainfo), std::move(sem_acq)));
+                    if (pulse_when_chunk_ready != nullptr) {
+                        pulse_when_chunk_ready->pulse_if_not_already_pulsed();
+                    }
+                }
+            } catch (const interrupted_exc_t &) {
+                /* The session is being destroyed */
+            }
+        }
 
-                    /* `producer` goes out of scope here, so it restores `pre_items` to
-                    what it was before */
+        session_t *const session;
+
+        /* `cursor` is how far we've traversed; `right` is where our sub-range ends. */
+        key_range_t::right_bound_t cursor;
+        key_range_t::right_bound_t const right;
+
+        /* `throttler` limits the total mem size of the chunks in `chunks`. */
+        new_semaphore_t throttler;
+        std::deque<scoped_ptr_t<chunk_t> > chunks;
+
+        cond_t *pulse_when_pre_items_arrive;
+        cond_t *pulse_when_chunk_ready;
+    };
+
+    /* `traverse()` copies items from the store into `chunk` and `metainfo`, which must
+    start out empty, until the total size hits `item_chunk_mem_size`; we reach `right`;
+    or we run out of pre-items. */
+    void traverse(
+            const key_range_t::right_bound_t &right,
+            signal_t *interruptor,
+            backfill_item_seq_t<backfill_item_t> *chunk,
+            region_map_t<version_t> *metainfo) {
+        guarantee(chunk->empty_domain());
+        key_range_t::right_bound_t left = chunk->get_left_key();
+
+        /* Set up a `region_t` describing the range to traverse */
+        region_t subregion = parent->full_region;
+        subregion.inner.left = left.key();
+        subregion.inner.right = right;
+
+        /* `send_backfill()` reads from a copy of the pre-items, because other streams
+        may be traversing at the same time, and because `parent->pre_items` may only
+        shrink when we send a chunk over the network. */
+        backfill_item_seq_t<backfill_pre_item_t> pre_items =
+            copy_pre_items(parent->pre_items, left, right);
+        item_seq_pre_item_producer_t producer(&pre_items, left);
+
+        /* `consumer_t` is responsible for receiving backfill items and the
+        corresponding metainfo from `send_backfill()` and storing them in `chunk` and in
+        `metainfo`. */
+        class consumer_t : public store_view_t::backfill_item_consumer_t {
+        public:
+            consumer_t(
+                    backfill_item_seq_t<backfill_item_t> *_chunk,
+                    region_map_t<version_t> *_metainfo) :
+                chunk(_chunk), metainfo(_metainfo) {
+                    guarantee(chunk->get_mem_size() == 0);
                 }
+            void on_item(
+                    const region_map_t<binary_blob_t> &item_metainfo,
+                    backfill_item_t &&item) THROWS_NOTHING {
+                rassert(key_range_t::right_bound_t(item.range.left) >=
+                    chunk->get_right_key());
+                rassert(!item.range.is_empty());
+                on_metainfo(item_metainfo, item.range.right);
+                chunk->push_back(std::move(item));
+            }
+            void on_empty_range(
+                    const region_map_t<binary_blob_t> &range_metainfo,
+                    const key_range_t::right_bound_t &new_threshold)
+                    THROWS_NOTHING {
+                rassert(new_threshold >= chunk->get_right_key());
+                on_metainfo(range_metainfo, new_threshold);
+                chunk->push_back_nothing(new_threshold);
+            }
+        private:
+            void on_metainfo(
+                    const region_map_t<binary_blob_t> &new_metainfo,
+                    const key_range_t::right_bound_t &new_threshold) {
+                if (new_threshold == chunk->get_right_key()) {
+                    /* This is a no-op. But if `chunk->get_right_key()` is already
+                    unbounded, calling `key()` on it will crash. So the normal code path
+                    might break on certain no-ops and we should just return instead. */
+                    return;
+                }
+                region_t mask;
+                mask.beg = chunk->get_beg_hash();
+                mask.end = chunk->get_end_hash();
+                mask.inner.left = chunk->get_right_key().key();
+                mask.inner.right = new_threshold;
+                metainfo->extend_keys_right(
+                    to_version_map(new_metainfo.mask(mask)));
+            }
+            backfill_item_seq_t<backfill_item_t> *const chunk;
+            region_map_t<version_t> *const metainfo;
+        } consumer(chunk, metainfo);
+
+        backfill_item_memory_tracker_t memory_tracker(
+            parent->intro.config.item_chunk_mem_size);
+
+        parent->parent->store->send_backfill(
+            parent->common_version.mask(subregion),
+            &producer, &consumer, &memory_tracker, interruptor);
+    }
+
+    /* A chunk that a stream traversed ahead of time can only be sent if no part of it
+    is older than anything we've already sent. The backfillee requires the timestamps to
+    increase from left to right, because it discards the streaming writes that arrive
+    for the part of the range that it hasn't backfilled yet. */
+    bool is_up_to_date(const region_map_t<version_t> &metainfo) const {
+        bool up_to_date = true;
+        metainfo.visit(metainfo.get_domain(),
+        [&](const region_t &, const version_t &version) {
+            if (version.timestamp < max_sent_timestamp) {
+                up_to_date = false;
+            }
+        });
+        return up_to_date;
+    }
+
+    void run(auto_drainer_t::lock_t keepalive) {
+        with_priority_t p(CORO_PRIORITY_BACKFILL_SENDER);
+        try {
+            for (const scoped_ptr_t<stream_t> &stream : streams) {
+                while (threshold != stream->right) {
+                    while (stream->chunks.empty()) {
+                        cond_t cond;
+                        assignment_sentry_t<cond_t *> sentry(
+                            &stream->pulse_when_chunk_ready, &cond);
+                        wait_interruptible(&cond, keepalive.get_drain_signal());
+                    }
+                    scoped_ptr_t<chunk_t> chunk = std::move(stream->chunks.front());
+                    stream->chunks.pop_front();
+                    guarantee(chunk->items.get_left_key() == threshold);
+
+                    if (is_up_to_date(chunk->metainfo)) {
+                        send_chunk(std::move(chunk->items), chunk->metainfo,
+                            keepalive.get_drain_signal());
+                        continue;
+                    }
 
-                /* Check if we actually got a non-empty chunk; if we got an empty chunk
-                there's no point in sending it over the network. Note that we use
-                `empty_domain()` instead of `empty_of_items()`, because the knowledge
-                that there are no backfill items in the given range is still very useful
-                information for the backfillee to have. */
-                if (!chunk.empty_domain()) {
-                    /* Adjust for the fact that `chunk.get_mem_size()` isn't precisely
-                    equal to `item_chunk_mem_size`, and then transfer the semaphore
-                    ownership. */
-                    sem_acq.change_count(chunk.get_mem_size());
-                    parent->item_throttler_acq.transfer_in(std::move(sem_acq));
-
-                    /* Update `threshold` */
-                    guarantee(chunk.get_left_key() == threshold);
-                    threshold = chunk.get_right_key();
-
-                    /* Note: It's essential that we update `common_version` and
-                    `pre_items` if and only if we send the chunk over the network. So
-                    we shouldn't e.g. check the interruptor in between. This is because
-                    we want to make sure that `common_version` and `pre_items` accurately
-                    represent the state of the backfillee after it applies all the chunks
-                    we've sent. */
-                    try {
-                        /* Send the chunk over the network */
-                        send(parent->parent->mailbox_manager,
-                            parent->intro.items_mailbox,
-                            parent->fifo_source.enter_write(), metainfo, chunk);
-
-                        /* Update `common_version` to reflect the changes that will
-                        happen on the backfillee in response to the chunk */
-                        parent->common_version.update(
-                            metainfo.map(metainfo.get_domain(),
-                                [](const version_t &v) { return v.timestamp; }));
-
-                        /* Discard pre-items we don't need anymore. This has two
-                        purposes: it saves memory, and it keeps `pre_items` consistent
-                        with `common_version`. However, we note that the domain of the
-                        `pre_items` seq still starts at the left-hand end of the range to
-                        be backfilled, representing that there are no pre items there.
-                        This is correct because after the backfillee applies the item we
-                        just sent, it won't have any divergent data relative to us in
-                        that region. */
-                        size_t old_size = parent->pre_items.get_mem_size();
-                        parent->pre_items.delete_to_key(threshold);
-                        parent->pre_items.push_front_nothing(
-                            key_range_t::right_bound_t(parent->full_region.inner.left));
-                        size_t new_size = parent->pre_items.get_mem_size();
-
-                        /* Notify the backfiller that it's OK to send us more pre items.
-
-                        Note that the way we acknowledge pre-items is different from how
-                        the backfillee acknowledges items; the backfillee acknowledges
-                        items periodically during the call to `receive_backfill()`, but
-                        we wait until after `send_backfill()` returns to acknowledge the
-                        pre-items. This way of doing things is simpler; the reason we
-                        can't do things the same way in the backfillee is because the
-                        call to `receive_backfill()` might run for a long time, but our
-                        call to `send_backfill()` will only go until it fills up the
-                        chunk. */
-                        if (old_size != new_size) {
-                            send(parent->parent->mailbox_manager,
-                                parent->intro.ack_pre_items_mailbox,
-                                parent->fifo_source.enter_write(), old_size - new_size);
+                    /* Writes have been applied to the store since the stream traversed
+                    the chunk. Traverse the chunk's range again; this is usually cheap
+                    because the first traversal brought the blocks into the cache. */
+                    key_range_t::right_bound_t chunk_right =
+                        chunk->items.get_right_key();
+                    chunk.reset();
+                    while (threshold != chunk_right) {
+                        backfill_item_seq_t<backfill_item_t> items(
+                            parent->full_region.beg, parent->full_region.end,
+                            threshold);
+                        region_map_t<version_t> metainfo =
+                            region_map_t<version_t>::empty();
+                        traverse(chunk_right, keepalive.get_drain_signal(),
+                            &items, &metainfo);
+                        if (!items.empty_domain()) {
+                            send_chunk(std::move(items), metainfo,
+                                keepalive.get_drain_signal());
                         }
-                    } catch (const interrupted_exc_t &) {
-                        /* This is just a sanity check in case someone unthinkingly makes
-                        something interruptible in the above code block */
-                        crash("We shouldn't be interrupted during this block");
                     }
                 }
             }
@@ -429,20 +540,91 @@ private:
         }
     }
 
+    void send_chunk(
+            backfill_item_seq_t<backfill_item_t> &&chunk,
+            const region_map_t<version_t> &metainfo,
+            signal_t *interruptor) {
+        /* Wait until there's room in the backfillee's queue for the chunk, and then
+        transfer the semaphore ownership. */
+        new_semaphore_in_line_t sem_acq(&parent->item_throttler, chunk.get_mem_size());
+        wait_interruptible(sem_acq.acquisition_signal(), interruptor);
+        parent->item_throttler_acq.transfer_in(std::move(sem_acq));
+
+        /* Update `threshold` */
+        guarantee(chunk.get_left_key() == threshold);
+        threshold = chunk.get_right_key();
+
+        metainfo.visit(metainfo.get_domain(),
+        [&](const region_t &, const version_t &version) {
+            max_sent_timestamp = std::max(max_sent_timestamp, version.timestamp);
+        });
+
+        /* Note: It's essential that we update `common_version` and `pre_items` if and
+        only if we send the chunk over the network. So we shouldn't e.g. check the
+        interruptor in between. This is because we want to make sure that
+        `common_version` and `pre_items` accurately represent the state of the
+        backfillee after it applies all the chunks we've sent. */
+        try {
+            /* Send the chunk over the network */
+            send(parent->parent->mailbox_manager,
+                parent->intro.items_mailbox,
+                parent->fifo_source.enter_write(), metainfo, chunk);
+
+            /* Update `common_version` to reflect the changes that will happen on the
+            backfillee in response to the chunk */
+            parent->common_version.update(
+                metainfo.map(metainfo.get_domain(),
+                    [](const version_t &v) { return v.timestamp; }));
+
+            /* Discard pre-items we don't need anymore. This has two purposes: it saves
+            memory, and it keeps `pre_items` consistent with `common_version`. However,
+            we note that the domain of the `pre_items` seq still starts at the left-hand
+            end of the range to be backfilled, representing that there are no pre items
+            there. This is correct because after the backfillee applies the item we just
+            sent, it won't have any divergent data relative to us in that region. */
+            size_t old_size = parent->pre_items.get_mem_size();
+            parent->pre_items.delete_to_key(threshold);
+            parent->pre_items.push_front_nothing(
+                key_range_t::right_bound_t(parent->full_region.inner.left));
+            size_t new_size = parent->pre_items.get_mem_size();
+
+            /* Notify the backfiller that it's OK to send us more pre items.
+
+            Note that the way we acknowledge pre-items is different from how the
+            backfillee acknowledges items; the backfillee acknowledges items periodically
+            during the call to `receive_backfill()`, but we wait until the chunk is sent
+            to acknowledge the pre-items. This way of doing things is simpler; the reason
+            we can't do things the same way in the backfillee is because the call to
+            `receive_backfill()` might run for a long time, but our call to
+            `send_backfill()` will only go until it fills up the chunk. */
+            if (old_size != new_size) {
+                send(parent->parent->mailbox_manager,
+                    parent->intro.ack_pre_items_mailbox,
+                    parent->fifo_source.enter_write(), old_size - new_size);
+            }
+        } catch (const interrupted_exc_t &) {
+            /* This is just a sanity check in case someone unthinkingly makes something
+            interruptible in the above code block */
+            crash("We shouldn't be interrupted during this block");
+        }
+    }
+
     client_t *const parent;
 
-    /* This is the current location we've backfilled up to. Initially it's set to the
+    /* This is the current location we've sent items up to. Initially it's set to the
     point that the backfillee sent us with the begin-session message, and it moves right
     from there. */
     key_range_t::right_bound_t threshold;
 
-    /* This exists if we're waiting for more pre items. `on_pre_items()` pulses it if it
-    exists. */
-    cond_t *pulse_when_pre_items_arrive;
+    /* The highest timestamp of any chunk we've sent in this session */
+    state_timestamp_t max_sent_timestamp;
+
+    /* The streams, in lexicographical order of their sub-ranges */
+    std::vector<scoped_ptr_t<stream_t> > streams;
 
     /* Destructor order matters here: `drainer` must be destroyed before the other member
-    variables because `drainer` stops `run()`, which accesses the other member
-    variables. */
+    variables because `drainer` stops `run()` and `stream_t::run()`, which access the
+    other member variables. */
     auto_drainer_t drainer;
 };
 
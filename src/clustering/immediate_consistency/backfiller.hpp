@@ -93,6 +93,10 @@ private:
         region_map_t<state_timestamp_t> common_version;
         backfill_item_seq_t<backfill_pre_item_t> pre_items;
 
+        /* `key_distribution` is used to split the range of a backfill session into
+        sub-ranges of roughly equal size, which are then traversed concurrently. */
+        distribution_progress_estimator_t key_distribution;
+
         /* `item_throttler` limits the total mem size of the backfill items that are
         allowed to queue up on the backfillee. `item_throttler_acq` always holds
         `item_throttler`, but its `count` changes to reflect the total mem size that's
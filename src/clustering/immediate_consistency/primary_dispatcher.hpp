@@ -173,6 +173,11 @@ public:
         order_token_t tok,
         write_callback_t *cb);
 
+    /* Returns the timestamp of the latest write that has been dispatched. */
+    state_timestamp_t get_latest_timestamp() {
+        return current_timestamp;
+    }
+
     clone_ptr_t<watchable_t<std::set<server_id_t> > > get_ready_dispatchees() {
         return ready_dispatchees_as_set.get_watchable();
     }
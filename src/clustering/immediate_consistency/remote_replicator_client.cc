@@ -3,7 +3,9 @@
 
 #include "clustering/immediate_consistency/backfill_throttler.hpp"
 #include "clustering/immediate_consistency/backfillee.hpp"
+#include "clustering/immediate_consistency/staleness_tracker.hpp"
 #include "clustering/table_manager/backfill_progress_tracker.hpp"
+#include "concurrency/pmap.hpp"
 #include "stl_utils.hpp"
 #include "store_view.hpp"
 
@@ -152,12 +154,15 @@ remote_replicator_client_t::remote_replicator_client_t(
         store_view_t *store,
         branch_history_manager_t *branch_history_manager,
 
+        staleness_tracker_t *staleness_tracker,
+
         signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) :
 
     mailbox_manager_(mailbox_manager),
     store_(store),
     region_(store->get_region()),
     branch_id_(branch_id),
+    staleness_tracker_(staleness_tracker),
     mode_(backfill_mode_t::PAUSED),
 
     next_write_waiter_(nullptr),
@@ -168,12 +173,18 @@ remote_replicator_client_t::remote_replicator_client_t(
     write_sync_mailbox_(mailbox_manager,
         std::bind(&remote_replicator_client_t::on_write_sync, this,
             ph::_1, ph::_2, ph::_3, ph::_4, ph::_5, ph::_6)),
+    write_sync_batch_mailbox_(mailbox_manager,
+        std::bind(&remote_replicator_client_t::on_write_sync_batch, this,
+            ph::_1, ph::_2, ph::_3)),
     dummy_write_mailbox_(mailbox_manager,
         std::bind(&remote_replicator_client_t::on_dummy_write, this,
             ph::_1, ph::_2)),
     read_mailbox_(mailbox_manager,
         std::bind(&remote_replicator_client_t::on_read, this,
-            ph::_1, ph::_2, ph::_3, ph::_4))
+            ph::_1, ph::_2, ph::_3, ph::_4)),
+    timestamp_mailbox_(mailbox_manager,
+        std::bind(&remote_replicator_client_t::on_timestamp, this,
+            ph::_1, ph::_2))
 {
     guarantee(remote_replicator_server_bcard.branch == branch_id);
     guarantee(remote_replicator_server_bcard.region == region_);
@@ -210,8 +221,10 @@ remote_replicator_client_t::remote_replicator_client_t(
             intro_mailbox.get_address(),
             write_async_mailbox_.get_address(),
             write_sync_mailbox_.get_address(),
+            write_sync_batch_mailbox_.get_address(),
             dummy_write_mailbox_.get_address(),
-            read_mailbox_.get_address() };
+            read_mailbox_.get_address(),
+            timestamp_mailbox_.get_address() };
         registrant_.init(new registrant_t<remote_replicator_client_bcard_t>(
             mailbox_manager, remote_replicator_server_bcard.registrar, our_bcard));
         wait_interruptible(&got_intro, interruptor);
@@ -346,6 +359,7 @@ remote_replicator_client_t::remote_replicator_client_t(
         to create a `replica_t`. */
         replica_.init(new replica_t(mailbox_manager_, store_, branch_history_manager,
             branch_id, timestamp_enforcer_->get_latest_all_before_completed()));
+        update_staleness_tracker();
 
         tracker_.reset();   /* we don't need `tracker_` anymore */
         mode_ = backfill_mode_t::STREAMING;
@@ -359,11 +373,22 @@ remote_replicator_client_t::remote_replicator_client_t(
     /* Now that we're completely up-to-date, tell the primary that it's OK to send us
     reads and synchronous writes */
     send(mailbox_manager, intro.ready_mailbox);
+
+    if (staleness_tracker_ != nullptr) {
+        remote_replicator_client_intro_t::heartbeat_request_mailbox_t::address_t
+            heartbeat_request_mailbox = intro.heartbeat_request_mailbox;
+        staleness_tracker_->set_heartbeat_requester([this, heartbeat_request_mailbox]() {
+            send(mailbox_manager_, heartbeat_request_mailbox);
+        });
+    }
 }
 
 remote_replicator_client_t::~remote_replicator_client_t() {
     /* The destructor is declared here instead of the header file so that we can see the
     destructor for `timestamp_range_tracker_t` */
+    if (staleness_tracker_ != nullptr) {
+        staleness_tracker_->set_heartbeat_requester(std::function<void()>());
+    }
 }
 
 void remote_replicator_client_t::on_write_async(
@@ -373,6 +398,11 @@ void remote_replicator_client_t::on_write_async(
         order_token_t order_token,
         const mailbox_t<>::address_t &ack_addr)
         THROWS_ONLY(interrupted_exc_t) {
+    if (mode_ == backfill_mode_t::STREAMING) {
+        /* Record the timestamp as it arrives, before we wait for earlier writes. */
+        on_primary_timestamp(timestamp);
+    }
+
     wait_interruptible(&registered_, interruptor);
 
     timestamp_enforcer_->wait_all_before(timestamp.pred(), interruptor);
@@ -402,6 +432,7 @@ void remote_replicator_client_t::on_write_async(
         write_response_t dummy_response;
         replica_->do_write(write, timestamp, order_token, write_durability_t::SOFT,
             interruptor, &dummy_response);
+        update_staleness_tracker();
     } else {
         region_t clip_region;
         if (mode_ == backfill_mode_t::PAUSED) {
@@ -458,14 +489,47 @@ void remote_replicator_client_t::on_write_sync(
     once it's started sending sync writes, but we don't want to rely on that detail, so
     we pass sync writes through the timestamp enforcer too. */
     timestamp_enforcer_->complete(timestamp);
+    on_primary_timestamp(timestamp);
 
     write_response_t response;
     replica_->do_write(
         write, timestamp, order_token, durability,
         interruptor, &response);
+    update_staleness_tracker();
     send(mailbox_manager_, ack_addr, response);
 }
 
+void remote_replicator_client_t::on_write_sync_batch(
+        signal_t *interruptor,
+        const std::vector<remote_replicator_sync_write_t> &writes,
+        const mailbox_t<std::vector<write_response_t> >::address_t &ack_addr)
+        THROWS_ONLY(interrupted_exc_t) {
+    for (const remote_replicator_sync_write_t &write : writes) {
+        timestamp_enforcer_->complete(write.timestamp);
+        on_primary_timestamp(write.timestamp);
+    }
+
+    /* The writes must run concurrently rather than one after another, both so that the
+    store can pipeline them and because a write in this batch might have to wait for a
+    write with an earlier timestamp that's in a batch that hasn't arrived yet. */
+    std::vector<write_response_t> responses(writes.size());
+    bool interrupted = false;
+    pmap(writes.size(), [&](size_t i) {
+        try {
+            replica_->do_write(
+                writes[i].write, writes[i].timestamp, writes[i].order_token,
+                writes[i].durability, interruptor, &responses[i]);
+        } catch (const interrupted_exc_t &) {
+            interrupted = true;
+        }
+    });
+    if (interrupted) {
+        throw interrupted_exc_t();
+    }
+    update_staleness_tracker();
+    send(mailbox_manager_, ack_addr, responses);
+}
+
 void remote_replicator_client_t::on_dummy_write(
         signal_t *interruptor,
         const mailbox_t<write_response_t>::address_t &ack_addr)
@@ -486,6 +550,28 @@ void remote_replicator_client_t::on_read(
     send(mailbox_manager_, ack_addr, response);
 }
 
+void remote_replicator_client_t::on_timestamp(
+        UNUSED signal_t *interruptor,
+        state_timestamp_t primary_timestamp) {
+    /* We only ask for heartbeats once we're streaming. */
+    guarantee(replica_.has());
+    on_primary_timestamp(primary_timestamp);
+}
+
+void remote_replicator_client_t::on_primary_timestamp(
+        state_timestamp_t primary_timestamp) {
+    if (staleness_tracker_ != nullptr) {
+        staleness_tracker_->on_primary_timestamp(primary_timestamp);
+    }
+}
+
+void remote_replicator_client_t::update_staleness_tracker() {
+    if (staleness_tracker_ != nullptr) {
+        staleness_tracker_->on_applied_timestamp(
+            replica_->get_latest_applied_timestamp());
+    }
+}
+
 bool remote_replicator_client_t::next_write_can_proceed(
         mutex_assertion_t::acq_t *mutex_assertion_acq) {
     mutex_assertion_acq->assert_is_holding(&mutex_assertion_);
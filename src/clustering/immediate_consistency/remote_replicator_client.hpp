@@ -3,6 +3,7 @@
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_CLIENT_HPP_
 
 #include <queue>
+#include <vector>
 
 #include "clustering/generic/registrant.hpp"
 #include "clustering/immediate_consistency/backfill_throttler.hpp"
@@ -13,6 +14,7 @@
 #include "concurrency/semaphore.hpp"
 
 class backfill_progress_tracker_t;
+class staleness_tracker_t;
 
 /* `remote_replicator_client_t` contacts a `remote_replicator_server_t` on another server
 to sign up for writes to a given shard, and then applies them to a `store_t` on the same
@@ -71,6 +73,10 @@ public:
         store_view_t *store,
         branch_history_manager_t *branch_history_manager,
 
+        /* May be `nullptr`. Otherwise it's kept up to date with how far behind the
+        primary the store is, once the backfill is over. */
+        staleness_tracker_t *staleness_tracker,
+
         signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
 
     ~remote_replicator_client_t();
@@ -78,9 +84,10 @@ public:
 private:
     class timestamp_range_tracker_t;
 
-    /* `on_write_async()`, `on_write_sync()`, `on_dummy_write()`, and `on_read()`
-    are mailbox callbacks for `write_async_mailbox_`, `write_sync_mailbox_`,
-    `dummy_write_mailbox_` and `read_mailbox_`. */
+    /* `on_write_async()`, `on_write_sync()`, `on_write_sync_batch()`,
+    `on_dummy_write()`, `on_read()`, and `on_timestamp()` are mailbox callbacks for
+    `write_async_mailbox_`, `write_sync_mailbox_`, `write_sync_batch_mailbox_`,
+    `dummy_write_mailbox_`, `read_mailbox_`, and `timestamp_mailbox_`. */
     void on_write_async(
             signal_t *interruptor,
             write_t &&write,
@@ -98,6 +105,12 @@ private:
             const mailbox_t<write_response_t>::address_t &ack_addr)
         THROWS_ONLY(interrupted_exc_t);
 
+    void on_write_sync_batch(
+            signal_t *interruptor,
+            const std::vector<remote_replicator_sync_write_t> &writes,
+            const mailbox_t<std::vector<write_response_t> >::address_t &ack_addr)
+        THROWS_ONLY(interrupted_exc_t);
+
     void on_dummy_write(
             signal_t *interruptor,
             const mailbox_t<write_response_t>::address_t &ack_addr)
@@ -110,10 +123,22 @@ private:
             const mailbox_t<read_response_t>::address_t &ack_addr)
         THROWS_ONLY(interrupted_exc_t);
 
+    void on_timestamp(
+            signal_t *interruptor,
+            state_timestamp_t primary_timestamp);
+
+    /* Tells `staleness_tracker_` about a timestamp the primary has reached, either from
+    a heartbeat or from a write. */
+    void on_primary_timestamp(state_timestamp_t primary_timestamp);
+
+    /* Tells `staleness_tracker_` how far `replica_` has gotten. */
+    void update_staleness_tracker();
+
     mailbox_manager_t *const mailbox_manager_;
     store_view_t *const store_;
     region_t const region_;   /* same as `store_->get_region()` */
     branch_id_t const branch_id_;
+    staleness_tracker_t *const staleness_tracker_;
 
     /* During the constructor, we alternate between `PAUSED` and `BACKFILLING`. When the
     constructor is done, we switch to `STREAMING` mode and stay there. */
@@ -172,8 +197,11 @@ private:
 
     remote_replicator_client_bcard_t::write_async_mailbox_t write_async_mailbox_;
     remote_replicator_client_bcard_t::write_sync_mailbox_t write_sync_mailbox_;
+    remote_replicator_client_bcard_t::write_sync_batch_mailbox_t
+        write_sync_batch_mailbox_;
     remote_replicator_client_bcard_t::dummy_write_mailbox_t dummy_write_mailbox_;
     remote_replicator_client_bcard_t::read_mailbox_t read_mailbox_;
+    remote_replicator_client_bcard_t::timestamp_mailbox_t timestamp_mailbox_;
 
     /* We use `registrant_` to subscribe to a stream of reads and writes from the
     dispatcher via the `remote_replicator_server_t`. */
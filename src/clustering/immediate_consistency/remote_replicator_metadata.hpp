@@ -2,6 +2,8 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_METADATA_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_METADATA_HPP_
 
+#include <vector>
+
 #include "clustering/generic/registration_metadata.hpp"
 #include "clustering/immediate_consistency/history.hpp"
 #include "rdb_protocol/protocol.hpp"
@@ -9,13 +11,30 @@
 class remote_replicator_client_intro_t {
 public:
     typedef mailbox_t<> ready_mailbox_t;
+    /* Once the client is ready, it can ask for a heartbeat by sending to
+    `heartbeat_request_mailbox`. The primary answers on the client's
+    `timestamp_mailbox`. See `staleness_tracker_t`. */
+    typedef mailbox_t<> heartbeat_request_mailbox_t;
 
     state_timestamp_t streaming_begin_timestamp;
     ready_mailbox_t::address_t ready_mailbox;
+    heartbeat_request_mailbox_t::address_t heartbeat_request_mailbox;
 };
 
 RDB_DECLARE_SERIALIZABLE(remote_replicator_client_intro_t);
 
+/* `remote_replicator_sync_write_t` is one of the writes in a batch that the
+`remote_replicator_server_t` sends to the `remote_replicator_client_t` at once. */
+class remote_replicator_sync_write_t {
+public:
+    write_t write;
+    state_timestamp_t timestamp;
+    order_token_t order_token;
+    write_durability_t durability;
+};
+
+RDB_DECLARE_SERIALIZABLE(remote_replicator_sync_write_t);
+
 class remote_replicator_client_bcard_t {
 public:
     typedef mailbox_t<
@@ -29,6 +48,10 @@ public:
         write_t, state_timestamp_t, order_token_t, write_durability_t,
         mailbox_t<write_response_t>::address_t
         > write_sync_mailbox_t;
+    typedef mailbox_t<
+        std::vector<remote_replicator_sync_write_t>,
+        mailbox_t<std::vector<write_response_t> >::address_t
+        > write_sync_batch_mailbox_t;
     typedef mailbox_t<
         mailbox_t<write_response_t>::address_t
         > dummy_write_mailbox_t;
@@ -36,13 +59,21 @@ public:
         read_t, state_timestamp_t,
         mailbox_t<read_response_t>::address_t
         > read_mailbox_t;
+    /* The primary sends its latest timestamp to `timestamp_mailbox` when the client
+    asks for a heartbeat, so that the secondary can tell how far behind it is. See
+    `staleness_tracker_t`. */
+    typedef mailbox_t<
+        state_timestamp_t
+        > timestamp_mailbox_t;
 
     server_id_t server_id;
     intro_mailbox_t::address_t intro_mailbox;
     write_async_mailbox_t::address_t write_async_mailbox;
     write_sync_mailbox_t::address_t write_sync_mailbox;
+    write_sync_batch_mailbox_t::address_t write_sync_batch_mailbox;
     dummy_write_mailbox_t::address_t dummy_write_mailbox;
     read_mailbox_t::address_t read_mailbox;
+    timestamp_mailbox_t::address_t timestamp_mailbox;
 };
 
 RDB_DECLARE_SERIALIZABLE(remote_replicator_client_bcard_t);
@@ -1,6 +1,13 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/remote_replicator_server.hpp"
 
+/* While this many batches of sync writes are waiting for acks, further sync writes are
+held back and sent together with the next batch. */
+const size_t MAX_SYNC_WRITE_BATCHES_IN_FLIGHT = 4;
+
+/* A batch is sent regardless once it holds this many writes. */
+const size_t MAX_SYNC_WRITE_BATCH_SIZE = 64;
+
 remote_replicator_server_t::remote_replicator_server_t(
         mailbox_manager_t *_mailbox_manager,
         primary_dispatcher_t *_primary) :
@@ -14,9 +21,13 @@ remote_replicator_server_t::proxy_replica_t::proxy_replica_t(
         const remote_replicator_client_bcard_t &_client_bcard,
         UNUSED signal_t *interruptor) :
     client_bcard(_client_bcard), parent(_parent), is_ready(false),
+    sync_batches_in_flight(0),
     ready_mailbox(
         parent->mailbox_manager,
-        std::bind(&proxy_replica_t::on_ready, this, ph::_1))
+        std::bind(&proxy_replica_t::on_ready, this, ph::_1)),
+    heartbeat_request_mailbox(
+        parent->mailbox_manager,
+        std::bind(&proxy_replica_t::on_heartbeat_request, this, ph::_1))
 {
     state_timestamp_t first_timestamp;
     registration = make_scoped<primary_dispatcher_t::dispatchee_registration_t>(
@@ -24,7 +35,8 @@ remote_replicator_server_t::proxy_replica_t::proxy_replica_t(
     send(parent->mailbox_manager, client_bcard.intro_mailbox,
         remote_replicator_client_intro_t {
             first_timestamp,
-            ready_mailbox.get_address() });
+            ready_mailbox.get_address(),
+            heartbeat_request_mailbox.get_address() });
 }
 
 void remote_replicator_server_t::proxy_replica_t::do_read(
@@ -53,16 +65,80 @@ void remote_replicator_server_t::proxy_replica_t::do_write_sync(
         signal_t *interruptor,
         write_response_t *response_out) {
     guarantee(is_ready);
-    cond_t got_response;
-    mailbox_t<write_response_t> response_mailbox(
-        parent->mailbox_manager,
-        [&](signal_t *, const write_response_t &response) {
-            *response_out = response;
-            got_response.pulse();
-        });
-    send(parent->mailbox_manager, client_bcard.write_sync_mailbox,
-        write, timestamp, order_token, durability, response_mailbox.get_address());
-    wait_interruptible(&got_response, interruptor);
+    counted_t<pending_sync_write_t> pending = make_counted<pending_sync_write_t>();
+    pending->write = remote_replicator_sync_write_t {
+        write, timestamp, order_token, durability };
+    pending_sync_writes.push_back(pending);
+    if (sync_batches_in_flight < MAX_SYNC_WRITE_BATCHES_IN_FLIGHT
+            || pending_sync_writes.size() >= MAX_SYNC_WRITE_BATCH_SIZE) {
+        flush_sync_writes();
+    }
+    wait_interruptible(&pending->done, interruptor);
+    *response_out = std::move(pending->response);
+}
+
+void remote_replicator_server_t::proxy_replica_t::flush_sync_writes() {
+    if (pending_sync_writes.empty()) {
+        return;
+    }
+    ++sync_batches_in_flight;
+    std::vector<counted_t<pending_sync_write_t> > batch;
+    batch.swap(pending_sync_writes);
+    auto_drainer_t::lock_t keepalive(&sync_write_drainer);
+    coro_t::spawn_sometime([this, batch, keepalive /* important to capture */]() {
+        send_sync_write_batch(batch, keepalive);
+    });
+}
+
+void remote_replicator_server_t::proxy_replica_t::send_sync_write_batch(
+        const std::vector<counted_t<pending_sync_write_t> > &batch,
+        auto_drainer_t::lock_t keepalive) {
+    try {
+        cond_t got_response;
+        if (batch.size() == 1) {
+            /* A batch of one is sent the same way as before batching existed, so that
+            writes don't pay for the batching when the load is low. */
+            const remote_replicator_sync_write_t &write = batch[0]->write;
+            mailbox_t<write_response_t> response_mailbox(
+                parent->mailbox_manager,
+                [&](signal_t *, const write_response_t &response) {
+                    batch[0]->response = response;
+                    got_response.pulse();
+                });
+            send(parent->mailbox_manager, client_bcard.write_sync_mailbox,
+                write.write, write.timestamp, write.order_token, write.durability,
+                response_mailbox.get_address());
+            wait_interruptible(&got_response, keepalive.get_drain_signal());
+        } else {
+            std::vector<remote_replicator_sync_write_t> writes;
+            writes.reserve(batch.size());
+            for (const counted_t<pending_sync_write_t> &pending : batch) {
+                writes.push_back(pending->write);
+            }
+            mailbox_t<std::vector<write_response_t> > response_mailbox(
+                parent->mailbox_manager,
+                [&](signal_t *, const std::vector<write_response_t> &responses) {
+                    guarantee(responses.size() == batch.size());
+                    for (size_t i = 0; i < batch.size(); ++i) {
+                        batch[i]->response = responses[i];
+                    }
+                    got_response.pulse();
+                });
+            send(parent->mailbox_manager, client_bcard.write_sync_batch_mailbox,
+                writes, response_mailbox.get_address());
+            wait_interruptible(&got_response, keepalive.get_drain_signal());
+        }
+    } catch (const interrupted_exc_t &) {
+        /* The `proxy_replica_t` is being destroyed */
+        return;
+    }
+    for (const counted_t<pending_sync_write_t> &pending : batch) {
+        pending->done.pulse();
+    }
+    --sync_batches_in_flight;
+    if (!keepalive.get_drain_signal()->is_pulsed()) {
+        flush_sync_writes();
+    }
 }
 
 void remote_replicator_server_t::proxy_replica_t::do_dummy_write(
@@ -103,3 +179,12 @@ void remote_replicator_server_t::proxy_replica_t::on_ready(signal_t *) {
     registration->mark_ready();
 }
 
+void remote_replicator_server_t::proxy_replica_t::on_heartbeat_request(signal_t *) {
+    /* The client only asks once it's ready, but the request can overtake the message
+    to `ready_mailbox`. A heartbeat before then would be useless anyway. */
+    if (is_ready) {
+        send(parent->mailbox_manager, client_bcard.timestamp_mailbox,
+            parent->primary->get_latest_timestamp());
+    }
+}
+
@@ -2,6 +2,8 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_SERVER_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_SERVER_HPP_
 
+#include <vector>
+
 #include "clustering/generic/registrar.hpp"
 #include "clustering/immediate_consistency/primary_dispatcher.hpp"
 #include "clustering/immediate_consistency/remote_replicator_metadata.hpp"
@@ -64,16 +66,45 @@ private:
             write_response_t *response_out);
 
     private:
+        /* `do_write_sync()` doesn't send its write right away if too many batches are
+        already waiting for acks. Instead it adds a `pending_sync_write_t` to
+        `pending_sync_writes`, and all of the pending writes go out as one batch when the
+        next ack comes back. So when the load is low, every write is sent as soon as it
+        arrives; when it's high, the batches grow with the round-trip time. */
+        class pending_sync_write_t :
+            public single_threaded_countable_t<pending_sync_write_t> {
+        public:
+            remote_replicator_sync_write_t write;
+            write_response_t response;
+            cond_t done;
+        };
+
         void on_ready(signal_t *interruptor);
 
+        /* Sends the primary's latest timestamp to the client, so it can tell how far
+        behind it is. Called when the client asks for a heartbeat. */
+        void on_heartbeat_request(signal_t *interruptor);
+
+        void flush_sync_writes();
+        void send_sync_write_batch(
+            const std::vector<counted_t<pending_sync_write_t> > &batch,
+            auto_drainer_t::lock_t keepalive);
+
         remote_replicator_client_bcard_t client_bcard;
         remote_replicator_server_t *parent;
         bool is_ready;
 
+        size_t sync_batches_in_flight;
+        std::vector<counted_t<pending_sync_write_t> > pending_sync_writes;
+        auto_drainer_t sync_write_drainer;
+
         // The destruction order matters: The `ready_mailbox` callback assumes
-        // that `registration` is still valid.
+        // that `registration` is still valid, and `registration` must stop the calls
+        // to `do_write_sync()` before `sync_write_drainer` goes away.
         scoped_ptr_t<primary_dispatcher_t::dispatchee_registration_t> registration;
         remote_replicator_client_intro_t::ready_mailbox_t ready_mailbox;
+        remote_replicator_client_intro_t::heartbeat_request_mailbox_t
+            heartbeat_request_mailbox;
     };
 
     mailbox_manager_t *mailbox_manager;
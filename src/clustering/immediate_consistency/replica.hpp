@@ -50,6 +50,12 @@ public:
         signal_t *interruptor,
         write_response_t *response_out);
 
+    /* Returns the latest timestamp such that every write up to and including it has
+    been applied to the store. */
+    state_timestamp_t get_latest_applied_timestamp() const {
+        return end_enforcer.get_latest_all_before_completed();
+    }
+
 private:
     void on_synchronize(
         signal_t *interruptor,
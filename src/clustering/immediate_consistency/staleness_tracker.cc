@@ -0,0 +1,91 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/immediate_consistency/staleness_tracker.hpp"
+
+#include <algorithm>
+
+#include "arch/timing.hpp"
+#include "concurrency/wait_any.hpp"
+#include "config/args.hpp"
+#include "containers/map_sentries.hpp"
+
+staleness_tracker_t::staleness_tracker_t() :
+    applied_timestamp(state_timestamp_t::zero()),
+    fresh_as_of(0),
+    latest_heartbeat(0),
+    latest_heartbeat_request(0) { }
+
+void staleness_tracker_t::on_primary_timestamp(state_timestamp_t timestamp) {
+    assert_thread();
+    ticks_t now = get_ticks();
+    latest_heartbeat = now;
+    if (timestamp <= applied_timestamp) {
+        advance_fresh_as_of(now);
+    } else {
+        pending_heartbeats.push_back(std::make_pair(timestamp, now));
+    }
+}
+
+void staleness_tracker_t::on_applied_timestamp(state_timestamp_t timestamp) {
+    assert_thread();
+    if (timestamp <= applied_timestamp) {
+        return;
+    }
+    applied_timestamp = timestamp;
+    ticks_t latest = 0;
+    while (!pending_heartbeats.empty()
+            && pending_heartbeats.front().first <= applied_timestamp) {
+        latest = pending_heartbeats.front().second;
+        pending_heartbeats.pop_front();
+    }
+    if (latest != 0) {
+        advance_fresh_as_of(latest);
+    }
+}
+
+bool staleness_tracker_t::wait_until_fresh(
+        int64_t max_staleness_ms, signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    assert_thread();
+    rassert(max_staleness_ms >= 0);
+    ticks_t now = get_ticks();
+    /* A bound reaching back past tick zero means any state is fresh enough. Clamping
+    before the multiplication keeps it from overflowing. */
+    ticks_t max_staleness =
+        std::min<ticks_t>(std::max<int64_t>(max_staleness_ms, 0),
+                 now / MILLION) * MILLION;
+    ticks_t goal = now - std::min(now, max_staleness);
+    if (fresh_as_of != 0 && fresh_as_of >= goal) {
+        return true;
+    }
+    /* If a timestamp arrived after the deadline, we only have to wait for the writes
+    to catch up with it. Otherwise we need a heartbeat, unless we've already asked for
+    one since the deadline. */
+    if ((latest_heartbeat == 0 || latest_heartbeat < goal)
+            && (latest_heartbeat_request == 0 || latest_heartbeat_request < goal)
+            && heartbeat_requester) {
+        latest_heartbeat_request = now;
+        heartbeat_requester();
+    }
+    cond_t fresh;
+    multimap_insertion_sentry_t<ticks_t, cond_t *> sentry(&waiters, goal, &fresh);
+    signal_timer_t timeout(STALENESS_MAX_WAIT_MS);
+    wait_any_t fresh_or_timeout(&fresh, &timeout);
+    wait_interruptible(&fresh_or_timeout, interruptor);
+    return fresh.is_pulsed();
+}
+
+void staleness_tracker_t::set_heartbeat_requester(
+        const std::function<void()> &request_heartbeat) {
+    assert_thread();
+    heartbeat_requester = request_heartbeat;
+}
+
+void staleness_tracker_t::advance_fresh_as_of(ticks_t ticks) {
+    if (ticks <= fresh_as_of) {
+        return;
+    }
+    fresh_as_of = ticks;
+    for (auto it = waiters.begin(); it != waiters.upper_bound(fresh_as_of); ++it) {
+        it->second->pulse_if_not_already_pulsed();
+    }
+}
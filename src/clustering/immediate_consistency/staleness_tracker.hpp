@@ -0,0 +1,96 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_STALENESS_TRACKER_HPP_
+#define CLUSTERING_IMMEDIATE_CONSISTENCY_STALENESS_TRACKER_HPP_
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <utility>
+
+#include "concurrency/cond_var.hpp"
+#include "concurrency/interruptor.hpp"
+#include "threading.hpp"
+#include "time.hpp"
+#include "timestamps.hpp"
+
+/* `staleness_tracker_t` keeps track of how far a secondary replica's store lags behind
+the primary, so that the `direct_query_server_t` can serve reads with
+`read_mode_t::BOUNDED`.
+
+The tracker learns the primary's latest timestamp in two ways. Every write that the
+`remote_replicator_server_t` sends carries its timestamp, so while there are writes the
+tracker gets a new one with each of them. When there are no writes and a bounded read
+finds the store too stale, the tracker asks the primary for a heartbeat, and the
+primary answers with the latest timestamp it has assigned. Nothing is sent when nobody
+reads in bounded mode.
+
+Once every write up to a timestamp has been applied to the store, the store contains
+everything the primary had seen when it sent that timestamp, so we consider the store
+fresh as of the moment the timestamp arrived. The time spent on the network isn't
+accounted for, and neither are writes that the primary sent out concurrently with a
+piggybacked timestamp, so the real staleness can be higher by about the one-way latency
+between the two servers.
+
+If we lose contact with the primary, the heartbeats stop and the store just gets more
+and more stale, which is what we want. */
+
+/* `wait_until_fresh()` gives up after this long. It's long enough for a heartbeat to
+make the round trip to the primary. */
+const int64_t STALENESS_MAX_WAIT_MS = 200;
+
+class staleness_tracker_t : public home_thread_mixin_t {
+public:
+    staleness_tracker_t();
+
+    /* Called when a heartbeat from the primary arrives, or a write with the given
+    timestamp. */
+    void on_primary_timestamp(state_timestamp_t timestamp);
+
+    /* Called when all writes up to and including `timestamp` have been applied to the
+    store. */
+    void on_applied_timestamp(state_timestamp_t timestamp);
+
+    /* Blocks until the store is at most `max_staleness_ms` behind the primary, as of
+    the time of the call, and returns `true`. Returns `false` if that doesn't happen
+    within `STALENESS_MAX_WAIT_MS`. */
+    bool wait_until_fresh(int64_t max_staleness_ms, signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
+    /* `wait_until_fresh()` calls `request_heartbeat` when it needs a heartbeat from
+    the primary. The `remote_replicator_client_t` sets it once it's streaming, and
+    resets it to an empty function before it goes away. */
+    void set_heartbeat_requester(const std::function<void()> &request_heartbeat);
+
+private:
+    void advance_fresh_as_of(ticks_t ticks);
+
+    state_timestamp_t applied_timestamp;
+
+    /* The heartbeats (including the timestamps of writes) whose timestamps haven't
+    been applied yet, in the order in which they arrived, each with the time it
+    arrived. */
+    std::deque<std::pair<state_timestamp_t, ticks_t> > pending_heartbeats;
+
+    /* The arrival time of the latest heartbeat whose timestamp has been applied, or
+    zero if there hasn't been any. */
+    ticks_t fresh_as_of;
+
+    /* The arrival time of the latest heartbeat, applied or not, or zero if there
+    hasn't been any. */
+    ticks_t latest_heartbeat;
+
+    std::function<void()> heartbeat_requester;
+
+    /* When `heartbeat_requester` was last called, or zero if it hasn't been. A
+    heartbeat we asked for after a read's deadline will be recent enough for that read,
+    so we don't ask again. */
+    ticks_t latest_heartbeat_request;
+
+    /* `waiters` holds the conds of the `wait_until_fresh()` calls, keyed by the value
+    that `fresh_as_of` has to reach for them to be pulsed. */
+    std::multimap<ticks_t, cond_t *> waiters;
+
+    DISABLE_COPYING(staleness_tracker_t);
+};
+
+#endif /* CLUSTERING_IMMEDIATE_CONSISTENCY_STALENESS_TRACKER_HPP_ */
@@ -5,19 +5,25 @@
 #include "clustering/query_routing/metadata.hpp"
 #include "concurrency/fifo_checker.hpp"
 
+class staleness_tracker_t;
 class store_view_t;
 
 /* For each primary or secondary replica of each shard, there is a
 `direct_query_server_t`. The `direct_query_server_t` allows the `table_query_server_t` to
 bypass the `broadcaster_t` and read directly from the B-tree itself. This reduces network
 traffic and is possible even when the primary replica is unavailable, but the data it
-returns might be out of date. */
+returns might be out of date.
+
+Reads with `read_mode_t::BOUNDED` are only served once the store is within the read's
+staleness bound, according to the `staleness_tracker_t`. On the primary there is no
+`staleness_tracker_t`, because the primary's store is always up to date. */
 
 class direct_query_server_t {
 public:
     direct_query_server_t(
             mailbox_manager_t *mm,
-            store_view_t *svs);
+            store_view_t *svs,
+            staleness_tracker_t *staleness_tracker);
 
     direct_query_bcard_t get_bcard();
 
@@ -26,13 +32,24 @@ private:
             signal_t *interruptor,
             const read_t &,
             const mailbox_addr_t<read_response_t> &);
+    void on_bounded_read(
+            signal_t *interruptor,
+            const read_t &,
+            const mailbox_addr_t<optional<read_response_t> > &);
+
+    void perform_read(
+            const read_t &read,
+            read_response_t *response,
+            signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
 
     mailbox_manager_t *mailbox_manager;
     store_view_t *svs;
+    staleness_tracker_t *staleness_tracker;
 
     order_source_t order_source;  // TODO: order_token_t::ignore
 
     direct_query_bcard_t::read_mailbox_t read_mailbox;
+    direct_query_bcard_t::bounded_read_mailbox_t bounded_read_mailbox;
 };
 
 #endif /* CLUSTERING_QUERY_ROUTING_DIRECT_QUERY_SERVER_HPP_ */
@@ -123,6 +123,8 @@ void table_query_client_t::read(
     } else if (r.read_mode == read_mode_t::DEBUG_DIRECT) {
         guarantee(!r.route_to_primary());
         dispatch_debug_direct_read(r, response, interruptor);
+    } else if (r.read_mode == read_mode_t::BOUNDED) {
+        dispatch_bounded_read(r, response, order_token, interruptor);
     } else {
         dispatch_immediate_op<read_t, fifo_enforcer_sink_t::exit_read_t, read_response_t>(
                 &primary_query_client_t::new_read_token,
@@ -373,6 +375,16 @@ void table_query_client_t::dispatch_outdated_read(
             new_op_info->direct_bcard = chosen_relationship->direct_bcard;
             new_op_info->keepalive = auto_drainer_t::lock_t(
                 &chosen_relationship->drainer);
+            if (new_op_info->sharded_op.read_mode == read_mode_t::BOUNDED) {
+                for (relationship_t *rel : rels) {
+                    if (rel != chosen_relationship && rel->direct_bcard != nullptr
+                            && rel->region == region) {
+                        new_op_info->fallbacks.push_back(std::make_pair(
+                            rel->direct_bcard,
+                            auto_drainer_t::lock_t(&rel->drainer)));
+                    }
+                }
+            }
             replicas_to_contact.push_back(std::move(new_op_info));
             new_op_info.init(new outdated_read_info_t());
         }
@@ -405,23 +417,60 @@ void table_query_client_t::perform_outdated_read(
     outdated_read_info_t *replica_to_contact = (*replicas_to_contact)[i].get();
 
     try {
-        cond_t done;
-        mailbox_t<read_response_t> cont(mailbox_manager,
-            [&](signal_t *, const read_response_t &res) {
-                results->at(i) = res;
-                done.pulse();
-            });
-
-        send(mailbox_manager,
-            replica_to_contact->direct_bcard->read_mailbox,
-            replica_to_contact->sharded_op,
-            cont.get_address());
-        wait_any_t waiter(replica_to_contact->keepalive.get_drain_signal(), &done);
-        wait_interruptible(&waiter, interruptor);
-        if (!done.is_pulsed()) {
-            /* `wait_interruptible()` returned because
-            `replica_to_contact->keepalive.get_drain_signal()` was pulsed */
-            failures->at(i).assign("lost contact with replica");
+        for (;;) {
+            cond_t done;
+            /* Bounded-staleness reads go to a different mailbox, which replies with
+            nothing if the replica is too far behind the primary. */
+            bool too_stale = false;
+            scoped_ptr_t<mailbox_t<read_response_t> > cont;
+            scoped_ptr_t<mailbox_t<optional<read_response_t> > > bounded_cont;
+            if (replica_to_contact->sharded_op.read_mode == read_mode_t::BOUNDED) {
+                bounded_cont.init(new mailbox_t<optional<read_response_t> >(
+                    mailbox_manager,
+                    [&](signal_t *, const optional<read_response_t> &res) {
+                        if (res.has_value()) {
+                            results->at(i) = *res;
+                        } else {
+                            too_stale = true;
+                        }
+                        done.pulse();
+                    }));
+                send(mailbox_manager,
+                    replica_to_contact->direct_bcard->bounded_read_mailbox,
+                    replica_to_contact->sharded_op,
+                    bounded_cont->get_address());
+            } else {
+                cont.init(new mailbox_t<read_response_t>(mailbox_manager,
+                    [&](signal_t *, const read_response_t &res) {
+                        results->at(i) = res;
+                        done.pulse();
+                    }));
+                send(mailbox_manager,
+                    replica_to_contact->direct_bcard->read_mailbox,
+                    replica_to_contact->sharded_op,
+                    cont->get_address());
+            }
+            wait_any_t waiter(replica_to_contact->keepalive.get_drain_signal(), &done);
+            wait_interruptible(&waiter, interruptor);
+            if (done.is_pulsed() && !too_stale) {
+                failures->at(i).clear();
+                return;
+            }
+            failures->at(i).assign(!done.is_pulsed()
+                /* `wait_interruptible()` returned because
+                `replica_to_contact->keepalive.get_drain_signal()` was pulsed */
+                ? "lost contact with replica"
+                : "replica is too far behind the primary");
+            if (replica_to_contact->fallbacks.empty()) {
+                return;
+            }
+            /* Try the next replica of this shard before making the caller fall back
+            to the primaries. */
+            replica_to_contact->direct_bcard =
+                replica_to_contact->fallbacks.back().first;
+            replica_to_contact->keepalive =
+                std::move(replica_to_contact->fallbacks.back().second);
+            replica_to_contact->fallbacks.pop_back();
         }
     } catch (const interrupted_exc_t &) {
         /* Return immediately. `dispatch_immediate_op()` will notice that the
@@ -429,6 +478,30 @@ void table_query_client_t::perform_outdated_read(
     }
 }
 
+void table_query_client_t::dispatch_bounded_read(
+        const read_t &op,
+        read_response_t *response,
+        order_token_t order_token,
+        signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t) {
+    if (!op.route_to_primary()) {
+        try {
+            dispatch_outdated_read(op, response, interruptor);
+            return;
+        } catch (const cannot_perform_query_exc_t &) {
+            /* Some shard had no replica that was reachable and fresh enough, even
+            after trying all of its replicas. The results from the other shards are
+            thrown away, and we redo the whole read on the primaries. */
+        }
+    }
+    read_t up_to_date_op = op;
+    up_to_date_op.read_mode = read_mode_t::SINGLE;
+    dispatch_immediate_op<read_t, fifo_enforcer_sink_t::exit_read_t, read_response_t>(
+            &primary_query_client_t::new_read_token,
+            &primary_query_client_t::read,
+            up_to_date_op, response, order_token, interruptor);
+}
+
 void table_query_client_t::dispatch_debug_direct_read(
         const read_t &op,
         read_response_t *response,
@@ -445,9 +518,10 @@ void table_query_client_t::dispatch_debug_direct_read(
                 query_state_t::FAILED);
         }
         std::vector<read_response_t> responses;
-        pmap(CPU_SHARDING_FACTOR, [&](size_t shard_number) {
+        size_t num_cpu_shards = multistore->num_cpu_shards();
+        pmap(num_cpu_shards, [&](size_t shard_number) {
             try {
-                region_t region = cpu_sharding_subspace(shard_number);
+                region_t region = cpu_sharding_subspace(shard_number, num_cpu_shards);
                 read_t subread;
                 if (!op.shard(region, &subread)) {
                     return;
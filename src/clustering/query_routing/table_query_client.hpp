@@ -95,6 +95,10 @@ private:
         read_t sharded_op;
         const direct_query_bcard_t *direct_bcard;
         auto_drainer_t::lock_t keepalive;
+        /* For bounded-staleness reads, the other replicas of the shard that we try
+        in turn if `direct_bcard` turns out to be too far behind the primary. */
+        std::vector<std::pair<const direct_query_bcard_t *, auto_drainer_t::lock_t> >
+            fallbacks;
     };
 
     template <class op_type, class fifo_enforcer_token_type, class op_response_type>
@@ -137,6 +141,16 @@ private:
             signal_t *interruptor)
         THROWS_NOTHING;
 
+    /* Tries to perform the read on replicas that are fresh enough, trying every
+    replica of a shard before giving up on it. If some shard has no replica that is
+    reachable and fresh enough, the whole read is redone on the primaries. */
+    void dispatch_bounded_read(
+            const read_t &op,
+            read_response_t *response,
+            order_token_t order_token,
+            signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t);
+
     void dispatch_debug_direct_read(
             const read_t &op,
             read_response_t *response,
@@ -201,7 +201,9 @@ RDB_IMPL_SERIALIZABLE_6_SINCE_v2_1(
     member_ids, server_names);
 
 table_raft_state_t make_new_table_raft_state(
-        const table_config_and_shards_t &config) {
+        const table_config_and_shards_t &config,
+        size_t num_cpu_shards) {
+    guarantee(is_valid_cpu_sharding_factor(num_cpu_shards));
     table_raft_state_t state;
     state.config = config;
     for (size_t i = 0; i < config.shard_scheme.num_shards(); ++i) {
@@ -214,10 +216,10 @@ table_raft_state_t make_new_table_raft_state(
                 contract_t::primary_t { shard_conf.primary_replica, r_nullopt });
         }
         contract.after_emergency_repair = false;
-        for (size_t j = 0; j < CPU_SHARDING_FACTOR; ++j) {
+        for (size_t j = 0; j < num_cpu_shards; ++j) {
             region_t region = region_intersection(
                 region_t(config.shard_scheme.get_shard_range(i)),
-                cpu_sharding_subspace(j));
+                cpu_sharding_subspace(j, num_cpu_shards));
             state.contracts.insert(std::make_pair(generate_uuid(),
                 std::make_pair(region, contract)));
         }
@@ -232,6 +234,12 @@ table_raft_state_t make_new_table_raft_state(
     return state;
 }
 
+size_t get_cpu_sharding_factor(const table_raft_state_t &state) {
+    /* Contracts never span more than one CPU shard, so any contract will do. */
+    guarantee(!state.contracts.empty());
+    return get_cpu_sharding_factor(state.contracts.begin()->second.first);
+}
+
 RDB_IMPL_EQUALITY_COMPARABLE_6(table_shard_status_t,
     primary, secondary, need_primary, need_quorum, backfilling, transitioning);
 RDB_IMPL_SERIALIZABLE_6_FOR_CLUSTER(table_shard_status_t,
@@ -281,10 +281,15 @@ RDB_DECLARE_SERIALIZABLE(table_raft_state_t::change_t::new_server_names_t);
 RDB_DECLARE_SERIALIZABLE(table_raft_state_t::change_t);
 RDB_DECLARE_SERIALIZABLE(table_raft_state_t);
 
-/* Returns a `table_raft_state_t` for a newly-created table with the given configuration.
-*/
+/* Returns a `table_raft_state_t` for a newly-created table with the given configuration
+and number of CPU shards. */
 table_raft_state_t make_new_table_raft_state(
-    const table_config_and_shards_t &config);
+    const table_config_and_shards_t &config,
+    size_t num_cpu_shards);
+
+/* Returns the number of CPU shards of the table, which can be read off the regions of
+its contracts. */
+size_t get_cpu_sharding_factor(const table_raft_state_t &state);
 
 /* `table_shard_status_t` describes the current state of the server with respect to some
 range of the key-space. It's used for producing `rethinkdb.table_status`. It's designed
@@ -8,33 +8,55 @@
 
 class store_t;
 
-/* Changing this number would break backwards compatibility in the disk format. */
+/* Every table is split into a number of CPU shards by hash, and each server keeps one
+`store_t` per CPU shard. The number of CPU shards is chosen when the table is created and
+can't be changed afterwards. It must be a power of two between one and
+`MAX_CPU_SHARDING_FACTOR`.
+
+The number isn't stored anywhere explicitly. Every contract of the table covers exactly
+one CPU shard, so it can be recovered from the regions of the contracts (see
+`get_cpu_sharding_factor()`). Tables that were created before the number could be chosen
+have `CPU_SHARDING_FACTOR` CPU shards. Changing that number would break backwards
+compatibility in the disk format. */
 #define CPU_SHARDING_FACTOR 8
+#define MAX_CPU_SHARDING_FACTOR 64
+
+/* Returns `true` if `num_cpu_shards` is a valid number of CPU shards for a table. */
+bool is_valid_cpu_sharding_factor(size_t num_cpu_shards);
 
 /* `cpu_sharding_subspace()` returns a `region_t` that contains the full key-range space
-but only 1/CPU_SHARDING_FACTOR of the shard space. */
-region_t cpu_sharding_subspace(int subregion_number);
+but only 1/`num_cpu_shards` of the shard space. */
+region_t cpu_sharding_subspace(
+    int subregion_number, size_t num_cpu_shards = CPU_SHARDING_FACTOR);
 
 /* `get_cpu_shard_number()` is the reverse of `cpu_sharding_subspace()`; it returns the
 subregion number for `region`'s hash subspace. It ignores `region`'s key boundaries. If
 `region`'s hash subspace doesn't exactly correspond to a specific CPU sharding region, it
 crashes. */
-int get_cpu_shard_number(const region_t &region);
+int get_cpu_shard_number(
+    const region_t &region, size_t num_cpu_shards = CPU_SHARDING_FACTOR);
 
 /* `get_cpu_shard_approx_number()` is like `get_cpu_shard_number()`, except that if the
 input doesn't correspond exactly to a CPU shard, it returns an estimate. */
-int get_cpu_shard_approx_number(const region_t &region);
+int get_cpu_shard_approx_number(
+    const region_t &region, size_t num_cpu_shards = CPU_SHARDING_FACTOR);
+
+/* `get_cpu_sharding_factor()` returns the number of CPU shards of a table that has a
+CPU shard with the given hash subspace. */
+size_t get_cpu_sharding_factor(const region_t &cpu_shard_region);
 
 /* `multistore_ptr_t` is a bundle of `store_view_t`s, one for each CPU shard. The rule
-is that `get_cpu_sharded_store(i)->get_region() == cpu_sharding_subspace(i)`. The
-individual stores' home threads may be different from the `multistore_ptr_t`'s home
-thread. */
+is that `get_cpu_sharded_store(i)->get_region() ==
+cpu_sharding_subspace(i, num_cpu_shards())`. The individual stores' home threads may be
+different from the `multistore_ptr_t`'s home thread. */
 class multistore_ptr_t : public home_thread_mixin_t {
 public:
     virtual ~multistore_ptr_t() { }
 
     virtual branch_history_manager_t *get_branch_history_manager() = 0;
 
+    virtual size_t num_cpu_shards() = 0;
+
     virtual store_view_t *get_cpu_sharded_store(size_t i) = 0;
 
     /* The `sindex_manager_t` uses this interface to get at the underlying `store_t`s so
@@ -44,4 +66,3 @@ public:
 };
 
 #endif /* CLUSTERING_TABLE_CONTRACT_CPU_SHARDING_HPP_ */
-
@@ -129,7 +129,8 @@ void primary_execution_t::run(auto_drainer_t::lock_t keepalive) {
 
         direct_query_server_t direct_query_server(
             context->mailbox_manager,
-            store);
+            store,
+            nullptr);
 
         on_thread_t thread_switcher_2(home_thread());
 
@@ -437,6 +438,7 @@ bool primary_execution_t::on_read(
         }
         break;
     case read_mode_t::OUTDATED: // Fallthrough intentional
+    case read_mode_t::BOUNDED: // Fallthrough intentional
     case read_mode_t::DEBUG_DIRECT:
     default:
         // These read modes should not come through the `primary_exection_t`.
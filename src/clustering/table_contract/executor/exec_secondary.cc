@@ -4,6 +4,7 @@
 #include <utility>
 
 #include "clustering/immediate_consistency/remote_replicator_client.hpp"
+#include "clustering/immediate_consistency/staleness_tracker.hpp"
 #include "clustering/query_routing/direct_query_server.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 
@@ -82,7 +83,11 @@ void secondary_execution_t::run(auto_drainer_t::lock_t keepalive) {
                     order_source.check_in("secondary_execution_t").with_read_mode(),
                     &token, region, &interruptor_on_store_thread)));
 
-            direct_query_server_t direct_query_server(context->mailbox_manager, store);
+            /* `staleness_tracker` stays stale until the `remote_replicator_client_t`
+            is streaming, so bounded-staleness reads go to the primary until then. */
+            staleness_tracker_t staleness_tracker;
+            direct_query_server_t direct_query_server(
+                context->mailbox_manager, store, &staleness_tracker);
 
             /* Switch back to the home thread so we can send the initial ack */
             on_thread_t thread_switcher_2(home_thread());
@@ -184,6 +189,7 @@ void secondary_execution_t::run(auto_drainer_t::lock_t keepalive) {
                 primary,
                 store,
                 context->branch_history_manager,
+                &staleness_tracker,
                 &stop_signal_on_store_thread);
 
             on_thread_t thread_switcher_4(home_thread());
@@ -18,7 +18,8 @@ public:
         parent(_parent), contract_id(_contract_id),
         store_subview(
             parent->multistore->get_cpu_sharded_store(
-                get_cpu_shard_number(key.region)),
+                get_cpu_shard_number(
+                    key.region, parent->multistore->num_cpu_shards())),
             key.region),
         perfmon_name(strprintf("%s-%d", key.role_name().c_str(), ++parent->perfmon_counter))
     {
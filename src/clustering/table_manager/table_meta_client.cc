@@ -284,6 +284,7 @@ void table_meta_client_t::get_debug_status(
 void table_meta_client_t::create(
         namespace_id_t table_id,
         const table_config_and_shards_t &initial_config,
+        size_t num_cpu_shards,
         signal_t *interruptor_on_caller)
         THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t,
             maybe_failed_table_op_exc_t) {
@@ -298,7 +299,7 @@ void table_meta_client_t::create(
 
     create_or_emergency_repair(
         table_id,
-        make_new_table_raft_state(initial_config),
+        make_new_table_raft_state(initial_config, num_cpu_shards),
         multi_table_manager_timestamp_t::epoch_t::make(
             multi_table_manager_timestamp_t::epoch_t::min()),
         &interruptor);
@@ -163,12 +163,13 @@ public:
         std::map<server_id_t, table_status_response_t> *responses_out)
         THROWS_ONLY(interrupted_exc_t, no_such_table_exc_t, failed_table_op_exc_t);
 
-    /* `create()` creates a table with the given configuration. It sets `*table_id_out`
-    to the ID of the newly generated table. It may block. If it returns successfully, the
-    change will be visible in `find()`, etc. */
+    /* `create()` creates a table with the given configuration and number of CPU shards.
+    It sets `*table_id_out` to the ID of the newly generated table. It may block. If it
+    returns successfully, the change will be visible in `find()`, etc. */
     void create(
         namespace_id_t new_table_id,
         const table_config_and_shards_t &new_config,
+        size_t num_cpu_shards,
         signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t,
             maybe_failed_table_op_exc_t);
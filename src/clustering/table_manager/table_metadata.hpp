@@ -340,14 +340,20 @@ public:
     virtual void delete_metadata(
         const namespace_id_t &table_id) = 0;
 
+    /* `create_multistore()` creates the stores for a table that this server didn't
+    have any data for, and `load_multistore()` opens the stores of a table that it has
+    data for. `num_cpu_shards` is the table's CPU sharding factor, as given by
+    `get_cpu_sharding_factor()`. */
     virtual void load_multistore(
         const namespace_id_t &table_id,
+        size_t num_cpu_shards,
         metadata_file_t::read_txn_t *metadata_read_txn,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers) = 0;
     virtual void create_multistore(
         const namespace_id_t &table_id,
+        size_t num_cpu_shards,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers) = 0;
@@ -0,0 +1,116 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "concurrency/cpu_work_pool.hpp"
+
+#include <atomic>
+#include <exception>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "arch/spinlock.hpp"
+#include "concurrency/cond_var.hpp"
+#include "containers/counted.hpp"
+
+// The state shared by the coroutines working on one `run_cpu_tasks()` call.  Helper
+// coroutines can outlive the call (if they only get to run after all tasks have
+// been taken), so this is reference counted, and `task` and `done` must only be
+// used by whoever takes a task that hasn't been taken yet.
+class cpu_task_batch_t : public slow_atomic_countable_t<cpu_task_batch_t> {
+public:
+    cpu_task_batch_t(size_t _num_tasks,
+                     const std::function<void(size_t)> *_task,
+                     cond_t *_done)
+        : num_tasks(_num_tasks),
+          task(_task),
+          done(_done),
+          home_thread(get_thread_id()),
+          next_task(0),
+          num_unfinished(_num_tasks),
+          failed(false) { }
+
+    // Takes and runs tasks until there are none left.  Returns true if this call
+    // finished the last unfinished task.
+    bool run_tasks() {
+        bool finished_last = false;
+        for (;;) {
+            size_t index = next_task.fetch_add(1);
+            if (index >= num_tasks) {
+                break;
+            }
+            // Once a task has failed, we skip the remaining ones.
+            if (!failed.load()) {
+                try {
+                    ASSERT_NO_CORO_WAITING;
+                    (*task)(index);
+                } catch (...) {
+                    spinlock_acq_t acq(&error_lock);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    failed.store(true);
+                }
+            }
+            if (num_unfinished.fetch_sub(1) == 1) {
+                finished_last = true;
+            }
+        }
+        return finished_last;
+    }
+
+    void rethrow_error() {
+        spinlock_acq_t acq(&error_lock);
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    const size_t num_tasks;
+    const std::function<void(size_t)> *const task;
+    cond_t *const done;
+    const threadnum_t home_thread;
+
+private:
+    std::atomic<size_t> next_task;
+    std::atomic<size_t> num_unfinished;
+    std::atomic<bool> failed;
+
+    spinlock_t error_lock;
+    std::exception_ptr error;
+
+    DISABLE_COPYING(cpu_task_batch_t);
+};
+
+void run_cpu_task_helper(counted_t<cpu_task_batch_t> batch) {
+    if (batch->run_tasks()) {
+        // The caller is waiting for us.
+        cond_t *done = batch->done;
+        coro_t::spawn_on_thread([done]() { done->pulse(); },
+                                batch->home_thread,
+                                coro_stack_class_t::SMALL);
+    }
+}
+
+void run_cpu_tasks(size_t num_tasks, const std::function<void(size_t)> &task) {
+    if (num_tasks == 0) {
+        return;
+    }
+
+    cond_t done;
+    counted_t<cpu_task_batch_t> batch =
+        make_counted<cpu_task_batch_t>(num_tasks, &task, &done);
+
+    // Send a helper to each of the other db threads, as long as there are enough
+    // tasks to go around.
+    int num_threads = get_num_db_threads();
+    int current_thread = get_thread_id().threadnum;
+    size_t num_helpers = std::min(num_tasks - 1,
+                                  static_cast<size_t>(std::max(num_threads - 1, 0)));
+    for (size_t i = 1; i <= num_helpers; ++i) {
+        threadnum_t thread((current_thread + i) % num_threads);
+        coro_t::spawn_on_thread([batch]() { run_cpu_task_helper(batch); }, thread);
+    }
+
+    if (!batch->run_tasks()) {
+        done.wait();
+    }
+    batch->rethrow_error();
+}
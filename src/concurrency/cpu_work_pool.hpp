@@ -0,0 +1,90 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONCURRENCY_CPU_WORK_POOL_HPP_
+#define CONCURRENCY_CPU_WORK_POOL_HPP_
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+#include "errors.hpp"
+#include "threading.hpp"
+
+/* `run_cpu_tasks()` lets a coroutine spread a CPU-heavy computation over the db
+threads that have time for it, instead of saturating its own thread.  It calls
+`task(0)`, ..., `task(num_tasks - 1)`, some of them on other threads, and returns
+once they have all completed.
+
+The calling coroutine works through the tasks itself, while helper coroutines are
+sent to other db threads.  Tasks aren't assigned to threads ahead of time: whichever
+thread gets around to it first takes the next task.  So a thread that's busy with
+other work doesn't run any tasks, and by the time its helper runs there's usually
+nothing left to do.
+
+Tasks must be pure computations: they must not block, switch threads, or touch any
+object that belongs to a particular thread (anything with a home thread, thread-local
+state, or a non-atomic reference count).  Reading `datum_t`s is fine.  If a task
+throws, the first exception is rethrown by `run_cpu_tasks()` once all tasks have
+finished or have been skipped. */
+void run_cpu_tasks(size_t num_tasks, const std::function<void(size_t)> &task);
+
+// Below this many elements, `parallel_stable_sort()` just calls `std::stable_sort()`.
+const size_t MIN_PARALLEL_SORT_SIZE = 8192;
+
+/* Like `std::stable_sort()`, but sorts chunks of the range with `run_cpu_tasks()`
+and then merges them, also in parallel.  `lt` must be safe to call on any thread. */
+template <class value_t, class lt_t>
+void parallel_stable_sort(std::vector<value_t> *values, const lt_t &lt) {
+    const size_t num_threads = std::max(get_num_db_threads(), 1);
+    if (values->size() < MIN_PARALLEL_SORT_SIZE || num_threads == 1) {
+        std::stable_sort(values->begin(), values->end(), lt);
+        return;
+    }
+
+    // Use a few more chunks than threads so a thread that's late to help can still
+    // take some of the work.
+    size_t num_chunks = std::min(values->size() / (MIN_PARALLEL_SORT_SIZE / 4),
+                                 2 * num_threads);
+    std::vector<size_t> bounds;
+    for (size_t i = 0; i <= num_chunks; ++i) {
+        bounds.push_back(values->size() * i / num_chunks);
+    }
+    run_cpu_tasks(num_chunks, [&](size_t i) {
+        std::stable_sort(values->begin() + bounds[i], values->begin() + bounds[i + 1],
+                         lt);
+    });
+
+    // Merge neighbouring chunks until only one is left.  Merging takes elements from
+    // the left chunk first when they're equal, which keeps the sort stable.
+    std::vector<value_t> buffer(values->size());
+    std::vector<value_t> *from = values;
+    std::vector<value_t> *to = &buffer;
+    while (bounds.size() > 2) {
+        size_t num_merges = bounds.size() / 2;
+        run_cpu_tasks(num_merges, [&](size_t i) {
+            size_t begin = bounds[2 * i];
+            size_t middle = bounds[2 * i + 1];
+            size_t end = bounds[std::min(2 * i + 2, bounds.size() - 1)];
+            std::merge(std::make_move_iterator(from->begin() + begin),
+                       std::make_move_iterator(from->begin() + middle),
+                       std::make_move_iterator(from->begin() + middle),
+                       std::make_move_iterator(from->begin() + end),
+                       to->begin() + begin,
+                       lt);
+        });
+        std::vector<size_t> merged_bounds;
+        for (size_t i = 0; i < bounds.size(); i += 2) {
+            merged_bounds.push_back(bounds[i]);
+        }
+        if (merged_bounds.back() != bounds.back()) {
+            merged_bounds.push_back(bounds.back());
+        }
+        bounds.swap(merged_bounds);
+        std::swap(from, to);
+    }
+    if (from != values) {
+        values->swap(*from);
+    }
+}
+
+#endif  // CONCURRENCY_CPU_WORK_POOL_HPP_
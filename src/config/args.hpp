@@ -21,9 +21,8 @@
  * Basic configuration parameters.
  */
 
-// The number of hash-based CPU shards per table.
-// This "must" be hard-coded because a cluster cannot run with
-// differing cpu sharding factors.
+// The default number of hash-based CPU shards per table. Tables can be
+// created with a different number; see clustering/table_contract/cpu_sharding.hpp.
 #define CPU_SHARDING_FACTOR                       8
 
 // Defines the maximum size of the batch of IO events to process on
@@ -99,6 +98,9 @@
 // TODO: make this dynamic where possible
 #define MAX_THREADS                               128
 
+// The longest a thread may busy-poll for events before blocking (see `--busy-poll`)
+#define MAX_BUSY_POLL_USECS                       1000000
+
 // Ticks (in milliseconds) the internal timed tasks are performed at
 #define TIMER_TICKS_IN_MS                         5
 
@@ -145,6 +147,8 @@
 #define LBA_RECONSTRUCTION_BATCH_SIZE             1024
 
 #define COROUTINE_STACK_SIZE                      131072
+// Stack size for coroutines spawned with `coro_stack_class_t::SMALL`.
+#define COROUTINE_SMALL_STACK_SIZE                32768
 
 
 /**
@@ -0,0 +1,36 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "containers/arena.hpp"
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "memory_utils.hpp"
+
+arena_t::~arena_t() {
+    while (last_chunk != nullptr) {
+        chunk_header_t *prev = last_chunk->prev;
+        free(last_chunk);
+        last_chunk = prev;
+    }
+}
+
+void *arena_t::allocate_from_new_chunk(size_t size, size_t alignment) {
+    rassert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+    // Make sure the allocation fits into the new chunk, whatever its alignment.
+    const size_t needed = sizeof(chunk_header_t) + alignment - 1 + size;
+    const size_t chunk_size = std::max(next_chunk_size, needed);
+    chunk_header_t *chunk = static_cast<chunk_header_t *>(rmalloc(chunk_size));
+    chunk->prev = last_chunk;
+    last_chunk = chunk;
+    next = reinterpret_cast<char *>(chunk + 1);
+    end = reinterpret_cast<char *>(chunk) + chunk_size;
+    // Grow geometrically, so filling the arena takes a logarithmic number of chunks.
+    next_chunk_size = chunk_size * 2;
+
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(next) + alignment - 1)
+        & ~static_cast<uintptr_t>(alignment - 1);
+    next = reinterpret_cast<char *>(aligned + size);
+    rassert(next <= end);
+    return reinterpret_cast<void *>(aligned);
+}
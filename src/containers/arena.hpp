@@ -0,0 +1,113 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_ARENA_HPP_
+#define CONTAINERS_ARENA_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <limits>
+#include <new>
+#include <utility>
+
+#include "errors.hpp"
+
+/* `arena_t` is a bump allocator.  It hands out memory from a few chunks that get
+bigger as more memory is needed, and frees all of it at once when it's destroyed.
+Deallocating individual objects does nothing.
+
+It's meant for short-lived containers that are filled up, read out and then thrown
+away, where allocating every element separately (as `std::map` does) would dominate
+the cost.  Anything that has to outlive the arena must be copied out of it first. */
+class arena_t {
+public:
+    static const size_t DEFAULT_FIRST_CHUNK_SIZE = 1024;
+
+    explicit arena_t(size_t first_chunk_size = DEFAULT_FIRST_CHUNK_SIZE)
+        : last_chunk(nullptr), next(nullptr), end(nullptr),
+          next_chunk_size(first_chunk_size) { }
+    ~arena_t();
+
+    void *allocate(size_t size, size_t alignment) {
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(next) + alignment - 1)
+            & ~static_cast<uintptr_t>(alignment - 1);
+        if (next != nullptr && aligned + size <= reinterpret_cast<uintptr_t>(end)) {
+            next = reinterpret_cast<char *>(aligned + size);
+            return reinterpret_cast<void *>(aligned);
+        }
+        return allocate_from_new_chunk(size, alignment);
+    }
+
+private:
+    struct chunk_header_t {
+        chunk_header_t *prev;
+    };
+
+    void *allocate_from_new_chunk(size_t size, size_t alignment);
+
+    chunk_header_t *last_chunk;
+    char *next;
+    char *end;
+    size_t next_chunk_size;
+
+    DISABLE_COPYING(arena_t);
+};
+
+/* A standard allocator that takes its memory from an `arena_t`, for use with standard
+containers.  The container must be destroyed before the arena. */
+template <class T>
+class arena_allocator_t {
+public:
+    typedef T value_type;
+    typedef T *pointer;
+    typedef const T *const_pointer;
+    typedef T &reference;
+    typedef const T &const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <class U>
+    struct rebind {
+        typedef arena_allocator_t<U> other;
+    };
+
+    explicit arena_allocator_t(arena_t *_arena) : arena(_arena) { }
+    template <class U>
+    arena_allocator_t(const arena_allocator_t<U> &other)  // NOLINT(runtime/explicit)
+        : arena(other.arena) { }
+
+    T *allocate(size_t n, const void * = nullptr) {
+        return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *, size_t) { }
+
+    size_t max_size() const {
+        return std::numeric_limits<size_t>::max() / sizeof(T);
+    }
+
+    template <class U, class... Args>
+    void construct(U *p, Args &&... args) {
+        new (p) U(std::forward<Args>(args)...);
+    }
+    template <class U>
+    void destroy(U *p) {
+        p->~U();
+    }
+
+    T *address(T &x) const { return &x; }
+    const T *address(const T &x) const { return &x; }
+
+    template <class U>
+    bool operator==(const arena_allocator_t<U> &other) const {
+        return arena == other.arena;
+    }
+    template <class U>
+    bool operator!=(const arena_allocator_t<U> &other) const {
+        return arena != other.arena;
+    }
+
+private:
+    template <class U> friend class arena_allocator_t;
+    arena_t *arena;
+};
+
+#endif  // CONTAINERS_ARENA_HPP_
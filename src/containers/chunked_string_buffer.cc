@@ -0,0 +1,137 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "containers/chunked_string_buffer.hpp"
+
+#include <string.h>
+
+#include "containers/buffer_group.hpp"
+#include "thread_local.hpp"
+
+// The number of unused chunks we keep around on each thread.
+static const size_t MAX_FREE_CHUNKS_PER_THREAD = 64;
+
+TLS_with_init(void *, free_chunks_head, nullptr);
+TLS_with_init(size_t, num_free_chunks, 0);
+
+chunked_string_buffer_t::chunked_string_buffer_t() : size(0) { }
+
+chunked_string_buffer_t::~chunked_string_buffer_t() {
+    for (chunk_t *chunk : chunks) {
+        release_chunk(chunk);
+    }
+}
+
+chunked_string_buffer_t::chunked_string_buffer_t(chunked_string_buffer_t &&other)
+    : chunks(std::move(other.chunks)), size(other.size) {
+    other.chunks.clear();
+    other.size = 0;
+}
+
+char *chunked_string_buffer_t::Push(size_t count) {
+    guarantee(count <= CHUNK_SIZE);
+    if (chunks.empty() || CHUNK_SIZE - chunks.back()->end < count) {
+        add_chunk();
+    }
+    chunk_t *chunk = chunks.back();
+    char *ret = chunk->data + chunk->end;
+    chunk->end += count;
+    size += count;
+    return ret;
+}
+
+void chunked_string_buffer_t::append(const char *data, size_t count) {
+    size += count;
+    while (count > 0) {
+        if (chunks.empty() || chunks.back()->end == CHUNK_SIZE) {
+            add_chunk();
+        }
+        chunk_t *chunk = chunks.back();
+        size_t n = std::min(count, CHUNK_SIZE - chunk->end);
+        memcpy(chunk->data + chunk->end, data, n);
+        chunk->end += n;
+        data += n;
+        count -= n;
+    }
+}
+
+void chunked_string_buffer_t::Pop(size_t count) {
+    guarantee(count <= size);
+    size -= count;
+    while (count > 0) {
+        chunk_t *chunk = chunks.back();
+        size_t n = std::min(count, chunk->end - chunk->begin);
+        chunk->end -= n;
+        count -= n;
+        if (chunk->begin == chunk->end) {
+            chunks.pop_back();
+            release_chunk(chunk);
+        }
+    }
+}
+
+void chunked_string_buffer_t::pop_front(size_t count) {
+    guarantee(count <= size);
+    size -= count;
+    size_t dropped = 0;
+    while (count > 0) {
+        chunk_t *chunk = chunks[dropped];
+        size_t n = std::min(count, chunk->end - chunk->begin);
+        chunk->begin += n;
+        count -= n;
+        if (chunk->begin == chunk->end) {
+            release_chunk(chunk);
+            ++dropped;
+        }
+    }
+    chunks.erase(chunks.begin(), chunks.begin() + dropped);
+}
+
+char chunked_string_buffer_t::front() const {
+    guarantee(size > 0);
+    return chunks.front()->data[chunks.front()->begin];
+}
+
+char chunked_string_buffer_t::back() const {
+    guarantee(size > 0);
+    return chunks.back()->data[chunks.back()->end - 1];
+}
+
+void chunked_string_buffer_t::splice(chunked_string_buffer_t *other) {
+    chunks.insert(chunks.end(), other->chunks.begin(), other->chunks.end());
+    size += other->size;
+    other->chunks.clear();
+    other->size = 0;
+}
+
+void chunked_string_buffer_t::append_to_group(const_buffer_group_t *group) const {
+    for (const chunk_t *chunk : chunks) {
+        group->add_buffer(chunk->end - chunk->begin, chunk->data + chunk->begin);
+    }
+}
+
+void chunked_string_buffer_t::add_chunk() {
+    chunks.push_back(allocate_chunk());
+}
+
+chunked_string_buffer_t::chunk_t *chunked_string_buffer_t::allocate_chunk() {
+    chunk_t *chunk = static_cast<chunk_t *>(TLS_get_free_chunks_head());
+    if (chunk != nullptr) {
+        TLS_set_free_chunks_head(static_cast<void *>(chunk->next_free));
+        TLS_set_num_free_chunks(TLS_get_num_free_chunks() - 1);
+    } else {
+        chunk = new chunk_t;
+    }
+    chunk->next_free = nullptr;
+    chunk->begin = 0;
+    chunk->end = 0;
+    return chunk;
+}
+
+void chunked_string_buffer_t::release_chunk(chunk_t *chunk) {
+    if (TLS_get_num_free_chunks() >= MAX_FREE_CHUNKS_PER_THREAD) {
+        delete chunk;
+        return;
+    }
+    chunk->next_free = static_cast<chunk_t *>(TLS_get_free_chunks_head());
+    TLS_set_free_chunks_head(static_cast<void *>(chunk));
+    TLS_set_num_free_chunks(TLS_get_num_free_chunks() + 1);
+}
@@ -0,0 +1,101 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_CHUNKED_STRING_BUFFER_HPP_
+#define CONTAINERS_CHUNKED_STRING_BUFFER_HPP_
+
+#include <string>
+#include <vector>
+
+#include "config/args.hpp"
+#include "errors.hpp"
+
+class const_buffer_group_t;
+
+/* `chunked_string_buffer_t` is an output stream for rapidjson's `Writer` (like
+`rapidjson::StringBuffer`) that writes into a list of fixed-size chunks instead of
+one contiguous buffer.  Growing it never copies what has already been written, and
+the chunks can be handed to `tcp_conn_t::write()` as a `const_buffer_group_t`, so a
+response never has to be assembled into one string before going to the socket.
+
+Chunks are recycled through a small per-thread free list.  A buffer may be filled
+on one thread and destroyed on another. */
+class chunked_string_buffer_t {
+public:
+    typedef char Ch;
+
+    static const size_t CHUNK_SIZE = 16 * KILOBYTE;
+
+    chunked_string_buffer_t();
+    ~chunked_string_buffer_t();
+
+    chunked_string_buffer_t(chunked_string_buffer_t &&other);
+
+    // The rapidjson output stream interface.
+    void Put(char c) {
+        if (chunks.empty() || chunks.back()->end == CHUNK_SIZE) {
+            add_chunk();
+        }
+        chunk_t *chunk = chunks.back();
+        chunk->data[chunk->end++] = c;
+        ++size;
+    }
+    void Flush() { }
+
+    // Reserves `count` contiguous bytes at the end of the buffer and returns a
+    // pointer to them.  `count` must not be larger than `CHUNK_SIZE`.
+    char *Push(size_t count);
+
+    // Copies `count` bytes to the end of the buffer, filling up the last chunk
+    // before adding new ones.
+    void append(const char *data, size_t count);
+
+    // Removes `count` bytes from the end of the buffer.
+    void Pop(size_t count);
+
+    // Removes `count` bytes from the beginning of the buffer.
+    void pop_front(size_t count);
+
+    size_t GetSize() const { return size; }
+
+    // Returns the first byte of the buffer, which must not be empty.
+    char front() const;
+    // Returns the last byte of the buffer, which must not be empty.
+    char back() const;
+
+    // Moves all of `other`'s chunks to the end of this buffer, leaving `other`
+    // empty.  Nothing is copied.
+    void splice(chunked_string_buffer_t *other);
+
+    // Adds the contents of this buffer to `group`.  The buffer must stay alive
+    // and unmodified for as long as `group` is used.
+    void append_to_group(const_buffer_group_t *group) const;
+
+    // Copies the contents of this buffer to an output stream that supports
+    // `Put` (e.g. a `rapidjson::StringBuffer`).
+    template <class stream_t>
+    void copy_to(stream_t *stream) const {
+        for (const chunk_t *chunk : chunks) {
+            for (size_t i = chunk->begin; i < chunk->end; ++i) {
+                stream->Put(chunk->data[i]);
+            }
+        }
+    }
+
+private:
+    struct chunk_t {
+        chunk_t *next_free;
+        size_t begin;
+        size_t end;
+        char data[CHUNK_SIZE];
+    };
+
+    void add_chunk();
+    static chunk_t *allocate_chunk();
+    static void release_chunk(chunk_t *chunk);
+
+    std::vector<chunk_t *> chunks;
+    size_t size;
+
+    DISABLE_COPYING(chunked_string_buffer_t);
+};
+
+#endif  // CONTAINERS_CHUNKED_STRING_BUFFER_HPP_
@@ -0,0 +1,97 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_MPSC_LIST_HPP_
+#define CONTAINERS_MPSC_LIST_HPP_
+
+#include <atomic>
+
+#include "containers/intrusive_list.hpp"
+#include "errors.hpp"
+
+template <class T> class mpsc_list_t;
+
+template <class T>
+class mpsc_list_node_t {
+protected:
+    mpsc_list_node_t() : mpsc_next_(nullptr) { }
+
+private:
+    friend class mpsc_list_t<T>;
+    T *mpsc_next_;
+};
+
+/* `mpsc_list_t` is a lock-free intrusive list that any number of threads can push
+to, and that one thread at a time takes all items from.  Items pushed by a single
+thread come out in the order they were pushed.
+
+Internally this is a stack that producers push onto with a compare-and-swap.  The
+consumer detaches the whole stack with one exchange and reverses it, so there is no
+ABA problem and neither side ever waits for the other. */
+template <class T>
+class mpsc_list_t {
+public:
+    mpsc_list_t() : head_(nullptr) { }
+    ~mpsc_list_t() {
+        guarantee(empty());
+    }
+
+    // Moves all items from `list` to the back of this list.  Returns true if this
+    // list was empty before (as seen by this thread).
+    bool push_all(intrusive_list_t<T> *list) {
+        if (list->empty()) {
+            return false;
+        }
+        // Build a chain with the newest item first, like the stack itself.
+        T *oldest = list->head();
+        T *newest = nullptr;
+        while (T *item = list->head()) {
+            list->remove(item);
+            static_cast<mpsc_list_node_t<T> *>(item)->mpsc_next_ = newest;
+            newest = item;
+        }
+        T *old_head = head_.load(std::memory_order_relaxed);
+        do {
+            static_cast<mpsc_list_node_t<T> *>(oldest)->mpsc_next_ = old_head;
+        } while (!head_.compare_exchange_weak(old_head, newest));
+        return old_head == nullptr;
+    }
+
+    bool push(T *item) {
+        intrusive_list_t<T> list;
+        list.push_back(item);
+        return push_all(&list);
+    }
+
+    // Moves all items to the back of `list_out`, oldest first.  Must not be called
+    // by more than one thread at a time.
+    void pop_all(intrusive_list_t<T> *list_out) {
+        T *item = head_.exchange(nullptr, std::memory_order_acquire);
+        // Reverse the chain, so it goes from the oldest to the newest item.
+        T *oldest = nullptr;
+        while (item != nullptr) {
+            T *next = static_cast<mpsc_list_node_t<T> *>(item)->mpsc_next_;
+            static_cast<mpsc_list_node_t<T> *>(item)->mpsc_next_ = oldest;
+            oldest = item;
+            item = next;
+        }
+        while (oldest != nullptr) {
+            T *next = static_cast<mpsc_list_node_t<T> *>(oldest)->mpsc_next_;
+            static_cast<mpsc_list_node_t<T> *>(oldest)->mpsc_next_ = nullptr;
+            list_out->push_back(oldest);
+            oldest = next;
+        }
+    }
+
+    // Pushing and `empty()` are sequentially consistent, so a consumer can safely go
+    // to sleep after clearing a flag that producers set after pushing, and then
+    // checking `empty()` one last time.
+    bool empty() const {
+        return head_.load() == nullptr;
+    }
+
+private:
+    std::atomic<T *> head_;
+
+    DISABLE_COPYING(mpsc_list_t);
+};
+
+#endif  // CONTAINERS_MPSC_LIST_HPP_
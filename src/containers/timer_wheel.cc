@@ -0,0 +1,199 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "containers/timer_wheel.hpp"
+
+#include <string.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+const int overflow_shift = timer_wheel_t::LEVEL_BITS * timer_wheel_t::NUM_LEVELS;
+
+int slot_index(int64_t tick, int level) {
+    return static_cast<int>((tick >> (level * timer_wheel_t::LEVEL_BITS))
+                            & (timer_wheel_t::NUM_SLOTS - 1));
+}
+
+// The first tick covered by slot `index` of `level`, in the slot range that `tick` is
+// in.
+int64_t slot_start(int64_t tick, int level, int index) {
+    const int shift = (level + 1) * timer_wheel_t::LEVEL_BITS;
+    return ((tick >> shift) << shift)
+        + (static_cast<int64_t>(index) << (level * timer_wheel_t::LEVEL_BITS));
+}
+
+// The index of the lowest set bit of `bits`, which must not be zero.
+int lowest_set_bit(uint64_t bits) {
+#ifdef _MSC_VER
+    unsigned long index;  // NOLINT(runtime/int)
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+}  // namespace
+
+timer_wheel_t::timer_wheel_t(int64_t start_tick)
+    : current_tick(start_tick), size_(0), overflow_epoch(0) {
+    guarantee(start_tick >= 0);
+    memset(occupied, 0, sizeof(occupied));
+}
+
+timer_wheel_t::~timer_wheel_t() {
+    guarantee(empty());
+}
+
+void timer_wheel_t::insert(timer_wheel_entry_t *entry, int64_t expiry_tick) {
+    rassert(!entry->in_a_list());
+    entry->expiry_tick = std::max(expiry_tick, current_tick);
+    place(entry);
+    ++size_;
+}
+
+void timer_wheel_t::remove(timer_wheel_entry_t *entry) {
+    rassert(entry->in_a_list());
+    unlink(entry);
+    --size_;
+}
+
+timer_wheel_entry_t *timer_wheel_t::pop_expired(int64_t now_tick) {
+    while (expired.empty()) {
+        const int64_t tick = empty() ? std::numeric_limits<int64_t>::max()
+                                     : next_event_tick();
+        if (tick > now_tick) {
+            // Nothing else can happen before `now_tick`, so we skip ahead.
+            current_tick = std::max(current_tick, now_tick + 1);
+            break;
+        }
+        current_tick = tick;
+
+        // Entries that are now close enough move down the levels, starting at the top
+        // so that they can cascade all the way in one go.
+        if (!overflow.empty() && (current_tick >> overflow_shift) != overflow_epoch) {
+            cascade(&overflow);
+        }
+        for (int level = NUM_LEVELS - 1; level > 0; --level) {
+            cascade(&slots[level][slot_index(current_tick, level)]);
+        }
+
+        // What's left in the slot for the current tick is due.
+        const int index = slot_index(current_tick, 0);
+        slot_t *slot = &slots[0][index];
+        while (timer_wheel_entry_t *entry = slot->head()) {
+            slot->remove(entry);
+            entry->level = EXPIRED_LEVEL;
+            expired.push_back(entry);
+        }
+        occupied[0][index / 64] &= ~(static_cast<uint64_t>(1) << (index % 64));
+        current_tick = tick + 1;
+    }
+
+    timer_wheel_entry_t *entry = expired.head();
+    if (entry != nullptr) {
+        remove(entry);
+    }
+    return entry;
+}
+
+int64_t timer_wheel_t::next_event_tick() const {
+    guarantee(!empty());
+    if (!expired.empty()) {
+        return expired.head()->expiry_tick;
+    }
+    int64_t result = std::numeric_limits<int64_t>::max();
+    for (int level = 0; level < NUM_LEVELS; ++level) {
+        const int index = find_slot(level, slot_index(current_tick, level));
+        if (index != -1) {
+            // If the current tick is in the middle of the slot, the slot has to be
+            // cascaded right away.
+            result = std::min(result,
+                std::max(current_tick, slot_start(current_tick, level, index)));
+        }
+    }
+    if (!overflow.empty()) {
+        result = std::min(result, (overflow_epoch + 1) << overflow_shift);
+    }
+    return result;
+}
+
+void timer_wheel_t::place(timer_wheel_entry_t *entry) {
+    int level = 0;
+    while (level < NUM_LEVELS
+           && (entry->expiry_tick >> ((level + 1) * LEVEL_BITS))
+              != (current_tick >> ((level + 1) * LEVEL_BITS))) {
+        ++level;
+    }
+    entry->level = level;
+    if (level == NUM_LEVELS) {
+        if (overflow.empty()) {
+            overflow_epoch = current_tick >> overflow_shift;
+        }
+        rassert(overflow_epoch == current_tick >> overflow_shift);
+        entry->level = OVERFLOW_LEVEL;
+        overflow.push_back(entry);
+        return;
+    }
+    // Because the entry and the current tick share the slot range of the level above,
+    // this slot is never one that the current tick has already passed.
+    const int index = slot_index(entry->expiry_tick, level);
+    entry->index = index;
+    slots[level][index].push_back(entry);
+    occupied[level][index / 64] |= static_cast<uint64_t>(1) << (index % 64);
+}
+
+void timer_wheel_t::unlink(timer_wheel_entry_t *entry) {
+    switch (entry->level) {
+    case OVERFLOW_LEVEL:
+        overflow.remove(entry);
+        break;
+    case EXPIRED_LEVEL:
+        expired.remove(entry);
+        break;
+    default: {
+        rassert(entry->level >= 0 && entry->level < NUM_LEVELS);
+        slot_t *slot = &slots[entry->level][entry->index];
+        slot->remove(entry);
+        if (slot->empty()) {
+            occupied[entry->level][entry->index / 64]
+                &= ~(static_cast<uint64_t>(1) << (entry->index % 64));
+        }
+        break;
+    }
+    }
+    entry->level = -1;
+    entry->index = -1;
+}
+
+void timer_wheel_t::cascade(slot_t *slot) {
+    // Detach the entries first, since some of them might end up in the same slot
+    // again (the overflow list in particular).
+    slot_t entries;
+    while (timer_wheel_entry_t *entry = slot->head()) {
+        unlink(entry);
+        entries.push_back(entry);
+    }
+    while (timer_wheel_entry_t *entry = entries.head()) {
+        entries.remove(entry);
+        place(entry);
+    }
+}
+
+int timer_wheel_t::find_slot(int level, int from) const {
+    int word = from / 64;
+    uint64_t bits = occupied[level][word] & (~static_cast<uint64_t>(0) << (from % 64));
+    for (;;) {
+        if (bits != 0) {
+            return word * 64 + lowest_set_bit(bits);
+        }
+        if (++word == BITMAP_WORDS) {
+            return -1;
+        }
+        bits = occupied[level][word];
+    }
+}
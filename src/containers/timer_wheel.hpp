@@ -0,0 +1,102 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_TIMER_WHEEL_HPP_
+#define CONTAINERS_TIMER_WHEEL_HPP_
+
+#include <stdint.h>
+
+#include "containers/intrusive_list.hpp"
+#include "errors.hpp"
+
+class timer_wheel_t;
+
+/* Objects stored in a `timer_wheel_t` derive from `timer_wheel_entry_t`. */
+class timer_wheel_entry_t : public intrusive_list_node_t<timer_wheel_entry_t> {
+public:
+    timer_wheel_entry_t() : expiry_tick(-1), level(-1), index(-1) { }
+
+    int64_t get_expiry_tick() const { return expiry_tick; }
+
+private:
+    friend class timer_wheel_t;
+    int64_t expiry_tick;
+    // Where in the wheel the entry is.
+    int level;
+    int index;
+
+    DISABLE_COPYING(timer_wheel_entry_t);
+};
+
+/* `timer_wheel_t` is a hierarchical timer wheel.  It keeps entries ordered by an
+integer expiry "tick", with O(1) insertion and removal.
+
+Level `L` has `TIMER_WHEEL_SLOTS` slots, each covering `TIMER_WHEEL_SLOTS^L` ticks.
+An entry goes into the lowest level whose slot range contains both its expiry tick and
+the current tick, and moves down ("cascades") a level once the current tick reaches
+its slot.  Entries too far in the future for the top level wait in an overflow list.
+A bitmap of the non-empty slots on each level makes it cheap to find the next tick at
+which something happens, so the wheel can skip over idle stretches of time.
+
+`timer_wheel_t` doesn't own its entries or know about real time; the caller drives it
+with `pop_expired()`. */
+class timer_wheel_t {
+public:
+    static const int LEVEL_BITS = 8;
+    static const int NUM_SLOTS = 1 << LEVEL_BITS;
+    static const int NUM_LEVELS = 4;
+
+    explicit timer_wheel_t(int64_t start_tick);
+    ~timer_wheel_t();
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+    /* Entries whose expiry tick has already passed expire on the next call to
+    `pop_expired()`. */
+    void insert(timer_wheel_entry_t *entry, int64_t expiry_tick);
+    void remove(timer_wheel_entry_t *entry);
+
+    /* Returns an entry with an expiry tick of at most `now_tick` and removes it from
+    the wheel, or returns `nullptr` if there is none.  Entries are returned in the
+    order of their expiry ticks.  `now_tick` must not go backwards.  It's fine to
+    insert or remove entries between calls. */
+    timer_wheel_entry_t *pop_expired(int64_t now_tick);
+
+    /* Returns the earliest tick at which `pop_expired()` might have something to do.
+    That is no later than the earliest expiry tick in the wheel, but it might be
+    earlier, when entries have to be cascaded.  Must not be called if the wheel is
+    empty. */
+    int64_t next_event_tick() const;
+
+private:
+    typedef intrusive_list_t<timer_wheel_entry_t> slot_t;
+
+    static const int OVERFLOW_LEVEL = NUM_LEVELS;
+    static const int EXPIRED_LEVEL = NUM_LEVELS + 1;
+    static const int BITMAP_WORDS = NUM_SLOTS / 64;
+
+    void place(timer_wheel_entry_t *entry);
+    void unlink(timer_wheel_entry_t *entry);
+    void cascade(slot_t *slot);
+    // Returns the first non-empty slot on `level` with an index of at least `from`, or
+    // -1 if there is none.
+    int find_slot(int level, int from) const;
+
+    // Every tick before `current_tick` has been processed.
+    int64_t current_tick;
+    size_t size_;
+
+    slot_t slots[NUM_LEVELS][NUM_SLOTS];
+    uint64_t occupied[NUM_LEVELS][BITMAP_WORDS];
+
+    // Entries that are too far in the future even for the top level.  They all got
+    // there while `current_tick >> overflow_shift` was `overflow_epoch`.
+    slot_t overflow;
+    int64_t overflow_epoch;
+
+    // Entries that are due, in expiry order, waiting to be returned by `pop_expired()`.
+    slot_t expired;
+
+    DISABLE_COPYING(timer_wheel_t);
+};
+
+#endif  // CONTAINERS_TIMER_WHEEL_HPP_
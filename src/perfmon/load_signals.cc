@@ -0,0 +1,43 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "perfmon/load_signals.hpp"
+
+#include "arch/runtime/runtime.hpp"
+
+load_counter_t::load_counter_t() {
+    for (auto &slot : slots) {
+        slot.value.store(0, std::memory_order_relaxed);
+    }
+}
+
+void load_counter_t::add(int64_t delta) {
+    int thread = get_thread_id().threadnum;
+    if (thread < 0 || thread >= MAX_THREADS) {
+        thread = MAX_THREADS;
+    }
+    slots[thread].value.fetch_add(delta, std::memory_order_relaxed);
+}
+
+int64_t load_counter_t::get_total() const {
+    int64_t total = 0;
+    for (const auto &slot : slots) {
+        total += slot.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+// These are function-local statics so that they are constructed before anything
+// updates them, even during static initialization.
+load_counter_t *get_disk_ops_in_flight() {
+    static load_counter_t counter;
+    return &counter;
+}
+
+load_counter_t *get_cache_page_acquisitions() {
+    static load_counter_t counter;
+    return &counter;
+}
+
+load_counter_t *get_cache_page_misses() {
+    static load_counter_t counter;
+    return &counter;
+}
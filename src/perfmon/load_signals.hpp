@@ -0,0 +1,41 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef PERFMON_LOAD_SIGNALS_HPP_
+#define PERFMON_LOAD_SIGNALS_HPP_
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "concurrency/cache_line_padded.hpp"
+#include "config/args.hpp"
+#include "errors.hpp"
+
+/* `load_counter_t` is a counter that any thread can update cheaply, and that any
+thread can read the (approximate) total of.  Every thread has its own slot, so updates
+don't contend with each other. */
+class load_counter_t {
+public:
+    load_counter_t();
+
+    void add(int64_t delta);
+    int64_t get_total() const;
+
+private:
+    // The last slot is shared by the threads outside of the thread pool.
+    cache_line_padded_t<std::atomic<int64_t> > slots[MAX_THREADS + 1];
+
+    DISABLE_COPYING(load_counter_t);
+};
+
+/* Node-wide indicators of how busy the server is, for admission control (see
+`client_protocol/admission_control.hpp`). */
+
+// Disk operations that have been submitted but haven't completed yet.
+load_counter_t *get_disk_ops_in_flight();
+
+// Buffer cache page acquisitions, and those of them that had to wait for the page to
+// be read from disk.
+load_counter_t *get_cache_page_acquisitions();
+load_counter_t *get_cache_page_misses();
+
+#endif  // PERFMON_LOAD_SIGNALS_HPP_
@@ -173,12 +173,14 @@ ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(durability_requirement_t,
                                       DURABILITY_REQUIREMENT_DEFAULT,
                                       DURABILITY_REQUIREMENT_SOFT);
 
-enum class read_mode_t { MAJORITY, SINGLE, OUTDATED, DEBUG_DIRECT };
+/* `BOUNDED` reads may be served by any replica whose data is at most
+`read_t::max_staleness_ms` behind the primary; otherwise they go to the primary. */
+enum class read_mode_t { MAJORITY, SINGLE, OUTDATED, DEBUG_DIRECT, BOUNDED };
 
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(read_mode_t,
                                       int8_t,
                                       read_mode_t::MAJORITY,
-                                      read_mode_t::DEBUG_DIRECT);
+                                      read_mode_t::BOUNDED);
 
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
         reql_version_t, int8_t,
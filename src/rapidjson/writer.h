@@ -162,6 +162,23 @@ public:
         return true;
     }
 
+    // RethinkDB addition: Splice a chunked buffer (containing an array) into the
+    // current array.  The chunks are moved rather than copied, and `buffer` is
+    // left empty.
+    template <typename ChunkedBuffer>
+    bool SpliceChunkedArray(ChunkedBuffer *buffer) {
+        RAPIDJSON_ASSERT(level_stack_.template Top<Level>()->inArray);
+        Prefix(kStringType); // The type doesn't matter here
+
+        // Ignore the start and end square brackets in the array
+        RAPIDJSON_ASSERT(buffer->front() == '[');
+        RAPIDJSON_ASSERT(buffer->back() == ']');
+        buffer->pop_front(1);
+        buffer->Pop(1);
+        os_->splice(buffer);
+        return true;
+    }
+
     bool StartObject() {
         Prefix(kObjectType);
         new (level_stack_.template Push<Level>()) Level(false);
@@ -133,7 +133,7 @@ scoped_ptr_t<ql::reader_t> artificial_table_t::read_all_with_sindexes(
     counted_t<ql::datum_stream_t> datum_stream =
         read_all(env, sindex, bt, table_name, datumspec, sorting, read_mode);
 
-    scoped_ptr_t<ql::eager_acc_t> to_array = ql::make_to_array();
+    scoped_ptr_t<ql::eager_acc_t> to_array = ql::make_to_array(env);
     datum_stream->accumulate_all(env, to_array.get());
     ql::datum_t items = to_array->finish_eager(
         bt,
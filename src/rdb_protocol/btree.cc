@@ -587,6 +587,14 @@ void rdb_value_detacher_t::delete_value(buf_parent_t parent, const void *value)
     detach_rdb_value(parent, value);
 }
 
+void rdb_value_discarder_t::delete_value(buf_parent_t parent, const void *value) const {
+    rdb_value_sizer_t sizer(parent.cache()->max_block_size());
+    scoped_malloc_t<rdb_value_t> value_copy(sizer.max_possible_size());
+    memcpy(value_copy.get(), value, sizer.size(value));
+    detach_rdb_value(parent, value);
+    actually_delete_rdb_value(buf_parent_t(parent.txn()), value_copy.get());
+}
+
 typedef ql::transform_variant_t transform_variant_t;
 typedef ql::terminal_variant_t terminal_variant_t;
 
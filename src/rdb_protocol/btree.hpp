@@ -358,6 +358,14 @@ public:
     void delete_value(buf_parent_t parent, const void *value) const;
 };
 
+/* Detaches a value from its leaf node and then deletes it right away. Used for
+ * discarding whole leaf nodes of the primary btree once there are no secondary index
+ * entries left that refer to the values. */
+class rdb_value_discarder_t : public value_deleter_t {
+public:
+    void delete_value(buf_parent_t parent, const void *value) const;
+};
+
 /* Used for operations on the live storage.
  * Each value is first detached in all trees, and then actually deleted through
  * the post_deleter. */
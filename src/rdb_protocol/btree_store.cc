@@ -91,6 +91,7 @@ store_t::store_t(const region_t &_region,
       perfmon_collection(),
       io_backender_(io_backender), base_path_(base_path),
       perfmon_collection_membership(parent_perfmon_collection, &perfmon_collection, perfmon_name),
+      key_load_sampler_membership(&perfmon_collection, &key_load_sampler, "key_load"),
       ctx(_ctx),
       table_id(_table_id),
       write_superblock_acq_semaphore(WRITE_SUPERBLOCK_ACQ_WAITERS_LIMIT)
@@ -248,35 +249,125 @@ void store_t::reset_data(
     assert_thread();
     with_priority_t p(CORO_PRIORITY_RESET_DATA);
 
-    // Erase the data in small chunks
-    always_true_key_tester_t key_tester;
+    if (subregion != get_region()) {
+        /* Only part of the key range goes away, so we have to erase it key by key and
+        remove each of the documents from the secondary indexes. */
+        for (continue_bool_t done_erasing = continue_bool_t::CONTINUE;
+             done_erasing == continue_bool_t::CONTINUE;) {
+            done_erasing = reset_data_pass(
+                zero_metainfo, subregion, durability, std::set<uuid_u>(), interruptor);
+        }
+        return;
+    }
+
+    /* Erasing the documents one at a time and removing each of them from the secondary
+    indexes takes O(m log n) writes. Since we're erasing everything, we instead swap
+    every secondary index for an empty one, and then free the nodes of the old indexes
+    and of the primary btree in bulk.
+
+    The new indexes are only marked as constructed once the primary btree is empty. If
+    we get interrupted before that, they get post-constructed from whatever data is
+    left, so they always end up consistent with the primary btree. */
+    std::vector<secondary_index_t> old_sindexes;
+    std::set<uuid_u> new_sindexes;
+    replace_sindexes_with_empty_ones(
+        durability, interruptor, &old_sindexes, &new_sindexes);
+
+    size_t num_old_sindexes_dropped = 0;
+    try {
+        rdb_value_sizer_t sizer(cache->max_block_size());
+        for (const secondary_index_t &sindex : old_sindexes) {
+            /* The documents still exist at this point, so we must detach the values of
+            indexes that might be read from snapshots. See also
+            `delayed_clear_and_drop_sindex()`. */
+            rdb_live_deletion_context_t live_deletion_context;
+            rdb_post_construction_deletion_context_t post_con_deletion_context;
+            deletion_context_t *actual_deletion_context =
+                sindex.post_construction_complete()
+                ? static_cast<deletion_context_t *>(&live_deletion_context)
+                : static_cast<deletion_context_t *>(&post_con_deletion_context);
+            clear_sindex_data(sindex.id,
+                              &sizer,
+                              actual_deletion_context,
+                              key_range_t::universe(),
+                              interruptor);
+            drop_sindex(sindex.id);
+            ++num_old_sindexes_dropped;
+        }
+
+        for (continue_bool_t done_erasing = continue_bool_t::CONTINUE;
+             done_erasing == continue_bool_t::CONTINUE;) {
+            done_erasing = reset_data_pass(
+                zero_metainfo, subregion, durability, new_sindexes, interruptor);
+        }
+    } catch (const interrupted_exc_t &) {
+        for (size_t i = num_old_sindexes_dropped; i < old_sindexes.size(); ++i) {
+            coro_t::spawn_sometime(std::bind(&store_t::delayed_clear_and_drop_sindex,
+                                             this,
+                                             old_sindexes[i],
+                                             drainer.lock()));
+        }
+        for (const uuid_u &sindex_id : new_sindexes) {
+            coro_t::spawn_sometime(std::bind(&rdb_protocol::resume_construct_sindex,
+                                             sindex_id,
+                                             key_range_t::universe(),
+                                             this,
+                                             drainer.lock()));
+        }
+        throw;
+    }
+}
+
+continue_bool_t store_t::reset_data_pass(
+        const binary_blob_t &zero_metainfo,
+        const region_t &subregion,
+        write_durability_t durability,
+        const std::set<uuid_u> &new_sindexes,
+        signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+
     const uint64_t max_erased_per_pass = 100;
-    for (continue_bool_t done_erasing = continue_bool_t::CONTINUE;
-         done_erasing == continue_bool_t::CONTINUE;) {
-        scoped_ptr_t<txn_t> txn;
-        scoped_ptr_t<real_superblock_t> superblock;
+    const int expected_change_count = 2 + max_erased_per_pass;
+    write_token_t token;
+    new_write_token(&token);
+    acquire_superblock_for_write(expected_change_count,
+                                 durability,
+                                 &token,
+                                 &txn,
+                                 &superblock,
+                                 interruptor);
 
-        const int expected_change_count = 2 + max_erased_per_pass;
-        write_token_t token;
-        new_write_token(&token);
-        acquire_superblock_for_write(expected_change_count,
-                                     durability,
-                                     &token,
-                                     &txn,
-                                     &superblock,
-                                     interruptor);
+    buf_lock_t sindex_block(superblock->expose_buf(),
+                            superblock->get_sindex_block_id(),
+                            access_t::write);
 
-        buf_lock_t sindex_block(superblock->expose_buf(),
-                                superblock->get_sindex_block_id(),
-                                access_t::write);
+    /* Discarding whole nodes is only possible if we're erasing the whole btree.
+    Otherwise, or if a secondary index that was created after we swapped out the old
+    ones is under construction (which relies on seeing the modification reports for
+    every document we erase), we have to erase one key at a time. */
+    bool erase_key_by_key = subregion != get_region();
+    {
+        std::map<sindex_name_t, secondary_index_t> sindexes;
+        get_secondary_indexes(&sindex_block, &sindexes);
+        for (const auto &pair : sindexes) {
+            if (!pair.second.being_deleted && new_sindexes.count(pair.second.id) == 0) {
+                erase_key_by_key = true;
+            }
+        }
+    }
 
-        /* Note we don't allow interruption during this step; it's too easy to end up in
-        an inconsistent state. */
-        cond_t non_interruptor;
+    /* Note we don't allow interruption during this step; it's too easy to end up in
+    an inconsistent state. */
+    cond_t non_interruptor;
 
-        rdb_live_deletion_context_t deletion_context;
-        std::vector<rdb_modification_report_t> mod_reports;
-        key_range_t deleted_range;
+    continue_bool_t done_erasing;
+    rdb_live_deletion_context_t deletion_context;
+    std::vector<rdb_modification_report_t> mod_reports;
+    key_range_t deleted_range;
+    if (erase_key_by_key) {
+        always_true_key_tester_t key_tester;
         done_erasing = rdb_erase_small_range(btree.get(),
                                              &key_tester,
                                              subregion.inner,
@@ -286,19 +377,83 @@ void store_t::reset_data(
                                              max_erased_per_pass,
                                              &mod_reports,
                                              &deleted_range);
+    } else {
+        /* None of the secondary indexes refer to the documents anymore, so we can
+        delete the values right away while freeing the leaf nodes. */
+        rdb_value_sizer_t sizer(cache->max_block_size());
+        rdb_value_discarder_t discarder;
+        done_erasing = rdb_discard_small_subtree(&sizer,
+                                                 subregion.inner,
+                                                 superblock.get(),
+                                                 &discarder,
+                                                 &deleted_range);
+        if (done_erasing == continue_bool_t::ABORT) {
+            /* The btree is empty now, and so are the new secondary indexes. */
+            for (const uuid_u &sindex_id : new_sindexes) {
+                mark_index_up_to_date(sindex_id, &sindex_block, key_range_t::empty());
+            }
+        }
+    }
 
+    if (!deleted_range.is_empty()) {
         region_t deleted_region(subregion.beg, subregion.end, deleted_range);
         metainfo->update(superblock.get(),
                          region_map_t<binary_blob_t>(deleted_region, zero_metainfo));
+    }
 
-        superblock.reset();
-        if (!mod_reports.empty()) {
-            update_sindexes(txn.get(), &sindex_block, mod_reports, true);
-        }
+    superblock.reset();
+    if (!mod_reports.empty()) {
+        update_sindexes(txn.get(), &sindex_block, mod_reports, true);
+    }
 
-        sindex_block.reset_buf_lock();
-        txn->commit();
+    sindex_block.reset_buf_lock();
+    txn->commit();
+    return done_erasing;
+}
+
+void store_t::replace_sindexes_with_empty_ones(
+        write_durability_t durability,
+        signal_t *interruptor,
+        std::vector<secondary_index_t> *old_sindexes_out,
+        std::set<uuid_u> *new_sindexes_out)
+        THROWS_ONLY(interrupted_exc_t) {
+    write_token_t token;
+    new_write_token(&token);
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    acquire_superblock_for_write(2,
+                                 durability,
+                                 &token,
+                                 &txn,
+                                 &superblock,
+                                 interruptor);
+    buf_lock_t sindex_block(superblock->expose_buf(),
+                            superblock->get_sindex_block_id(),
+                            access_t::write);
+    superblock->release();
+
+    std::map<sindex_name_t, secondary_index_t> sindexes;
+    get_secondary_indexes(&sindex_block, &sindexes);
+    for (const auto &pair : sindexes) {
+        if (pair.second.being_deleted) {
+            continue;
+        }
+        /* The old index keeps its data and gets cleared by `reset_data()`. The new one
+        has the same name and definition, and starts out waiting for construction. */
+        bool success = mark_secondary_index_deleted(&sindex_block, pair.first);
+        guarantee(success);
+        optional<uuid_u> new_id = add_sindex_internal(
+            pair.first, pair.second.opaque_definition, &sindex_block);
+        guarantee(new_id);
+
+        secondary_index_t old_sindex = pair.second;
+        old_sindex.being_deleted = true;
+        old_sindexes_out->push_back(old_sindex);
+        new_sindexes_out->insert(*new_id);
     }
+
+    sindex_block.reset_buf_lock();
+    txn->commit();
 }
 
 std::map<std::string, std::pair<sindex_config_t, sindex_status_t> > store_t::sindex_list(
@@ -710,6 +865,12 @@ void store_t::clear_sindex_data(
         const key_range_t &pkey_range_to_clear,
         signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t) {
+    if (pkey_range_to_clear == key_range_t::universe()) {
+        /* Everything goes, so we don't need to look at the individual keys. */
+        discard_sindex_data(sindex_id, sizer, deletion_context, interruptor);
+        return;
+    }
+
     /* Delete one piece of the secondary index at a time */
     key_range_t remaining_range = key_range_t::universe();
     for (bool reached_end = false; !reached_end;)
@@ -821,6 +982,64 @@ void store_t::clear_sindex_data(
     }
 }
 
+void store_t::discard_sindex_data(
+        uuid_u sindex_id,
+        value_sizer_t *sizer,
+        const deletion_context_t *deletion_context,
+        signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    /* Free a few nodes of the secondary index at a time */
+    for (continue_bool_t done = continue_bool_t::CONTINUE;
+         done == continue_bool_t::CONTINUE;) {
+        coro_t::yield();
+        if (interruptor->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+
+        write_token_t token;
+        new_write_token(&token);
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        acquire_superblock_for_write(
+            // Not really the right value, since we free a whole node at a time:
+            clear_sindex_traversal_cb_t::CHUNK_SIZE,
+            write_durability_t::SOFT,
+            &token,
+            &txn,
+            &superblock,
+            interruptor);
+
+        buf_lock_t sindex_block(superblock->expose_buf(),
+                                superblock->get_sindex_block_id(),
+                                access_t::write);
+        superblock->release();
+
+        secondary_index_t sindex;
+        bool found = get_secondary_index(&sindex_block, sindex_id, &sindex);
+        if (!found) {
+            // The index got dropped by someone else. That's ok, there's nothing left
+            // to do for us.
+            return;
+        }
+
+        buf_lock_t sindex_superblock_lock(buf_parent_t(&sindex_block),
+                                          sindex.superblock, access_t::write);
+        sindex_block.reset_buf_lock();
+        scoped_ptr_t<sindex_superblock_t> sindex_superblock
+            = make_scoped<sindex_superblock_t>(std::move(sindex_superblock_lock));
+
+        key_range_t discarded_range;
+        done = rdb_discard_small_subtree(sizer,
+                                         key_range_t::universe(),
+                                         sindex_superblock.get(),
+                                         deletion_context->in_tree_deleter(),
+                                         &discarded_range);
+
+        sindex_superblock.reset();
+        txn->commit();
+    }
+}
+
 void store_t::drop_sindex(uuid_u sindex_id) THROWS_NOTHING {
     /* Start a transaction. */
     write_token_t token;
@@ -3,12 +3,17 @@
 
 #include <queue>
 
+#include "assignment_sentry.hpp"
 #include "btree/reql_specific.hpp"
 #include "clustering/administration/auth/user_context.hpp"
 #include "clustering/administration/tables/name_resolver.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/interruptor.hpp"
+#include "config/args.hpp"
 #include "containers/archive/boost_types.hpp"
+#include "containers/archive/optional.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/disk_backed_queue.hpp"
 #include "rdb_protocol/artificial_table/backend.hpp"
 #include "rdb_protocol/btree.hpp"
 #include "rdb_protocol/env.hpp"
@@ -170,6 +175,9 @@ public:
     virtual ~maybe_squashing_queue_t() { }
     virtual void add(change_val_t change_val) = 0;
     virtual size_t size() const = 0;
+    // The number of changes currently held in memory.  This is what the
+    // `changefeed_queue_size` limit is checked against.
+    virtual size_t memory_size() const = 0;
     virtual void clear() = 0;
     virtual change_val_t pop() = 0;
     virtual const change_val_t &peek() = 0;
@@ -183,6 +191,9 @@ class nonsquashing_queue_t final : public maybe_squashing_queue_t {
     size_t size() const final {
         return queue.size();
     }
+    size_t memory_size() const final {
+        return queue.size();
+    }
     void clear() final {
         queue.clear();
     }
@@ -249,6 +260,9 @@ public:
         guarantee(queue.size() == queue_order.size());
         return queue.size();
     }
+    size_t memory_size() const final {
+        return size();
+    }
     void clear() final {
         queue.clear();
         queue_order.clear();
@@ -278,6 +292,223 @@ private:
     std::list<store_key_t> queue_order;
 };
 
+// The on-disk representation of a `change_val_t` in a `spilling_queue_t`.
+// Spill files never outlive the process, so this is only ever serialized with
+// `cluster_version_t::LATEST_OVERALL`.
+struct spilled_change_val_t {
+    std::pair<uuid_u, uint64_t> source_stamp;
+    store_key_t pkey;
+    optional<datum_t> old_val;
+    optional<std::string> old_index_key;
+    optional<datum_t> new_val;
+    optional<std::string> new_index_key;
+    optional<std::string> sindex;
+};
+RDB_MAKE_SERIALIZABLE_7(spilled_change_val_t,
+                        source_stamp, pkey, old_val, old_index_key,
+                        new_val, new_index_key, sindex);
+
+// A non-squashing queue that keeps at most `max_memory_size` changes ready in
+// memory.  Once that many changes are queued, further changes are appended to
+// `write_buffer` and a background coroutine moves them to a
+// `disk_backed_queue_t`, from which they are read back in batches as the
+// consumer catches up.  Changes are only ever written to `queue` when no live
+// changes are waiting on disk or in `write_buffer`, so the order in which they
+// were added is preserved.
+//
+// `add`, `clear`, `size`, `memory_size` and `purge_below` never block, because
+// `add_el` calls them with coroutine switches forbidden.  `pop` and `peek` may
+// block on disk I/O.
+class spilling_queue_t final : public maybe_squashing_queue_t {
+public:
+    spilling_queue_t(rdb_context_t *ctx, size_t _max_memory_size)
+        : max_memory_size(std::max<size_t>(_max_memory_size, 1)),
+          disk_live(0),
+          disk_written(0),
+          writer_running(false),
+          write_waiter(nullptr),
+          io_backender(ctx->io_backender),
+          base_path(ctx->base_path) {
+        guarantee(io_backender != nullptr);
+    }
+    void add(change_val_t change_val) final {
+        if (disk_live == 0 && write_buffer.empty() && queue.size() < max_memory_size) {
+            queue.push_back(std::move(change_val));
+            return;
+        }
+        spilled_change_val_t spilled;
+        spilled.source_stamp = change_val.source_stamp;
+        spilled.pkey = change_val.pkey;
+        if (change_val.old_val) {
+            spilled.old_val.set(std::move(change_val.old_val->val));
+            spilled.old_index_key = std::move(change_val.old_val->btree_index_key);
+        }
+        if (change_val.new_val) {
+            spilled.new_val.set(std::move(change_val.new_val->val));
+            spilled.new_index_key = std::move(change_val.new_val->btree_index_key);
+        }
+        DEBUG_ONLY_CODE(spilled.sindex = std::move(change_val.sindex));
+        write_buffer.push_back(std::move(spilled));
+        if (!writer_running) {
+            writer_running = true;
+            coro_t::spawn_sometime(std::bind(
+                &spilling_queue_t::write_to_disk, this, drainer.lock()));
+        }
+    }
+    size_t size() const final {
+        return queue.size() + disk_live + write_buffer.size();
+    }
+    // Changes waiting in `write_buffer` are in memory too, so if the disk can't
+    // keep up with the writes we still hit the `changefeed_queue_size` limit.
+    size_t memory_size() const final {
+        return queue.size() + write_buffer.size();
+    }
+    void clear() final {
+        queue.clear();
+        write_buffer.clear();
+        // The changes on disk are skipped when the consumer reaches them.
+        for (auto &&entry : disk_index) {
+            entry.second = false;
+        }
+        disk_live = 0;
+    }
+    const change_val_t &peek() final {
+        guarantee(size() != 0);
+        maybe_refill();
+        return queue.front();
+    }
+    change_val_t pop() final {
+        guarantee(size() != 0);
+        maybe_refill();
+        auto ret = std::move(queue.front());
+        queue.pop_front();
+        return ret;
+    }
+    void purge_below(std::map<uuid_u, uint64_t> stamps) final {
+        // See `nonsquashing_queue_t::purge_below` for why these are `>=`.
+        auto keep = [&](const std::pair<uuid_u, uint64_t> &source_stamp) {
+            auto it = stamps.find(source_stamp.first);
+            r_sanity_check(it != stamps.end());
+            return source_stamp.second >= it->second;
+        };
+        std::deque<change_val_t> old_queue;
+        old_queue.swap(queue);
+        for (auto &&cv : old_queue) {
+            if (keep(cv.source_stamp)) {
+                queue.push_back(std::move(cv));
+            }
+        }
+        // We don't rewrite the spill file; purged changes are just marked dead in
+        // `disk_index` and skipped when the consumer reads past them.
+        for (auto &&entry : disk_index) {
+            if (entry.second && !keep(entry.first)) {
+                entry.second = false;
+                --disk_live;
+            }
+        }
+        std::deque<spilled_change_val_t> old_write_buffer;
+        old_write_buffer.swap(write_buffer);
+        for (auto &&spilled : old_write_buffer) {
+            if (keep(spilled.source_stamp)) {
+                write_buffer.push_back(std::move(spilled));
+            }
+        }
+    }
+private:
+    void write_to_disk(auto_drainer_t::lock_t keepalive) {
+        if (!disk_queue.has()) {
+            disk_queue.init(new disk_backed_queue_t<spilled_change_val_t>(
+                io_backender,
+                serializer_filepath_t(
+                    base_path, "changefeed_spill_" + uuid_to_str(generate_uuid())),
+                &perfmon_collection));
+        }
+        while (!write_buffer.empty() && !keepalive.get_drain_signal()->is_pulsed()) {
+            spilled_change_val_t spilled = std::move(write_buffer.front());
+            write_buffer.pop_front();
+            // The change is in `disk_index` while we write it, so that `clear` and
+            // `purge_below` can still drop it.
+            disk_index.push_back(std::make_pair(spilled.source_stamp, true));
+            ++disk_live;
+            disk_queue->push(spilled);
+            ++disk_written;
+            if (write_waiter != nullptr) {
+                write_waiter->pulse_if_not_already_pulsed();
+            }
+        }
+        writer_running = false;
+        if (write_waiter != nullptr) {
+            write_waiter->pulse_if_not_already_pulsed();
+        }
+    }
+    void maybe_refill() {
+        if (!queue.empty()) {
+            return;
+        }
+        while (queue.size() < max_memory_size) {
+            if (disk_written != 0) {
+                spilled_change_val_t spilled;
+                disk_queue->pop(&spilled);
+                --disk_written;
+                bool live = disk_index.front().second;
+                disk_index.pop_front();
+                if (live) {
+                    --disk_live;
+                    queue.push_back(unspill(std::move(spilled)));
+                }
+            } else if (!disk_index.empty()) {
+                // The next change is still being written.
+                cond_t written;
+                assignment_sentry_t<cond_t *> waiter(&write_waiter, &written);
+                written.wait_lazily_unordered();
+            } else if (!write_buffer.empty()) {
+                // Nothing is on disk, so the writer hasn't started on
+                // `write_buffer` yet and we can take changes from it directly.
+                queue.push_back(unspill(std::move(write_buffer.front())));
+                write_buffer.pop_front();
+            } else {
+                break;
+            }
+        }
+    }
+    static change_val_t unspill(spilled_change_val_t &&spilled) {
+        optional<indexed_datum_t> old_val, new_val;
+        if (spilled.old_val) {
+            old_val.set(indexed_datum_t(std::move(*spilled.old_val),
+                                        std::move(spilled.old_index_key)));
+        }
+        if (spilled.new_val) {
+            new_val.set(indexed_datum_t(std::move(*spilled.new_val),
+                                        std::move(spilled.new_index_key)));
+        }
+        return change_val_t(
+            spilled.source_stamp,
+            spilled.pkey,
+            std::move(old_val),
+            std::move(new_val)
+            DEBUG_ONLY(, std::move(spilled.sindex)));
+    }
+
+    const size_t max_memory_size;
+    std::deque<change_val_t> queue;
+    // The source stamp of every change that has been or is being written to disk
+    // and hasn't been read back yet, in order, and whether it's still live.
+    std::deque<std::pair<std::pair<uuid_u, uint64_t>, bool> > disk_index;
+    // The number of live changes in `disk_index`.
+    size_t disk_live;
+    // The number of changes at the front of `disk_index` that are on disk.
+    size_t disk_written;
+    // Changes waiting for `write_to_disk` to write them, after those on disk.
+    std::deque<spilled_change_val_t> write_buffer;
+    bool writer_running;
+    cond_t *write_waiter;
+    io_backender_t *io_backender;
+    const base_path_t base_path;
+    perfmon_collection_t perfmon_collection;
+    scoped_ptr_t<disk_backed_queue_t<spilled_change_val_t> > disk_queue;
+    auto_drainer_t drainer;
+};
+
 optional<datum_t> apply_ops(
     const datum_t &val,
     const std::vector<scoped_ptr_t<op_t> > &ops,
@@ -416,8 +647,11 @@ void server_t::add_client(
         //   `keepalive` in. This is no longer the case.
         //   We're keeping the `spawn_now_dangerously` for now to make sure that
         //   we don't introduce any subtle new bugs in 2.1.2.
+        // There is one of these coroutines per client, and it spends almost all
+        // of its life waiting, so it gets a small stack.
         coro_t::spawn_now_dangerously(
-            std::bind(&server_t::add_client_cb, this, stopped, addr, keepalive));
+            std::bind(&server_t::add_client_cb, this, stopped, addr, keepalive),
+            coro_stack_class_t::SMALL);
     }
 }
 
@@ -474,18 +708,21 @@ void server_t::add_client_cb(
             &disconnect, stopped, keepalive.get_drain_signal());
         wait_any.wait_lazily_unordered();
     }
-    rwlock_in_line_t coro_spot(&clients_lock, access_t::write);
-    coro_spot.read_signal()->wait_lazily_unordered();
-    auto it = clients.find(addr);
-    // We can be removed more than once safely (e.g. in the case of oversharding).
-    if (it != clients.end()) {
-        send_one_with_lock(&*it, msg_t(msg_t::stop_t()), keepalive);
-    }
-    coro_spot.write_signal()->wait_lazily_unordered();
-    size_t erased = clients.erase(addr);
-    // This is true even if we have multiple shards per btree because
-    // `add_client` only spawns one of us.
-    guarantee(erased == 1);
+    // We're running on a small stack, which isn't enough for sending a message.
+    call_with_enough_stack([&]() {
+        rwlock_in_line_t coro_spot(&clients_lock, access_t::write);
+        coro_spot.read_signal()->wait_lazily_unordered();
+        auto it = clients.find(addr);
+        // We can be removed more than once safely (e.g. in the case of oversharding).
+        if (it != clients.end()) {
+            send_one_with_lock(&*it, msg_t(msg_t::stop_t()), keepalive);
+        }
+        coro_spot.write_signal()->wait_lazily_unordered();
+        size_t erased = clients.erase(addr);
+        // This is true even if we have multiple shards per btree because
+        // `add_client` only spawns one of us.
+        guarantee(erased == 1);
+    }, COROUTINE_SMALL_STACK_SIZE);
 }
 
 struct stamped_msg_t {
@@ -1388,6 +1625,7 @@ protected:
     void destructor_cleanup(std::function<void()> del_sub) THROWS_NOTHING;
 
     datum_t maybe_add_type(datum_t &&datum, change_type_t type);
+    rdb_context_t *get_rdb_context() const { return rdb_context; }
     // If an error occurs, we're detached and `exc` is set to an exception to rethrow.
     std::exception_ptr exc;
     // If we exceed the array size limit, elements are evicted from `els` and
@@ -1544,11 +1782,18 @@ enum class init_squashing_queue_t { NO, YES };
 class flat_sub_t : public subscription_t {
 public:
     template<class... Args>
-    explicit flat_sub_t(init_squashing_queue_t init_squashing_queue, Args &&... args)
+    flat_sub_t(init_squashing_queue_t init_squashing_queue,
+               bool spill_to_disk,
+               Args &&... args)
         : subscription_t(std::forward<Args>(args)...),
           last_stamp(std::make_pair(nil_uuid(), std::numeric_limits<uint64_t>::max())) {
         if (init_squashing_queue == init_squashing_queue_t::YES && squash) {
             queue = make_scoped<squashing_queue_t>();
+        } else if (spill_to_disk && get_rdb_context()->io_backender != nullptr) {
+            // We keep at most half the queue size in memory, so we never hit
+            // the limit below and drop changes.
+            queue = make_scoped<spilling_queue_t>(
+                get_rdb_context(), limits.changefeed_queue_size() / 2);
         } else {
             queue = make_scoped<nonsquashing_queue_t>();
         }
@@ -1573,7 +1818,7 @@ public:
                 std::move(old_val),
                 std::move(new_val)
                 DEBUG_ONLY(, sindex)));
-            if (queue->size() > limits.changefeed_queue_size()) {
+            if (queue->memory_size() > limits.changefeed_queue_size()) {
                 skipped += queue->size();
                 queue->clear();
             } else if (queue->size() > limits.changefeed_queue_size() / 2) {
@@ -1901,6 +2146,7 @@ public:
                 bool _include_types)
     // There will never be any changes, safe to start squashing right away.
     : flat_sub_t(init_squashing_queue_t::YES,
+                 false,
                  _rdb_context,
                  _user_context,
                  _feed,
@@ -1982,9 +2228,11 @@ public:
                 const datum_t &_squash,
                 bool _include_states,
                 bool _include_types,
+                bool _spill_to_disk,
                 datum_t _pkey)
         // For point changefeeds we start squashing right away.
         : flat_sub_t(init_squashing_queue_t::YES,
+                     _spill_to_disk,
                      _rdb_context,
                      _user_context,
                      _feed,
@@ -2170,11 +2418,13 @@ public:
                 const datum_t &_squash,
                 bool _include_states,
                 bool _include_types,
+                bool _spill_to_disk,
                 env_t *outer_env,
                 keyspec_t::range_t _spec)
         // We don't turn on squashing until later for range subs.  (We need to
         // wait until we've purged and all the initial values are reconciled.)
         : flat_sub_t(init_squashing_queue_t::NO,
+                     _spill_to_disk,
                      _rdb_context,
                      _user_context,
                      _feed,
@@ -3779,6 +4029,7 @@ scoped_ptr_t<subscription_t> new_sub(
                 ss->squash,
                 ss->include_states,
                 ss->include_types,
+                ss->spill_to_disk,
                 env,
                 range);
         }
@@ -3817,6 +4068,7 @@ scoped_ptr_t<subscription_t> new_sub(
                 ss->squash,
                 ss->include_states,
                 ss->include_types,
+                ss->spill_to_disk,
                 point.key);
         }
         env_t *env;
@@ -3832,6 +4084,7 @@ streamspec_t::streamspec_t(counted_t<datum_stream_t> _maybe_src,
                            bool _include_offsets,
                            bool _include_states,
                            bool _include_types,
+                           bool _spill_to_disk,
                            configured_limits_t _limits,
                            datum_t _squash,
                            keyspec_t::spec_t _spec) :
@@ -3840,6 +4093,7 @@ streamspec_t::streamspec_t(counted_t<datum_stream_t> _maybe_src,
     include_offsets(std::move(_include_offsets)),
     include_states(std::move(_include_states)),
     include_types(std::move(_include_types)),
+    spill_to_disk(_spill_to_disk),
     limits(std::move(_limits)),
     squash(std::move(_squash)),
     spec(std::move(_spec)) { }
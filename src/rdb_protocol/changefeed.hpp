@@ -183,6 +183,9 @@ struct streamspec_t {
     bool include_offsets;
     bool include_states;
     bool include_types;
+    // Whether to spill queued changes to disk instead of dropping them when
+    // the consumer falls behind.
+    bool spill_to_disk;
     configured_limits_t limits;
     datum_t squash;
     keyspec_t::spec_t spec;
@@ -191,6 +194,7 @@ struct streamspec_t {
                  bool _include_offsets,
                  bool _include_states,
                  bool _include_types,
+                 bool _spill_to_disk,
                  configured_limits_t _limits,
                  datum_t _squash,
                  keyspec_t::spec_t _spec);
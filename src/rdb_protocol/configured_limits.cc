@@ -3,41 +3,46 @@
 
 #include <limits>
 #include "rdb_protocol/func.hpp"
+#include "rdb_protocol/memory_tracker.hpp"
 #include "rdb_protocol/pseudo_time.hpp"
 #include "rdb_protocol/wire_func.hpp"
 
 namespace ql {
 
+// Fake an environment with no arguments.  We have to fake it because of a
+// chicken/egg problem; these functions get called before there are any extant
+// environments at all.  Only because we use an empty argument list do we prevent an
+// infinite loop.
+// TODO: there's a `env_t(interruptor, reql_version)` constructor,
+// should this be using that?
+static scoped_ptr_t<env_t> make_optarg_env(rdb_context_t *ctx, signal_t *interruptor) {
+    return make_scoped<env_t>(
+        ctx,
+        return_empty_normal_batches_t::NO,
+        interruptor,
+        serializable_env_t{
+            global_optargs_t(),
+            auth::user_context_t(auth::permissions_t(tribool::False, tribool::False, tribool::False, tribool::False)),
+            datum_t()},
+        nullptr);
+}
+
 configured_limits_t from_optargs(
     rdb_context_t *ctx, signal_t *interruptor, global_optargs_t *args) {
     size_t changefeed_queue_size = configured_limits_t::default_changefeed_queue_size;
     size_t array_size_limit = configured_limits_t::default_array_size_limit;
-    // Fake an environment with no arguments.  We have to fake it
-    // because of a chicken/egg problem; this function gets called
-    // before there are any extant environments at all.  Only
-    // because we use an empty argument list do we prevent an
-    // infinite loop.
-    // TODO: there's a `env_t(interruptor, reql_version)` constructor,
-    // should this be using that?
     if (args != nullptr) {
         bool has_changefeed_queue_size = args->has_optarg("changefeed_queue_size");
         bool has_array_limit = args->has_optarg("array_limit");
         if (has_changefeed_queue_size || has_array_limit) {
-            env_t env(
-                ctx,
-                return_empty_normal_batches_t::NO,
-                interruptor,
-                serializable_env_t{
-                    global_optargs_t(),
-                    auth::user_context_t(auth::permissions_t(tribool::False, tribool::False, tribool::False, tribool::False)),
-                    datum_t()},
-                nullptr);
+            scoped_ptr_t<env_t> env = make_optarg_env(ctx, interruptor);
             if (has_changefeed_queue_size) {
-                int64_t sz = args->get_optarg(&env, "changefeed_queue_size")->as_int();
+                int64_t sz =
+                    args->get_optarg(env.get(), "changefeed_queue_size")->as_int();
                 changefeed_queue_size = check_limit("changefeed queue size", sz);
             }
             if (has_array_limit) {
-                int64_t limit = args->get_optarg(&env, "array_limit")->as_int();
+                int64_t limit = args->get_optarg(env.get(), "array_limit")->as_int();
                 array_size_limit = check_limit("array size limit", limit);
             }
         }
@@ -45,6 +50,16 @@ configured_limits_t from_optargs(
     return configured_limits_t(changefeed_queue_size, array_size_limit);
 }
 
+uint64_t memory_limit_from_optargs(
+    rdb_context_t *ctx, signal_t *interruptor, global_optargs_t *args) {
+    if (args != nullptr && args->has_optarg("memory_limit")) {
+        scoped_ptr_t<env_t> env = make_optarg_env(ctx, interruptor);
+        int64_t limit = args->get_optarg(env.get(), "memory_limit")->as_int();
+        return check_limit("memory limit", limit);
+    }
+    return ctx != nullptr ? ctx->query_memory_limit : memory_tracker_t::unlimited;
+}
+
 size_t check_limit(const char *name, int64_t limit) {
     rcheck_datum(
         limit >= 1, base_exc_t::LOGIC,
@@ -1,6 +1,8 @@
 #ifndef RDB_PROTOCOL_CONFIGURED_LIMITS_HPP_
 #define RDB_PROTOCOL_CONFIGURED_LIMITS_HPP_
 
+#include <stdint.h>
+
 #include <map>
 #include <string>
 #include "rpc/serialize_macros.hpp"
@@ -36,6 +38,10 @@ private:
 
 configured_limits_t from_optargs(rdb_context_t *ctx, signal_t *interruptor,
                                  global_optargs_t *optargs);
+// The memory budget of a query, from the `memory_limit` optarg or else the server's
+// default (see `memory_tracker_t`).
+uint64_t memory_limit_from_optargs(rdb_context_t *ctx, signal_t *interruptor,
+                                   global_optargs_t *optargs);
 size_t check_limit(const char *name, int64_t limit);
 
 } // namespace ql
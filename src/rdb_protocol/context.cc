@@ -5,6 +5,7 @@
 #include "concurrency/cross_thread_watchable.hpp"
 #include "rdb_protocol/query_cache.hpp"
 #include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/memory_tracker.hpp"
 #include "rpc/semilattice/view/field.hpp"
 #include "rpc/semilattice/watchable.hpp"
 #include "time.hpp"
@@ -72,13 +73,17 @@ rdb_context_t::stats_t::stats_t(perfmon_collection_t *global_stats)
       queries_per_sec_membership(&qe_stats_collection,
                                  &queries_per_sec, "queries_per_sec"),
       queries_total_membership(&qe_stats_collection,
-                               &queries_total, "queries_total") { }
+                               &queries_total, "queries_total"),
+      connections_membership(&qe_stats_collection,
+                             &connections_collection, "connections") { }
 
 rdb_context_t::rdb_context_t()
     : extproc_pool(nullptr),
       cluster_interface(nullptr),
       manager(nullptr),
       reql_http_proxy(),
+      query_memory_limit(ql::memory_tracker_t::unlimited),
+      io_backender(nullptr),
       stats(&get_global_perfmon_collection()) { }
 
 rdb_context_t::rdb_context_t(
@@ -90,6 +95,8 @@ rdb_context_t::rdb_context_t(
       cluster_interface(_cluster_interface),
       manager(nullptr),
       reql_http_proxy(),
+      query_memory_limit(ql::memory_tracker_t::unlimited),
+      io_backender(nullptr),
       stats(&get_global_perfmon_collection()) {
     init_auth_watchables(auth_semilattice_view);
 }
@@ -101,11 +108,17 @@ rdb_context_t::rdb_context_t(
         std::shared_ptr<semilattice_read_view_t<auth_semilattice_metadata_t>>
             auth_semilattice_view,
         perfmon_collection_t *global_stats,
-        const std::string &_reql_http_proxy)
+        const std::string &_reql_http_proxy,
+        uint64_t _query_memory_limit,
+        io_backender_t *_io_backender,
+        const base_path_t &_base_path)
     : extproc_pool(_extproc_pool),
       cluster_interface(_cluster_interface),
       manager(_mailbox_manager),
       reql_http_proxy(_reql_http_proxy),
+      query_memory_limit(_query_memory_limit),
+      io_backender(_io_backender),
+      base_path(_base_path),
       stats(global_stats) {
     init_auth_watchables(auth_semilattice_view);
 }
@@ -15,6 +15,7 @@
 #include "containers/optional.hpp"
 #include "containers/scoped.hpp"
 #include "containers/uuid.hpp"
+#include "paths.hpp"
 #include "perfmon/perfmon.hpp"
 #include "protocol_api.hpp"
 #include "rdb_protocol/changefeed.hpp"
@@ -142,6 +143,11 @@ public:
     name_string_t primary_replica_tag;
 };
 
+/* `rebalance_mode_t` says what `table.rebalance()` should even out between the shards:
+the number of documents, or the recent reads and writes. In the latter case it also
+moves the primary replicas around to even out the load between the servers. */
+enum class rebalance_mode_t { SIZE, LOAD };
+
 enum class admin_identifier_format_t {
     /* Some parts of the code rely on the fact that `admin_identifier_format_t` can be
     mapped to `{0, 1}` using `static_cast`. */
@@ -158,6 +164,10 @@ public:
     virtual namespace_id_t get_id() const = 0;
     virtual const std::string &get_pkey() const = 0;
 
+    /* Sets the staleness bound for the reads with `read_mode_t::BOUNDED` that go through
+    this table object. Artificial tables ignore it, since they don't have replicas. */
+    virtual void set_max_staleness_ms(int64_t) { }
+
     virtual scoped_ptr_t<ql::reader_t> read_all_with_sindexes(
         ql::env_t *,
         const std::string &,
@@ -275,6 +285,7 @@ public:
             const table_generate_config_params_t &config_params,
             const std::string &primary_key,
             write_durability_t durability,
+            size_t num_cpu_shards,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out) = 0;
@@ -361,12 +372,14 @@ public:
             auth::user_context_t const &user_context,
             counted_t<const ql::db_t> db,
             const name_string_t &name,
+            rebalance_mode_t mode,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out) = 0;
     virtual bool db_rebalance(
             auth::user_context_t const &user_context,
             counted_t<const ql::db_t> db,
+            rebalance_mode_t mode,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out) = 0;
@@ -448,6 +461,7 @@ protected:
     virtual ~reql_cluster_interface_t() { }   // silence compiler warnings
 };
 
+class io_backender_t;
 class mailbox_manager_t;
 
 class rdb_context_t {
@@ -468,7 +482,10 @@ public:
         std::shared_ptr<semilattice_read_view_t<auth_semilattice_metadata_t>>
             auth_semilattice_view,
         perfmon_collection_t *global_stats,
-        const std::string &_reql_http_proxy);
+        const std::string &_reql_http_proxy,
+        uint64_t _query_memory_limit,
+        io_backender_t *_io_backender,
+        const base_path_t &_base_path);
 
     ~rdb_context_t();
 
@@ -479,6 +496,15 @@ public:
 
     const std::string reql_http_proxy;
 
+    // The memory budget of queries that don't set the `memory_limit` optarg.
+    const uint64_t query_memory_limit;
+
+    // Used by changefeeds that spill their queue to disk.  `io_backender` is
+    // `nullptr` on proxies and in unit tests, in which case changefeed queues
+    // are always kept in memory.
+    io_backender_t *io_backender;
+    const base_path_t base_path;
+
     class stats_t {
     public:
         explicit stats_t(perfmon_collection_t *global_stats);
@@ -493,6 +519,9 @@ public:
         perfmon_membership_t queries_per_sec_membership;
         perfmon_counter_t queries_total;
         perfmon_membership_t queries_total_membership;
+        // Every client connection adds its own collection to this one.
+        perfmon_collection_t connections_collection;
+        perfmon_membership_t connections_membership;
     private:
         DISABLE_COPYING(stats_t);
     } stats;
@@ -17,6 +17,7 @@
 #include "arch/runtime/coroutines.hpp"
 #include "cjson/json.hpp"
 #include "containers/archive/stl_types.hpp"
+#include "containers/chunked_string_buffer.hpp"
 #include "containers/scoped.hpp"
 #include "rapidjson/prettywriter.h"
 #include "rapidjson/rapidjson.h"
@@ -1574,6 +1575,8 @@ template void datum_t::write_json(
     rapidjson::Writer<rapidjson::StringBuffer> *writer) const;
 template void datum_t::write_json(
     rapidjson::PrettyWriter<rapidjson::StringBuffer> *writer) const;
+template void datum_t::write_json(
+    rapidjson::Writer<chunked_string_buffer_t> *writer) const;
 
 rapidjson::Value datum_t::as_json(rapidjson::Value::AllocatorType *allocator) const {
     switch (get_type()) {
@@ -2043,10 +2046,15 @@ datum_t stats_merge(UNUSED const datum_string_t &key,
     return l;
 }
 
-datum_object_builder_t::datum_object_builder_t(const datum_t &copy_from) {
+datum_object_builder_t::datum_object_builder_t()
+    : map(std::less<datum_string_t>(), map_t::allocator_type(&arena)) { }
+
+datum_object_builder_t::datum_object_builder_t(const datum_t &copy_from)
+    : map(std::less<datum_string_t>(), map_t::allocator_type(&arena)) {
     const size_t copy_from_sz = copy_from.obj_size();
     for (size_t i = 0; i < copy_from_sz; ++i) {
-        map.insert(copy_from.get_pair(i));
+        // The pairs are sorted already, so each one goes right at the end.
+        map.insert(map.end(), copy_from.get_pair(i));
     }
 }
 
@@ -2159,13 +2167,23 @@ datum_t datum_object_builder_t::try_get(const datum_string_t &key) const {
     return it == map.end() ? datum_t() : it->second;
 }
 
+std::vector<std::pair<datum_string_t, datum_t> >
+datum_object_builder_t::to_sorted_vec() RVALUE_THIS {
+    std::vector<std::pair<datum_string_t, datum_t> > sorted_vec;
+    sorted_vec.reserve(map.size());
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        sorted_vec.push_back(std::make_pair(it->first, std::move(it->second)));
+    }
+    return sorted_vec;
+}
+
 datum_t datum_object_builder_t::to_datum() RVALUE_THIS {
-    return datum_t(std::move(map));
+    return datum_t(std::move(*this).to_sorted_vec());
 }
 
 datum_t datum_object_builder_t::to_datum(
         const std::set<std::string> &permissible_ptypes) RVALUE_THIS {
-    return datum_t(std::move(map), permissible_ptypes);
+    return datum_t(std::move(*this).to_sorted_vec(), permissible_ptypes);
 }
 
 datum_array_builder_t::datum_array_builder_t(const datum_t &copy_from,
@@ -13,6 +13,7 @@
 
 #include "cjson/json.hpp"
 #include "containers/archive/archive.hpp"
+#include "containers/arena.hpp"
 #include "containers/counted.hpp"
 #include "containers/optional.hpp"
 #include "rdb_protocol/datum_string.hpp"
@@ -485,7 +486,7 @@ int64_t checked_convert_to_int(const rcheckable_t *target, double d);
 // Useful for building an object datum and doing mutation operations
 class datum_object_builder_t {
 public:
-    datum_object_builder_t() { }
+    datum_object_builder_t();
     explicit datum_object_builder_t(const datum_t &copy_from);
 
     bool empty() const {
@@ -518,7 +519,16 @@ public:
             const std::set<std::string> &permissible_ptypes) RVALUE_THIS;
 
 private:
-    std::map<datum_string_t, datum_t> map;
+    // The map's nodes only live as long as the builder, so they come from an arena
+    // rather than each getting allocated on its own.  `to_datum()` copies the fields
+    // out into the object's own storage.
+    typedef std::map<datum_string_t, datum_t, std::less<datum_string_t>,
+                     arena_allocator_t<std::pair<const datum_string_t, datum_t> > >
+        map_t;
+    std::vector<std::pair<datum_string_t, datum_t> > to_sorted_vec() RVALUE_THIS;
+
+    arena_t arena;
+    map_t map;
     DISABLE_COPYING(datum_object_builder_t);
 };
 
@@ -45,6 +45,7 @@ read_mode_t up_to_date_read_mode(read_mode_t in) {
     case read_mode_t::MAJORITY: return in;
     case read_mode_t::SINGLE:   return in;
     case read_mode_t::OUTDATED: return read_mode_t::SINGLE;
+    case read_mode_t::BOUNDED:  return read_mode_t::SINGLE;
     case read_mode_t::DEBUG_DIRECT:
         rfail_datum(base_exc_t::LOGIC,
                     "DEBUG_DIRECT is not a legal read mode for this operation "
@@ -396,7 +397,11 @@ raw_stream_t rget_response_reader_t::unshard(
     // hypothetical `rget_item_t`s from the shards.  We also mark shards
     // exhausted in this step.
     std::vector<pseudoshard_t> pseudoshards;
-    pseudoshards.reserve(active_ranges->ranges.size() * CPU_SHARDING_FACTOR);
+    size_t num_hash_ranges = 0;
+    for (auto &&pair : active_ranges->ranges) {
+        num_hash_ranges += pair.second.hash_ranges.size();
+    }
+    pseudoshards.reserve(num_hash_ranges);
     size_t n_active = 0, n_fresh = 0;
     for (auto &&pair : active_ranges->ranges) {
         bool range_active = pair.second.state() == range_state_t::ACTIVE;
@@ -1352,7 +1357,7 @@ scoped_ptr_t<val_t> datum_stream_t::run_terminal(
 }
 
 scoped_ptr_t<val_t> datum_stream_t::to_array(env_t *env) {
-    scoped_ptr_t<eager_acc_t> acc = make_to_array();
+    scoped_ptr_t<eager_acc_t> acc = make_to_array(env);
     accumulate_all(env, acc.get());
     return acc->finish_eager(backtrace(), is_grouped(), env->limits());
 }
@@ -2339,6 +2344,7 @@ std::vector<datum_t> eq_join_datum_stream_t::next_raw_batch(
             // Basically do a get all on the new keys
             // but we get the reader directly so we can read the sindex from the lookup.
             sindex_to_datum.clear();
+            sindex_to_datum_charge = memory_charge_t(env->memory_tracker());
             std::map<datum_t, uint64_t> keys;
             for (size_t i = 0; i < stream_batch.size(); ++i) {
                 datum_t key_val;
@@ -2355,6 +2361,8 @@ std::vector<datum_t> eq_join_datum_stream_t::next_raw_batch(
                 }
                 // Build a multimap from sindex value to datums from left side stream.
                 if (key_val.get_type() != datum_t::type_t::R_NULL) {
+                    sindex_to_datum_charge.add(key_val);
+                    sindex_to_datum_charge.add(stream_batch[i]);
                     sindex_to_datum.insert(std::pair<datum_t, datum_t>{
                             key_val, stream_batch[i]});
                     keys[key_val] = 1;
@@ -2,6 +2,7 @@
 #define RDB_PROTOCOL_DATUM_STREAM_EQ_JOIN_HPP_
 
 #include "rdb_protocol/datum_stream.hpp"
+#include "rdb_protocol/memory_tracker.hpp"
 
 namespace ql {
 
@@ -39,6 +40,7 @@ private:
 
     std::multimap<ql::datum_t,
                   ql::datum_t> sindex_to_datum;
+    memory_charge_t sindex_to_datum_charge;
 
     counted_t<const func_t> predicate;
 
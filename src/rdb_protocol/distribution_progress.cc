@@ -1,6 +1,8 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/distribution_progress.hpp"
 
+#include <iterator>
+
 #include "rdb_protocol/protocol.hpp"
 #include "store_view.hpp"
 
@@ -50,6 +52,32 @@ double distribution_progress_estimator_t::estimate_progress(
     }
 }
 
+std::vector<store_key_t> distribution_progress_estimator_t::split_range(
+        const key_range_t &range, size_t num_parts) const {
+    std::vector<store_key_t> split_points;
+    auto begin = distribution_counts.upper_bound(range.left);
+    auto end = range.right.unbounded
+        ? distribution_counts.end()
+        : distribution_counts.lower_bound(range.right.key());
+    if (num_parts < 2 || begin == end) {
+        return split_points;
+    }
+    /* The counts are partial sums, so the number of keys between two entries is the
+    difference of their counts. */
+    int64_t first = begin->second;
+    int64_t last = std::prev(end)->second;
+    size_t part = 1;
+    for (auto it = begin; it != end && part < num_parts; ++it) {
+        int64_t target = first + (last - first) * static_cast<int64_t>(part)
+            / static_cast<int64_t>(num_parts);
+        if (it->second >= target && it->second > first) {
+            split_points.push_back(it->first);
+            ++part;
+        }
+    }
+    return split_points;
+}
+
 RDB_IMPL_SERIALIZABLE_2(distribution_progress_estimator_t,
     distribution_counts, distribution_counts_sum);
 INSTANTIATE_SERIALIZABLE_FOR_CLUSTER(distribution_progress_estimator_t);
@@ -72,6 +72,9 @@ env_t::env_t(rdb_context_t *ctx,
       limits_(from_optargs(ctx, _interruptor, &serializable.global_optargs)),
       reql_version_(reql_version_t::LATEST),
       regex_cache_(LRU_CACHE_SIZE),
+      memory_tracker_(make_counted<memory_tracker_t>(
+          memory_limit_from_optargs(ctx, _interruptor, &serializable.global_optargs))),
+      term_parameters_(nullptr),
       return_empty_normal_batches(_return_empty_normal_batches),
       interruptor(_interruptor),
       trace(_trace),
@@ -108,6 +111,8 @@ env_t::env_t(signal_t *_interruptor,
         datum_t()},
       reql_version_(_reql_version),
       regex_cache_(LRU_CACHE_SIZE),
+      memory_tracker_(make_counted<memory_tracker_t>(memory_tracker_t::unlimited)),
+      term_parameters_(nullptr),
       return_empty_normal_batches(_return_empty_normal_batches),
       interruptor(_interruptor),
       trace(NULL),
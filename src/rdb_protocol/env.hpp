@@ -17,6 +17,7 @@
 #include "rdb_protocol/context.hpp"
 #include "rdb_protocol/datum_stream.hpp"
 #include "rdb_protocol/error.hpp"
+#include "rdb_protocol/memory_tracker.hpp"
 #include "rdb_protocol/optargs.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rdb_protocol/val.hpp"
@@ -128,8 +129,30 @@ public:
 
     regex_cache_t &regex_cache() { return regex_cache_; }
 
+    // The memory that big in-memory structures of the query hold gets charged to this.
+    const counted_t<memory_tracker_t> &memory_tracker() const {
+        return memory_tracker_;
+    }
+    // Used to keep charging the same tracker when a query spans several `env_t`s, as
+    // queries that return a stream do.
+    void set_memory_tracker(counted_t<memory_tracker_t> tracker) {
+        r_sanity_check(tracker.has());
+        memory_tracker_ = std::move(tracker);
+    }
+
     reql_version_t reql_version() const { return reql_version_; }
 
+    // The values of the parameters of a prepared query (see `prepared_query.hpp`).
+    // The vector must outlive the evaluation of the query.
+    void set_term_parameters(const std::vector<datum_t> *parameters) {
+        term_parameters_ = parameters;
+    }
+    const datum_t &get_term_parameter(size_t index) const {
+        r_sanity_check(term_parameters_ != nullptr);
+        r_sanity_check(index < term_parameters_->size());
+        return (*term_parameters_)[index];
+    }
+
 private:
     serializable_env_t serializable;
 
@@ -144,6 +167,10 @@ private:
     // query specific cache parameters; for example match regexes.
     regex_cache_t regex_cache_;
 
+    counted_t<memory_tracker_t> memory_tracker_;
+
+    const std::vector<datum_t> *term_parameters_;
+
 public:
     const return_empty_normal_batches_t return_empty_normal_batches;
 
@@ -174,9 +201,13 @@ private:
 // evaluate anything, it doesn't need an env_t *.
 class compile_env_t {
 public:
-    explicit compile_env_t(var_visibility_t &&_visibility)
-        : visibility(std::move(_visibility)) { }
+    explicit compile_env_t(var_visibility_t &&_visibility,
+                           const std::map<uint32_t, size_t> *_parameter_slots = nullptr)
+        : visibility(std::move(_visibility)), parameter_slots(_parameter_slots) { }
     var_visibility_t visibility;
+    // Maps the backtrace ids of `DATUM` terms that are parameters of a prepared
+    // query to the parameters' indexes.  Only set for the query's root scope.
+    const std::map<uint32_t, size_t> *const parameter_slots;
 };
 
 // This is an environment for evaluating things that use variables in scope.  It
@@ -2,6 +2,7 @@
 #include "rdb_protocol/erase_range.hpp"
 
 #include "buffer_cache/alt.hpp"
+#include "btree/internal_node.hpp"
 #include "btree/leaf_node.hpp"
 #include "btree/node.hpp"
 #include "btree/operations.hpp"
@@ -180,3 +181,175 @@ continue_bool_t rdb_erase_small_range(
         ? continue_bool_t::CONTINUE : continue_bool_t::ABORT;
 }
 
+
+continue_bool_t rdb_discard_small_subtree(
+        value_sizer_t *sizer,
+        const key_range_t &keys,
+        superblock_t *superblock,
+        const value_deleter_t *value_deleter,
+        key_range_t *deleted_out) {
+    rassert(deleted_out != nullptr);
+    guarantee(keys == key_range_t::universe(),
+              "rdb_discard_small_subtree() can only discard the whole btree");
+    *deleted_out = key_range_t::empty();
+
+    const block_id_t root_id = superblock->get_root_block_id();
+    if (root_id == NULL_BLOCK_ID) {
+        *deleted_out = keys;
+        return continue_bool_t::ABORT;
+    }
+
+    /* Step 1: Walk down the left edge of the tree until we reach the lowest internal
+    node. `path` holds the internal nodes above it, starting with the root. None of
+    the leaves below `bottom` contain keys at or beyond `right_bound`. */
+    std::vector<buf_lock_t> path;
+    key_range_t::right_bound_t right_bound = keys.right;
+    buf_lock_t bottom(superblock->expose_buf(), root_id, access_t::write);
+    std::vector<buf_lock_t> leaves;
+    for (;;) {
+        std::vector<block_id_t> children;
+        store_key_t first_key;
+        {
+            buf_read_t read(&bottom);
+            const node_t *node = static_cast<const node_t *>(read.get_data_read());
+            if (!node::is_leaf(node)) {
+                const internal_node_t *internal =
+                    reinterpret_cast<const internal_node_t *>(node);
+                for (int i = 0; i < internal->npairs; ++i) {
+                    children.push_back(
+                        internal_node::get_pair_by_index(internal, i)->lnode);
+                }
+                first_key = store_key_t(
+                    &internal_node::get_pair_by_index(internal, 0)->key);
+            }
+        }
+        if (children.empty()) {
+            // This only happens if the root is a leaf.
+            leaves.push_back(std::move(bottom));
+            break;
+        }
+
+        buf_lock_t first_child(&bottom, children[0], access_t::write);
+        bool first_child_is_leaf;
+        {
+            buf_read_t read(&first_child);
+            first_child_is_leaf = node::is_leaf(
+                static_cast<const node_t *>(read.get_data_read()));
+        }
+        if (first_child_is_leaf) {
+            /* Acquire all the leaves up front, so that they get loaded in parallel. */
+            leaves.push_back(std::move(first_child));
+            for (size_t i = 1; i < children.size(); ++i) {
+                leaves.push_back(buf_lock_t(&bottom, children[i], access_t::write));
+            }
+            break;
+        }
+
+        /* The last pair's key is special and doesn't bound anything. */
+        if (children.size() > 1) {
+            key_range_t::right_bound_t child_bound(first_key);
+            child_bound.increment();
+            if (child_bound < right_bound) {
+                right_bound = child_bound;
+            }
+        }
+        path.push_back(std::move(bottom));
+        bottom = std::move(first_child);
+    }
+
+    /* Step 2: Delete the values and the leaf nodes. */
+    int64_t population_change = 0;
+    for (auto &&leaf_lock : leaves) {
+        {
+            buf_read_t read(&leaf_lock);
+            const leaf_node_t *leaf =
+                static_cast<const leaf_node_t *>(read.get_data_read());
+            for (auto it = leaf::begin(*leaf); it != leaf::end(*leaf); ++it) {
+                value_deleter->delete_value(buf_parent_t(&leaf_lock), (*it).second);
+                --population_change;
+            }
+        }
+        leaf_lock.write_acq_signal()->wait_lazily_unordered();
+        leaf_lock.mark_deleted();
+        leaf_lock.reset_buf_lock();
+    }
+
+    /* Step 3: Delete `bottom`, and every node above it that has no children left.
+    The first ancestor that still has other children just loses its first pair. */
+    bool tree_is_empty = true;
+    if (!bottom.empty()) {
+        bottom.write_acq_signal()->wait_lazily_unordered();
+        bottom.mark_deleted();
+        bottom.reset_buf_lock();
+        while (!path.empty()) {
+            {
+                buf_write_t write(&path.back());
+                internal_node_t *node =
+                    static_cast<internal_node_t *>(write.get_data_write());
+                if (node->npairs > 1) {
+                    store_key_t first_key(
+                        &internal_node::get_pair_by_index(node, 0)->key);
+                    internal_node::remove(sizer->block_size(), node,
+                                          first_key.btree_key());
+                    tree_is_empty = false;
+                    break;
+                }
+            }
+            path.back().write_acq_signal()->wait_lazily_unordered();
+            path.back().mark_deleted();
+            path.pop_back();
+        }
+    }
+
+    if (tree_is_empty) {
+        superblock->set_root_block_id(NULL_BLOCK_ID);
+    } else {
+        /* Step 4: Don't leave a root with only a single child behind, since the
+        rebalancing code can't handle that. Replace it with its child instead. */
+        buf_lock_t root = std::move(path.front());
+        path.clear();
+        for (;;) {
+            block_id_t only_child;
+            {
+                buf_read_t read(&root);
+                const node_t *node = static_cast<const node_t *>(read.get_data_read());
+                if (node::is_leaf(node)) {
+                    break;
+                }
+                const internal_node_t *internal =
+                    reinterpret_cast<const internal_node_t *>(node);
+                if (internal->npairs != 1) {
+                    break;
+                }
+                only_child = internal_node::get_pair_by_index(internal, 0)->lnode;
+            }
+            buf_lock_t child(&root, only_child, access_t::write);
+            root.detach_child(only_child);
+            root.write_acq_signal()->wait_lazily_unordered();
+            root.mark_deleted();
+            insert_root(only_child, superblock);
+            root = std::move(child);
+        }
+    }
+
+    if (superblock->get_stat_block_id() != NULL_BLOCK_ID && population_change != 0) {
+        buf_lock_t stat_block(buf_parent_t(superblock->expose_buf().txn()),
+                              superblock->get_stat_block_id(), access_t::write);
+        buf_write_t stat_block_write(&stat_block);
+        auto stat_block_buf = static_cast<btree_statblock_t *>(
+                stat_block_write.get_data_write(BTREE_STATBLOCK_SIZE));
+        stat_block_buf->population += population_change;
+    }
+
+    if (tree_is_empty) {
+        *deleted_out = keys;
+        return continue_bool_t::ABORT;
+    } else {
+        guarantee(!right_bound.unbounded);
+        if (key_range_t::right_bound_t(keys.left) < right_bound) {
+            deleted_out->left = keys.left;
+            deleted_out->right = right_bound;
+        }
+        return continue_bool_t::CONTINUE;
+    }
+}
@@ -15,6 +15,8 @@ class deletion_context_t;
 struct rdb_modification_report_t;
 class superblock_t;
 class signal_t;
+class value_deleter_t;
+class value_sizer_t;
 
 class key_tester_t {
 public:
@@ -55,4 +57,25 @@ continue_bool_t rdb_erase_small_range(
     std::vector<rdb_modification_report_t> *mod_reports_out,
     key_range_t *deleted_out);
 
+/* `rdb_discard_small_subtree` frees the leftmost leaf nodes of the btree all at once,
+without looking up or rebalancing for the individual keys. Each call deletes the leaves
+below the lowest internal node on the left edge of the tree (or the root, if it's a
+leaf), and then any internal nodes that end up without children. Its complexity is
+O(log n + k) where k is the number of blocks being freed, and it doesn't generate any
+modification reports.
+
+The btree stays valid between calls, but it isn't rebalanced, so this is only meant
+for discarding a whole btree in a series of transactions. `keys` must be
+`key_range_t::universe()`; the leaves are freed no matter which keys they hold.
+`value_deleter` is called on every value, with the leaf node as the parent.
+
+Sets `*deleted_out` to the part of `keys` that is known to be empty now. Returns
+`CONTINUE` if some of the btree is left and `ABORT` once it's empty. */
+continue_bool_t rdb_discard_small_subtree(
+    value_sizer_t *sizer,
+    const key_range_t &keys,
+    superblock_t *superblock,
+    const value_deleter_t *value_deleter,
+    key_range_t *deleted_out);
+
 #endif  // RDB_PROTOCOL_ERASE_RANGE_HPP_
@@ -0,0 +1,159 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/key_load_sampler.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "containers/scoped.hpp"
+#include "rdb_protocol/datum.hpp"
+
+/* The counts are only decayed once this much time has passed, so that we don't have to
+walk over all buckets on every operation. */
+static const microtime_t key_load_decay_interval = 1000 * 1000;
+
+/* Buckets whose decayed count drops below this are removed. */
+static const double key_load_min_count = 0.001;
+
+key_load_sampler_t::key_load_sampler_t() :
+    start_time(current_microtime()),
+    last_decay(start_time) { }
+
+void key_load_sampler_t::record_read(const store_key_t &key) {
+    assert_thread();
+    record(key, 1, 0);
+}
+
+void key_load_sampler_t::record_write(const store_key_t &key) {
+    assert_thread();
+    record(key, 0, 1);
+}
+
+std::map<store_key_t, key_load_sampler_t::rates_t> key_load_sampler_t::get_rates(
+        const key_range_t &range) {
+    return get_rates(range, current_microtime());
+}
+
+std::map<store_key_t, key_load_sampler_t::rates_t> key_load_sampler_t::get_rates(
+        const key_range_t &range, microtime_t now) {
+    assert_thread();
+    decay(now);
+
+    /* With exponential decay, a steady rate of one operation per second adds up to a
+    count of `half_life / ln(2)`. Before the sampler has been running for a while, the
+    count is lower than that, so we correct for the time it has been running. */
+    double age_secs = (now - start_time) / 1e6;
+    double window_secs = (KEY_LOAD_HALF_LIFE_SECS / M_LN2)
+        * (1 - exp2(-age_secs / KEY_LOAD_HALF_LIFE_SECS));
+    window_secs = std::max(window_secs, 1.0);
+
+    std::map<store_key_t, rates_t> rates;
+    for (const auto &pair : buckets) {
+        if (range.contains_key(pair.first)) {
+            rates_t r;
+            r.reads_per_sec = pair.second.reads / window_secs;
+            r.writes_per_sec = pair.second.writes / window_secs;
+            rates.insert(rates.end(), std::make_pair(pair.first, r));
+        }
+    }
+    return rates;
+}
+
+class key_load_stats_t {
+public:
+    std::vector<std::pair<store_key_t, key_load_sampler_t::rates_t> > hottest;
+};
+
+void *key_load_sampler_t::begin_stats() {
+    return new key_load_stats_t;
+}
+
+void key_load_sampler_t::visit_stats(void *ctx) {
+    if (get_thread_id() != home_thread()) {
+        return;
+    }
+    key_load_stats_t *stats = static_cast<key_load_stats_t *>(ctx);
+    std::map<store_key_t, rates_t> rates = get_rates(key_range_t::universe());
+    stats->hottest.assign(rates.begin(), rates.end());
+    auto load = [](const std::pair<store_key_t, rates_t> &p) {
+        return p.second.reads_per_sec + p.second.writes_per_sec;
+    };
+    std::sort(stats->hottest.begin(), stats->hottest.end(),
+        [&](const std::pair<store_key_t, rates_t> &a,
+                const std::pair<store_key_t, rates_t> &b) {
+            return load(a) > load(b);
+        });
+    if (stats->hottest.size() > KEY_LOAD_REPORTED_BUCKETS) {
+        stats->hottest.resize(KEY_LOAD_REPORTED_BUCKETS);
+    }
+}
+
+ql::datum_t key_load_sampler_t::end_stats(void *ctx) {
+    scoped_ptr_t<key_load_stats_t> stats(static_cast<key_load_stats_t *>(ctx));
+    ql::datum_array_builder_t builder(ql::configured_limits_t::unlimited);
+    for (const auto &pair : stats->hottest) {
+        ql::datum_object_builder_t bucket;
+        bucket.overwrite("left_key", ql::datum_t(
+            datum_string_t(key_to_debug_str(pair.first))));
+        bucket.overwrite("reads_per_sec", ql::datum_t(pair.second.reads_per_sec));
+        bucket.overwrite("writes_per_sec", ql::datum_t(pair.second.writes_per_sec));
+        builder.add(std::move(bucket).to_datum());
+    }
+    return std::move(builder).to_datum();
+}
+
+void key_load_sampler_t::record(const store_key_t &key, double reads, double writes) {
+    decay(current_microtime());
+    counts_t *counts = &buckets[key];
+    counts->reads += reads;
+    counts->writes += writes;
+    if (buckets.size() > 2 * KEY_LOAD_MAX_BUCKETS) {
+        merge_buckets();
+    }
+}
+
+void key_load_sampler_t::decay(microtime_t now) {
+    if (now < last_decay + key_load_decay_interval) {
+        return;
+    }
+    double factor = exp2(-((now - last_decay) / 1e6) / KEY_LOAD_HALF_LIFE_SECS);
+    last_decay = now;
+    for (auto it = buckets.begin(); it != buckets.end();) {
+        it->second.reads *= factor;
+        it->second.writes *= factor;
+        if (it->second.reads + it->second.writes < key_load_min_count) {
+            /* The bucket's keys are now counted towards the previous bucket, but there
+            was hardly any load on them anyway. */
+            buckets.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void key_load_sampler_t::merge_buckets() {
+    double total = 0;
+    for (const auto &pair : buckets) {
+        total += pair.second.reads + pair.second.writes;
+    }
+    /* Every two neighbouring buckets that are left over have a combined load above
+    `target`, so there are at most about `KEY_LOAD_MAX_BUCKETS` of them. */
+    double target = 2 * total / KEY_LOAD_MAX_BUCKETS;
+    auto current = buckets.begin();
+    auto next = current;
+    ++next;
+    while (next != buckets.end()) {
+        double combined = current->second.reads + current->second.writes
+            + next->second.reads + next->second.writes;
+        if (combined <= target) {
+            current->second.reads += next->second.reads;
+            current->second.writes += next->second.writes;
+            buckets.erase(next++);
+        } else {
+            current = next;
+            ++next;
+        }
+    }
+}
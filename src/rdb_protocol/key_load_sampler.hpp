@@ -0,0 +1,82 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_KEY_LOAD_SAMPLER_HPP_
+#define RDB_PROTOCOL_KEY_LOAD_SAMPLER_HPP_
+
+#include <map>
+
+#include "btree/keys.hpp"
+#include "perfmon/core.hpp"
+#include "threading.hpp"
+#include "time.hpp"
+
+/* `key_load_sampler_t` keeps track of how many reads and writes a store serves in each
+part of its key range, so that shards can be split by load rather than by size (see
+`calculate_split_points_with_load()`).
+
+The counts are kept in buckets. A bucket covers the keys from its own key up to the key
+of the next bucket. An operation on a key that doesn't have a bucket yet creates one.
+Once there are more than twice `KEY_LOAD_MAX_BUCKETS` buckets, neighbouring buckets
+with little load are merged into each other. So a hot key keeps a bucket of its own,
+while the cold parts of the key range are only tracked coarsely.
+
+All counts decay with a half-life of `KEY_LOAD_HALF_LIFE_SECS`, so the rates reflect the
+recent load of the store. The sampler is also a perfmon that reports its hottest
+buckets. */
+
+const size_t KEY_LOAD_MAX_BUCKETS = 128;
+const double KEY_LOAD_HALF_LIFE_SECS = 60.0;
+
+/* The number of buckets that the perfmon reports. */
+const size_t KEY_LOAD_REPORTED_BUCKETS = 8;
+
+class key_load_sampler_t : public perfmon_t, public home_thread_mixin_t {
+public:
+    class rates_t {
+    public:
+        rates_t() : reads_per_sec(0), writes_per_sec(0) { }
+        double reads_per_sec;
+        double writes_per_sec;
+    };
+
+    key_load_sampler_t();
+
+    void record_read(const store_key_t &key);
+    void record_write(const store_key_t &key);
+
+    /* Returns the rates of the buckets whose keys lie in `range`. */
+    std::map<store_key_t, rates_t> get_rates(const key_range_t &range);
+
+    /* Like `get_rates()`, but as of `now` rather than the current time. `now` must not
+    be earlier than the time of any previous call. This is for the unit tests. */
+    std::map<store_key_t, rates_t> get_rates(const key_range_t &range,
+                                             microtime_t now);
+
+    /* Perfmon interface. The stats are taken when `visit_stats()` is called on the
+    home thread. */
+    void *begin_stats();
+    void visit_stats(void *ctx);
+    ql::datum_t end_stats(void *ctx);
+
+private:
+    class counts_t {
+    public:
+        counts_t() : reads(0), writes(0) { }
+        double reads;
+        double writes;
+    };
+
+    void record(const store_key_t &key, double reads, double writes);
+
+    /* Applies the decay for the time that passed between the last call and `now`. */
+    void decay(microtime_t now);
+
+    void merge_buckets();
+
+    std::map<store_key_t, counts_t> buckets;
+    microtime_t start_time;
+    microtime_t last_decay;
+
+    DISABLE_COPYING(key_load_sampler_t);
+};
+
+#endif /* RDB_PROTOCOL_KEY_LOAD_SAMPLER_HPP_ */
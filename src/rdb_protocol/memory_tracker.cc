@@ -0,0 +1,84 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/memory_tracker.hpp"
+
+#include <algorithm>
+
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/error.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
+
+namespace ql {
+
+const uint64_t memory_tracker_t::unlimited;
+
+memory_tracker_t::memory_tracker_t(uint64_t _limit)
+    : limit(_limit), usage(0), peak_usage(0) { }
+
+memory_tracker_t::~memory_tracker_t() {
+    rassert(usage == 0);
+}
+
+void memory_tracker_t::charge(uint64_t bytes) {
+    rcheck_datum(
+        bytes <= limit && usage <= limit - bytes, base_exc_t::RESOURCE,
+        strprintf("Query memory usage over limit `%" PRIu64 "` bytes.  To raise the "
+                  "limit, modify the `memory_limit` option to `.run`, or use an "
+                  "index.", limit));
+    usage += bytes;
+    peak_usage = std::max(peak_usage, usage);
+}
+
+void memory_tracker_t::release(uint64_t bytes) {
+    rassert(bytes <= usage);
+    usage -= bytes;
+}
+
+memory_charge_t::memory_charge_t() : bytes_charged(0) { }
+
+memory_charge_t::memory_charge_t(counted_t<memory_tracker_t> _tracker)
+    : tracker(std::move(_tracker)), bytes_charged(0) { }
+
+memory_charge_t::memory_charge_t(memory_charge_t &&other)
+    : tracker(std::move(other.tracker)), bytes_charged(other.bytes_charged) {
+    other.bytes_charged = 0;
+}
+
+memory_charge_t::~memory_charge_t() {
+    reset();
+}
+
+memory_charge_t &memory_charge_t::operator=(memory_charge_t &&other) {
+    reset();
+    tracker = std::move(other.tracker);
+    bytes_charged = other.bytes_charged;
+    other.bytes_charged = 0;
+    return *this;
+}
+
+void memory_charge_t::add(uint64_t bytes) {
+    if (tracker.has()) {
+        tracker->charge(bytes);
+        bytes_charged += bytes;
+    }
+}
+
+void memory_charge_t::add(const datum_t &datum) {
+    if (tracker.has()) {
+        add(estimate_memory_usage(datum));
+    }
+}
+
+void memory_charge_t::reset() {
+    if (tracker.has()) {
+        tracker->release(bytes_charged);
+    }
+    bytes_charged = 0;
+}
+
+uint64_t estimate_memory_usage(const datum_t &datum) {
+    // The serialized size is what the batching code uses too.  It's a reasonable
+    // stand-in for the in-memory size, which we don't have a cheap way to compute.
+    return sizeof(datum_t) + serialized_size<cluster_version_t::CLUSTER>(datum);
+}
+
+}  // namespace ql
@@ -0,0 +1,78 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_MEMORY_TRACKER_HPP_
+#define RDB_PROTOCOL_MEMORY_TRACKER_HPP_
+
+#include <stdint.h>
+
+#include <limits>
+
+#include "containers/counted.hpp"
+
+namespace ql {
+
+class datum_t;
+
+/* `memory_tracker_t` keeps a running estimate of how much memory a single query holds
+in its big in-memory structures (sort buffers, grouped data, join tables, and so on),
+and makes the query fail once that goes over the query's budget.  It's not meant to
+account for every byte; the point is to stop a single runaway query before it takes
+the whole server down with it.
+
+The tracker is shared by everything that charges memory to it, and lives as long as
+the last of them. */
+class memory_tracker_t : public single_threaded_countable_t<memory_tracker_t> {
+public:
+    static const uint64_t unlimited = std::numeric_limits<uint64_t>::max();
+
+    explicit memory_tracker_t(uint64_t _limit);
+    ~memory_tracker_t();
+
+    /* Throws a `RESOURCE` error, without charging anything, if `bytes` more would put
+    the query over its limit. */
+    void charge(uint64_t bytes);
+    void release(uint64_t bytes);
+
+    uint64_t get_usage() const { return usage; }
+    uint64_t get_peak_usage() const { return peak_usage; }
+    uint64_t get_limit() const { return limit; }
+
+private:
+    const uint64_t limit;
+    uint64_t usage;
+    uint64_t peak_usage;
+
+    DISABLE_COPYING(memory_tracker_t);
+};
+
+/* `memory_charge_t` is the memory charged on behalf of one data structure.  All of it
+is released when the `memory_charge_t` is reset or destroyed, so it should live next to
+the structure it accounts for. */
+class memory_charge_t {
+public:
+    memory_charge_t();
+    explicit memory_charge_t(counted_t<memory_tracker_t> _tracker);
+    memory_charge_t(memory_charge_t &&other);
+    ~memory_charge_t();
+
+    memory_charge_t &operator=(memory_charge_t &&other);
+
+    void add(uint64_t bytes);
+    // Charges the estimated size of `datum`.
+    void add(const datum_t &datum);
+    void reset();
+
+    uint64_t get_bytes() const { return bytes_charged; }
+
+private:
+    counted_t<memory_tracker_t> tracker;
+    uint64_t bytes_charged;
+
+    DISABLE_COPYING(memory_charge_t);
+};
+
+// An estimate of the memory a datum holds on to.
+uint64_t estimate_memory_usage(const datum_t &datum);
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_MEMORY_TRACKER_HPP_
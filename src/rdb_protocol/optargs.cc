@@ -78,6 +78,7 @@ static const std::set<std::string> acceptable_optargs({
     "max_batch_seconds",
     "max_dist",
     "max_results",
+    "memory_limit",
     "method",
     "min_batch_rows",
     "multi",
@@ -140,4 +140,54 @@ bool lt_cmp_t::operator()(env_t *env,
     return false;
 }
 
+keyed_datum_t lt_cmp_t::make_keyed(env_t *env, datum_t d) const {
+    keyed_datum_t res;
+    res.keys.reserve(comparisons.size());
+    for (auto it = comparisons.begin(); it != comparisons.end(); ++it) {
+        try {
+            res.keys.push_back(it->second->call(env, d)->as_datum());
+        } catch (const base_exc_t &e) {
+            if (e.get_type() != base_exc_t::NON_EXISTENCE) {
+                res.error = std::current_exception();
+                break;
+            }
+            res.keys.push_back(datum_t());
+        }
+    }
+    res.datum = std::move(d);
+    return res;
+}
+
+bool lt_cmp_t::operator()(const keyed_datum_t &l, const keyed_datum_t &r) const {
+    for (size_t i = 0; i < comparisons.size(); ++i) {
+        // Like above, an error from `l`'s function takes precedence.
+        if (i == l.keys.size()) {
+            std::rethrow_exception(l.error);
+        }
+        if (i == r.keys.size()) {
+            std::rethrow_exception(r.error);
+        }
+        const datum_t &lval = l.keys[i];
+        const datum_t &rval = r.keys[i];
+        const bool desc = comparisons[i].first == DESC;
+
+        if (!lval.has() && !rval.has()) {
+            continue;
+        }
+        if (!lval.has()) {
+            return true != desc;
+        }
+        if (!rval.has()) {
+            return false != desc;
+        }
+        int cmp_res = lval.cmp(rval);
+        if (cmp_res == 0) {
+            continue;
+        }
+        return (cmp_res < 0) != desc;
+    }
+
+    return false;
+}
+
 } // namespace ql
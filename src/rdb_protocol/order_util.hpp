@@ -3,11 +3,14 @@
 #ifndef RDB_PROTOCOL_ORDER_UTIL_HPP_
 #define RDB_PROTOCOL_ORDER_UTIL_HPP_
 
+#include <exception>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "errors.hpp"
 
+#include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/profile.hpp"
 #include "containers/counted.hpp"
@@ -43,6 +46,16 @@ build_comparisons_from_single_term(const term_t *target,
                                    scoped_ptr_t<val_t> &&arg,
                                    const raw_term_t &raw_term);
 
+// A datum along with the values of an `lt_cmp_t`'s comparison functions for it.
+struct keyed_datum_t {
+    datum_t datum;
+    // An empty key means that the function found no value.
+    std::vector<datum_t> keys;
+    // If a function threw any other error, the remaining keys are missing and
+    // comparing by them rethrows the error.
+    std::exception_ptr error;
+};
+
 class lt_cmp_t {
 public:
     typedef bool result_type;
@@ -54,6 +67,12 @@ public:
                     datum_t l,
                     datum_t r) const;
 
+    // Calls the comparison functions on `d` once, instead of on every comparison.
+    keyed_datum_t make_keyed(env_t *env, datum_t d) const;
+    // Compares datums by the keys from `make_keyed`.  This doesn't evaluate anything,
+    // so it can be used on any thread (e.g. by `parallel_stable_sort`).
+    bool operator()(const keyed_datum_t &l, const keyed_datum_t &r) const;
+
 private:
     const std::vector<std::pair<order_direction_t, counted_t<const func_t> > >
         comparisons;
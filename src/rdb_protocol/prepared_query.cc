@@ -0,0 +1,221 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/prepared_query.hpp"
+
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include "rdb_protocol/configured_limits.hpp"
+#include "rdb_protocol/ql2.pb.h"
+#include "rdb_protocol/term.hpp"
+#include "rdb_protocol/term_storage.hpp"
+
+namespace ql {
+
+// Larger queries aren't worth caching, and would make the cache keys expensive.
+const size_t MAX_QUERY_SHAPE_SIZE = 4 * KILOBYTE;
+
+// Returns true for terms whose positional arguments are only ever used by
+// evaluating them, so literals in them can be replaced by parameters.  Don't add
+// terms to this list that look at their arguments' source (e.g. through
+// `get_src()`, `lazy_literal_optarg`, or by deriving functions from it).
+bool term_only_evaluates_args(Term::TermType type) {
+    switch (type) {
+    case Term::MAKE_ARRAY:
+    case Term::MAKE_OBJ:
+    case Term::DB:
+    case Term::TABLE:
+    case Term::GET:
+    case Term::GET_ALL:
+    case Term::BETWEEN:
+    case Term::EQ:
+    case Term::NE:
+    case Term::LT:
+    case Term::LE:
+    case Term::GT:
+    case Term::GE:
+    case Term::NOT:
+    case Term::AND:
+    case Term::OR:
+    case Term::ADD:
+    case Term::SUB:
+    case Term::MUL:
+    case Term::DIV:
+    case Term::MOD:
+    case Term::SLICE:
+    case Term::SKIP:
+    case Term::LIMIT:
+    case Term::NTH:
+    case Term::INSERT:
+    case Term::UPDATE:
+    case Term::REPLACE:
+    case Term::DELETE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool is_json_scalar(const rapidjson::Value &value) {
+    return value.IsNull() || value.IsBool() || value.IsNumber() || value.IsString();
+}
+
+class query_shape_walker_t {
+public:
+    explicit query_shape_walker_t(query_shape_t *_shape) : shape(_shape) { }
+
+    bool walk(const rapidjson::Value *term, bool parameterizable) {
+        if (shape->key.size() > MAX_QUERY_SHAPE_SIZE) {
+            return false;
+        }
+        if (is_json_scalar(*term)) {
+            add_datum(term, *term, parameterizable);
+            return true;
+        } else if (term->IsObject()) {
+            // This will be rewritten into a `MAKE_OBJ` term.
+            shape->key.push_back('{');
+            if (!walk_optargs(term, parameterizable
+                                    && term_only_evaluates_args(Term::MAKE_OBJ))) {
+                return false;
+            }
+            shape->key.push_back('}');
+            return true;
+        } else if (!term->IsArray() || term->Size() == 0 || !(*term)[0].IsInt()) {
+            return false;
+        }
+
+        Term::TermType type = static_cast<Term::TermType>((*term)[0].GetInt());
+        if (type == Term::DATUM) {
+            if (term->Size() != 2) {
+                return false;
+            }
+            if (parameterizable && is_json_scalar((*term)[1])) {
+                // A parameter has the same shape whether or not the client wrapped
+                // it in a `DATUM` term.
+                add_datum(term, (*term)[1], parameterizable);
+                return true;
+            }
+        }
+        shape->key.append(strprintf("[%d", static_cast<int>(type)));
+        if (type == Term::DATUM) {
+            add_datum(term, (*term)[1], parameterizable);
+        } else {
+            bool args_parameterizable =
+                parameterizable && term_only_evaluates_args(type);
+            for (size_t i = 1; i < term->Size(); ++i) {
+                const rapidjson::Value *item = &(*term)[i];
+                if (item->IsArray()) {
+                    shape->key.push_back('(');
+                    for (size_t j = 0; j < item->Size(); ++j) {
+                        if (!walk(&(*item)[j], args_parameterizable)) {
+                            return false;
+                        }
+                    }
+                    shape->key.push_back(')');
+                } else if (item->IsObject()) {
+                    // `MAKE_OBJ` is the only term that uses its optional arguments
+                    // like positional ones.
+                    shape->key.push_back('{');
+                    if (!walk_optargs(item, type == Term::MAKE_OBJ
+                                            && args_parameterizable)) {
+                        return false;
+                    }
+                    shape->key.push_back('}');
+                } else {
+                    return false;
+                }
+            }
+        }
+        shape->key.push_back(']');
+        return true;
+    }
+
+private:
+    bool walk_optargs(const rapidjson::Value *optargs, bool parameterizable) {
+        for (auto it = optargs->MemberBegin(); it != optargs->MemberEnd(); ++it) {
+            add_string(it->name.GetString(), it->name.GetStringLength());
+            if (!walk(&it->value, parameterizable)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void add_datum(const rapidjson::Value *term,
+                   const rapidjson::Value &value,
+                   bool parameterizable) {
+        if (parameterizable && is_json_scalar(value)) {
+            // The type is kept in the shape to stay on the safe side; no term
+            // should be compiled differently depending on it.
+            shape->key.push_back('?');
+            shape->key.push_back(static_cast<char>('0' + value.GetType()));
+            shape->parameter_terms.push_back(term);
+        } else {
+            rapidjson::StringBuffer buffer;
+            rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+            value.Accept(writer);
+            add_string(buffer.GetString(), buffer.GetSize());
+        }
+    }
+
+    // Strings are prefixed by their length so they can't be confused with the
+    // structure around them.
+    void add_string(const char *str, size_t size) {
+        shape->key.append(strprintf("%zu:", size));
+        shape->key.append(str, size);
+    }
+
+    query_shape_t *shape;
+};
+
+bool compute_query_shape(const rapidjson::Value *root_term, query_shape_t *shape_out) {
+    shape_out->key.clear();
+    shape_out->parameter_terms.clear();
+    query_shape_walker_t walker(shape_out);
+    return walker.walk(root_term, true);
+}
+
+std::vector<datum_t> read_query_parameters(const query_shape_t &shape) {
+    std::vector<datum_t> res;
+    res.reserve(shape.parameter_terms.size());
+    for (const rapidjson::Value *term : shape.parameter_terms) {
+        const rapidjson::Value &value = term->IsArray() ? (*term)[1] : *term;
+        res.push_back(to_datum(value,
+                               configured_limits_t::unlimited,
+                               reql_version_t::LATEST));
+    }
+    return res;
+}
+
+std::map<uint32_t, size_t> get_parameter_slots(const query_shape_t &shape) {
+    std::map<uint32_t, size_t> res;
+    for (size_t i = 0; i < shape.parameter_terms.size(); ++i) {
+        // Preprocessing rewrote the parameters into `DATUM` terms in place.
+        raw_term_t term(shape.parameter_terms[i]);
+        r_sanity_check(term.type() == Term::DATUM);
+        res[term.bt().get()] = i;
+    }
+    return res;
+}
+
+prepared_query_t::prepared_query_t(scoped_ptr_t<const term_storage_t> &&_term_storage,
+                                   counted_t<const term_t> &&_term_tree) :
+    term_storage(std::move(_term_storage)),
+    term_tree(std::move(_term_tree)) { }
+
+prepared_query_t::~prepared_query_t() { }
+
+prepared_query_cache_t::prepared_query_cache_t() : queries(MAX_PREPARED_QUERIES) { }
+
+counted_t<const prepared_query_t> prepared_query_cache_t::find(const std::string &key) {
+    auto it = queries.find(key);
+    if (it == queries.end()) {
+        return counted_t<const prepared_query_t>();
+    }
+    return it->second;
+}
+
+void prepared_query_cache_t::insert(const std::string &key,
+                                    counted_t<const prepared_query_t> query) {
+    queries[key] = std::move(query);
+}
+
+} // namespace ql
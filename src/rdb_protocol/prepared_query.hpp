@@ -0,0 +1,89 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_PREPARED_QUERY_HPP_
+#define RDB_PROTOCOL_PREPARED_QUERY_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "containers/counted.hpp"
+#include "containers/lru_cache.hpp"
+#include "containers/scoped.hpp"
+#include "rapidjson/rapidjson.h"
+#include "rapidjson/document.h"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/error.hpp"
+
+namespace ql {
+
+class term_storage_t;
+class term_t;
+
+/* Applications tend to send the same few queries over and over again, only with
+different constants (`r.table('users').get(<id>)`).  To avoid preprocessing and
+compiling those every time, `query_cache_t` keeps the compiled term trees of recent
+queries in a `prepared_query_cache_t`, keyed by the query's shape.
+
+The shape of a query is its term tree with some of its literals replaced by
+parameter slots.  A literal only becomes a parameter if every term above it is known
+to use its positional arguments solely by evaluating them.  Other terms read their
+arguments' source when they are compiled, or turn it into a function that is sent to
+the shards (e.g. the bodies of `FUNC` terms, `pluck`, or optional arguments), so
+their literals stay part of the shape.  When a compiled tree is reused, its
+parameter slots evaluate to the values from the new query, which are passed in
+through `env_t::set_term_parameters`. */
+
+struct query_shape_t {
+    std::string key;
+    // The terms in the unprocessed query that are parameters.  Each is either a
+    // plain JSON scalar or a `DATUM` term.
+    std::vector<const rapidjson::Value *> parameter_terms;
+};
+
+// Computes the shape of an unprocessed query term.  Returns false if the query
+// shouldn't be cached, either because it's malformed (in which case compiling it
+// will report the error) or because it's too large.
+bool compute_query_shape(const rapidjson::Value *root_term, query_shape_t *shape_out);
+
+// Reads the values of the parameters from an unprocessed query.
+std::vector<datum_t> read_query_parameters(const query_shape_t &shape);
+
+// Maps the backtrace ids of the parameter terms to their index, once the query
+// has been preprocessed.
+std::map<uint32_t, size_t> get_parameter_slots(
+    const query_shape_t &shape);
+
+// A term tree that can be evaluated by all queries of a given shape.
+class prepared_query_t : public single_threaded_countable_t<prepared_query_t> {
+public:
+    prepared_query_t(scoped_ptr_t<const term_storage_t> &&_term_storage,
+                     counted_t<const term_t> &&_term_tree);
+    ~prepared_query_t();
+
+    // The query the tree was compiled from.  The tree points into it, and its
+    // backtrace registry must be used for errors from the tree.
+    const scoped_ptr_t<const term_storage_t> term_storage;
+    const counted_t<const term_t> term_tree;
+
+private:
+    DISABLE_COPYING(prepared_query_t);
+};
+
+class prepared_query_cache_t {
+public:
+    prepared_query_cache_t();
+
+    counted_t<const prepared_query_t> find(const std::string &key);
+    void insert(const std::string &key, counted_t<const prepared_query_t> query);
+
+private:
+    static const size_t MAX_PREPARED_QUERIES = 64;
+
+    lru_cache_t<std::string, counted_t<const prepared_query_t> > queries;
+
+    DISABLE_COPYING(prepared_query_cache_t);
+};
+
+} // namespace ql
+
+#endif  // RDB_PROTOCOL_PREPARED_QUERY_HPP_
@@ -596,8 +596,12 @@ struct rdb_r_shard_visitor_t : public boost::static_visitor<bool> {
             auto *rg_out = boost::get<rget_read_t>(payload_out);
             guarantee(!region.inner.right.unbounded);
             rg_out->current_shard.set(region);
+            /* Without hints, the read goes to every CPU shard of the table. The number
+            of CPU shards is per table, but they all have the same width. */
             rg_out->batchspec = rg_out->batchspec.scale_down(
-                rg.hints.has_value() ? rg.hints->size() : CPU_SHARDING_FACTOR);
+                rg.hints.has_value()
+                    ? rg.hints->size()
+                    : HASH_REGION_HASH_SIZE / (region.end - region.beg));
             if (rg_out->primary_keys.has_value()) {
                 for (auto it = rg_out->primary_keys->begin();
                      it != rg_out->primary_keys->end();) {
@@ -651,6 +655,7 @@ bool read_t::shard(const hash_region_t<key_range_t> &region,
     read_t::variant_t payload;
     bool result = boost::apply_visitor(rdb_r_shard_visitor_t(&region, &payload), read);
     *read_out = read_t(payload, profile, read_mode);
+    read_out->max_staleness_ms = max_staleness_ms;
     return result;
 }
 
@@ -1016,6 +1021,14 @@ void rdb_r_unshard_visitor_t::operator()(const distribution_read_t &dg) {
         }
     }
 
+    // Unlike the key counts, the loads of the hash shards for the same key range are
+    // all real, so we add them up.
+    for (const auto &result : results) {
+        for (const auto &pair : result.key_loads) {
+            res.key_loads[pair.first] += pair.second;
+        }
+    }
+
     // If the result is larger than the requested limit, scale it down
     if (dg.result_limit > 0 && res.key_counts.size() > dg.result_limit) {
         scale_down_distribution(dg.result_limit, &res.key_counts);
@@ -1470,7 +1483,8 @@ ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
 RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
     rget_read_response_t, stamp_response, result, reql_version);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(nearest_geo_read_response_t, results_or_error);
-RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(distribution_read_response_t, region, key_counts);
+RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
+        distribution_read_response_t, region, key_counts, key_loads);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(
     changefeed_subscribe_response_t, server_uuids, addrs);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(
@@ -1553,7 +1567,7 @@ RDB_IMPL_SERIALIZABLE_7_FOR_CLUSTER(
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(changefeed_stamp_t, addr, region);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(changefeed_point_stamp_t, addr, key);
 
-RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(read_t, read, profile, read_mode);
+RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(read_t, read, profile, read_mode, max_staleness_ms);
 
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_write_response_t, result);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_delete_response_t, result);
@@ -161,6 +161,10 @@ struct distribution_read_response_t {
     // key_counts[kn] = the number of keys in [kn, right_key)
     region_t region;
     std::map<store_key_t, int64_t> key_counts;
+    // The recent reads and writes per second in the same kind of ranges, as sampled
+    // by the `key_load_sampler_t` of the stores. The keys aren't related to the ones
+    // in `key_counts`.
+    std::map<store_key_t, double> key_loads;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(distribution_read_response_t);
 
@@ -495,6 +499,8 @@ struct read_t {
     variant_t read;
     profile_bool_t profile;
     read_mode_t read_mode;
+    /* Only used with `read_mode_t::BOUNDED`. */
+    int64_t max_staleness_ms;
 
     region_t get_region() const THROWS_NOTHING;
     // Returns true if the read has any operation for this region.  Returns
@@ -507,10 +513,13 @@ struct read_t {
                  signal_t *interruptor) const
         THROWS_ONLY(interrupted_exc_t);
 
-    read_t() : profile(profile_bool_t::DONT_PROFILE), read_mode(read_mode_t::SINGLE) { }
+    read_t()
+        : profile(profile_bool_t::DONT_PROFILE), read_mode(read_mode_t::SINGLE),
+          max_staleness_ms(0) { }
     template<class T>
     read_t(T &&_read, profile_bool_t _profile, read_mode_t _read_mode)
-        : read(std::forward<T>(_read)), profile(_profile), read_mode(_read_mode) { }
+        : read(std::forward<T>(_read)), profile(_profile), read_mode(_read_mode),
+          max_staleness_ms(0) { }
 
     // We use snapshotting for queries that acquire-and-hold large portions of the
     // table, so that they don't block writes.
@@ -18,9 +18,10 @@ const char *const binary_string = "BINARY";
 const char *const data_key = "data";
 
 // Given a raw data string, encodes it into a `r.binary` pseudotype with base64 encoding
-void encode_base64_ptype(
+template <class json_writer_t>
+void encode_base64_ptype_to_writer(
         const datum_string_t &data,
-        rapidjson::Writer<rapidjson::StringBuffer> *writer) {
+        json_writer_t *writer) {
     writer->StartObject();
     writer->Key(datum_t::reql_type_string.data(), datum_t::reql_type_string.size());
     writer->String(binary_string);
@@ -30,6 +31,18 @@ void encode_base64_ptype(
     writer->EndObject();
 }
 
+void encode_base64_ptype(
+        const datum_string_t &data,
+        rapidjson::Writer<rapidjson::StringBuffer> *writer) {
+    encode_base64_ptype_to_writer(data, writer);
+}
+
+void encode_base64_ptype(
+        const datum_string_t &data,
+        rapidjson::Writer<chunked_string_buffer_t> *writer) {
+    encode_base64_ptype_to_writer(data, writer);
+}
+
 rapidjson::Value encode_base64_ptype(const datum_string_t &data,
                                      rapidjson::Value::AllocatorType *allocator) {
     rapidjson::Value res(rapidjson::kObjectType);
@@ -48,13 +48,48 @@ scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(query_params_t *query_p
 
     global_optargs_t global_optargs;
     counted_t<const term_t> term_tree;
+    counted_t<const prepared_query_t> prepared_query;
+    std::vector<datum_t> term_parameters;
     try {
+        // Queries of the same shape share one compiled term tree, see
+        // `prepared_query.hpp`.
+        query_shape_t shape;
+        const rapidjson::Value *unprocessed_root =
+            query_params->term_storage->unprocessed_root_term();
+        bool cacheable = unprocessed_root != nullptr
+            && compute_query_shape(unprocessed_root, &shape);
+        if (cacheable) {
+            term_parameters = read_query_parameters(shape);
+            prepared_query = prepared_queries.find(shape.key);
+        }
+
+        // We still preprocess queries that have been prepared before, because the
+        // jobs table and error backtraces use their (identical) term trees.
         query_params->term_storage->preprocess();
-        global_optargs = query_params->term_storage->global_optargs();
 
-        compile_env_t compile_env((var_visibility_t()));
-        term_tree = compile_term(&compile_env, query_params->term_storage->root_term());
+        if (prepared_query.has()) {
+            global_optargs = query_params->term_storage->global_optargs();
+            term_tree = prepared_query->term_tree;
+        } else if (cacheable) {
+            // This must happen before `global_optargs()`, which may move the root
+            // term.
+            std::map<uint32_t, size_t> parameter_slots = get_parameter_slots(shape);
+            global_optargs = query_params->term_storage->global_optargs();
+
+            compile_env_t compile_env((var_visibility_t()), &parameter_slots);
+            counted_t<const term_t> prepared_tree =
+                compile_term(&compile_env, query_params->term_storage->root_term());
+            prepared_query = make_counted<prepared_query_t>(
+                std::move(query_params->term_storage), std::move(prepared_tree));
+            prepared_queries.insert(shape.key, prepared_query);
+            term_tree = prepared_query->term_tree;
+        } else {
+            global_optargs = query_params->term_storage->global_optargs();
 
+            compile_env_t compile_env((var_visibility_t()));
+            term_tree = compile_term(&compile_env,
+                                     query_params->term_storage->root_term());
+        }
     } catch (const exc_t &e) {
         throw bt_exc_t(Response::COMPILE_ERROR,
             e.get_error_type(),
@@ -68,7 +103,9 @@ scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(query_params_t *query_p
     }
     scoped_ptr_t<entry_t> entry(new entry_t(query_params,
                                             std::move(global_optargs),
-                                            std::move(term_tree)));
+                                            std::move(term_tree),
+                                            std::move(prepared_query),
+                                            std::move(term_parameters)));
 
     scoped_ptr_t<ref_t> ref(new ref_t(this,
                                       query_params->token,
@@ -207,6 +244,12 @@ void query_cache_t::ref_t::fill_response(response_t *res) {
             &combined_interruptor,
             serializable,
             trace.get_or_null());
+        env.set_term_parameters(&entry->term_parameters);
+        if (entry->memory_tracker.has()) {
+            env.set_memory_tracker(entry->memory_tracker);
+        } else {
+            entry->memory_tracker = env.memory_tracker();
+        }
 
         if (entry->state == entry_t::state_t::START) {
             run(&env, res);
@@ -254,14 +297,15 @@ void query_cache_t::ref_t::fill_response(response_t *res) {
         throw bt_exc_t(Response::RUNTIME_ERROR,
                        ex.get_error_type(),
                        ex.what(),
-                       entry->term_storage->backtrace_registry().datum_backtrace(ex));
+                       entry->get_term_storage()->backtrace_registry()
+                           .datum_backtrace(ex));
     } catch (const datum_exc_t &ex) {
         query_cache->terminate_internal(entry);
         throw bt_exc_t(Response::RUNTIME_ERROR,
                        ex.get_error_type(),
                        ex.what(),
-                       entry->term_storage->backtrace_registry().datum_backtrace(
-                            backtrace_id_t::empty(), 0));
+                       entry->get_term_storage()->backtrace_registry()
+                           .datum_backtrace(backtrace_id_t::empty(), 0));
     } catch (const std::exception &ex) {
         query_cache->terminate_internal(entry);
         throw bt_exc_t(Response::RUNTIME_ERROR,
@@ -360,7 +404,9 @@ void query_cache_t::ref_t::serve(env_t *env, response_t *res) {
 
 query_cache_t::entry_t::entry_t(query_params_t *query_params,
                                 global_optargs_t &&_global_optargs,
-                                counted_t<const term_t> &&_term_tree) :
+                                counted_t<const term_t> &&_term_tree,
+                                counted_t<const prepared_query_t> &&_prepared_query,
+                                std::vector<datum_t> &&_term_parameters) :
         state(state_t::START),
         interrupt_reason(interrupt_reason_t::UNKNOWN),
         job_id(generate_uuid()),
@@ -369,10 +415,16 @@ query_cache_t::entry_t::entry_t(query_params_t *query_params,
                                         profile_bool_t::DONT_PROFILE),
         term_storage(std::move(query_params->term_storage)),
         global_optargs(std::move(_global_optargs)),
+        prepared_query(std::move(_prepared_query)),
+        term_parameters(std::move(_term_parameters)),
         start_time(current_microtime()),
         term_tree(std::move(_term_tree)),
         has_sent_batch(false) { }
 
 query_cache_t::entry_t::~entry_t() { }
 
+const term_storage_t *query_cache_t::entry_t::get_term_storage() const {
+    return term_storage.has() ? term_storage.get() : prepared_query->term_storage.get();
+}
+
 } // namespace ql
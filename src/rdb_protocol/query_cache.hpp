@@ -8,6 +8,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "arch/address.hpp"
 #include "clustering/administration/auth/user_context.hpp"
@@ -24,6 +25,7 @@
 #include "rdb_protocol/rdb_backtrace.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/env.hpp"
+#include "rdb_protocol/prepared_query.hpp"
 #include "rdb_protocol/ql2.pb.h"
 #include "rdb_protocol/query_params.hpp"
 #include "rdb_protocol/term.hpp"
@@ -106,17 +108,27 @@ private:
     public:
         entry_t(query_params_t *query_params,
                 global_optargs_t &&_global_optargs,
-                counted_t<const term_t> &&_term_tree);
+                counted_t<const term_t> &&_term_tree,
+                counted_t<const prepared_query_t> &&_prepared_query,
+                std::vector<datum_t> &&_term_parameters);
         ~entry_t();
 
+        // The query as received from the client.
+        const term_storage_t *get_term_storage() const;
+
         enum class state_t { START, STREAM, DONE, DELETING } state;
         interrupt_reason_t interrupt_reason;
 
         const uuid_u job_id;
         const bool noreply;
         const profile_bool_t profile;
+        // This is empty if the query was moved into `prepared_query`.
         const scoped_ptr_t<const term_storage_t> term_storage;
         const global_optargs_t global_optargs;
+        // The prepared query that `term_tree` comes from, if any.  The term tree
+        // (and anything evaluated from it) may refer to its `term_storage`.
+        const counted_t<const prepared_query_t> prepared_query;
+        const std::vector<datum_t> term_parameters;
         const microtime_t start_time;
 
         cond_t persistent_interruptor;
@@ -124,6 +136,10 @@ private:
         // This will be empty if the root term has already been run
         counted_t<const term_t> term_tree;
 
+        // What the query's memory is charged to.  This is empty until the query
+        // starts running, and is shared by the `env_t`s of all its batches.
+        counted_t<memory_tracker_t> memory_tracker;
+
         // This will be empty until the root term has been evaluated
         // If this resulted in a stream, this will not be empty until the
         // stream is finished
@@ -145,6 +161,7 @@ private:
     return_empty_normal_batches_t return_empty_normal_batches;
     auth::user_context_t user_context;
     std::map<int64_t, scoped_ptr_t<entry_t> > queries;
+    prepared_query_cache_t prepared_queries;
 
     // Used for noreply waiting, this contains all allocated-but-incomplete query ids
     friend class query_params_t::query_id_t;
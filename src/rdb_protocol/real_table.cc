@@ -25,6 +25,10 @@ const std::string &real_table_t::get_pkey() const {
     return pkey;
 }
 
+void real_table_t::set_max_staleness_ms(int64_t ms) {
+    max_staleness_ms = ms;
+}
+
 ql::datum_t real_table_t::read_row(
     ql::env_t *env, ql::datum_t pval, read_mode_t read_mode) {
     read_t read(point_read_t(store_key_t(pval.print_primary())),
@@ -346,18 +350,29 @@ void real_table_t::read_with_profile(ql::env_t *env, const read_t &read,
         env->profile() == profile_bool_t::PROFILE,
         (read.read_mode == read_mode_t::OUTDATED ? "Perform outdated read." :
          (read.read_mode == read_mode_t::DEBUG_DIRECT ? "Perform debug_direct read." :
+         (read.read_mode == read_mode_t::BOUNDED ? "Perform bounded read." :
          (read.read_mode == read_mode_t::SINGLE ? "Perform read." :
-                                                  "Perform majority read."))),
+                                                  "Perform majority read.")))),
         env->trace);
     profile::splitter_t splitter(env->trace);
     /* propagate whether or not we're doing profiles */
     r_sanity_check(read.profile == env->profile());
 
+    /* The staleness bound is a property of the table object, so the readers that
+    built `read` didn't fill it in. */
+    const read_t *read_to_send = &read;
+    read_t bounded_read;
+    if (read.read_mode == read_mode_t::BOUNDED) {
+        bounded_read = read;
+        bounded_read.max_staleness_ms = max_staleness_ms;
+        read_to_send = &bounded_read;
+    }
+
     /* Do the actual read. */
     try {
         namespace_access.get()->read(
             env->get_user_context(),
-            read,
+            *read_to_send,
             response,
             order_token_t::ignore,
             env->interruptor);
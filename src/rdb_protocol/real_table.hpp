@@ -40,11 +40,14 @@ public:
         namespace_access(_namespace_access),
         pkey(_pkey),
         changefeed_client(_changefeed_client),
-        m_table_meta_client(table_meta_client) { }
+        m_table_meta_client(table_meta_client),
+        max_staleness_ms(0) { }
 
     namespace_id_t get_id() const;
     const std::string &get_pkey() const;
 
+    void set_max_staleness_ms(int64_t ms) final;
+
     ql::datum_t read_row(ql::env_t *env, ql::datum_t pval, read_mode_t read_mode);
     counted_t<ql::datum_stream_t> read_all(
         ql::env_t *env,
@@ -128,6 +131,7 @@ private:
     std::string pkey;
     ql::changefeed::client_t *changefeed_client;
     table_meta_client_t *m_table_meta_client;
+    int64_t max_staleness_ms;
 };
 
 #endif /* RDB_PROTOCOL_REAL_TABLE_HPP_ */
@@ -363,7 +363,7 @@ bool is_grouped_data(grouped_t<stream_t> *streams, const ql::datum_t &q) {
 // (Also, I'm sorry for this absurd type hierarchy.)
 class to_array_t : public eager_acc_t {
 public:
-    to_array_t() : size(0) { }
+    explicit to_array_t(env_t *env) : size(0), charge(env->memory_tracker()) { }
 private:
     virtual void operator()(env_t *env, groups_t *gs) {
         for (auto kv = gs->begin(); kv != gs->end(); ++kv) {
@@ -382,6 +382,9 @@ private:
                     format_array_size_error(env->limits()
                               .array_size_limit()).c_str());
             }
+            for (const datum_t &d : *lst2) {
+                charge.add(d);
+            }
             lst1->reserve(lst1->size() + lst2->size());
             std::move(lst2->begin(), lst2->end(), std::back_inserter(*lst1));
         }
@@ -399,6 +402,9 @@ private:
             stream_t *stream = &kv->second;
             for (auto &&pair : stream->substreams) {
                 size += pair.second.stream.size();
+                for (const auto &item : pair.second.stream) {
+                    charge.add(item.data);
+                }
             }
             if (is_grouped_data(streams, kv->first)) {
                 rcheck_toplevel(
@@ -500,10 +506,12 @@ private:
 
     groups_t groups;
     size_t size;
+    // Accounts for the elements in `groups`.
+    memory_charge_t charge;
 };
 
-scoped_ptr_t<eager_acc_t> make_to_array() {
-    return make_scoped<to_array_t>();
+scoped_ptr_t<eager_acc_t> make_to_array(env_t *env) {
+    return make_scoped<to_array_t>(env);
 }
 
 template<class T>
@@ -428,7 +428,7 @@ scoped_ptr_t<accumulator_t> make_append(region_t region,
                                         require_sindexes_t require_sindex_val);
 scoped_ptr_t<accumulator_t> make_unsharding_append();
 scoped_ptr_t<accumulator_t> make_terminal(const terminal_variant_t &t);
-scoped_ptr_t<eager_acc_t> make_to_array();
+scoped_ptr_t<eager_acc_t> make_to_array(env_t *env);
 scoped_ptr_t<eager_acc_t> make_eager_terminal(const terminal_variant_t &t);
 scoped_ptr_t<op_t> make_op(const transform_variant_t &tv);
 
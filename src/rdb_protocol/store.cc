@@ -452,6 +452,7 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
         point_read_response_t *res =
             boost::get<point_read_response_t>(&response->response);
         rdb_get(get.key, btree, superblock, res, trace);
+        store->key_load_sampler.record_read(get.key);
     }
 
     void operator()(const intersecting_geo_read_t &geo_read) {
@@ -662,6 +663,11 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
             scale_down_distribution(dg.result_limit, &res->key_counts);
         }
 
+        for (const auto &pair : store->key_load_sampler.get_rates(dg.region.inner)) {
+            res->key_loads.insert(res->key_loads.end(), std::make_pair(pair.first,
+                pair.second.reads_per_sec + pair.second.writes_per_sec));
+        }
+
         res->region = dg.region;
     }
 
@@ -816,6 +822,9 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
                                  write_hook,
                                  br.return_changes);
 
+        for (const store_key_t &key : br.keys) {
+            store->key_load_sampler.record_write(key);
+        }
         response->response =
             rdb_batched_replace(
                 btree_info_t(btree, timestamp, datum_string_t(br.pkey)),
@@ -844,6 +853,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
         keys.reserve(bi.inserts.size());
         for (auto it = bi.inserts.begin(); it != bi.inserts.end(); ++it) {
             keys.emplace_back(it->get_field(datum_string_t(bi.pkey)).print_primary());
+            store->key_load_sampler.record_write(keys.back());
         }
         response->response =
             rdb_batched_replace(
@@ -867,6 +877,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
 
         rdb_live_deletion_context_t deletion_context;
         rdb_modification_report_t mod_report(w.key);
+        store->key_load_sampler.record_write(w.key);
         rdb_set(w.key, w.data, w.overwrite, btree, timestamp, superblock->get(),
                 &deletion_context, res, &mod_report.info, trace);
 
@@ -883,6 +894,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
 
         rdb_live_deletion_context_t deletion_context;
         rdb_modification_report_t mod_report(d.key);
+        store->key_load_sampler.record_write(d.key);
         rdb_delete(d.key, btree, timestamp, superblock->get(), &deletion_context,
                 delete_mode_t::REGULAR_QUERY, res, &mod_report.info, trace);
 
@@ -23,6 +23,7 @@
 #include "paths.hpp"
 #include "protocol_api.hpp"
 #include "rdb_protocol/changefeed.hpp"
+#include "rdb_protocol/key_load_sampler.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rdb_protocol/store_metainfo.hpp"
 #include "rpc/mailbox/typed.hpp"
@@ -336,6 +337,31 @@ public:
             THROWS_ONLY(interrupted_exc_t);
 
 private:
+    // Used by `clear_sindex_data` when the whole index gets cleared. Frees the nodes
+    // of the index without looking at the individual keys.
+    void discard_sindex_data(
+            uuid_u sindex_id,
+            value_sizer_t *sizer,
+            const deletion_context_t *deletion_context,
+            signal_t *interruptor)
+            THROWS_ONLY(interrupted_exc_t);
+
+    // Helpers for `reset_data`. The first one swaps every secondary index for an
+    // empty one that still needs to be constructed, and returns both sets of indexes.
+    void replace_sindexes_with_empty_ones(
+            write_durability_t durability,
+            signal_t *interruptor,
+            std::vector<secondary_index_t> *old_sindexes_out,
+            std::set<uuid_u> *new_sindexes_out)
+            THROWS_ONLY(interrupted_exc_t);
+    continue_bool_t reset_data_pass(
+            const binary_blob_t &zero_metainfo,
+            const region_t &subregion,
+            write_durability_t durability,
+            const std::set<uuid_u> &new_sindexes,
+            signal_t *interruptor)
+            THROWS_ONLY(interrupted_exc_t);
+
     // Helper function to clear out a secondary index that has been
     // marked as deleted and drop it at the end. To be run in a coroutine.
     void delayed_clear_and_drop_sindex(
@@ -377,6 +403,9 @@ public:
     io_backender_t *io_backender_;
     base_path_t base_path_;
     perfmon_membership_t perfmon_collection_membership;
+    /* Counts the point reads and the writes by key, for load-based rebalancing. */
+    key_load_sampler_t key_load_sampler;
+    perfmon_membership_t key_load_sampler_membership;
     scoped_ptr_t<store_metainfo_manager_t> metainfo;
 
     std::map<uuid_u, scoped_ptr_t<btree_slice_t> > secondary_index_slices;
@@ -1,6 +1,10 @@
 #include "rdb_protocol/store.hpp"
 
+#include <algorithm>
+#include <iterator>
+
 #include "btree/backfill.hpp"
+#include "btree/depth_first_traversal.hpp"
 #include "btree/reql_specific.hpp"
 #include "rdb_protocol/btree.hpp"
 
@@ -14,6 +18,13 @@ backfill faster, but it will also cause the backfill-related transactions to hol
 superblock for a longer time. */
 static const int MAX_CHANGES_PER_TXN = 16;
 
+/* `MAX_CHANGES_PER_BULK_TXN` is the maximum number of keys we'll insert in a single
+transaction when backfilling into a range that didn't hold any data to begin with. In
+that case there is nothing to erase first, and nothing else writes to the range while
+we're filling it, so we can put several leaf nodes' worth of items into each
+transaction. Items with more pairs than this are split across transactions. */
+static const int MAX_CHANGES_PER_BULK_TXN = 256;
+
 /* `MAX_UNSAVED_CHANGES` is the maximum number of keys we'll modify or delete before
 flushing our changes out to disk. This prevents the backfill from using too much of the
 cache's unsaved data limit, which would slow down queries on other shards. */
@@ -82,11 +93,38 @@ private:
     auto_drainer_t drainer;
 };
 
+/* `range_is_empty()` returns `true` if the B-tree doesn't have any keys in `range`.
+Deletion entries don't count. */
+class key_finder_t : public depth_first_traversal_callback_t {
+public:
+    key_finder_t() : found(false) { }
+    continue_bool_t handle_pair(scoped_key_value_t &&, signal_t *) {
+        found = true;
+        return continue_bool_t::ABORT;
+    }
+    bool found;
+};
+
+bool range_is_empty(cache_conn_t *cache, const key_range_t &range,
+                    signal_t *interruptor) {
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    get_btree_superblock_and_txn_for_reading(
+        cache, CACHE_SNAPSHOTTED_NO, &superblock, &txn);
+    key_finder_t key_finder;
+    btree_depth_first_traversal(superblock.get(), range, &key_finder, access_t::read,
+        direction_t::FORWARD, release_superblock_t::RELEASE, interruptor);
+    if (interruptor->is_pulsed()) {
+        throw interrupted_exc_t();
+    }
+    return !key_finder.found;
+}
+
 /* `receive_backfill()` spawns a series of coroutines running `apply_empty_range()`,
-`apply_single_key_item()`, and `apply_multi_key_item()`. Each coroutine gets a
-`receive_backfill_tokens_t` that keeps track of order, takes care of updating the
-sindexes, etc. `receive_backfill_info_t` stores some information that's common to the
-entire backfill task, that the tokens need access to. */
+`apply_single_key_item()`, `apply_multi_key_item()`, and `apply_bulk_items()`. Each
+coroutine gets a `receive_backfill_tokens_t` that keeps track of order, takes care of
+updating the sindexes, etc. `receive_backfill_info_t` stores some information that's
+common to the entire backfill task, that the tokens need access to. */
 
 class receive_backfill_info_t {
 public:
@@ -382,6 +420,78 @@ void apply_multi_key_item(
     }
 }
 
+/* `apply_bulk_items()` applies a run of consecutive items to a part of the B-tree that
+was empty when the backfill started, all in one transaction. Since there's nothing in the
+range yet, it skips the erasing that `apply_multi_key_item()` has to do and inserts the
+pairs directly, which is much cheaper when seeding a new replica. */
+void apply_bulk_items(
+        const receive_backfill_tokens_t &tokens,
+        /* `items` is conceptually passed by move, but `std::bind()` isn't smart enough
+        to handle that. */
+        std::vector<backfill_item_t> &items   // NOLINT runtime/references
+        ) {
+    try {
+        size_t num_pairs = 0;
+        for (const backfill_item_t &item : items) {
+            num_pairs += item.pairs.size();
+        }
+
+        /* Acquire the superblock */
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        {
+            fifo_enforcer_sink_t::exit_write_t exiter(
+                &tokens.info->btree_fifo_sink, tokens.write_token);
+            wait_interruptible(&exiter, tokens.keepalive.get_drain_signal());
+
+            tokens.info->limiter->prepare_for_changes(
+                num_pairs, tokens.keepalive.get_drain_signal());
+
+            get_btree_superblock_and_txn_for_writing(tokens.info->cache_conn, nullptr,
+                write_access_t::write, num_pairs, write_durability_t::SOFT,
+                &superblock, &txn);
+        }
+
+        /* We must not throw within the transaction. */
+        cond_t non_interruptor;
+        rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+        std::vector<rdb_modification_report_t> mod_reports;
+        for (backfill_item_t &item : items) {
+            if (!item.is_single_key()) {
+                /* See `btree/backfill.hpp` for why this is still necessary. */
+                btree_receive_backfill_item_update_deletion_timestamps(
+                    superblock.get(), release_superblock_t::KEEP, &sizer, item,
+                    &non_interruptor);
+            }
+            for (backfill_item_t::pair_t &pair : item.pairs) {
+                promise_t<superblock_t *> pass_back_superblock;
+                apply_item_pair(tokens.info->slice, superblock.get(), std::move(pair),
+                    &mod_reports, &pass_back_superblock);
+                guarantee(superblock.get() == pass_back_superblock.assert_get_value());
+            }
+        }
+
+        /* Acquire the sindex block and update the metainfo */
+        const key_range_t::right_bound_t &progress = items.back().range.right;
+        buf_lock_t sindex_block(superblock->expose_buf(),
+            superblock->get_sindex_block_id(), access_t::write);
+        tokens.update_metainfo_cb(progress, superblock.get());
+        superblock->release();
+
+        /* Notify that we're done and update the sindexes */
+        fifo_enforcer_sink_t::exit_write_t exiter(
+            &tokens.info->commit_fifo_sink, tokens.write_token);
+        /* Note: This must not be interruptible, or we might miss updating secondary
+        indexes. */
+        exiter.wait_lazily_unordered();
+        tokens.commit_cb(progress, std::move(txn), std::move(sindex_block),
+            std::move(mod_reports));
+
+    } catch (const interrupted_exc_t &exc) {
+        /* The call to `receive_backfill()` was interrupted. Ignore. */
+    }
+}
+
 continue_bool_t store_t::receive_backfill(
         const region_t &_region,
         backfill_item_producer_t *item_producer,
@@ -405,35 +515,23 @@ continue_bool_t store_t::receive_backfill(
     /* We'll set `result` to `false` to record if `item_producer` returns `ABORT`. */
     continue_bool_t result = continue_bool_t::CONTINUE;
 
-    /* Repeatedly request items from `item_producer` and spawn coroutines to handle them,
-    but limit the number of simultaneously active coroutines. */
-    while (spawn_threshold != _region.inner.right) {
-        bool is_item;
-        backfill_item_t item;
-        key_range_t::right_bound_t empty_range;
-        if (continue_bool_t::ABORT ==
-                item_producer->next_item(&is_item, &item, &empty_range)) {
-            /* By breaking out of the loop instead of returning immediately, we ensure
-            that we commit every item that we got from the item producer, as we are
-            required to. */
-            result = continue_bool_t::ABORT;
-            break;
-        }
-
+    /* If there's no data in the range yet, as when seeding a new replica, we collect
+    runs of consecutive items into `bulk_items` and apply each run in one transaction
+    with `apply_bulk_items()`. */
+    const bool bulk = range_is_empty(general_cache_conn.get(), _region.inner,
+                                     interruptor);
+    std::vector<backfill_item_t> bulk_items;
+    size_t bulk_pairs = 0;
+
+    /* `make_tokens()` blocks until another coroutine may be spawned, and returns the
+    tokens for it. */
+    auto make_tokens = [&]() {
         receive_backfill_tokens_t tokens(&info, interruptor);
 
-        if (is_item) {
-            rassert(key_range_t::right_bound_t(item.get_range().left)
-                >= spawn_threshold);
-            spawn_threshold = item.get_range().right;
-        } else {
-            rassert(empty_range >= spawn_threshold);
-            spawn_threshold = empty_range;
-        }
-
         /* The `apply_*()` functions will call back to `update_metainfo_cb` when they
         want to apply the metainfo to the superblock. They may make multiple calls, but
-        the last call will have `progress` equal to `item.get_range().right`. */
+        the last call will have `progress` equal to the right-hand side of the last item
+        they were given. */
         tokens.update_metainfo_cb = [this, &_region, &metainfo_threshold, &item_producer,
                     &spawn_threshold](
                 const key_range_t::right_bound_t &progress,
@@ -456,7 +554,8 @@ continue_bool_t store_t::receive_backfill(
 
         /* The `apply_*()` functions will call back to `commit_cb` when they're done
         applying the changes for a given sub-region. They may make multiple calls, but
-        the last call will have `progress` equal to `item.get_range().right`. */
+        the last call will have `progress` equal to the right-hand side of the last item
+        they were given. */
         tokens.commit_cb = [this, item_producer, &commit_threshold, &metainfo_threshold](
                 const key_range_t::right_bound_t &progress,
                 scoped_ptr_t<txn_t> &&txn,
@@ -483,17 +582,85 @@ continue_bool_t store_t::receive_backfill(
             item_producer->on_commit(progress);
         };
 
+        return tokens;
+    };
+
+    auto spawn_bulk_items = [&]() {
+        if (!bulk_items.empty()) {
+            coro_t::spawn_sometime(std::bind(
+                &apply_bulk_items, make_tokens(), std::move(bulk_items)));
+            bulk_items.clear();
+            bulk_pairs = 0;
+        }
+    };
+
+    /* Repeatedly request items from `item_producer` and spawn coroutines to handle them,
+    but limit the number of simultaneously active coroutines. */
+    while (spawn_threshold != _region.inner.right) {
+        bool is_item;
+        backfill_item_t item;
+        key_range_t::right_bound_t empty_range;
+        if (continue_bool_t::ABORT ==
+                item_producer->next_item(&is_item, &item, &empty_range)) {
+            /* By breaking out of the loop instead of returning immediately, we ensure
+            that we commit every item that we got from the item producer, as we are
+            required to. */
+            result = continue_bool_t::ABORT;
+            break;
+        }
+
+        if (is_item) {
+            rassert(key_range_t::right_bound_t(item.get_range().left)
+                >= spawn_threshold);
+            spawn_threshold = item.get_range().right;
+        } else {
+            rassert(empty_range >= spawn_threshold);
+            spawn_threshold = empty_range;
+        }
+
+        if (bulk && is_item) {
+            /* If the item doesn't fit into the current run, we split it at a pair
+            boundary and finish the run with its left part. `spawn_bulk_items()` is called
+            as soon as a run is full, so there's always room for at least one pair. */
+            const size_t max_pairs = MAX_CHANGES_PER_BULK_TXN;
+            while (bulk_pairs + item.pairs.size() > max_pairs) {
+                size_t room = max_pairs - bulk_pairs;
+                backfill_item_t left_part;
+                left_part.range.left = item.range.left;
+                left_part.range.right = key_range_t::right_bound_t(item.pairs[room].key);
+                left_part.min_deletion_timestamp = item.min_deletion_timestamp;
+                left_part.pairs.reserve(room);
+                std::move(item.pairs.begin(), item.pairs.begin() + room,
+                    std::back_inserter(left_part.pairs));
+                item.pairs.erase(item.pairs.begin(), item.pairs.begin() + room);
+                item.range.left = item.pairs[0].key;
+                bulk_items.push_back(std::move(left_part));
+                bulk_pairs += room;
+                spawn_bulk_items();
+            }
+            bulk_pairs += item.pairs.size();
+            bulk_items.push_back(std::move(item));
+            if (bulk_pairs >= max_pairs) {
+                spawn_bulk_items();
+            }
+            continue;
+        }
+
+        /* Everything must be applied in order, so the items we've collected so far go
+        first. */
+        spawn_bulk_items();
         if (!is_item) {
             coro_t::spawn_sometime(std::bind(
-                &apply_empty_range, std::move(tokens), empty_range));
+                &apply_empty_range, make_tokens(), empty_range));
         } else if (item.is_single_key()) {
             coro_t::spawn_sometime(std::bind(
-                &apply_single_key_item, std::move(tokens), std::move(item)));
+                &apply_single_key_item, make_tokens(), std::move(item)));
         } else {
             coro_t::spawn_sometime(std::bind(
-                &apply_multi_key_item, std::move(tokens), std::move(item)));
+                &apply_multi_key_item, make_tokens(), std::move(item)));
         }
     }
+    spawn_bulk_items();
 
     /* Wait for any running coroutines to finish. We construct an `exit_write_t` instead
     of just destroying `info.drainer` because we don't want to interrupt the coroutines
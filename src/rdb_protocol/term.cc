@@ -25,7 +25,7 @@ counted_t<const term_t> compile_on_current_stack(
         compile_env_t *env,
         const raw_term_t &t) {
     switch (t.type()) {
-    case Term::DATUM:              return make_datum_term(t);
+    case Term::DATUM:              return make_datum_term(env, t);
     case Term::MAKE_ARRAY:         return make_make_array_term(env, t);
     case Term::MAKE_OBJ:           return make_make_obj_term(env, t);
     case Term::BINARY:             return make_binary_term(env, t);
@@ -229,12 +229,20 @@ bool term_storage_t::static_optarg_as_bool(UNUSED const std::string &key,
     unreachable();
 }
 
+optional<std::string> term_storage_t::global_db_name() const {
+    return r_nullopt;
+}
+
 global_optargs_t term_storage_t::global_optargs() {
     r_sanity_check(false, "global_optargs() is unimplemented "
                    "for this term_storage_t type");
     unreachable();
 }
 
+const rapidjson::Value *term_storage_t::unprocessed_root_term() const {
+    return nullptr;
+}
+
 const backtrace_registry_t &term_storage_t::backtrace_registry() const {
     return bt_reg;
 }
@@ -290,6 +298,11 @@ void json_term_storage_t::preprocess() {
     preprocess_term_tree(&query_json[1], &query_json.GetAllocator(), &bt_reg);
 }
 
+const rapidjson::Value *json_term_storage_t::unprocessed_root_term() const {
+    r_sanity_check(query_json.Size() >= 2);
+    return &query_json[1];
+}
+
 raw_term_t json_term_storage_t::root_term() const {
     r_sanity_check(query_json.Size() >= 2);
     return raw_term_t(&query_json[1]);
@@ -322,6 +335,33 @@ bool json_term_storage_t::static_optarg_as_bool(const std::string &key,
 
 }
 
+optional<std::string> json_term_storage_t::global_db_name() const {
+    r_sanity_check(query_json.IsArray());
+    if (query_json.Size() < 3) {
+        // `global_optargs()` fills in the same default.
+        return make_optional(std::string("test"));
+    }
+
+    const rapidjson::Value *_global_optargs = &query_json[2];
+    r_sanity_check(_global_optargs->IsObject());
+
+    const auto it = _global_optargs->FindMember("db");
+    if (it == _global_optargs->MemberEnd()) {
+        return make_optional(std::string("test"));
+    } else if (!it->value.IsArray() ||
+               it->value.Size() != 2 ||
+               !it->value[0].IsNumber() ||
+               static_cast<Term::TermType>(it->value[0].GetInt()) != Term::DB ||
+               !it->value[1].IsArray() ||
+               it->value[1].Size() != 1 ||
+               !it->value[1][0].IsString()) {
+        // The database is computed by some expression, which we don't evaluate here.
+        return r_nullopt;
+    }
+    return make_optional(std::string(it->value[1][0].GetString(),
+                                     it->value[1][0].GetStringLength()));
+}
+
 global_optargs_t json_term_storage_t::global_optargs() {
     auto &allocator = query_json.GetAllocator();
     rapidjson::Value *src;
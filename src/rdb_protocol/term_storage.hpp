@@ -131,9 +131,16 @@ public:
     virtual Query::QueryType query_type() const;
     virtual bool static_optarg_as_bool(const std::string &key,
                                        bool default_value) const;
+    // The name of the query's default database, if it can be determined without
+    // evaluating anything.  This is only valid before `preprocess()`.
+    virtual optional<std::string> global_db_name() const;
     virtual void preprocess();
     virtual global_optargs_t global_optargs();
 
+    // Returns the root term as it was received from the client, or `nullptr` if
+    // it didn't come in as JSON.  This is only valid before `preprocess()`.
+    virtual const rapidjson::Value *unprocessed_root_term() const;
+
 protected:
     backtrace_registry_t bt_reg;
 };
@@ -145,9 +152,11 @@ public:
     Query::QueryType query_type() const;
     bool static_optarg_as_bool(const std::string &key,
                                bool default_value) const;
+    optional<std::string> global_db_name() const;
     void preprocess();
     raw_term_t root_term() const;
     global_optargs_t global_optargs();
+    const rapidjson::Value *unprocessed_root_term() const;
 private:
     scoped_array_t<char> original_data;
     rapidjson::Document query_json;
@@ -32,6 +32,34 @@ private:
     const datum_t datum;
 };
 
+// A `DATUM` term of a prepared query, whose value is different for every query
+// evaluating it.
+class parameter_term_t : public term_t {
+public:
+    parameter_term_t(const raw_term_t &term, size_t _index)
+            : term_t(term),
+              index(_index),
+              is_string(term.datum(configured_limits_t::unlimited,
+                                   reql_version_t::LATEST).get_type()
+                        == datum_t::type_t::R_STR) { }
+
+    // The type of a parameter is part of the query's shape, so it's the same for
+    // every query evaluating this term.
+    bool is_simple_selector() const {
+        return is_string;
+    }
+
+private:
+    virtual void accumulate_captures(var_captures_t *) const { /* do nothing */ }
+    virtual deterministic_t is_deterministic() const { return deterministic_t::always; }
+    virtual scoped_ptr_t<val_t> term_eval(scope_env_t *env, eval_flags_t) const {
+        return new_val(env->env->get_term_parameter(index));
+    }
+    virtual const char *name() const { return "datum"; }
+    const size_t index;
+    const bool is_string;
+};
+
 class constant_term_t : public op_term_t {
 public:
     constant_term_t(compile_env_t *env, const raw_term_t &term,
@@ -145,7 +173,13 @@ private:
 };
 
 counted_t<term_t> make_datum_term(
-        const raw_term_t &term) {
+        compile_env_t *env, const raw_term_t &term) {
+    if (env->parameter_slots != nullptr) {
+        auto it = env->parameter_slots->find(term.bt().get());
+        if (it != env->parameter_slots->end()) {
+            return make_counted<parameter_term_t>(term, it->second);
+        }
+    }
     return make_counted<datum_term_t>(term);
 }
 counted_t<term_t> make_constant_term(
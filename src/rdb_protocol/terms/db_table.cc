@@ -7,6 +7,7 @@
 #include "clustering/administration/admin_op_exc.hpp"
 #include "clustering/administration/auth/permissions.hpp"
 #include "clustering/administration/auth/username.hpp"
+#include "clustering/table_contract/cpu_sharding.hpp"
 #include "containers/name_string.hpp"
 #include "rdb_protocol/datum_string.hpp"
 #include "rdb_protocol/op.hpp"
@@ -162,7 +163,7 @@ public:
         : meta_op_term_t(env, term, argspec_t(1, 2),
             optargspec_t({"primary_key", "shards", "replicas",
                           "nonvoting_replica_tags", "primary_replica_tag",
-                          "durability"})) { }
+                          "durability", "cpu_shards"})) { }
 private:
     virtual scoped_ptr_t<val_t> eval_impl(
             scope_env_t *env, args_t *args, eval_flags_t) const {
@@ -194,6 +195,18 @@ private:
                 DURABILITY_REQUIREMENT_SOFT ?
                     write_durability_t::SOFT : write_durability_t::HARD;
 
+        // Parse the 'cpu_shards' optarg. It can't be changed after the table is created.
+        size_t num_cpu_shards = CPU_SHARDING_FACTOR;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "cpu_shards")) {
+            int64_t n = v->as_int();
+            rcheck_target(v,
+                n > 0 && is_valid_cpu_sharding_factor(n),
+                base_exc_t::LOGIC,
+                strprintf("`cpu_shards` must be a power of two between 1 and %d.",
+                          MAX_CPU_SHARDING_FACTOR));
+            num_cpu_shards = n;
+        }
+
         counted_t<const db_t> db;
         name_string_t tbl_name;
         if (args->num_args() == 1) {
@@ -217,6 +230,7 @@ private:
                     config_params,
                     primary_key,
                     durability,
+                    num_cpu_shards,
                     env->env->interruptor,
                     &result,
                     &error)) {
@@ -697,7 +711,7 @@ private:
 class rebalance_term_t : public table_or_db_meta_term_t {
 public:
     rebalance_term_t(compile_env_t *env, const raw_term_t &term)
-        : table_or_db_meta_term_t(env, term, optargspec_t({})) { }
+        : table_or_db_meta_term_t(env, term, optargspec_t({"mode"})) { }
 private:
     virtual scoped_ptr_t<val_t> eval_impl_on_table_or_db(
             scope_env_t *env, args_t *args, eval_flags_t,
@@ -708,6 +722,19 @@ private:
 	  rfail(base_exc_t::LOGIC, "`rebalance` can only be called on a table or database.");
         }
 
+        rebalance_mode_t mode = rebalance_mode_t::SIZE;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "mode")) {
+            datum_string_t mode_str = v->as_str();
+            if (mode_str == "size") {
+                mode = rebalance_mode_t::SIZE;
+            } else if (mode_str == "load") {
+                mode = rebalance_mode_t::LOAD;
+            } else {
+                rfail_target(v.get(), base_exc_t::LOGIC,
+                    "`mode` should be \"size\" or \"load\"");
+            }
+        }
+
         ql::datum_t result;
         bool success;
         admin_err_t error;
@@ -717,6 +744,7 @@ private:
                     env->env->get_user_context(),
                     db,
                     *name_if_table,
+                    mode,
                     env->env->interruptor,
                     &result,
                     &error);
@@ -724,6 +752,7 @@ private:
                 success = env->env->reql_cluster_interface()->db_rebalance(
                     env->env->get_user_context(),
                     db,
+                    mode,
                     env->env->interruptor,
                     &result,
                     &error);
@@ -821,11 +850,18 @@ private:
     }
 };
 
+/* The staleness bound of `read_mode="bounded"` if the query doesn't give one. */
+static const int64_t DEFAULT_MAX_STALENESS_MS = 1000;
+/* Larger bounds would overflow when converted to milliseconds and ticks, and a day is
+already far beyond any useful bound. */
+static const double MAX_MAX_STALENESS_SECS = 86400;
+
 class table_term_t : public op_term_t {
 public:
     table_term_t(compile_env_t *env, const raw_term_t &term)
         : op_term_t(env, term, argspec_t(1, 2),
-                    optargspec_t({"read_mode", "use_outdated", "identifier_format"})) { }
+                    optargspec_t({"read_mode", "use_outdated", "identifier_format",
+                                  "max_staleness"})) { }
 private:
     virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
         read_mode_t read_mode = read_mode_t::SINGLE;
@@ -842,15 +878,32 @@ private:
                 read_mode = read_mode_t::SINGLE;
             } else if (str == "outdated") {
                 read_mode = read_mode_t::OUTDATED;
+            } else if (str == "bounded") {
+                read_mode = read_mode_t::BOUNDED;
             } else if (str == "_debug_direct") {
                 read_mode = read_mode_t::DEBUG_DIRECT;
             } else {
                 rfail(base_exc_t::LOGIC, "Read mode `%s` unrecognized (options "
-                      "are \"majority\", \"single\", and \"outdated\").",
+                      "are \"majority\", \"single\", \"outdated\", and "
+                      "\"bounded\").",
                       str.to_std().c_str());
             }
         }
 
+        // The staleness bound for `read_mode="bounded"`, given in seconds.
+        int64_t max_staleness_ms = DEFAULT_MAX_STALENESS_MS;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "max_staleness")) {
+            rcheck(read_mode == read_mode_t::BOUNDED, base_exc_t::LOGIC,
+                   "The `max_staleness` optarg requires `read_mode=\"bounded\"`.");
+            double secs = v->as_num();
+            rcheck(secs >= 0, base_exc_t::LOGIC,
+                   "`max_staleness` must not be negative.");
+            rcheck(secs <= MAX_MAX_STALENESS_SECS, base_exc_t::LOGIC,
+                   strprintf("`max_staleness` must not be greater than %.0f seconds.",
+                             MAX_MAX_STALENESS_SECS));
+            max_staleness_ms = static_cast<int64_t>(secs * 1000);
+        }
+
         optional<admin_identifier_format_t> identifier_format;
         if (scoped_ptr_t<val_t> v = args->optarg(env, "identifier_format")) {
             const datum_string_t &str = v->as_str();
@@ -883,6 +936,9 @@ private:
                 identifier_format, env->env->interruptor, &table, &error)) {
             REQL_RETHROW(error);
         }
+        if (read_mode == read_mode_t::BOUNDED) {
+            table->set_max_staleness_ms(max_staleness_ms);
+        }
         return new_val(make_counted<table_t>(
             std::move(table), db, table_name.str(), read_mode, backtrace()));
     }
@@ -545,6 +545,7 @@ public:
             env, term, argspec_t(1),
             optargspec_t({"squash",
                           "changefeed_queue_size",
+                          "changefeed_queue_spill",
                           "include_initial",
                           "include_offsets",
                           "include_states",
@@ -585,6 +586,11 @@ private:
             include_offsets = v->as_bool();
         }
 
+        bool spill_to_disk = false;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "changefeed_queue_spill")) {
+            spill_to_disk = v->as_bool();
+        }
+
         scoped_ptr_t<val_t> v = args->arg(env, 0);
         configured_limits_t limits = env->env->limits_with_changefeed_queue_size(
                 args->optarg(env, "changefeed_queue_size"));
@@ -610,6 +616,7 @@ private:
                             include_offsets,
                             include_states,
                             include_types,
+                            spill_to_disk,
                             limits,
                             squash,
                             std::move(changespec.keyspec.spec)),
@@ -644,6 +651,7 @@ private:
                         include_offsets,
                         include_states,
                         include_types,
+                        spill_to_disk,
                         limits,
                         squash,
                         sel->get_spec()),
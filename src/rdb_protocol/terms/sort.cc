@@ -4,6 +4,7 @@
 #include <string>
 #include <utility>
 
+#include "concurrency/cpu_work_pool.hpp"
 #include "rdb_protocol/datum_stream.hpp"
 #include "rdb_protocol/datum_stream/array.hpp"
 #include "rdb_protocol/datum_stream/indexed_sort.hpp"
@@ -106,6 +107,7 @@ private:
             rcheck(!comparisons.empty(), base_exc_t::LOGIC,
                    "Must specify something to order by.");
             std::vector<datum_t> to_sort;
+            memory_charge_t charge(env->env->memory_tracker());
             batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
             for (;;) {
                 std::vector<datum_t> data
@@ -113,12 +115,30 @@ private:
                 if (data.size() == 0) {
                     break;
                 }
+                for (const datum_t &d : data) {
+                    charge.add(d);
+                }
                 std::move(data.begin(), data.end(), std::back_inserter(to_sort));
                 rcheck_array_size(to_sort, env->env->limits());
             }
             profile::sampler_t sampler("Sorting in-memory.", env->env->trace);
-            auto fn = std::bind(lt_cmp, env->env, &sampler, ph::_1, ph::_2);
-            std::stable_sort(to_sort.begin(), to_sort.end(), fn);
+            if (to_sort.size() < MIN_PARALLEL_SORT_SIZE) {
+                auto fn = std::bind(lt_cmp, env->env, &sampler, ph::_1, ph::_2);
+                std::stable_sort(to_sort.begin(), to_sort.end(), fn);
+            } else {
+                // For large arrays, we compute the sort keys of each row once on
+                // this thread, so the sort itself can be spread over idle threads.
+                std::vector<keyed_datum_t> keyed;
+                keyed.reserve(to_sort.size());
+                for (datum_t &d : to_sort) {
+                    keyed.push_back(lt_cmp.make_keyed(env->env, std::move(d)));
+                    sampler.new_sample();
+                }
+                parallel_stable_sort(&keyed, lt_cmp);
+                for (size_t i = 0; i < keyed.size(); ++i) {
+                    to_sort[i] = std::move(keyed[i].datum);
+                }
+            }
             seq = make_counted<array_datum_stream_t>(
                 datum_t(std::move(to_sort), env->env->limits()),
                 backtrace());
@@ -169,13 +189,17 @@ private:
         // The reql_version matters here, because we copy `results` into `toret`
         // in ascending order.
         std::set<datum_t, optional_datum_less_t> results;
+        memory_charge_t charge(env->env->memory_tracker());
         batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
         {
             profile::sampler_t sampler("Evaluating elements in distinct.",
                                        env->env->trace);
             datum_t d;
             while (d = s->next(env->env, batchspec), d.has()) {
-                results.insert(std::move(d));
+                auto res = results.insert(std::move(d));
+                if (res.second) {
+                    charge.add(*res.first);
+                }
                 rcheck_array_size(results, env->env->limits());
                 sampler.new_sample();
             }
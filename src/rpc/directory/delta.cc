@@ -0,0 +1,49 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rpc/directory/delta.hpp"
+
+#include <algorithm>
+
+directory_delta_t compute_directory_delta(
+        const std::vector<char> &old_bytes,
+        const std::vector<char> &new_bytes) {
+    const size_t max_common = std::min(old_bytes.size(), new_bytes.size());
+    size_t prefix_size = 0;
+    while (prefix_size < max_common
+            && old_bytes[prefix_size] == new_bytes[prefix_size]) {
+        ++prefix_size;
+    }
+    /* The prefix and the suffix must not overlap in either version. */
+    size_t suffix_size = 0;
+    while (prefix_size + suffix_size < max_common
+            && old_bytes[old_bytes.size() - suffix_size - 1]
+                == new_bytes[new_bytes.size() - suffix_size - 1]) {
+        ++suffix_size;
+    }
+
+    directory_delta_t delta;
+    delta.prefix_size = prefix_size;
+    delta.suffix_size = suffix_size;
+    delta.middle.assign(new_bytes.begin() + prefix_size,
+                        new_bytes.end() - suffix_size);
+    return delta;
+}
+
+bool apply_directory_delta(
+        const std::vector<char> &old_bytes,
+        const directory_delta_t &delta,
+        std::vector<char> *new_bytes_out) {
+    if (delta.prefix_size > old_bytes.size()
+            || delta.suffix_size > old_bytes.size() - delta.prefix_size) {
+        return false;
+    }
+    new_bytes_out->clear();
+    new_bytes_out->reserve(
+        delta.prefix_size + delta.middle.size() + delta.suffix_size);
+    new_bytes_out->insert(new_bytes_out->end(),
+                          old_bytes.begin(), old_bytes.begin() + delta.prefix_size);
+    new_bytes_out->insert(new_bytes_out->end(),
+                          delta.middle.begin(), delta.middle.end());
+    new_bytes_out->insert(new_bytes_out->end(),
+                          old_bytes.end() - delta.suffix_size, old_bytes.end());
+    return true;
+}
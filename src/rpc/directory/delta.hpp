@@ -0,0 +1,41 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RPC_DIRECTORY_DELTA_HPP_
+#define RPC_DIRECTORY_DELTA_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "errors.hpp"
+
+/* The directory map managers send every value as its serialized bytes. Once a peer
+has one version of a value, the next version can be sent as the difference to it: the
+sizes of the prefix and the suffix that both versions have in common, and the bytes in
+between. A change to a `table_manager_bcard_t` usually only touches a few fields, so
+that's much smaller than the whole value. */
+
+/* Each message of a directory map manager carries one of these codes after the key. A
+deletion has nothing after it, a full value has its version and bytes, and a delta has
+the version it's based on, the new version and a `directory_delta_t`. */
+const uint8_t directory_map_value_deleted = 'D';
+const uint8_t directory_map_value_full = 'F';
+const uint8_t directory_map_value_delta = 'd';
+
+struct directory_delta_t {
+    uint64_t prefix_size;
+    uint64_t suffix_size;
+    std::vector<char> middle;
+};
+
+directory_delta_t compute_directory_delta(
+    const std::vector<char> &old_bytes,
+    const std::vector<char> &new_bytes);
+
+/* Returns `false` if the delta wasn't computed from `old_bytes`, as far as we can
+tell. */
+MUST_USE bool apply_directory_delta(
+    const std::vector<char> &old_bytes,
+    const directory_delta_t &delta,
+    std::vector<char> *new_bytes_out);
+
+#endif /* RPC_DIRECTORY_DELTA_HPP_ */
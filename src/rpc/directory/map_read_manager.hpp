@@ -2,6 +2,10 @@
 #ifndef RPC_DIRECTORY_MAP_READ_MANAGER_HPP_
 #define RPC_DIRECTORY_MAP_READ_MANAGER_HPP_
 
+#include <map>
+#include <utility>
+#include <vector>
+
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/one_per_thread.hpp"
 #include "concurrency/watchable_map.hpp"
@@ -22,6 +26,11 @@ public:
     }
 
 private:
+    /* The serialized version of every value that we last received over a connection,
+    so that the writer can send us deltas against it. This isn't needed for loopback
+    connections, because the writer always sends full values over those. */
+    typedef std::map<key_t, std::pair<uint64_t, std::vector<char> > > conn_values_t;
+
     void on_message(
             connectivity_cluster_t::connection_t *connection,
             auto_drainer_t::lock_t connection_keepalive,
@@ -34,10 +43,19 @@ private:
             uint64_t timestamp,
             const key_t &key,
             const optional<value_t> &value);
+    void clean_up_conn_values(
+            connectivity_cluster_t::connection_t *connection,
+            auto_drainer_t::lock_t connection_keepalive,
+            auto_drainer_t::lock_t this_keepalive);
 
     watchable_map_var_t<std::pair<peer_id_t, key_t>, value_t> map_var;
     std::map<peer_id_t, std::map<key_t, uint64_t> > timestamps;
 
+    /* `on_message()` is called on the connection's thread, so this is kept per thread.
+    An entry is removed by `clean_up_conn_values()` when the connection goes away. */
+    one_per_thread_t<std::map<connectivity_cluster_t::connection_t *, conn_values_t> >
+        conn_values;
+
     /* Instances of `do_update()` hold a lock on one of these drainers. */
     one_per_thread_t<auto_drainer_t> per_thread_drainers;
 };
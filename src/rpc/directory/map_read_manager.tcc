@@ -6,6 +6,9 @@
 
 #include "concurrency/wait_any.hpp"
 #include "containers/archive/optional.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "rpc/directory/delta.hpp"
 
 template<class key_t, class value_t>
 directory_map_read_manager_t<key_t, value_t>::directory_map_read_manager_t(
@@ -38,11 +41,95 @@ void directory_map_read_manager_t<key_t, value_t>::on_message(
     if (res != archive_result_t::SUCCESS) {
         throw fake_archive_exc_t();
     }
-    optional<value_t> value;
-    res = deserialize<cluster_version_t::CLUSTER>(s, &value);
+    uint8_t kind;
+    res = deserialize<cluster_version_t::CLUSTER>(s, &kind);
     if (res != archive_result_t::SUCCESS) {
         throw fake_archive_exc_t();
     }
+
+    conn_values_t *values = nullptr;
+    if (!connection->is_loopback()) {
+        auto pair = conn_values.get()->insert(
+            std::make_pair(connection, conn_values_t()));
+        if (pair.second) {
+            coro_t::spawn_sometime(std::bind(
+                &directory_map_read_manager_t::clean_up_conn_values, this,
+                connection, connection_keepalive,
+                auto_drainer_t::lock_t(per_thread_drainers.get())));
+        }
+        values = &pair.first->second;
+    }
+
+    optional<value_t> value;
+    if (kind == directory_map_value_deleted) {
+        if (values != nullptr) {
+            values->erase(key);
+        }
+    } else {
+        uint64_t version;
+        std::vector<char> bytes;
+        if (kind == directory_map_value_full) {
+            res = deserialize<cluster_version_t::CLUSTER>(s, &version);
+            if (res != archive_result_t::SUCCESS) {
+                throw fake_archive_exc_t();
+            }
+            res = deserialize<cluster_version_t::CLUSTER>(s, &bytes);
+            if (res != archive_result_t::SUCCESS) {
+                throw fake_archive_exc_t();
+            }
+        } else if (kind == directory_map_value_delta) {
+            uint64_t base_version;
+            directory_delta_t delta;
+            res = deserialize<cluster_version_t::CLUSTER>(s, &base_version);
+            if (res == archive_result_t::SUCCESS) {
+                res = deserialize<cluster_version_t::CLUSTER>(s, &version);
+            }
+            if (res == archive_result_t::SUCCESS) {
+                res = deserialize<cluster_version_t::CLUSTER>(s, &delta.prefix_size);
+            }
+            if (res == archive_result_t::SUCCESS) {
+                res = deserialize<cluster_version_t::CLUSTER>(s, &delta.suffix_size);
+            }
+            if (res == archive_result_t::SUCCESS) {
+                res = deserialize<cluster_version_t::CLUSTER>(s, &delta.middle);
+            }
+            if (res != archive_result_t::SUCCESS) {
+                throw fake_archive_exc_t();
+            }
+            /* The writer only sends a delta if it knows which version we have. If we
+            don't have it after all, something went wrong; dropping the connection makes
+            the writer start over with full values. */
+            if (values == nullptr) {
+                throw fake_archive_exc_t();
+            }
+            auto it = values->find(key);
+            if (it == values->end() || it->second.first != base_version) {
+                throw fake_archive_exc_t();
+            }
+            if (!apply_directory_delta(it->second.second, delta, &bytes)) {
+                throw fake_archive_exc_t();
+            }
+        } else {
+            throw fake_archive_exc_t();
+        }
+
+        value.set(value_t());
+        {
+            vector_read_stream_t value_stream(std::move(bytes));
+            res = deserialize<cluster_version_t::CLUSTER>(&value_stream, &value.get());
+            if (res != archive_result_t::SUCCESS) {
+                throw fake_archive_exc_t();
+            }
+            if (values != nullptr) {
+                int64_t pos;
+                value_stream.swap(&bytes, &pos);
+            }
+        }
+        if (values != nullptr) {
+            (*values)[key] = std::make_pair(version, std::move(bytes));
+        }
+    }
+
     auto_drainer_t::lock_t this_keepalive(per_thread_drainers.get());
     coro_t::spawn_sometime(std::bind(
         &directory_map_read_manager_t::do_update, this,
@@ -113,5 +200,19 @@ void directory_map_read_manager_t<key_t, value_t>::do_update(
     }
 }
 
+template<class key_t, class value_t>
+void directory_map_read_manager_t<key_t, value_t>::clean_up_conn_values(
+        connectivity_cluster_t::connection_t *connection,
+        auto_drainer_t::lock_t connection_keepalive,
+        auto_drainer_t::lock_t this_keepalive) {
+    /* We hold `connection_keepalive` until the entry is gone, so the connection can't be
+    destroyed and a new one can't get the same address in the meantime. */
+    wait_any_t waiter(
+        connection_keepalive.get_drain_signal(),
+        this_keepalive.get_drain_signal());
+    waiter.wait_lazily_unordered();
+    conn_values.get()->erase(connection);
+}
+
 #endif   /* RPC_DIRECTORY_MAP_READ_MANAGER_TCC_ */
 
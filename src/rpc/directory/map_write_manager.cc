@@ -3,6 +3,7 @@
 #include "rpc/directory/map_write_manager.tcc"
 
 template class directory_map_write_manager_t<int, int>;
+template class directory_map_write_manager_t<int, std::string>;
 
 #include "clustering/table_manager/table_metadata.hpp"
 template class directory_map_write_manager_t<
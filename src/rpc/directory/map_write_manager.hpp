@@ -2,6 +2,11 @@
 #ifndef RPC_DIRECTORY_WRITE_MAP_MANAGER_HPP_
 #define RPC_DIRECTORY_WRITE_MAP_MANAGER_HPP_
 
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/new_semaphore.hpp"
 #include "concurrency/watchable_map.hpp"
@@ -15,16 +20,37 @@ public:
         connectivity_cluster_t::message_tag_t message_tag,
         watchable_map_t<key_t, value_t> *value);
 
+    /* How many updates have been sent as deltas rather than full values. This is for
+    the unit tests. */
+    uint64_t get_num_deltas_sent() const {
+        return num_deltas_sent;
+    }
+
 private:
     /* For each connection, we have an instance of `conn_info_t` in `conns` and a
     corresponding `stream_to_conn()` coroutine. `on_connections_change()` is responsible
     for creating the `conn_info_t` and spawning the coroutine; the coroutine is
     responsible for stopping itself and removing the `conn_info_t`. The coroutine's job
     is to check for keys marked as dirty in `dirty_keys` and send those key-value pairs
-    over the network. */
+    over the network.
+
+    Every value is serialized once when it changes, and stored in `encoded_values`
+    together with the previous version. If a peer already has the previous version, we
+    only send the difference between the two (see `rpc/directory/delta.hpp`). A new
+    connection starts out without any versions, so it gets the full values. */
 
     class update_writer_t;
 
+    class encoded_value_t {
+    public:
+        encoded_value_t() : version(0), prev_version(0) { }
+        uint64_t version;
+        std::shared_ptr<const std::vector<char> > bytes;
+        /* `prev_version` is zero if there's no previous version. */
+        uint64_t prev_version;
+        std::shared_ptr<const std::vector<char> > prev_bytes;
+    };
+
     class conn_info_t {
     public:
         conn_info_t() : pulse_on_dirty(nullptr) { }
@@ -32,8 +58,12 @@ private:
         and `pulse_on_dirty` will be pulsed if it is non-null. */
         std::set<key_t> dirty_keys;
         cond_t *pulse_on_dirty;
+        /* The version of each value that we last sent to the peer. */
+        std::map<key_t, uint64_t> sent_versions;
     };
 
+    void encode_value(const key_t &key, const value_t *new_value);
+
     void on_connection_change(
         const peer_id_t &peer_id,
         const connectivity_cluster_t::connection_pair_t *pair);
@@ -50,6 +80,8 @@ private:
 
     std::map<connectivity_cluster_t::connection_t *, conn_info_t> conns;
     uint64_t timestamp;
+    std::map<key_t, encoded_value_t> encoded_values;
+    uint64_t num_deltas_sent;
 
     /* Destructor order is important here. First we must destroy the subscriptions, so
     that they don't initiate any new coroutines that would need to lock `drainer`. Then
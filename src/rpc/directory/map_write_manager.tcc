@@ -6,6 +6,9 @@
 
 #include "concurrency/wait_any.hpp"
 #include "containers/archive/optional.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "rpc/directory/delta.hpp"
 
 template<class key_t, class value_t>
 directory_map_write_manager_t<key_t, value_t>::directory_map_write_manager_t(
@@ -16,9 +19,11 @@ directory_map_write_manager_t<key_t, value_t>::directory_map_write_manager_t(
     message_tag(_message_tag),
     value(_value),
     timestamp(0),
+    num_deltas_sent(0),
     value_subs(value,
-        [this](const key_t &key, const value_t *) {
+        [this](const key_t &key, const value_t *new_value) {
             ++this->timestamp;
+            this->encode_value(key, new_value);
             for (auto &pair : conns) {
                 pair.second.dirty_keys.insert(key);
                 if (pair.second.pulse_on_dirty != nullptr) {
@@ -34,6 +39,39 @@ directory_map_write_manager_t<key_t, value_t>::directory_map_write_manager_t(
             this, ph::_1, ph::_2),
         initial_call_t::YES)
 {
+    value->read_all([&](const key_t &key, const value_t *v) {
+        encode_value(key, v);
+    });
+}
+
+template<class key_t, class value_t>
+void directory_map_write_manager_t<key_t, value_t>::encode_value(
+        const key_t &key, const value_t *new_value) {
+    if (new_value == nullptr) {
+        encoded_values.erase(key);
+        return;
+    }
+
+    write_message_t wm;
+    serialize<cluster_version_t::CLUSTER>(&wm, *new_value);
+    vector_stream_t stream;
+    stream.reserve(wm.size());
+    int res = send_write_message(&stream, &wm);
+    guarantee(res == 0);
+    auto bytes = std::make_shared<std::vector<char> >();
+    stream.swap(bytes.get());
+
+    encoded_value_t *encoded = &encoded_values[key];
+    if (encoded->bytes && *encoded->bytes == *bytes) {
+        /* Peers that have the current version don't need to hear about this. */
+        return;
+    }
+    encoded->prev_version = encoded->version;
+    encoded->prev_bytes = std::move(encoded->bytes);
+    /* `timestamp` increases with every change, so this is a fresh version. The `+ 1`
+    keeps versions that are encoded in the constructor from being zero. */
+    encoded->version = timestamp + 1;
+    encoded->bytes = std::move(bytes);
 }
 
 template<class key_t, class value_t>
@@ -41,15 +79,40 @@ class directory_map_write_manager_t<key_t, value_t>::update_writer_t :
     public cluster_send_message_write_callback_t
 {
 public:
+    /* Constructs a deletion. */
+    update_writer_t(uint64_t _timestamp, const key_t &_key) :
+        timestamp(_timestamp), key(_key), kind(directory_map_value_deleted),
+        base_version(0), version(0) { }
+
+    /* Constructs a message that carries the full value. */
     update_writer_t(
-            uint64_t _timestamp, const key_t &_key, optional<value_t> &&_value) :
-        timestamp(_timestamp), key(_key), value(std::move(_value)) { }
+            uint64_t _timestamp, const key_t &_key, uint64_t _version,
+            const std::shared_ptr<const std::vector<char> > &_bytes) :
+        timestamp(_timestamp), key(_key), kind(directory_map_value_full),
+        base_version(0), version(_version), bytes(_bytes) { }
+
+    /* Constructs a message that carries the difference to `_base_version`. */
+    update_writer_t(
+            uint64_t _timestamp, const key_t &_key, uint64_t _base_version,
+            uint64_t _version, directory_delta_t &&_delta) :
+        timestamp(_timestamp), key(_key), kind(directory_map_value_delta),
+        base_version(_base_version), version(_version), delta(std::move(_delta)) { }
 
     void write(write_stream_t *s) {
         write_message_t wm;
         serialize<cluster_version_t::CLUSTER>(&wm, timestamp);
         serialize<cluster_version_t::CLUSTER>(&wm, key);
-        serialize<cluster_version_t::CLUSTER>(&wm, value);
+        serialize<cluster_version_t::CLUSTER>(&wm, kind);
+        if (kind == directory_map_value_full) {
+            serialize<cluster_version_t::CLUSTER>(&wm, version);
+            serialize<cluster_version_t::CLUSTER>(&wm, *bytes);
+        } else if (kind == directory_map_value_delta) {
+            serialize<cluster_version_t::CLUSTER>(&wm, base_version);
+            serialize<cluster_version_t::CLUSTER>(&wm, version);
+            serialize<cluster_version_t::CLUSTER>(&wm, delta.prefix_size);
+            serialize<cluster_version_t::CLUSTER>(&wm, delta.suffix_size);
+            serialize<cluster_version_t::CLUSTER>(&wm, delta.middle);
+        }
         int res = send_write_message(s, &wm);
         if (res) {
             throw fake_archive_exc_t();
@@ -67,7 +130,11 @@ public:
 private:
     uint64_t timestamp;
     key_t key;
-    optional<value_t> value;
+    uint8_t kind;
+    uint64_t base_version;
+    uint64_t version;
+    std::shared_ptr<const std::vector<char> > bytes;
+    directory_delta_t delta;
 };
 
 template<class key_t, class value_t>
@@ -123,7 +190,50 @@ void directory_map_write_manager_t<key_t, value_t>::stream_to_conn(
                 time as we copied `dirty_keys`. So it's OK to remove the key from
                 `dirty_keys` to prevent sending a redundant message. */
                 conns_entry->second.dirty_keys.erase(key);
-                update_writer_t writer(timestamp, key, value->get_key(key));
+                std::map<key_t, uint64_t> *sent_versions =
+                    &conns_entry->second.sent_versions;
+                auto it = encoded_values.find(key);
+                if (it == encoded_values.end()) {
+                    if (sent_versions->erase(key) == 0) {
+                        /* The peer never heard of this key */
+                        continue;
+                    }
+                    update_writer_t writer(timestamp, key);
+                    connectivity_cluster->send_message(
+                        connection, connection_keepalive, message_tag, &writer);
+                    continue;
+                }
+                /* Copy what we need, because `send_message()` may block and the value
+                may change in the meantime. */
+                encoded_value_t encoded = it->second;
+                auto sent_it = sent_versions->find(key);
+                optional<uint64_t> sent_version;
+                if (sent_it != sent_versions->end()) {
+                    sent_version.set(sent_it->second);
+                }
+                if (sent_version == make_optional(encoded.version)) {
+                    continue;
+                }
+                (*sent_versions)[key] = encoded.version;
+
+                /* Loopback messages are never serialized, so there's nothing to save
+                by sending a delta. */
+                if (!connection->is_loopback() &&
+                        encoded.prev_version != 0 &&
+                        sent_version == make_optional(encoded.prev_version)) {
+                    directory_delta_t delta =
+                        compute_directory_delta(*encoded.prev_bytes, *encoded.bytes);
+                    if (delta.middle.size() + 2 * sizeof(uint64_t)
+                            < encoded.bytes->size()) {
+                        update_writer_t writer(timestamp, key, encoded.prev_version,
+                            encoded.version, std::move(delta));
+                        ++num_deltas_sent;
+                        connectivity_cluster->send_message(
+                            connection, connection_keepalive, message_tag, &writer);
+                        continue;
+                    }
+                }
+                update_writer_t writer(timestamp, key, encoded.version, encoded.bytes);
                 connectivity_cluster->send_message(
                     connection, connection_keepalive, message_tag, &writer);
             }
@@ -1,6 +1,8 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "serializer/log/lba/lba_list.hpp"
 
+#include <algorithm>
+
 #include "utils.hpp"
 #include "serializer/log/lba/disk_format.hpp"
 #include "arch/arch.hpp"
@@ -169,13 +171,14 @@ repli_timestamp_t lba_list_t::get_block_recency(block_id_t block) {
 }
 
 segmented_vector_t<repli_timestamp_t> lba_list_t::get_block_recencies(block_id_t first,
-                                                                      block_id_t step) {
+                                                                      block_id_t step,
+                                                                      block_id_t end) {
     guarantee(coro_t::self() != nullptr);
     rassert(state == state_ready);
     segmented_vector_t<repli_timestamp_t> ret;
     // Note that we deliberately don't report recencies for aux blocks.
     // (those don't have valid recency values anyway)
-    block_id_t end = in_memory_index.end_block_id();
+    end = std::min(end, in_memory_index.end_block_id());
     block_id_t count = 0;
     for (block_id_t i = first; i < end; i += step) {
         ++count;
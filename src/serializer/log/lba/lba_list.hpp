@@ -46,8 +46,11 @@ public:
     uint16_t get_ser_block_size(block_id_t block);
     block_size_t get_block_size(block_id_t block);
     repli_timestamp_t get_block_recency(block_id_t block);
+    // Returns the recencies of `first + step * k` for every such block ID below
+    // `end`.  Blocks beyond `end_block_id()` are left out.
     segmented_vector_t<repli_timestamp_t> get_block_recencies(block_id_t first,
-                                                              block_id_t step);
+                                                              block_id_t step,
+                                                              block_id_t end);
 
     /* Returns a block ID such that all blocks that exist are guaranteed to have IDs
     less than that block ID. */
@@ -808,7 +808,14 @@ bool log_serializer_t::get_delete_bit(block_id_t id) {
 segmented_vector_t<repli_timestamp_t>
 log_serializer_t::get_all_recencies(block_id_t first, block_id_t step) {
     assert_thread();
-    return lba_index->get_block_recencies(first, step);
+    return lba_index->get_block_recencies(first, step, lba_index->end_block_id());
+}
+
+segmented_vector_t<repli_timestamp_t>
+log_serializer_t::get_recencies_in_range(block_id_t first, block_id_t step,
+                                         block_id_t end) {
+    assert_thread();
+    return lba_index->get_block_recencies(first, step, end);
 }
 
 void log_serializer_t::shutdown(cond_t *cb) {
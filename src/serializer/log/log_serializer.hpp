@@ -130,6 +130,9 @@ public:
     block_id_t end_aux_block_id();
     segmented_vector_t<repli_timestamp_t> get_all_recencies(block_id_t first,
                                                             block_id_t step);
+    segmented_vector_t<repli_timestamp_t> get_recencies_in_range(block_id_t first,
+                                                                 block_id_t step,
+                                                                 block_id_t end);
 
     bool get_delete_bit(block_id_t id);
     counted_t<block_token_t> index_read(block_id_t block_id);
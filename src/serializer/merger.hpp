@@ -79,6 +79,12 @@ public:
         return inner->get_all_recencies(first, step);
     }
 
+    segmented_vector_t<repli_timestamp_t> get_recencies_in_range(block_id_t first,
+                                                                 block_id_t step,
+                                                                 block_id_t end) {
+        return inner->get_recencies_in_range(first, step, end);
+    }
+
     /* Reads the block's delete bit. */
     bool get_delete_bit(block_id_t id) { return inner->get_delete_bit(id); }
 
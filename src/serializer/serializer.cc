@@ -17,6 +17,16 @@ file_account_t *serializer_t::make_io_account(int priority) {
     return make_io_account(priority, UNLIMITED_OUTSTANDING_REQUESTS);
 }
 
+segmented_vector_t<repli_timestamp_t> serializer_t::get_recencies_in_range(
+        block_id_t first, block_id_t step, block_id_t end) {
+    segmented_vector_t<repli_timestamp_t> all = get_all_recencies(first, step);
+    segmented_vector_t<repli_timestamp_t> ret;
+    for (size_t i = 0; i < all.size() && first + i * step < end; ++i) {
+        ret.push_back(all[i]);
+    }
+    return ret;
+}
+
 ser_buffer_t *convert_buffer_cache_buf_to_ser_buffer(const void *buf) {
     return static_cast<ser_buffer_t *>(const_cast<void *>(buf)) - 1;
 }
@@ -92,6 +92,11 @@ public:
         return get_all_recencies(0, 1);
     }
 
+    /* Like `get_all_recencies(first, step)`, but stops before `end`.  The default
+       implementation gets all of the recencies and drops the ones past `end`. */
+    virtual segmented_vector_t<repli_timestamp_t>
+    get_recencies_in_range(block_id_t first, block_id_t step, block_id_t end);
+
     /* Reads the block's delete bit.  You must only call this on startup, before
        _writing_ a block to this serializer_t instance, because otherwise the
        information you get back could be wrong. */
@@ -0,0 +1,512 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/shared.hpp"
+
+#include <algorithm>
+
+#include "arch/runtime/coroutines.hpp"
+#include "concurrency/cond_var.hpp"
+#include "debug.hpp"
+#include "math.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/types.hpp"
+
+const block_magic_t shared_serializer_config_block_t::expected_magic =
+    { { 's', 'h', 'r', 'd' } };
+
+// Block ID 0 holds the config block; the chunk table starts right after it.
+const block_id_t SHARED_SERIALIZER_CONFIG_BLOCK_ID = 0;
+
+// The reserved block IDs form the first global chunks of the regular space.
+const uint64_t FIRST_REGULAR_CHUNK =
+    SHARED_SERIALIZER_RESERVED_IDS / SHARED_SERIALIZER_CHUNK_SIZE;
+
+// The chunk table blocks of the groups of chunks before this one are in the reserved
+// block IDs, two per group. The later ones are in table chunks; see `table_block_id()`.
+const uint64_t FIRST_OVERFLOW_TABLE_GROUP =
+    (SHARED_SERIALIZER_RESERVED_IDS - SHARED_SERIALIZER_CONFIG_BLOCK_ID - 1) / 2;
+
+static void write_blocks_and_wait(serializer_t *ser,
+                                  const std::vector<buf_ptr_t> &bufs,
+                                  const std::vector<block_id_t> &block_ids,
+                                  std::vector<index_write_op_t> *ops_out) {
+    struct : public cond_t, public iocallback_t {
+        void on_io_complete() { pulse(); }
+    } cb;
+    std::vector<buf_write_info_t> infos;
+    for (size_t i = 0; i < bufs.size(); ++i) {
+        infos.push_back(buf_write_info_t(bufs[i].ser_buffer(), bufs[i].block_size(),
+                                         block_ids[i]));
+    }
+    std::vector<counted_t<block_token_t> > tokens
+        = ser->block_writes(infos, DEFAULT_DISK_ACCOUNT, &cb);
+    guarantee(tokens.size() == bufs.size());
+    cb.wait();
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        ops_out->push_back(index_write_op_t(block_ids[i],
+                                            make_optional(tokens[i]),
+                                            make_optional(repli_timestamp_t::invalid)));
+    }
+}
+
+/* shared_serializer_t */
+
+void shared_serializer_t::create(serializer_t *inner) {
+    on_thread_t thread_switcher(inner->home_thread());
+
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(inner->max_block_size());
+    shared_serializer_config_block_t *c
+        = static_cast<shared_serializer_config_block_t *>(buf.cache_data());
+    c->magic = shared_serializer_config_block_t::expected_magic;
+    c->chunk_size = SHARED_SERIALIZER_CHUNK_SIZE;
+
+    std::vector<buf_ptr_t> bufs;
+    bufs.push_back(std::move(buf));
+    std::vector<index_write_op_t> ops;
+    write_blocks_and_wait(inner, bufs, { SHARED_SERIALIZER_CONFIG_BLOCK_ID }, &ops);
+
+    new_mutex_in_line_t dummy_acq;  // We don't have ordering concerns between
+                                    // this and any other index_write call.
+    inner->index_write(&dummy_acq, []{ }, ops);
+}
+
+shared_serializer_t::shared_serializer_t(serializer_t *_inner) :
+        inner(_inner),
+        allocated_version(0),
+        persisted_version(0) {
+    assert_thread();
+    rassert(inner->home_thread() == home_thread());
+
+    entries_per_table_block =
+        inner->max_block_size().value() / sizeof(shared_serializer_chunk_entry_t);
+
+    {
+        buf_ptr_t buf = inner->block_read(
+            inner->index_read(SHARED_SERIALIZER_CONFIG_BLOCK_ID), DEFAULT_DISK_ACCOUNT);
+        const shared_serializer_config_block_t *c
+            = static_cast<const shared_serializer_config_block_t *>(buf.cache_data());
+        guarantee(c->magic == shared_serializer_config_block_t::expected_magic,
+                  "c->magic is %s", debug_strprint(c->magic).c_str());
+        guarantee(c->chunk_size == SHARED_SERIALIZER_CHUNK_SIZE);
+    }
+
+    /* Load the chunk table. */
+    for (uint64_t group = 0; group < FIRST_OVERFLOW_TABLE_GROUP; ++group) {
+        load_table_block(REGULAR_SPACE, group);
+        load_table_block(AUX_SPACE, group);
+    }
+    for (uint64_t group = FIRST_OVERFLOW_TABLE_GROUP;
+         table_block_id(REGULAR_SPACE, group) < inner->end_block_id();
+         ++group) {
+        load_table_block(REGULAR_SPACE, group);
+        load_table_block(AUX_SPACE, group);
+    }
+
+    for (int space = REGULAR_SPACE; space <= AUX_SPACE; ++space) {
+        const uint64_t first = space == REGULAR_SPACE ? FIRST_REGULAR_CHUNK : 1;
+        if (owners[space].size() < first) {
+            owners[space].resize(first);
+        }
+        for (uint64_t chunk = first; chunk < owners[space].size(); ++chunk) {
+            if (!owners[space][chunk].used
+                && !(space == REGULAR_SPACE && is_table_chunk(chunk))) {
+                free_chunks[space].insert(chunk);
+            }
+        }
+    }
+}
+
+void shared_serializer_t::load_table_block(space_t space, uint64_t table_group) {
+    const block_id_t id = table_block_id(space, table_group);
+    if (id >= inner->end_block_id()) {
+        return;
+    }
+    counted_t<block_token_t> token = inner->index_read(id);
+    if (!token.has()) {
+        return;
+    }
+    const uint64_t first_chunk = table_group * entries_per_table_block;
+    buf_ptr_t buf = inner->block_read(token, DEFAULT_DISK_ACCOUNT);
+    const shared_serializer_chunk_entry_t *entries
+        = static_cast<const shared_serializer_chunk_entry_t *>(buf.cache_data());
+    for (size_t i = 0; i < entries_per_table_block; ++i) {
+        if (entries[i].ns_plus_one == 0) {
+            continue;
+        }
+        const uint64_t global_chunk = first_chunk + i;
+        if (owners[space].size() <= global_chunk) {
+            owners[space].resize(global_chunk + 1);
+        }
+        chunk_owner_t *owner = &owners[space][global_chunk];
+        owner->used = true;
+        owner->ns = entries[i].ns_plus_one - 1;
+        owner->local_chunk = entries[i].local_chunk;
+
+        std::vector<uint64_t> *chunks = &namespaces[owner->ns].chunks[space];
+        if (chunks->size() <= owner->local_chunk) {
+            chunks->resize(owner->local_chunk + 1, 0);
+        }
+        (*chunks)[owner->local_chunk] = global_chunk;
+    }
+}
+
+shared_serializer_t::~shared_serializer_t() {
+    assert_thread();
+    for (const auto &pair : namespaces) {
+        guarantee(!pair.second.is_open);
+    }
+}
+
+bool shared_serializer_t::namespace_is_empty(serializer_namespace_id_t ns) const {
+    assert_thread();
+    auto it = namespaces.find(ns);
+    if (it == namespaces.end()) {
+        return true;
+    }
+    for (int space = REGULAR_SPACE; space <= AUX_SPACE; ++space) {
+        for (uint64_t chunk : it->second.chunks[space]) {
+            if (chunk != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+namespace_serializer_t *shared_serializer_t::open_namespace(
+        serializer_namespace_id_t ns) {
+    assert_thread();
+    namespace_chunks_t *chunks = &namespaces[ns];
+    guarantee(!chunks->is_open);
+    chunks->is_open = true;
+    return new namespace_serializer_t(this, ns);
+}
+
+void shared_serializer_t::close_namespace(serializer_namespace_id_t ns) {
+    assert_thread();
+    auto it = namespaces.find(ns);
+    guarantee(it != namespaces.end() && it->second.is_open);
+    it->second.is_open = false;
+}
+
+void shared_serializer_t::drop_namespace(serializer_namespace_id_t ns) {
+    assert_thread();
+    new_mutex_acq_t acq(&chunk_table_mutex);
+    auto it = namespaces.find(ns);
+    if (it == namespaces.end()) {
+        return;
+    }
+    guarantee(!it->second.is_open);
+    const uint64_t version = allocated_version;
+
+    /* Delete the blocks and mark the chunks as free in the chunk table. The chunks
+    can't be reused until the index write is done, so they are only put into
+    `free_chunks` afterwards. */
+    std::vector<index_write_op_t> ops;
+    std::vector<uint64_t> dropped_chunks[2];
+    for (int space = REGULAR_SPACE; space <= AUX_SPACE; ++space) {
+        for (uint64_t chunk : it->second.chunks[space]) {
+            if (chunk == 0) {
+                continue;
+            }
+            dropped_chunks[space].push_back(chunk);
+            owners[space][chunk] = chunk_owner_t();
+            dirty_table_blocks.insert(std::make_pair(
+                static_cast<space_t>(space), chunk / entries_per_table_block));
+            for (block_id_t i = 0; i < SHARED_SERIALIZER_CHUNK_SIZE; ++i) {
+                block_id_t id = chunk * SHARED_SERIALIZER_CHUNK_SIZE + i;
+                if (space == AUX_SPACE) {
+                    id += FIRST_AUX_BLOCK_ID;
+                }
+                if (inner->index_read(id).has()) {
+                    ops.push_back(index_write_op_t(
+                        id,
+                        make_optional(counted_t<block_token_t>()),
+                        make_optional(repli_timestamp_t::invalid)));
+                }
+            }
+        }
+    }
+    namespaces.erase(it);
+
+    write_chunk_table(&ops);
+    {
+        new_mutex_in_line_t dummy_acq;
+        inner->index_write(&dummy_acq, []{ }, ops);
+    }
+    persisted_version = std::max(persisted_version, version);
+
+    for (int space = REGULAR_SPACE; space <= AUX_SPACE; ++space) {
+        free_chunks[space].insert(dropped_chunks[space].begin(),
+                                  dropped_chunks[space].end());
+    }
+}
+
+block_id_t shared_serializer_t::table_block_id(space_t space,
+                                               uint64_t table_group) const {
+    if (table_group < FIRST_OVERFLOW_TABLE_GROUP) {
+        return SHARED_SERIALIZER_CONFIG_BLOCK_ID + 1 + 2 * table_group + space;
+    }
+    /* Once the reserved block IDs are used up, the first regular chunk of every group
+    holds the table blocks of that group for both spaces. */
+    return table_group * entries_per_table_block * SHARED_SERIALIZER_CHUNK_SIZE + space;
+}
+
+bool shared_serializer_t::is_table_chunk(uint64_t global_chunk) const {
+    return global_chunk % entries_per_table_block == 0
+        && global_chunk / entries_per_table_block >= FIRST_OVERFLOW_TABLE_GROUP;
+}
+
+block_id_t shared_serializer_t::translate_block_id(serializer_namespace_id_t ns,
+                                                   block_id_t id,
+                                                   bool allocate) {
+    assert_thread();
+    rassert(id != NULL_BLOCK_ID);
+    const space_t space = is_aux_block_id(id) ? AUX_SPACE : REGULAR_SPACE;
+    const block_id_t relative_id =
+        space == AUX_SPACE ? make_aux_block_id_relative(id) : id;
+    const uint64_t local_chunk = relative_id / SHARED_SERIALIZER_CHUNK_SIZE;
+
+    std::vector<uint64_t> *chunks = &namespaces[ns].chunks[space];
+    if (chunks->size() <= local_chunk) {
+        if (!allocate) {
+            return NULL_BLOCK_ID;
+        }
+        chunks->resize(local_chunk + 1, 0);
+    }
+    if ((*chunks)[local_chunk] == 0) {
+        if (!allocate) {
+            return NULL_BLOCK_ID;
+        }
+        uint64_t global_chunk;
+        if (!free_chunks[space].empty()) {
+            global_chunk = *free_chunks[space].begin();
+            free_chunks[space].erase(free_chunks[space].begin());
+        } else {
+            global_chunk = owners[space].size();
+            if (space == REGULAR_SPACE && is_table_chunk(global_chunk)) {
+                ++global_chunk;
+            }
+            owners[space].resize(global_chunk + 1);
+        }
+        dirty_table_blocks.insert(
+            std::make_pair(space, global_chunk / entries_per_table_block));
+        chunk_owner_t *owner = &owners[space][global_chunk];
+        owner->used = true;
+        owner->ns = ns;
+        owner->local_chunk = local_chunk;
+        (*chunks)[local_chunk] = global_chunk;
+        ++allocated_version;
+    }
+
+    const block_id_t inner_id = (*chunks)[local_chunk] * SHARED_SERIALIZER_CHUNK_SIZE
+        + relative_id % SHARED_SERIALIZER_CHUNK_SIZE;
+    return space == AUX_SPACE ? FIRST_AUX_BLOCK_ID + inner_id : inner_id;
+}
+
+block_id_t shared_serializer_t::end_block_id(serializer_namespace_id_t ns,
+                                             space_t space) {
+    assert_thread();
+    const block_id_t first_id = space == AUX_SPACE ? FIRST_AUX_BLOCK_ID : 0;
+    const std::vector<uint64_t> &chunks = namespaces[ns].chunks[space];
+    size_t end_chunk = chunks.size();
+    while (end_chunk > 0 && chunks[end_chunk - 1] == 0) {
+        --end_chunk;
+    }
+
+    // Like `translator_serializer_t`, skip the deleted blocks at the end.
+    block_id_t id = first_id + end_chunk * SHARED_SERIALIZER_CHUNK_SIZE;
+    while (id > first_id) {
+        const block_id_t inner_id = translate_block_id(ns, id - 1, false);
+        if (inner_id != NULL_BLOCK_ID && !inner->get_delete_bit(inner_id)) {
+            break;
+        }
+        --id;
+    }
+    return id;
+}
+
+segmented_vector_t<repli_timestamp_t> shared_serializer_t::get_recencies(
+        serializer_namespace_id_t ns, block_id_t first, block_id_t step) {
+    assert_thread();
+    segmented_vector_t<repli_timestamp_t> ret;
+    const block_id_t end = end_block_id(ns, REGULAR_SPACE);
+    for (block_id_t id = first; id < end; id += step) {
+        ret.push_back(repli_timestamp_t::invalid);
+    }
+
+    /* Look up each chunk's recencies with a single call to the inner serializer,
+    rather than one call per block. */
+    const std::vector<uint64_t> &chunks = namespaces[ns].chunks[REGULAR_SPACE];
+    for (uint64_t local_chunk = 0; local_chunk < chunks.size(); ++local_chunk) {
+        if (chunks[local_chunk] == 0) {
+            continue;
+        }
+        const block_id_t chunk_start = local_chunk * SHARED_SERIALIZER_CHUNK_SIZE;
+        const block_id_t chunk_end =
+            std::min(chunk_start + SHARED_SERIALIZER_CHUNK_SIZE, end);
+        // The first block ID of the form `first + k * step` in the chunk.
+        block_id_t id = first;
+        if (id < chunk_start) {
+            id += ceil_divide(chunk_start - first, step) * step;
+        }
+        if (id >= chunk_end) {
+            continue;
+        }
+        const block_id_t inner_start = chunks[local_chunk] * SHARED_SERIALIZER_CHUNK_SIZE;
+        segmented_vector_t<repli_timestamp_t> recencies = inner->get_recencies_in_range(
+            inner_start + (id - chunk_start),
+            step,
+            inner_start + (chunk_end - chunk_start));
+        const size_t offset = (id - first) / step;
+        for (size_t i = 0; i < recencies.size(); ++i) {
+            ret[offset + i] = recencies[i];
+        }
+    }
+    return ret;
+}
+
+void shared_serializer_t::persist_chunk_table(uint64_t version) {
+    assert_thread();
+    if (persisted_version >= version) {
+        return;
+    }
+    new_mutex_acq_t acq(&chunk_table_mutex);
+    if (persisted_version >= version) {
+        return;
+    }
+    const uint64_t snapshot_version = allocated_version;
+    std::vector<index_write_op_t> ops;
+    write_chunk_table(&ops);
+    {
+        new_mutex_in_line_t dummy_acq;
+        inner->index_write(&dummy_acq, []{ }, ops);
+    }
+    persisted_version = std::max(persisted_version, snapshot_version);
+}
+
+void shared_serializer_t::write_chunk_table(std::vector<index_write_op_t> *ops_out) {
+    std::vector<buf_ptr_t> bufs;
+    std::vector<block_id_t> block_ids;
+    for (const auto &pair : dirty_table_blocks) {
+        const space_t space = pair.first;
+        const uint64_t first_chunk = pair.second * entries_per_table_block;
+        buf_ptr_t buf = buf_ptr_t::alloc_zeroed(inner->max_block_size());
+        shared_serializer_chunk_entry_t *entries
+            = static_cast<shared_serializer_chunk_entry_t *>(buf.cache_data());
+        for (size_t i = 0; i < entries_per_table_block; ++i) {
+            const uint64_t global_chunk = first_chunk + i;
+            if (global_chunk < owners[space].size() && owners[space][global_chunk].used) {
+                entries[i].ns_plus_one = owners[space][global_chunk].ns + 1;
+                entries[i].local_chunk = owners[space][global_chunk].local_chunk;
+            }
+        }
+        bufs.push_back(std::move(buf));
+        block_ids.push_back(table_block_id(space, pair.second));
+    }
+    // Later changes to the chunk table mark their blocks dirty again.
+    dirty_table_blocks.clear();
+
+    if (!bufs.empty()) {
+        write_blocks_and_wait(inner, bufs, block_ids, ops_out);
+    }
+}
+
+/* namespace_serializer_t */
+
+namespace_serializer_t::namespace_serializer_t(shared_serializer_t *_parent,
+                                               serializer_namespace_id_t _ns)
+    : parent(_parent), ns(_ns) { }
+
+namespace_serializer_t::~namespace_serializer_t() {
+    parent->close_namespace(ns);
+}
+
+file_account_t *namespace_serializer_t::make_io_account(int priority,
+                                                        int outstanding_requests_limit) {
+    return parent->inner->make_io_account(priority, outstanding_requests_limit);
+}
+
+void namespace_serializer_t::register_read_ahead_cb(
+        UNUSED serializer_read_ahead_callback_t *cb) { }
+
+void namespace_serializer_t::unregister_read_ahead_cb(
+        UNUSED serializer_read_ahead_callback_t *cb) { }
+
+buf_ptr_t namespace_serializer_t::block_read(const counted_t<block_token_t> &token,
+                                             file_account_t *io_account) {
+    return parent->inner->block_read(token, io_account);
+}
+
+block_id_t namespace_serializer_t::end_block_id() {
+    return parent->end_block_id(ns, shared_serializer_t::REGULAR_SPACE);
+}
+
+block_id_t namespace_serializer_t::end_aux_block_id() {
+    return parent->end_block_id(ns, shared_serializer_t::AUX_SPACE);
+}
+
+segmented_vector_t<repli_timestamp_t>
+namespace_serializer_t::get_all_recencies(block_id_t first, block_id_t step) {
+    return parent->get_recencies(ns, first, step);
+}
+
+bool namespace_serializer_t::get_delete_bit(block_id_t id) {
+    const block_id_t inner_id = parent->translate_block_id(ns, id, false);
+    return inner_id == NULL_BLOCK_ID || parent->inner->get_delete_bit(inner_id);
+}
+
+counted_t<block_token_t> namespace_serializer_t::index_read(block_id_t block_id) {
+    const block_id_t inner_id = parent->translate_block_id(ns, block_id, false);
+    if (inner_id == NULL_BLOCK_ID) {
+        return counted_t<block_token_t>();
+    }
+    return parent->inner->index_read(inner_id);
+}
+
+void namespace_serializer_t::index_write(
+        new_mutex_in_line_t *mutex_acq,
+        const std::function<void()> &on_writes_reflected,
+        const std::vector<index_write_op_t> &write_ops) {
+    std::vector<index_write_op_t> translated_ops;
+    translated_ops.reserve(write_ops.size());
+    for (const index_write_op_t &op : write_ops) {
+        const block_id_t inner_id = parent->translate_block_id(ns, op.block_id, false);
+        if (inner_id == NULL_BLOCK_ID) {
+            // The block was never written, so there is nothing to update or delete.
+            rassert(!op.token.has_value() || !op.token->has());
+            continue;
+        }
+        translated_ops.push_back(op);
+        translated_ops.back().block_id = inner_id;
+    }
+    // The chunks that the blocks are in must be in the chunk table before the index
+    // refers to them.
+    parent->persist_chunk_table(parent->allocated_version);
+    parent->inner->index_write(mutex_acq, on_writes_reflected, translated_ops);
+}
+
+std::vector<counted_t<block_token_t> >
+namespace_serializer_t::block_writes(const std::vector<buf_write_info_t> &write_infos,
+                                     file_account_t *io_account, iocallback_t *cb) {
+    std::vector<buf_write_info_t> tmp;
+    tmp.reserve(write_infos.size());
+    for (const buf_write_info_t &info : write_infos) {
+        guarantee(info.block_id != NULL_BLOCK_ID);
+        tmp.push_back(buf_write_info_t(info.buf, info.block_size,
+                                       parent->translate_block_id(ns, info.block_id,
+                                                                  true)));
+    }
+    return parent->inner->block_writes(tmp, io_account, cb);
+}
+
+max_block_size_t namespace_serializer_t::max_block_size() const {
+    return parent->inner->max_block_size();
+}
+
+bool namespace_serializer_t::coop_lock_and_check() {
+    return parent->inner->coop_lock_and_check();
+}
+
+bool namespace_serializer_t::is_gc_active() const {
+    return parent->inner->is_gc_active();
+}
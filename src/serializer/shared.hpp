@@ -0,0 +1,188 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_SHARED_HPP_
+#define SERIALIZER_SHARED_HPP_
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer_cache/types.hpp"
+#include "concurrency/new_mutex.hpp"
+#include "serializer/serializer.hpp"
+
+/* Facilities for storing many small tables in a single serializer file.
+
+A `shared_serializer_t` divides the block IDs of an inner serializer into
+namespaces. Each namespace is used through a `namespace_serializer_t`, which presents
+the illusion of a complete serializer, much like a `translator_serializer_t` does.
+Unlike the translator's fixed interleaving, namespaces can be added and dropped at any
+time, and a namespace only takes as many block IDs on the inner serializer as it uses.
+
+The block IDs of a namespace are mapped to the inner serializer in chunks of
+`SHARED_SERIALIZER_CHUNK_SIZE` consecutive IDs. A chunk is allocated on the first
+block write to it. The owner of every chunk is recorded in the chunk table, which is
+written before any index write that refers to a new chunk. The first blocks of the
+chunk table are kept in the first `SHARED_SERIALIZER_RESERVED_IDS` block IDs of the
+inner serializer. Once those are used up, the table grows into regular chunks that
+are set aside for it, so the file never runs out of chunks.
+
+Dropping a namespace deletes all of its blocks and frees its chunks in a single index
+write, so the inner serializer's garbage collector can reclaim the space. */
+
+typedef uint32_t serializer_namespace_id_t;
+
+const block_id_t SHARED_SERIALIZER_CHUNK_SIZE = 64;
+const block_id_t SHARED_SERIALIZER_RESERVED_IDS = 4096;
+
+class namespace_serializer_t;
+
+class shared_serializer_t : public home_thread_mixin_t {
+public:
+    /* Blocking call. Assumes the given serializer is empty, and sets it up to be used
+    by a `shared_serializer_t`. */
+    static void create(serializer_t *inner);
+
+    /* Blocking call. Loads the chunk table. */
+    explicit shared_serializer_t(serializer_t *inner);
+    ~shared_serializer_t();
+
+    serializer_t *get_inner() { return inner; }
+
+    /* Returns `true` if no chunks are allocated to the namespace. */
+    bool namespace_is_empty(serializer_namespace_id_t ns) const;
+
+    /* There can be at most one `namespace_serializer_t` per namespace at a time. It
+    must be destroyed on this thread, before the `shared_serializer_t`. */
+    namespace_serializer_t *open_namespace(serializer_namespace_id_t ns);
+
+    /* Blocking call. Deletes all blocks of the namespace, which must not be open, and
+    frees its chunks. */
+    void drop_namespace(serializer_namespace_id_t ns);
+
+private:
+    friend class namespace_serializer_t;
+
+    enum space_t { REGULAR_SPACE = 0, AUX_SPACE = 1 };
+
+    struct chunk_owner_t {
+        chunk_owner_t() : used(false), ns(0), local_chunk(0) { }
+        bool used;
+        serializer_namespace_id_t ns;
+        uint64_t local_chunk;
+    };
+
+    struct namespace_chunks_t {
+        namespace_chunks_t() : is_open(false) { }
+        bool is_open;
+        // Maps local chunk numbers to global chunk numbers, with 0 for chunks that
+        // aren't allocated. (Global chunk 0 is never allocated in either space.)
+        std::vector<uint64_t> chunks[2];
+    };
+
+    /* Translates a block ID of the namespace to a block ID on the inner serializer.
+    If the chunk isn't allocated yet, allocates it if `allocate` is `true`, or returns
+    `NULL_BLOCK_ID` otherwise. */
+    block_id_t translate_block_id(serializer_namespace_id_t ns, block_id_t id,
+                                  bool allocate);
+    block_id_t end_block_id(serializer_namespace_id_t ns, space_t space);
+    segmented_vector_t<repli_timestamp_t> get_recencies(serializer_namespace_id_t ns,
+                                                        block_id_t first,
+                                                        block_id_t step);
+    void close_namespace(serializer_namespace_id_t ns);
+
+    /* The chunk table consists of one block per space for every
+    `entries_per_table_block` global chunks. `table_block_id()` returns the ID of the
+    block for the given space and group of chunks. */
+    block_id_t table_block_id(space_t space, uint64_t table_group) const;
+
+    /* Returns `true` for the regular chunks that hold chunk table blocks rather than
+    namespace blocks. */
+    bool is_table_chunk(uint64_t global_chunk) const;
+
+    void load_table_block(space_t space, uint64_t table_group);
+
+    /* Makes sure that every chunk allocation up to `version` is durable. */
+    void persist_chunk_table(uint64_t version);
+
+    /* Writes the modified blocks of the chunk table and appends the index write
+    operations for them to `ops_out`. Must be called with `chunk_table_mutex`
+    held. */
+    void write_chunk_table(std::vector<index_write_op_t> *ops_out);
+
+    serializer_t *const inner;
+    size_t entries_per_table_block;
+
+    // Indexed by space and then by global chunk number.
+    std::vector<chunk_owner_t> owners[2];
+    std::set<uint64_t> free_chunks[2];
+    std::map<serializer_namespace_id_t, namespace_chunks_t> namespaces;
+
+    // The chunk table blocks to write, by space and group of chunks.
+    std::set<std::pair<space_t, uint64_t> > dirty_table_blocks;
+    uint64_t allocated_version;
+    uint64_t persisted_version;
+    new_mutex_t chunk_table_mutex;
+
+    DISABLE_COPYING(shared_serializer_t);
+};
+
+ATTR_PACKED(struct shared_serializer_config_block_t {
+    block_magic_t magic;
+    uint64_t chunk_size;
+
+    static const block_magic_t expected_magic;
+});
+
+ATTR_PACKED(struct shared_serializer_chunk_entry_t {
+    // The namespace ID plus one, or zero if the chunk is free.
+    uint32_t ns_plus_one;
+    uint64_t local_chunk;
+});
+
+class namespace_serializer_t : public serializer_t {
+public:
+    ~namespace_serializer_t();
+
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+
+    /* The inner serializer's read-ahead isn't split up by namespace, so this doesn't
+    offer anything. */
+    void register_read_ahead_cb(serializer_read_ahead_callback_t *cb);
+    void unregister_read_ahead_cb(serializer_read_ahead_callback_t *cb);
+
+    buf_ptr_t block_read(const counted_t<block_token_t> &token,
+                         file_account_t *io_account);
+
+    block_id_t end_block_id();
+    block_id_t end_aux_block_id();
+
+    segmented_vector_t<repli_timestamp_t> get_all_recencies(block_id_t first,
+                                                            block_id_t step);
+    bool get_delete_bit(block_id_t id);
+    counted_t<block_token_t> index_read(block_id_t block_id);
+
+    void index_write(new_mutex_in_line_t *mutex_acq,
+                     const std::function<void()> &on_writes_reflected,
+                     const std::vector<index_write_op_t> &write_ops);
+
+    std::vector<counted_t<block_token_t> >
+    block_writes(const std::vector<buf_write_info_t> &write_infos,
+                 file_account_t *io_account, iocallback_t *cb);
+
+    max_block_size_t max_block_size() const;
+
+    bool coop_lock_and_check();
+
+    bool is_gc_active() const;
+
+private:
+    friend class shared_serializer_t;
+    namespace_serializer_t(shared_serializer_t *parent,
+                           serializer_namespace_id_t ns);
+
+    shared_serializer_t *const parent;
+    const serializer_namespace_id_t ns;
+};
+
+#endif /* SERIALIZER_SHARED_HPP_ */
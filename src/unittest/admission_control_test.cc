@@ -0,0 +1,152 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "client_protocol/admission_control.hpp"
+
+#include <string>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/cond_var.hpp"
+#include "perfmon/load_signals.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TEST(AdmissionControlTest, PriorityRules) {
+    query_priority_rules_t rules;
+    std::string error;
+    ASSERT_TRUE(rules.add_rule("user:admin=high", &error));
+    ASSERT_TRUE(rules.add_rule("user:reports=low", &error));
+    ASSERT_TRUE(rules.add_rule("db:analytics=low", &error));
+    ASSERT_TRUE(rules.add_rule("db:app=high", &error));
+
+    EXPECT_EQ(query_priority_t::HIGH, rules.classify("admin", make_optional(
+        std::string("analytics"))));
+    EXPECT_EQ(query_priority_t::LOW, rules.classify("reports", r_nullopt));
+    EXPECT_EQ(query_priority_t::LOW, rules.classify("bob", make_optional(
+        std::string("analytics"))));
+    EXPECT_EQ(query_priority_t::HIGH, rules.classify("bob", make_optional(
+        std::string("app"))));
+    EXPECT_EQ(query_priority_t::NORMAL, rules.classify("bob", make_optional(
+        std::string("test"))));
+    EXPECT_EQ(query_priority_t::NORMAL, rules.classify("bob", r_nullopt));
+
+    // A later rule for the same name replaces the earlier one.
+    ASSERT_TRUE(rules.add_rule("db:analytics=normal", &error));
+    EXPECT_EQ(query_priority_t::NORMAL, rules.classify("bob", make_optional(
+        std::string("analytics"))));
+}
+
+TEST(AdmissionControlTest, InvalidPriorityRules) {
+    query_priority_rules_t rules;
+    std::string error;
+    EXPECT_FALSE(rules.add_rule("admin=high", &error));
+    EXPECT_FALSE(rules.add_rule("user:admin", &error));
+    EXPECT_FALSE(rules.add_rule("user:=high", &error));
+    EXPECT_FALSE(rules.add_rule("user:admin=urgent", &error));
+    EXPECT_FALSE(rules.add_rule("table:foo=low", &error));
+    EXPECT_FALSE(error.empty());
+}
+
+/* Makes the node look saturated by pretending that a lot of disk operations are in
+flight, for as long as it exists.  The admission controller notices on its next tick. */
+class saturate_node_t {
+public:
+    saturate_node_t() { get_disk_ops_in_flight()->add(DISK_OPS); }
+    ~saturate_node_t() { get_disk_ops_in_flight()->add(-DISK_OPS); }
+private:
+    static const int64_t DISK_OPS = 1000000;
+    DISABLE_COPYING(saturate_node_t);
+};
+
+admission_config_t enabled_admission_config() {
+    admission_config_t config;
+    config.enabled = true;
+    return config;
+}
+
+/* Blocks until the admission controller on this thread has noticed that the node is
+saturated. */
+void wait_until_saturated(admission_controller_t *controller) {
+    cond_t non_interruptor;
+    controller->get_saturated()->run_until_satisfied(
+        [](bool saturated) { return saturated; }, &non_interruptor);
+}
+
+TPTEST(AdmissionControlTest, AdmitsWhileIdle) {
+    perfmon_collection_t stats;
+    admission_controller_t controller(enabled_admission_config(), &stats);
+    cond_t non_interruptor;
+    ASSERT_FALSE(controller.get_saturated()->get());
+    EXPECT_TRUE(controller.admit(query_priority_t::LOW, &non_interruptor));
+    EXPECT_TRUE(controller.admit(query_priority_t::NORMAL, &non_interruptor));
+    EXPECT_TRUE(controller.admit(query_priority_t::HIGH, &non_interruptor));
+}
+
+TPTEST(AdmissionControlTest, FullQueueRejectsAndTimesOut) {
+    saturate_node_t saturate;
+    perfmon_collection_t stats;
+    admission_config_t config = enabled_admission_config();
+    config.max_queue_wait_ms = 100;
+    admission_controller_t controller(config, &stats);
+    cond_t non_interruptor;
+    wait_until_saturated(&controller);
+
+    // Fill the queue.  The controller releases at most a few waiters per tick while
+    // the node is saturated, so most of them time out.
+    const int queue_size = 1000;
+    int admitted = 0, timed_out = 0;
+    cond_t all_done;
+    for (int i = 0; i < queue_size; ++i) {
+        coro_t::spawn_now_dangerously([&]() {
+            if (controller.admit(query_priority_t::NORMAL, &non_interruptor)) {
+                ++admitted;
+            } else {
+                ++timed_out;
+            }
+            if (admitted + timed_out == queue_size) {
+                all_done.pulse();
+            }
+        });
+    }
+    EXPECT_EQ(0, admitted + timed_out);
+
+    // Once the queue is full, further queries are turned away without waiting.
+    ticks_t start = get_ticks();
+    EXPECT_FALSE(controller.admit(query_priority_t::NORMAL, &non_interruptor));
+    EXPECT_FALSE(controller.admit(query_priority_t::LOW, &non_interruptor));
+    EXPECT_LT(get_ticks() - start, static_cast<ticks_t>(10 * MILLION));
+
+    all_done.wait_lazily_unordered();
+    EXPECT_GT(timed_out, queue_size / 2);
+}
+
+TPTEST(AdmissionControlTest, HigherPriorityFirst) {
+    saturate_node_t saturate;
+    perfmon_collection_t stats;
+    admission_controller_t controller(enabled_admission_config(), &stats);
+    cond_t non_interruptor;
+    wait_until_saturated(&controller);
+
+    std::vector<std::string> order;
+    cond_t normal_done;
+    coro_t::spawn_now_dangerously([&]() {
+        EXPECT_TRUE(controller.admit(query_priority_t::NORMAL, &non_interruptor));
+        order.push_back("normal");
+        normal_done.pulse();
+    });
+
+    // While the node is saturated, low priority queries are rejected right away,
+    // and high priority queries get in ahead of the queued normal one.
+    EXPECT_FALSE(controller.admit(query_priority_t::LOW, &non_interruptor));
+    EXPECT_TRUE(controller.admit(query_priority_t::HIGH, &non_interruptor));
+    order.push_back("high");
+
+    normal_done.wait_lazily_unordered();
+    ASSERT_EQ(2u, order.size());
+    EXPECT_EQ("high", order[0]);
+    EXPECT_EQ("normal", order[1]);
+}
+
+}  // namespace unittest
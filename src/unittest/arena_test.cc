@@ -0,0 +1,64 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <stdint.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "containers/arena.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(ArenaTest, Alignment) {
+    arena_t arena(64);
+    for (size_t i = 0; i < 1000; ++i) {
+        size_t alignment = size_t(1) << (i % 5);
+        void *p = arena.allocate(1 + i % 13, alignment);
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) % alignment);
+    }
+}
+
+TEST(ArenaTest, LargeAllocations) {
+    arena_t arena(16);
+    // Allocations bigger than the next chunk still fit, and don't overlap.
+    char *a = static_cast<char *>(arena.allocate(100000, 8));
+    char *b = static_cast<char *>(arena.allocate(100000, 8));
+    memset(a, 'a', 100000);
+    memset(b, 'b', 100000);
+    for (size_t i = 0; i < 100000; ++i) {
+        ASSERT_EQ('a', a[i]);
+        ASSERT_EQ('b', b[i]);
+    }
+}
+
+TEST(ArenaTest, Containers) {
+    arena_t arena;
+    typedef std::map<int, std::string, std::less<int>,
+                     arena_allocator_t<std::pair<const int, std::string> > > map_t;
+    map_t map((std::less<int>()), map_t::allocator_type(&arena));
+    for (int i = 0; i < 10000; ++i) {
+        map[(i * 7919) % 10000] = std::to_string(i);
+    }
+    for (int i = 0; i < 10000; i += 2) {
+        map.erase(i);
+    }
+    ASSERT_EQ(5000u, map.size());
+    int expected = 1;
+    for (const auto &pair : map) {
+        EXPECT_EQ(expected, pair.first);
+        expected += 2;
+    }
+
+    std::vector<int, arena_allocator_t<int> > vec((arena_allocator_t<int>(&arena)));
+    for (int i = 0; i < 10000; ++i) {
+        vec.push_back(i);
+    }
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_EQ(i, vec[i]);
+    }
+}
+
+}  // namespace unittest
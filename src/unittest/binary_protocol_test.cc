@@ -0,0 +1,105 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "client_protocol/binary.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "arch/io/network.hpp"
+#include "client_protocol/client_server_error.hpp"
+#include "containers/archive/buffer_stream.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/ql2.pb.h"
+#include "rdb_protocol/response.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// The first message of a V1_0 handshake, with `result_format` set to `format` unless
+// it's empty.
+ql::datum_t handshake_message(const ql::datum_t &format) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("protocol_version", ql::datum_t(0.0));
+    builder.overwrite("authentication_method", ql::datum_t("SCRAM-SHA-256"));
+    builder.overwrite("authentication", ql::datum_t("n,,n=admin,r=nonce"));
+    if (format.has()) {
+        builder.overwrite("result_format", format);
+    }
+    return std::move(builder).to_datum();
+}
+
+TEST(BinaryProtocolTest, NegotiateResultFormat) {
+    EXPECT_TRUE(binary_protocol_t::parse_result_format(
+        handshake_message(ql::datum_t("binary"))));
+
+    // Clients that don't ask for a format, or ask for JSON, get JSON.
+    EXPECT_FALSE(binary_protocol_t::parse_result_format(
+        handshake_message(ql::datum_t())));
+    EXPECT_FALSE(binary_protocol_t::parse_result_format(
+        handshake_message(ql::datum_t("json"))));
+}
+
+TEST(BinaryProtocolTest, RejectUnknownResultFormat) {
+    try {
+        binary_protocol_t::parse_result_format(handshake_message(ql::datum_t("xml")));
+        ADD_FAILURE() << "An unknown `result_format` was accepted.";
+    } catch (const client_protocol::client_server_error_t &error) {
+        EXPECT_EQ(6u, error.get_error_code());
+    }
+    EXPECT_THROW(binary_protocol_t::parse_result_format(
+                     handshake_message(ql::datum_t(1.0))),
+                 client_protocol::client_server_error_t);
+}
+
+TPTEST(BinaryProtocolTest, SendResponseRoundTrip) {
+    cond_t non_interruptor;
+    scoped_ptr_t<tcp_conn_t> server_conn;
+    cond_t got_conn;
+    tcp_listener_t listener(
+        std::set<ip_address_t>({ip_address_t("127.0.0.1")}), 0,
+        [&](scoped_ptr_t<tcp_conn_descriptor_t> &nconn) {
+            nconn->make_server_connection(nullptr, &server_conn, &non_interruptor);
+            got_conn.pulse();
+        });
+    tcp_conn_t client_conn(
+        ip_address_t("127.0.0.1"), listener.get_port(), &non_interruptor);
+    got_conn.wait_lazily_unordered();
+
+    const int64_t token = 1234;
+    ql::datum_object_builder_t row;
+    row.overwrite("id", ql::datum_t(1.0));
+    row.overwrite("name", ql::datum_t("a"));
+    ql::response_t response;
+    response.set_type(Response::SUCCESS_SEQUENCE);
+    response.set_data(std::vector<ql::datum_t>{
+        std::move(row).to_datum(), ql::datum_t(2.0)});
+    binary_protocol_t::send_response(
+        &response, token, server_conn.get(), &non_interruptor);
+
+    // The framing is the same as for JSON responses.
+    char header[12];
+    client_conn.read(header, sizeof(header), &non_interruptor);
+    EXPECT_EQ(static_cast<uint64_t>(token), decode_le64(std::string(header, 8)));
+    uint32_t size = decode_le32(std::string(header + 8, 4));
+    std::string payload(size, '\0');
+    client_conn.read(&payload[0], size, &non_interruptor);
+
+    buffer_read_stream_t stream(payload.data(), payload.size());
+    ql::datum_t decoded;
+    ASSERT_EQ(archive_result_t::SUCCESS, datum_deserialize(&stream, &decoded));
+    EXPECT_EQ(static_cast<int64_t>(payload.size()), stream.tell());
+
+    EXPECT_EQ(ql::datum_t(static_cast<double>(Response::SUCCESS_SEQUENCE)),
+              decoded.get_field("t"));
+    ql::datum_t rows = decoded.get_field("r");
+    ASSERT_EQ(2u, rows.arr_size());
+    EXPECT_EQ(ql::datum_t(1.0), rows.get(0).get_field("id"));
+    EXPECT_EQ(ql::datum_t("a"), rows.get(0).get_field("name"));
+    EXPECT_EQ(ql::datum_t(2.0), rows.get(1));
+    EXPECT_EQ(0u, decoded.get_field("n").arr_size());
+    EXPECT_FALSE(decoded.get_field("e", ql::NOTHROW).has());
+}
+
+}  // namespace unittest
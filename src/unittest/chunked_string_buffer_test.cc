@@ -0,0 +1,93 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include <string>
+
+#include "containers/buffer_group.hpp"
+#include "containers/chunked_string_buffer.hpp"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+namespace unittest {
+
+std::string chunked_to_string(const chunked_string_buffer_t &buffer) {
+    rapidjson::StringBuffer out;
+    buffer.copy_to(&out);
+    return std::string(out.GetString(), out.GetSize());
+}
+
+std::string group_to_string(const chunked_string_buffer_t &buffer) {
+    const_buffer_group_t group;
+    buffer.append_to_group(&group);
+    std::string ret;
+    for (size_t i = 0; i < group.num_buffers(); ++i) {
+        const_buffer_group_t::buffer_t b = group.get_buffer(i);
+        ret.append(static_cast<const char *>(b.data), b.size);
+    }
+    return ret;
+}
+
+TEST(ChunkedStringBufferTest, PutAcrossChunks) {
+    chunked_string_buffer_t buffer;
+    std::string expected;
+    for (size_t i = 0; i < 3 * chunked_string_buffer_t::CHUNK_SIZE + 17; ++i) {
+        char c = 'a' + (i % 26);
+        buffer.Put(c);
+        expected.push_back(c);
+    }
+    EXPECT_EQ(expected.size(), buffer.GetSize());
+    EXPECT_EQ(expected, chunked_to_string(buffer));
+    EXPECT_EQ(expected, group_to_string(buffer));
+}
+
+TEST(ChunkedStringBufferTest, PushAndPop) {
+    chunked_string_buffer_t buffer;
+    char *prefix = buffer.Push(4);
+    for (size_t i = 0; i < chunked_string_buffer_t::CHUNK_SIZE; ++i) {
+        buffer.Put('x');
+    }
+    buffer.Pop(chunked_string_buffer_t::CHUNK_SIZE - 2);
+    prefix[0] = 'a';
+    prefix[1] = 'b';
+    prefix[2] = 'c';
+    prefix[3] = 'd';
+    EXPECT_EQ("abcdxx", chunked_to_string(buffer));
+    buffer.pop_front(3);
+    EXPECT_EQ('d', buffer.front());
+    EXPECT_EQ('x', buffer.back());
+    EXPECT_EQ("dxx", group_to_string(buffer));
+}
+
+TEST(ChunkedStringBufferTest, Append) {
+    chunked_string_buffer_t buffer;
+    buffer.Put('<');
+    std::string data(2 * chunked_string_buffer_t::CHUNK_SIZE, 'y');
+    buffer.append(data.data(), data.size());
+    buffer.Put('>');
+    EXPECT_EQ(data.size() + 2, buffer.GetSize());
+    EXPECT_EQ("<" + data + ">", group_to_string(buffer));
+}
+
+TEST(ChunkedStringBufferTest, SpliceArray) {
+    chunked_string_buffer_t parts[2];
+    for (int i = 0; i < 2; ++i) {
+        rapidjson::Writer<chunked_string_buffer_t> writer(parts[i]);
+        writer.StartArray();
+        writer.Int(i * 2);
+        writer.Int(i * 2 + 1);
+        writer.EndArray();
+    }
+
+    chunked_string_buffer_t buffer;
+    rapidjson::Writer<chunked_string_buffer_t> writer(buffer);
+    writer.StartArray();
+    for (int i = 0; i < 2; ++i) {
+        writer.SpliceChunkedArray(&parts[i]);
+        EXPECT_EQ(0u, parts[i].GetSize());
+    }
+    writer.Int(4);
+    writer.EndArray();
+    EXPECT_EQ("[0,1,2,3,4]", chunked_to_string(buffer));
+}
+
+}  // namespace unittest
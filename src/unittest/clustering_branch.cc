@@ -1,6 +1,7 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "unittest/gtest.hpp"
 
+#include "clustering/generic/registrant.hpp"
 #include "clustering/immediate_consistency/local_replicator.hpp"
 #include "clustering/immediate_consistency/primary_dispatcher.hpp"
 #include "clustering/immediate_consistency/remote_replicator_client.hpp"
@@ -168,6 +169,7 @@ void run_backfill_test(
         server_id_t::generate_server_id(),
         &store2,
         &bhm2,
+        nullptr,
         &interruptor);
 
     nap(100);
@@ -188,4 +190,171 @@ TPTEST(ClusteringBranch, Backfill) {
     run_with_primary(&run_backfill_test);
 }
 
+/* The `SyncWriteBatching` test stands in for a `remote_replicator_client_t`, so that it
+can see how the `remote_replicator_server_t` sends sync writes and decide when to ack
+them. Once enough writes are waiting for acks, the rest should be held back and sent as
+one batch. */
+
+void run_sync_write_batching_test(
+        simple_mailbox_cluster_t *cluster,
+        primary_dispatcher_t *dispatcher,
+        UNUSED mock_store_t *store,
+        UNUSED local_replicator_t *local_replicator,
+        order_source_t *order_source) {
+    mailbox_manager_t *mailbox_manager = cluster->get_mailbox_manager();
+    remote_replicator_server_t remote_replicator_server(mailbox_manager, dispatcher);
+
+    cond_t got_intro;
+    remote_replicator_client_intro_t intro;
+    remote_replicator_client_bcard_t::intro_mailbox_t intro_mailbox(mailbox_manager,
+        [&](signal_t *, const remote_replicator_client_intro_t &i) {
+            intro = i;
+            got_intro.pulse();
+        });
+    std::vector<std::pair<state_timestamp_t, mailbox_t<write_response_t>::address_t> >
+        single_writes;
+    remote_replicator_client_bcard_t::write_sync_mailbox_t write_sync_mailbox(
+        mailbox_manager,
+        [&](signal_t *, const write_t &, state_timestamp_t timestamp,
+                order_token_t, write_durability_t,
+                const mailbox_t<write_response_t>::address_t &ack_addr) {
+            single_writes.push_back(std::make_pair(timestamp, ack_addr));
+        });
+    std::vector<std::pair<std::vector<remote_replicator_sync_write_t>,
+        mailbox_t<std::vector<write_response_t> >::address_t> > batches;
+    remote_replicator_client_bcard_t::write_sync_batch_mailbox_t write_sync_batch_mailbox(
+        mailbox_manager,
+        [&](signal_t *, const std::vector<remote_replicator_sync_write_t> &writes,
+                const mailbox_t<std::vector<write_response_t> >::address_t &ack_addr) {
+            batches.push_back(std::make_pair(writes, ack_addr));
+        });
+
+    /* The writes are only sent once the client is ready, so the other mailboxes are
+    never used. */
+    server_id_t server_id = server_id_t::generate_server_id();
+    remote_replicator_client_bcard_t bcard;
+    bcard.server_id = server_id;
+    bcard.intro_mailbox = intro_mailbox.get_address();
+    bcard.write_sync_mailbox = write_sync_mailbox.get_address();
+    bcard.write_sync_batch_mailbox = write_sync_batch_mailbox.get_address();
+    registrant_t<remote_replicator_client_bcard_t> registrant(
+        mailbox_manager, remote_replicator_server.get_bcard().registrar, bcard);
+    got_intro.wait_lazily_unordered();
+    send(mailbox_manager, intro.ready_mailbox);
+    cond_t non_interruptor;
+    dispatcher->get_ready_dispatchees()->run_until_satisfied(
+        [&](const std::set<server_id_t> &ready) { return ready.count(server_id) == 1; },
+        &non_interruptor);
+
+    const size_t num_writes = 20;
+    std::vector<scoped_ptr_t<simple_write_callback_t> > callbacks;
+    for (size_t i = 0; i < num_writes; ++i) {
+        callbacks.push_back(make_scoped<simple_write_callback_t>());
+        dispatcher->spawn_write(
+            mock_overwrite(strprintf("key%zu", i), strprintf("%zu", i)),
+            order_source->check_in("run_sync_write_batching_test"),
+            callbacks.back().get());
+    }
+    let_stuff_happen();
+
+    /* The first few writes go out on their own, and the rest wait for an ack. */
+    ASSERT_FALSE(single_writes.empty());
+    ASSERT_LT(single_writes.size(), num_writes);
+    EXPECT_TRUE(batches.empty());
+    size_t num_single_writes = single_writes.size();
+
+    /* Once one of them is acked, everything that was held back goes out at once. */
+    send(mailbox_manager, single_writes[0].second, write_response_t());
+    let_stuff_happen();
+    EXPECT_EQ(num_single_writes, single_writes.size());
+    ASSERT_EQ(1u, batches.size());
+    const std::vector<remote_replicator_sync_write_t> &batch = batches[0].first;
+    EXPECT_EQ(num_writes - num_single_writes, batch.size());
+
+    /* Between them, the single writes and the batch carry every write exactly once. */
+    std::set<state_timestamp_t> timestamps;
+    for (const auto &pair : single_writes) {
+        timestamps.insert(pair.first);
+    }
+    for (const remote_replicator_sync_write_t &write : batch) {
+        timestamps.insert(write.timestamp);
+    }
+    EXPECT_EQ(num_writes, timestamps.size());
+    EXPECT_EQ(dispatcher->get_latest_timestamp(), *timestamps.rbegin());
+
+    /* Each write in the batch gets its ack from the batch's single response. */
+    for (size_t i = 1; i < single_writes.size(); ++i) {
+        send(mailbox_manager, single_writes[i].second, write_response_t());
+    }
+    send(mailbox_manager, batches[0].second,
+        std::vector<write_response_t>(batch.size()));
+    for (const auto &callback : callbacks) {
+        callback->wait_lazily_unordered();
+        /* One ack from the local replica and one from our stand-in. */
+        EXPECT_EQ(2, callback->acks);
+    }
+}
+
+TPTEST(ClusteringBranch, SyncWriteBatching) {
+    run_with_primary(&run_sync_write_batching_test);
+}
+
+/* The `BatchedWritesInOrder` test sends a burst of concurrent writes to the same key
+through a real `remote_replicator_client_t`. Most of them arrive in batches, but they
+must still be applied in timestamp order, so the last write wins. */
+
+void run_batched_writes_in_order_test(
+        simple_mailbox_cluster_t *cluster,
+        primary_dispatcher_t *dispatcher,
+        mock_store_t *store1,
+        local_replicator_t *local_replicator,
+        order_source_t *order_source) {
+    remote_replicator_server_t remote_replicator_server(
+        cluster->get_mailbox_manager(),
+        dispatcher);
+
+    standard_backfill_throttler_t backfill_throttler;
+    backfill_progress_tracker_t backfill_progress_tracker;
+    mock_store_t store2((binary_blob_t(version_t::zero())));
+    in_memory_branch_history_manager_t bhm2;
+    cond_t interruptor;
+    remote_replicator_client_t remote_replicator_client(
+        &backfill_throttler,
+        backfill_config_t(),
+        &backfill_progress_tracker,
+        cluster->get_mailbox_manager(),
+        server_id_t::generate_server_id(),
+        backfill_throttler_t::priority_t::critical_t::NO,
+        dispatcher->get_branch_id(),
+        remote_replicator_server.get_bcard(),
+        local_replicator->get_replica_bcard(),
+        server_id_t::generate_server_id(),
+        &store2,
+        &bhm2,
+        nullptr,
+        &interruptor);
+
+    const int num_writes = 100;
+    std::vector<scoped_ptr_t<simple_write_callback_t> > callbacks;
+    for (int i = 0; i < num_writes; ++i) {
+        callbacks.push_back(make_scoped<simple_write_callback_t>());
+        dispatcher->spawn_write(
+            mock_overwrite("a", strprintf("%d", i)),
+            order_source->check_in("run_batched_writes_in_order_test"),
+            callbacks.back().get());
+    }
+    for (const auto &callback : callbacks) {
+        callback->wait_lazily_unordered();
+        EXPECT_EQ(2, callback->acks);
+    }
+
+    std::string last_value = strprintf("%d", num_writes - 1);
+    EXPECT_EQ(last_value, mock_lookup(store1, "a"));
+    EXPECT_EQ(last_value, mock_lookup(&store2, "a"));
+}
+
+TPTEST(ClusteringBranch, BatchedWritesInOrder) {
+    run_with_primary(&run_batched_writes_in_order_test);
+}
+
 }   /* namespace unittest */
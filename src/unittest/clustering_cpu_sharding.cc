@@ -0,0 +1,54 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include "clustering/administration/tables/split_points.hpp"
+#include "clustering/table_contract/contract_metadata.hpp"
+#include "clustering/table_contract/cpu_sharding.hpp"
+
+namespace unittest {
+
+TEST(CpuSharding, Subspaces) {
+    EXPECT_FALSE(is_valid_cpu_sharding_factor(0));
+    EXPECT_FALSE(is_valid_cpu_sharding_factor(3));
+    EXPECT_FALSE(is_valid_cpu_sharding_factor(2 * MAX_CPU_SHARDING_FACTOR));
+
+    for (size_t n = 1; n <= MAX_CPU_SHARDING_FACTOR; n *= 2) {
+        ASSERT_TRUE(is_valid_cpu_sharding_factor(n));
+        uint64_t next_beg = 0;
+        for (size_t i = 0; i < n; ++i) {
+            region_t region = cpu_sharding_subspace(i, n);
+            // The subspaces cover the whole hash space without gaps.
+            EXPECT_EQ(next_beg, region.beg);
+            next_beg = region.end;
+            EXPECT_EQ(static_cast<int>(i), get_cpu_shard_number(region, n));
+            EXPECT_EQ(n, get_cpu_sharding_factor(region));
+        }
+        EXPECT_EQ(HASH_REGION_HASH_SIZE, next_beg);
+    }
+
+    // The default must not change, or existing tables would no longer match their data.
+    EXPECT_EQ(3 * (HASH_REGION_HASH_SIZE / 8), cpu_sharding_subspace(3).beg);
+    EXPECT_EQ(HASH_REGION_HASH_SIZE, cpu_sharding_subspace(7).end);
+}
+
+TEST(CpuSharding, NewTable) {
+    table_config_and_shards_t config;
+    config.config.basic.name = name_string_t::guarantee_valid("test");
+    config.config.basic.database = generate_uuid();
+    config.config.basic.primary_key = "id";
+    for (size_t i = 0; i < 2; ++i) {
+        table_config_t::shard_t shard;
+        shard.primary_replica = server_id_t::generate_server_id();
+        shard.all_replicas.insert(shard.primary_replica);
+        config.config.shards.push_back(shard);
+    }
+    calculate_split_points_for_uuids(2, &config.shard_scheme);
+
+    for (size_t n : {1, 8, 32}) {
+        table_raft_state_t state = make_new_table_raft_state(config, n);
+        EXPECT_EQ(2 * n, state.contracts.size());
+        EXPECT_EQ(n, get_cpu_sharding_factor(state));
+    }
+}
+
+}  // namespace unittest
@@ -56,7 +56,7 @@ TPTEST(ClusteringRaft, StorageRoundtrip) {
     namespace_id_t table_id = generate_uuid();
 
     table_raft_state_t table_raft_state =
-        make_new_table_raft_state(make_table_config_and_shards());
+        make_new_table_raft_state(make_table_config_and_shards(), CPU_SHARDING_FACTOR);
     raft_member_id_t raft_member_id(generate_uuid());
     raft_config_t raft_config;
     raft_config.voting_members.insert(raft_member_id);
@@ -92,7 +92,7 @@ TPTEST(ClusteringRaft, StorageErase) {
     namespace_id_t table_id = generate_uuid();
 
     table_raft_state_t table_raft_state =
-        make_new_table_raft_state(make_table_config_and_shards());
+        make_new_table_raft_state(make_table_config_and_shards(), CPU_SHARDING_FACTOR);
     raft_member_id_t raft_member_id(generate_uuid());
     raft_config_t raft_config;
     raft_config.voting_members.insert(raft_member_id);
@@ -142,7 +142,7 @@ TPTEST(ClusteringRaft, StorageWriteCurrentTermAndVotedFor) {
     namespace_id_t table_id = generate_uuid();
 
     table_raft_state_t table_raft_state =
-        make_new_table_raft_state(make_table_config_and_shards());
+        make_new_table_raft_state(make_table_config_and_shards(), CPU_SHARDING_FACTOR);
     raft_member_id_t raft_member_id(generate_uuid());
     raft_member_id_t raft_member_id_voted_for(generate_uuid());
     raft_config_t raft_config;
@@ -189,7 +189,7 @@ TPTEST(ClusteringRaft, StorageWriteCommitIndex) {
     namespace_id_t table_id = generate_uuid();
 
     table_raft_state_t table_raft_state =
-        make_new_table_raft_state(make_table_config_and_shards());
+        make_new_table_raft_state(make_table_config_and_shards(), CPU_SHARDING_FACTOR);
     raft_member_id_t raft_member_id(generate_uuid());
     raft_config_t raft_config;
     raft_config.voting_members.insert(raft_member_id);
@@ -232,7 +232,7 @@ TPTEST(ClusteringRaft, StorageWriteLogReplaceTail) {
     namespace_id_t table_id = generate_uuid();
 
     table_raft_state_t table_raft_state =
-        make_new_table_raft_state(make_table_config_and_shards());
+        make_new_table_raft_state(make_table_config_and_shards(), CPU_SHARDING_FACTOR);
     raft_member_id_t raft_member_id(generate_uuid());
     raft_config_t raft_config;
     raft_config.voting_members.insert(raft_member_id);
@@ -287,7 +287,7 @@ TPTEST(ClusteringRaft, StorageWriteLogAppendOne) {
     namespace_id_t table_id = generate_uuid();
 
     table_raft_state_t table_raft_state =
-        make_new_table_raft_state(make_table_config_and_shards());
+        make_new_table_raft_state(make_table_config_and_shards(), CPU_SHARDING_FACTOR);
     raft_member_id_t raft_member_id(generate_uuid());
     raft_config_t raft_config;
     raft_config.voting_members.insert(raft_member_id);
@@ -337,7 +337,7 @@ TPTEST(ClusteringRaft, StorageWriteSnapshot) {
     namespace_id_t table_id = generate_uuid();
 
     table_raft_state_t table_raft_state =
-        make_new_table_raft_state(make_table_config_and_shards());
+        make_new_table_raft_state(make_table_config_and_shards(), CPU_SHARDING_FACTOR);
     raft_member_id_t raft_member_id(generate_uuid());
     raft_config_t raft_config;
     raft_config.voting_members.insert(raft_member_id);
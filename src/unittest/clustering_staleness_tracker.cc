@@ -0,0 +1,94 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
+#include "clustering/immediate_consistency/staleness_tracker.hpp"
+#include "config/args.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static state_timestamp_t timestamp(uint64_t n) {
+    state_timestamp_t ts = state_timestamp_t::zero();
+    for (uint64_t i = 0; i < n; ++i) {
+        ts = ts.next();
+    }
+    return ts;
+}
+
+TPTEST(StalenessTracker, FreshAfterHeartbeat) {
+    staleness_tracker_t tracker;
+    cond_t non_interruptor;
+
+    /* Without any heartbeat, the store is never fresh. */
+    tracker.on_applied_timestamp(timestamp(5));
+    EXPECT_FALSE(tracker.wait_until_fresh(1000, &non_interruptor));
+
+    /* A heartbeat whose timestamp has already been applied makes it fresh. */
+    tracker.on_primary_timestamp(timestamp(5));
+    EXPECT_TRUE(tracker.wait_until_fresh(10, &non_interruptor));
+
+    /* Once the last heartbeat is older than the bound, it's stale again. */
+    nap(50);
+    EXPECT_FALSE(tracker.wait_until_fresh(10, &non_interruptor));
+    EXPECT_TRUE(tracker.wait_until_fresh(1000, &non_interruptor));
+
+    /* A huge bound doesn't overflow; it just accepts any state we've seen. */
+    EXPECT_TRUE(tracker.wait_until_fresh(INT64_MAX, &non_interruptor));
+}
+
+TPTEST(StalenessTracker, WaitsForWrites) {
+    staleness_tracker_t tracker;
+    cond_t non_interruptor;
+    tracker.on_applied_timestamp(timestamp(5));
+    tracker.on_primary_timestamp(timestamp(8));
+
+    /* The heartbeat's timestamp hasn't been applied yet, so the read has to wait
+    until the writes catch up. */
+    coro_t::spawn_sometime([&]() {
+        nap(20);
+        tracker.on_applied_timestamp(timestamp(7));
+        nap(20);
+        tracker.on_applied_timestamp(timestamp(8));
+    });
+    ticks_t start = get_ticks();
+    EXPECT_TRUE(tracker.wait_until_fresh(1000, &non_interruptor));
+    EXPECT_GE(get_ticks() - start, static_cast<ticks_t>(30 * MILLION));
+}
+
+TPTEST(StalenessTracker, RequestsHeartbeats) {
+    staleness_tracker_t tracker;
+    cond_t non_interruptor;
+    tracker.on_applied_timestamp(timestamp(5));
+
+    /* A stale read asks the primary for a heartbeat, which makes the store fresh. */
+    int requests = 0;
+    tracker.set_heartbeat_requester([&]() {
+        ++requests;
+        coro_t::spawn_sometime([&]() {
+            nap(10);
+            tracker.on_primary_timestamp(timestamp(5));
+        });
+    });
+    EXPECT_TRUE(tracker.wait_until_fresh(0, &non_interruptor));
+    EXPECT_EQ(1, requests);
+
+    /* Reads that the last heartbeat is recent enough for don't ask for another. */
+    EXPECT_TRUE(tracker.wait_until_fresh(1000, &non_interruptor));
+    EXPECT_EQ(1, requests);
+
+    /* Neither do reads that a timestamp from a write is recent enough for; they just
+    wait for the write to be applied. */
+    nap(50);
+    tracker.on_primary_timestamp(timestamp(6));
+    coro_t::spawn_sometime([&]() {
+        nap(10);
+        tracker.on_applied_timestamp(timestamp(6));
+    });
+    EXPECT_TRUE(tracker.wait_until_fresh(20, &non_interruptor));
+    EXPECT_EQ(1, requests);
+
+    tracker.set_heartbeat_requester(std::function<void()>());
+}
+
+}  // namespace unittest
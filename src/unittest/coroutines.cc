@@ -1,5 +1,8 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 
+#include <string>
+
+#include "arch/runtime/coro_sampler.hpp"
 #include "arch/runtime/coroutines.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "concurrency/auto_drainer.hpp"
@@ -106,6 +109,63 @@ TEST(CoroutinesTest, NotifyNow) {
     });
 }
 
+TEST(CoroutinesTest, StackClasses) {
+    // Coroutines get a stack of the requested class, and each class has its own
+    // free list, so a small coroutine never gets a default stack and vice versa.
+    run_in_thread_pool([&]() {
+        for (int i = 0; i < 10; ++i) {
+            for (coro_stack_class_t stack_class :
+                     {coro_stack_class_t::SMALL, coro_stack_class_t::DEFAULT}) {
+                cond_t done;
+                coro_t::spawn_sometime([&]() {
+                    coro_t *self = coro_t::self();
+                    EXPECT_EQ(stack_class, self->get_stack_class());
+                    EXPECT_EQ(stack_class == coro_stack_class_t::SMALL
+                                  ? static_cast<size_t>(COROUTINE_SMALL_STACK_SIZE)
+                                  : static_cast<size_t>(COROUTINE_STACK_SIZE),
+                              self->get_stack_size());
+                    size_t used = coroutine_stack_space_used();
+                    EXPECT_GT(used, 0u);
+                    EXPECT_LT(used, self->get_stack_size());
+                    done.pulse();
+                }, stack_class);
+                done.wait_lazily_unordered();
+            }
+        }
+    });
+}
+
+TEST(CoroutinesTest, SmallStackCallWithEnoughStack) {
+    // A small-stack coroutine can move deep work to a default stack.
+    run_in_thread_pool([&]() {
+        cond_t done;
+        coro_t::spawn_sometime([&]() {
+            call_with_enough_stack([&]() {
+                EXPECT_EQ(coro_stack_class_t::DEFAULT,
+                          coro_t::self()->get_stack_class());
+            }, COROUTINE_SMALL_STACK_SIZE);
+            done.pulse();
+        }, coro_stack_class_t::SMALL);
+        done.wait_lazily_unordered();
+    });
+}
+
+TEST(CoroutinesTest, SpawnSiteDescription) {
+    run_in_thread_pool([&]() {
+        cond_t done;
+        std::string description;
+        coro_t::spawn_sometime([&]() {
+            description = describe_coro_spawn_site(coro_t::self()->get_spawn_site());
+            done.pulse();
+        });
+        done.wait_lazily_unordered();
+        // The description is the type of the callable, without the surrounding
+        // signature of `get_and_init_coro()`.
+        EXPECT_NE(std::string::npos, description.find("SpawnSiteDescription"));
+        EXPECT_EQ(std::string::npos, description.find("get_and_init_coro"));
+    });
+}
+
 // The following test does not work on 32 bit architectures because it will exceed
 // their virtual memory.
 #if defined (__x86_64__) || defined (_WIN64)
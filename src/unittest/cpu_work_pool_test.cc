@@ -0,0 +1,60 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "concurrency/cpu_work_pool.hpp"
+#include "random.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TPTEST(CpuWorkPoolTest, RunsEveryTaskOnce, 4) {
+    const size_t NUM_TASKS = 1000;
+    std::vector<std::atomic<int> > runs(NUM_TASKS);
+    for (auto &r : runs) {
+        r.store(0);
+    }
+    run_cpu_tasks(NUM_TASKS, [&](size_t i) {
+        runs[i].fetch_add(1);
+    });
+    for (size_t i = 0; i < NUM_TASKS; ++i) {
+        EXPECT_EQ(1, runs[i].load());
+    }
+}
+
+TPTEST(CpuWorkPoolTest, RethrowsErrors, 4) {
+    std::atomic<size_t> num_run(0);
+    EXPECT_THROW(run_cpu_tasks(100, [&](size_t i) {
+        num_run.fetch_add(1);
+        if (i == 10) {
+            throw std::runtime_error("task failed");
+        }
+    }), std::runtime_error);
+    EXPECT_LE(num_run.load(), 100u);
+
+    // The pool can still be used afterwards.
+    std::atomic<size_t> sum(0);
+    run_cpu_tasks(10, [&](size_t i) { sum.fetch_add(i); });
+    EXPECT_EQ(45u, sum.load());
+}
+
+TPTEST(CpuWorkPoolTest, ParallelStableSort, 4) {
+    // Few distinct keys, so stability matters.
+    std::vector<std::pair<int, size_t> > values;
+    for (size_t i = 0; i < 10 * MIN_PARALLEL_SORT_SIZE + 17; ++i) {
+        values.push_back(std::make_pair(randint(100), i));
+    }
+    auto lt = [](const std::pair<int, size_t> &a, const std::pair<int, size_t> &b) {
+        return a.first < b.first;
+    };
+    std::vector<std::pair<int, size_t> > expected = values;
+    std::stable_sort(expected.begin(), expected.end(), lt);
+    parallel_stable_sort(&values, lt);
+    EXPECT_TRUE(expected == values);
+}
+
+}  // namespace unittest
@@ -1,9 +1,15 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "containers/archive/string_stream.hpp"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/datum_string.hpp"
 #include "rdb_protocol/env.hpp"
+#include "time.hpp"
 #include "unittest/gtest.hpp"
 
 
@@ -205,4 +211,82 @@ TEST(DatumTest, OffsetScaling) {
     }
 }
 
+TEST(DatumTest, ObjectBuilder) {
+    ql::datum_object_builder_t builder;
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_FALSE(builder.add(
+            datum_string_t(std::to_string((i * 7919) % 1000)), ql::datum_t(1.0 * i)));
+    }
+    EXPECT_TRUE(builder.add(datum_string_t("5"), ql::datum_t(-1.0)));
+    builder.overwrite(datum_string_t("5"), ql::datum_t(-2.0));
+    EXPECT_TRUE(builder.delete_field(datum_string_t("6")));
+    EXPECT_FALSE(builder.delete_field(datum_string_t("6")));
+    ql::datum_t object = std::move(builder).to_datum();
+
+    ASSERT_EQ(999u, object.obj_size());
+    for (size_t i = 1; i < object.obj_size(); ++i) {
+        EXPECT_LT(object.get_pair(i - 1).first, object.get_pair(i).first);
+    }
+    EXPECT_EQ(-2.0, object.get_field("5").as_num());
+    EXPECT_FALSE(object.get_field("6", ql::NOTHROW).has());
+
+    // Copying an object into a builder and back gives the same object.
+    ql::datum_object_builder_t copy(object);
+    EXPECT_EQ(object, std::move(copy).to_datum());
+}
+
+// This is not really a unit test, but a micro benchmark for constructing datums.
+// No need to run this in debug mode.
+#ifdef NDEBUG
+TEST(DatumTest, ConstructionBenchmark) {
+    const int NUM_OBJECTS = 100000;
+    const int NUM_FIELDS = 10;
+    std::vector<datum_string_t> keys;
+    for (int i = 0; i < NUM_FIELDS; ++i) {
+        keys.push_back(datum_string_t(strprintf("field_%d", i)));
+    }
+    {
+        // Objects built field by field, like `object()` or a `map` function does.
+        ticks_t start_ticks = get_ticks();
+        for (int i = 0; i < NUM_OBJECTS; ++i) {
+            ql::datum_object_builder_t builder;
+            for (int j = 0; j < NUM_FIELDS; ++j) {
+                builder.overwrite(keys[j], ql::datum_t(1.0 * j));
+            }
+            ql::datum_t object = std::move(builder).to_datum();
+        }
+        double dur = ticks_to_secs(get_ticks() - start_ticks);
+        printf("Object construction: %f objects/s\n", NUM_OBJECTS / dur);
+    }
+    {
+        // Objects built from another object, like `merge()` does.
+        ql::datum_object_builder_t builder;
+        for (int j = 0; j < NUM_FIELDS; ++j) {
+            builder.overwrite(keys[j], ql::datum_t(1.0 * j));
+        }
+        ql::datum_t base = std::move(builder).to_datum();
+        ql::datum_t extra(std::map<datum_string_t, ql::datum_t>{
+            std::make_pair(datum_string_t("extra"), ql::datum_t(1.0))});
+        ticks_t start_ticks = get_ticks();
+        for (int i = 0; i < NUM_OBJECTS; ++i) {
+            ql::datum_t merged = base.merge(extra);
+        }
+        double dur = ticks_to_secs(get_ticks() - start_ticks);
+        printf("Object merge: %f objects/s\n", NUM_OBJECTS / dur);
+    }
+    {
+        ticks_t start_ticks = get_ticks();
+        for (int i = 0; i < NUM_OBJECTS; ++i) {
+            ql::datum_array_builder_t builder(ql::configured_limits_t::unlimited);
+            for (int j = 0; j < NUM_FIELDS; ++j) {
+                builder.add(ql::datum_t(1.0 * j));
+            }
+            ql::datum_t array = std::move(builder).to_datum();
+        }
+        double dur = ticks_to_secs(get_ticks() - start_ticks);
+        printf("Array construction: %f arrays/s\n", NUM_OBJECTS / dur);
+    }
+}
+#endif
+
 }  // namespace unittest
@@ -0,0 +1,68 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <utility>
+
+#include "rdb_protocol/error.hpp"
+#include "rdb_protocol/memory_tracker.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(MemoryTrackerTest, ChargeAndRelease) {
+    counted_t<ql::memory_tracker_t> tracker = make_counted<ql::memory_tracker_t>(1000);
+    tracker->charge(600);
+    tracker->charge(400);
+    EXPECT_EQ(1000u, tracker->get_usage());
+
+    // Going over the limit fails without charging anything.
+    EXPECT_THROW(tracker->charge(1), ql::datum_exc_t);
+    EXPECT_EQ(1000u, tracker->get_usage());
+
+    tracker->release(700);
+    EXPECT_EQ(300u, tracker->get_usage());
+    EXPECT_EQ(1000u, tracker->get_peak_usage());
+    tracker->release(300);
+
+    counted_t<ql::memory_tracker_t> unlimited
+        = make_counted<ql::memory_tracker_t>(ql::memory_tracker_t::unlimited);
+    unlimited->charge(ql::memory_tracker_t::unlimited);
+    EXPECT_THROW(unlimited->charge(1), ql::datum_exc_t);
+    unlimited->release(ql::memory_tracker_t::unlimited);
+}
+
+TEST(MemoryTrackerTest, Charge) {
+    counted_t<ql::memory_tracker_t> tracker = make_counted<ql::memory_tracker_t>(1000);
+    {
+        ql::memory_charge_t charge(tracker);
+        charge.add(100);
+        charge.add(200);
+        EXPECT_EQ(300u, charge.get_bytes());
+        EXPECT_EQ(300u, tracker->get_usage());
+
+        ql::memory_charge_t moved(std::move(charge));
+        EXPECT_EQ(0u, charge.get_bytes());
+        EXPECT_EQ(300u, moved.get_bytes());
+
+        // A failed charge leaves the existing one alone.
+        EXPECT_THROW(moved.add(701), ql::datum_exc_t);
+        EXPECT_EQ(300u, moved.get_bytes());
+
+        moved.reset();
+        EXPECT_EQ(0u, tracker->get_usage());
+        moved.add(50);
+
+        // Assigning releases what was charged before.
+        charge = ql::memory_charge_t(tracker);
+        charge.add(10);
+        moved = std::move(charge);
+        EXPECT_EQ(10u, tracker->get_usage());
+    }
+    // Everything is released once the charges go away.
+    EXPECT_EQ(0u, tracker->get_usage());
+
+    // A charge without a tracker doesn't count anything.
+    ql::memory_charge_t detached;
+    detached.add(1000000);
+    EXPECT_EQ(0u, detached.get_bytes());
+}
+
+}  // namespace unittest
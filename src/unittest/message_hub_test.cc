@@ -0,0 +1,161 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <pthread.h>
+
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "arch/runtime/starter.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/pmap.hpp"
+#include "containers/mpsc_list.hpp"
+#include "time.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+struct mpsc_item_t : public intrusive_list_node_t<mpsc_item_t>,
+                     public mpsc_list_node_t<mpsc_item_t> {
+    int producer;
+    int seq;
+};
+
+struct mpsc_producer_arg_t {
+    mpsc_list_t<mpsc_item_t> *list;
+    std::vector<mpsc_item_t> *items;
+};
+
+void *run_mpsc_producer(void *v_arg) {
+    mpsc_producer_arg_t *arg = static_cast<mpsc_producer_arg_t *>(v_arg);
+    // Push items in batches of varying sizes.
+    size_t i = 0;
+    while (i < arg->items->size()) {
+        intrusive_list_t<mpsc_item_t> batch;
+        for (size_t j = 0; j <= i % 7 && i < arg->items->size(); ++j, ++i) {
+            batch.push_back(&(*arg->items)[i]);
+        }
+        arg->list->push_all(&batch);
+    }
+    return nullptr;
+}
+
+TEST(MpscListTest, ConcurrentProducers) {
+    const int NUM_PRODUCERS = 4;
+    const int NUM_ITEMS = 100000;
+
+    mpsc_list_t<mpsc_item_t> list;
+    std::vector<std::vector<mpsc_item_t> > items(NUM_PRODUCERS);
+    std::vector<mpsc_producer_arg_t> args(NUM_PRODUCERS);
+    std::vector<pthread_t> threads(NUM_PRODUCERS);
+    for (int p = 0; p < NUM_PRODUCERS; ++p) {
+        items[p].resize(NUM_ITEMS);
+        for (int i = 0; i < NUM_ITEMS; ++i) {
+            items[p][i].producer = p;
+            items[p][i].seq = i;
+        }
+        args[p].list = &list;
+        args[p].items = &items[p];
+        int res = pthread_create(&threads[p], nullptr, run_mpsc_producer, &args[p]);
+        ASSERT_EQ(0, res);
+    }
+
+    // Consume concurrently, checking that each producer's items arrive in order.
+    std::vector<int> next_seq(NUM_PRODUCERS, 0);
+    int total = 0;
+    while (total < NUM_PRODUCERS * NUM_ITEMS) {
+        intrusive_list_t<mpsc_item_t> popped;
+        list.pop_all(&popped);
+        while (mpsc_item_t *item = popped.head()) {
+            popped.remove(item);
+            ASSERT_EQ(next_seq[item->producer], item->seq);
+            ++next_seq[item->producer];
+            ++total;
+        }
+    }
+
+    for (int p = 0; p < NUM_PRODUCERS; ++p) {
+        int res = pthread_join(threads[p], nullptr);
+        ASSERT_EQ(0, res);
+        EXPECT_EQ(NUM_ITEMS, next_seq[p]);
+    }
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(MessageHubTest, BusyPolling) {
+    const int NUM_THREADS = 4;
+    // While they poll, threads don't get woken up for new messages.  Make sure they
+    // still get them, and that they still get timer events.
+    ::run_in_thread_pool([&]() {
+        for (int i = 0; i < 1000; ++i) {
+            on_thread_t thread_switcher((threadnum_t(1)));
+        }
+        pmap(NUM_THREADS, [&](int thread) {
+            on_thread_t thread_switcher((threadnum_t(thread)));
+            pmap(4, [&](int coro) {
+                for (int i = 0; i < 500; ++i) {
+                    on_thread_t hop(threadnum_t((thread + coro + i) % NUM_THREADS));
+                }
+            });
+            // Long enough for the thread to give up polling and block.
+            nap(5);
+            on_thread_t hop(threadnum_t((thread + 1) % NUM_THREADS));
+        });
+    }, NUM_THREADS, false, 100);
+}
+
+// This is not really a unit test, but a micro benchmark for messages between
+// threads.  No need to run this in debug mode.
+#ifdef NDEBUG
+TEST(MessageHubTest, CrossThreadHopBenchmark) {
+    const int NUM_THREADS = 8;
+    run_in_thread_pool([&]() {
+        const int NUM_ROUND_TRIPS = 100000;
+        {
+            // One coroutine bouncing between two threads measures the latency of a
+            // hop, including waking up the idle target thread.
+            ticks_t start_ticks = get_ticks();
+            for (int i = 0; i < NUM_ROUND_TRIPS; ++i) {
+                on_thread_t thread_switcher((threadnum_t(1)));
+            }
+            double dur = ticks_to_secs(get_ticks() - start_ticks);
+            printf("Cross-thread round trip latency: %f us\n",
+                   dur / NUM_ROUND_TRIPS * 1000000);
+        }
+        {
+            // Many coroutines on every thread hopping to every other thread, like a
+            // query fanning out to all CPU shards, measures the throughput.
+            const int COROS_PER_THREAD = 16;
+            const int HOPS_PER_CORO = 2000;
+            ticks_t start_ticks = get_ticks();
+            pmap(NUM_THREADS, [&](int thread) {
+                on_thread_t thread_switcher((threadnum_t(thread)));
+                pmap(COROS_PER_THREAD, [&](int coro) {
+                    for (int i = 0; i < HOPS_PER_CORO; ++i) {
+                        on_thread_t hop(threadnum_t((thread + coro + i) % NUM_THREADS));
+                    }
+                });
+            });
+            double dur = ticks_to_secs(get_ticks() - start_ticks);
+            // Each `on_thread_t` hops there and back again.
+            double hops = 2.0 * NUM_THREADS * COROS_PER_THREAD * HOPS_PER_CORO;
+            printf("Cross-thread hop throughput: %f hops/s\n", hops / dur);
+        }
+    }, NUM_THREADS);
+
+    // The same round trips with busy polling, where the target thread doesn't have to
+    // be woken up.
+    ::run_in_thread_pool([&]() {
+        const int NUM_ROUND_TRIPS = 100000;
+        ticks_t start_ticks = get_ticks();
+        for (int i = 0; i < NUM_ROUND_TRIPS; ++i) {
+            on_thread_t thread_switcher((threadnum_t(1)));
+        }
+        double dur = ticks_to_secs(get_ticks() - start_ticks);
+        printf("Cross-thread round trip latency with busy polling: %f us\n",
+               dur / NUM_ROUND_TRIPS * 1000000);
+    }, NUM_THREADS, false, 100);
+}
+#endif
+
+}  // namespace unittest
@@ -0,0 +1,64 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "arch/runtime/numa.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(NumaTest, ParseCpuList) {
+    std::vector<int> cpus;
+    ASSERT_TRUE(parse_cpu_list("0-3,8,10-11\n", &cpus));
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 8, 10, 11}), cpus);
+
+    ASSERT_TRUE(parse_cpu_list("\n", &cpus));
+    EXPECT_TRUE(cpus.empty());
+
+    EXPECT_FALSE(parse_cpu_list("3-1", &cpus));
+    EXPECT_FALSE(parse_cpu_list("0,,1", &cpus));
+    EXPECT_FALSE(parse_cpu_list("0 1", &cpus));
+}
+
+TEST(NumaTest, AssignThreadsToCpus) {
+    std::vector<std::vector<int> > nodes = {{0, 1, 2, 3}, {4, 5, 6, 7}};
+
+    // One thread per CPU: every thread gets its own CPU.
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7}),
+              assign_threads_to_cpus(8, nodes));
+
+    // Fewer threads than CPUs: the threads are still split between the nodes, and
+    // consecutive threads stay on the same node.
+    EXPECT_EQ((std::vector<int>{0, 1, 4, 5}), assign_threads_to_cpus(4, nodes));
+
+    // More threads than CPUs: each node's CPUs are shared round-robin.
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 6, 7, 4, 5, 6, 7}),
+              assign_threads_to_cpus(16, nodes));
+
+    // Nodes of different sizes get threads in proportion to their CPUs.
+    std::vector<std::vector<int> > uneven = {{0}, {1, 2, 3}};
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3}), assign_threads_to_cpus(4, uneven));
+    EXPECT_EQ((std::vector<int>{0, 1}), assign_threads_to_cpus(2, uneven));
+}
+
+TEST(NumaTest, RestrictNodeCpus) {
+    std::vector<std::vector<int> > nodes = {{0, 1, 2, 3}, {4, 5, 6, 7}};
+
+    // Nodes keep only the CPUs we're allowed to run on...
+    EXPECT_EQ((std::vector<std::vector<int> >{{1, 3}, {4}}),
+              restrict_node_cpus(nodes, {1, 3, 4}));
+
+    // ...and nodes without any of them are dropped.
+    EXPECT_EQ((std::vector<std::vector<int> >{{5, 6}}),
+              restrict_node_cpus(nodes, {5, 6, 9}));
+    EXPECT_TRUE(restrict_node_cpus(nodes, {8, 9}).empty());
+}
+
+TEST(NumaTest, NodeCpus) {
+    std::vector<std::vector<int> > nodes = get_numa_node_cpus();
+    ASSERT_FALSE(nodes.empty());
+    for (const std::vector<int> &cpus : nodes) {
+        EXPECT_FALSE(cpus.empty());
+    }
+}
+
+}  // namespace unittest
@@ -0,0 +1,78 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include <string>
+
+#include "rdb_protocol/prepared_query.hpp"
+#include "rdb_protocol/term_storage.hpp"
+
+namespace unittest {
+
+bool shape_of(const char *json, rapidjson::Document *doc, ql::query_shape_t *shape) {
+    doc->Parse(json);
+    guarantee(!doc->HasParseError());
+    return ql::compute_query_shape(doc, shape);
+}
+
+TEST(PreparedQueryTest, ConstantsBecomeParameters) {
+    // r.table('users').get(1) and r.table('users').get(2)
+    rapidjson::Document doc1, doc2;
+    ql::query_shape_t shape1, shape2;
+    ASSERT_TRUE(shape_of("[16,[[15,[\"users\"]],1]]", &doc1, &shape1));
+    ASSERT_TRUE(shape_of("[16,[[15,[\"users\"]],[1,2]]]", &doc2, &shape2));
+    EXPECT_EQ(shape1.key, shape2.key);
+    ASSERT_EQ(2u, shape1.parameter_terms.size());
+
+    std::vector<ql::datum_t> params = ql::read_query_parameters(shape2);
+    ASSERT_EQ(2u, params.size());
+    EXPECT_EQ(ql::datum_t("users"), params[0]);
+    EXPECT_EQ(ql::datum_t(2.0), params[1]);
+
+    // Different types of constants result in different shapes.
+    rapidjson::Document doc3;
+    ql::query_shape_t shape3;
+    ASSERT_TRUE(shape_of("[16,[[15,[\"users\"]],\"2\"]]", &doc3, &shape3));
+    EXPECT_NE(shape1.key, shape3.key);
+
+    // The same goes for the elements of an array: r.expr([1, 2]) with and without
+    // `DATUM` terms around the elements.
+    rapidjson::Document doc4, doc5;
+    ql::query_shape_t shape4, shape5;
+    ASSERT_TRUE(shape_of("[2,[1,2]]", &doc4, &shape4));
+    ASSERT_TRUE(shape_of("[2,[[1,3],4]]", &doc5, &shape5));
+    EXPECT_EQ(shape4.key, shape5.key);
+    params = ql::read_query_parameters(shape5);
+    ASSERT_EQ(2u, params.size());
+    EXPECT_EQ(ql::datum_t(3.0), params[0]);
+    EXPECT_EQ(ql::datum_t(4.0), params[1]);
+}
+
+TEST(PreparedQueryTest, SourceReadingTermsKeepConstants) {
+    // r.table('users').pluck('a') and r.table('users').pluck('b')
+    rapidjson::Document doc1, doc2;
+    ql::query_shape_t shape1, shape2;
+    ASSERT_TRUE(shape_of("[33,[[15,[\"users\"]],\"a\"]]", &doc1, &shape1));
+    ASSERT_TRUE(shape_of("[33,[[15,[\"users\"]],\"b\"]]", &doc2, &shape2));
+    EXPECT_NE(shape1.key, shape2.key);
+    EXPECT_EQ(0u, shape1.parameter_terms.size());
+
+    // Optional arguments are never parameters: r.table('users', {read_mode: 'x'})
+    rapidjson::Document doc3, doc4;
+    ql::query_shape_t shape3, shape4;
+    ASSERT_TRUE(shape_of("[15,[\"users\"],{\"read_mode\":\"single\"}]",
+                         &doc3, &shape3));
+    ASSERT_TRUE(shape_of("[15,[\"users\"],{\"read_mode\":\"outdated\"}]",
+                         &doc4, &shape4));
+    EXPECT_NE(shape3.key, shape4.key);
+    EXPECT_EQ(1u, shape3.parameter_terms.size());
+}
+
+TEST(PreparedQueryTest, MalformedQueriesAreNotCached) {
+    rapidjson::Document doc;
+    ql::query_shape_t shape;
+    EXPECT_FALSE(shape_of("[]", &doc, &shape));
+    EXPECT_FALSE(shape_of("[\"x\"]", &doc, &shape));
+    EXPECT_FALSE(shape_of("[16,[1],5]", &doc, &shape));
+}
+
+}  // namespace unittest
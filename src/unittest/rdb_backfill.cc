@@ -267,7 +267,7 @@ void run_backfill_test(const backfill_test_config_t &cfg) {
                 backfill_throttler_t::priority_t::critical_t::NO,
                 dispatcher.get_branch_id(), remote_replicator_server.get_bcard(),
                 local_replicator.get_replica_bcard(), server_id_t::generate_server_id(),
-                &store2.store, &bhm, &non_interruptor);
+                &store2.store, &bhm, nullptr, &non_interruptor);
             backfill_debug_all("end backfill store1 -> store2");
             backfill_debug_all("begin backfill store1 -> store3");
             remote_replicator_client_t remote_replicator_client_3(&backfill_throttler,
@@ -276,7 +276,7 @@ void run_backfill_test(const backfill_test_config_t &cfg) {
                 backfill_throttler_t::priority_t::critical_t::NO,
                 dispatcher.get_branch_id(), remote_replicator_server.get_bcard(),
                 local_replicator.get_replica_bcard(), server_id_t::generate_server_id(),
-                &store3.store, &bhm, &non_interruptor);
+                &store3.store, &bhm, nullptr, &non_interruptor);
             backfill_debug_all("end backfill store1 -> store3");
 
             if (cfg.stream_during_backfill) {
@@ -340,7 +340,7 @@ void run_backfill_test(const backfill_test_config_t &cfg) {
             backfill_throttler_t::priority_t::critical_t::NO,
             dispatcher.get_branch_id(), remote_replicator_server.get_bcard(),
             local_replicator.get_replica_bcard(), server_id_t::generate_server_id(),
-            &store1.store, &bhm, &non_interruptor);
+            &store1.store, &bhm, nullptr, &non_interruptor);
         backfill_debug_all("end backfill store2 -> store1");
 
         if (cfg.stream_during_backfill) {
@@ -386,7 +386,7 @@ void run_backfill_test(const backfill_test_config_t &cfg) {
             backfill_throttler_t::priority_t::critical_t::NO,
             dispatcher.get_branch_id(), remote_replicator_server.get_bcard(),
             local_replicator.get_replica_bcard(), server_id_t::generate_server_id(),
-            &store3.store, &bhm, &non_interruptor);
+            &store3.store, &bhm, nullptr, &non_interruptor);
         backfill_debug_all("end backfill store1 -> store3");
 
         if (cfg.stream_during_backfill) {
@@ -543,5 +543,24 @@ TPTEST(RDBBackfill, FillBothQueuesAndPreemptOften) {
     run_backfill_test(cfg);
 }
 
+TPTEST(RDBBackfill, SingleStream) {
+    /* Traverse each session's range in a single stream, as if the backfiller weren't
+    splitting it into sub-ranges at all. */
+    backfill_test_config_t cfg;
+    cfg.backfill.num_streams = 1;
+    run_backfill_test(cfg);
+}
+
+TPTEST(RDBBackfill, ManyStreams) {
+    /* Split each session's range into many small streams, so that the chunks they
+    traverse ahead of time often fall behind the streaming writes and have to be
+    traversed again. */
+    backfill_test_config_t cfg;
+    cfg.backfill.num_streams = 32;
+    cfg.backfill.item_chunk_mem_size = 1;
+    cfg.num_initial_writes = 1000;
+    run_backfill_test(cfg);
+}
+
 }   /* namespace unittest */
 
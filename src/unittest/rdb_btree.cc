@@ -1,12 +1,15 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <algorithm>
 #include <functional>
 
 #include "arch/io/disk.hpp"
 #include "arch/runtime/coroutines.hpp"
 #include "arch/timing.hpp"
+#include "btree/backfill.hpp"
 #include "btree/operations.hpp"
 #include "btree/reql_specific.hpp"
 #include "buffer_cache/cache_balancer.hpp"
+#include "clustering/immediate_consistency/history.hpp"
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "containers/uuid.hpp"
@@ -16,6 +19,7 @@
 #include "rdb_protocol/erase_range.hpp"
 #include "rdb_protocol/minidriver.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 #include "rdb_protocol/store.hpp"
 #include "rdb_protocol/sym.hpp"
 #include "stl_utils.hpp"
@@ -371,6 +375,138 @@ TPTEST(RDBBtree, SindexEraseRange) {
     check_keys_are_NOT_present(&store, sindex_name);
 }
 
+TPTEST(RDBBtree, SindexResetData) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE);
+
+    cond_t dummy_interruptor;
+
+    insert_rows(0, TOTAL_KEYS_TO_INSERT, &store);
+
+    sindex_name_t sindex_name = create_sindex(&store);
+    check_keys_are_present(&store, sindex_name);
+
+    /* Discarding the data replaces the index with an empty one that's ready right
+    away. */
+    store.reset_data(binary_blob_t(version_t::zero()),
+                     region_t::universe(),
+                     write_durability_t::SOFT,
+                     &dummy_interruptor);
+    _check_keys_are_NOT_present(&store, sindex_name);
+
+    /* The store keeps working after the btrees have been discarded. */
+    insert_rows(0, TOTAL_KEYS_TO_INSERT, &store);
+    check_keys_are_present(&store, sindex_name);
+}
+
+bool primary_key_is_present(store_t *store, int i) {
+    cond_t dummy_interruptor;
+    read_token_t token;
+    store->new_read_token(&token);
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    store->acquire_superblock_for_read(
+        &token, &txn, &superblock, &dummy_interruptor, false);
+    point_read_response_t response;
+    rdb_get(store_key_t(ql::datum_t(static_cast<double>(i)).print_primary()),
+            store->btree.get(), superblock.get(), &response, nullptr);
+    return response.data.get_type() != ql::datum_t::R_NULL;
+}
+
+TPTEST(RDBBtree, SindexResetDataSubregion) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE);
+
+    cond_t dummy_interruptor;
+
+    insert_rows(0, TOTAL_KEYS_TO_INSERT, &store);
+
+    sindex_name_t sindex_name = create_sindex(&store);
+    check_keys_are_present(&store, sindex_name);
+
+    /* Erase only part of the key range, like a rebalance would. */
+    key_range_t erased_range(
+        key_range_t::closed,
+        store_key_t(ql::datum_t(static_cast<double>(
+            TOTAL_KEYS_TO_INSERT / 4)).print_primary()),
+        key_range_t::open,
+        store_key_t(ql::datum_t(static_cast<double>(
+            TOTAL_KEYS_TO_INSERT / 2)).print_primary()));
+    region_t erased_region = region_t::universe();
+    erased_region.inner = erased_range;
+    store.reset_data(binary_blob_t(version_t::zero()),
+                     erased_region,
+                     write_durability_t::SOFT,
+                     &dummy_interruptor);
+
+    /* The keys outside of the erased range are still in both the primary btree and
+    the secondary index. */
+    int num_erased = 0;
+    for (int i = 0; i < TOTAL_KEYS_TO_INSERT; ++i) {
+        bool erased = erased_range.contains_key(
+            store_key_t(ql::datum_t(static_cast<double>(i)).print_primary()));
+        num_erased += erased ? 1 : 0;
+        EXPECT_EQ(!erased, primary_key_is_present(&store, i));
+        ql::grouped_t<ql::stream_t> groups =
+            read_row_via_sindex(&store, sindex_name, i * i);
+        EXPECT_EQ(erased ? 0ul : 1ul, groups.size());
+    }
+    EXPECT_GT(num_erased, 0);
+    EXPECT_LT(num_erased, TOTAL_KEYS_TO_INSERT);
+}
+
 TPTEST(RDBBtree, SindexInterruptionViaDrop) {
     recreate_temporary_directory(base_path_t("."));
     temp_file_t temp_file;
@@ -451,4 +587,151 @@ TPTEST(RDBBtree, SindexInterruptionViaStoreDelete) {
     store.reset();
 }
 
+/* `test_item_producer_t` hands `receive_backfill()` the rows `0` to
+`TOTAL_KEYS_TO_INSERT - 1` in the format `insert_rows()` uses, as a sender would for a
+table holding exactly those rows. Most of them come in one multi-key item with more pairs
+than fit in a single bulk transaction; the last few come as single-key items; and a
+final multi-key item without pairs covers the rest of the key space. */
+class test_item_producer_t : public store_view_t::backfill_item_producer_t {
+public:
+    test_item_producer_t() :
+        metainfo(region_t::universe(), binary_blob_t(version_t::zero())),
+        next(0) {
+        const int num_single_key_items = 10;
+        ql::configured_limits_t limits;
+        backfill_item_t multi_key_item;
+        multi_key_item.range = key_range_t::universe();
+        multi_key_item.min_deletion_timestamp = repli_timestamp_t::distant_past;
+        for (int i = 0; i < TOTAL_KEYS_TO_INSERT; ++i) {
+            std::string data = strprintf("{\"id\" : %d, \"sid\" : %d}", i, i * i);
+            rapidjson::Document doc;
+            doc.Parse(data.c_str());
+            write_message_t wm;
+            ql::datum_serialize(&wm, ql::to_datum(doc, limits, reql_version_t::LATEST),
+                ql::check_datum_serialization_errors_t::YES);
+            vector_stream_t stream;
+            int res = send_write_message(&stream, &wm);
+            guarantee(res == 0);
+
+            backfill_item_t::pair_t pair;
+            pair.key = store_key_t(ql::datum_t(static_cast<double>(i)).print_primary());
+            pair.recency = repli_timestamp_t::distant_past.next();
+            pair.value.set(std::vector<char>());
+            stream.swap(&*pair.value);
+
+            if (i < TOTAL_KEYS_TO_INSERT - num_single_key_items) {
+                multi_key_item.pairs.push_back(std::move(pair));
+                continue;
+            }
+            if (i == TOTAL_KEYS_TO_INSERT - num_single_key_items) {
+                multi_key_item.range.right = key_range_t::right_bound_t(pair.key);
+                items.push_back(std::move(multi_key_item));
+            }
+            backfill_item_t single_key_item;
+            single_key_item.range = key_range_t(key_range_t::closed, pair.key,
+                                                key_range_t::closed, pair.key);
+            single_key_item.min_deletion_timestamp = repli_timestamp_t::distant_past;
+            single_key_item.pairs.push_back(std::move(pair));
+            items.push_back(std::move(single_key_item));
+        }
+        /* Numeric primary keys sort in numeric order, so this covers every larger
+        row. */
+        backfill_item_t tail_item;
+        tail_item.range = key_range_t::universe();
+        tail_item.range.left = items.back().range.right.key();
+        tail_item.min_deletion_timestamp = repli_timestamp_t::distant_past;
+        items.push_back(std::move(tail_item));
+    }
+
+    continue_bool_t next_item(
+            bool *is_item_out,
+            backfill_item_t *item_out,
+            key_range_t::right_bound_t *) THROWS_NOTHING {
+        guarantee(next < items.size());
+        *is_item_out = true;
+        *item_out = std::move(items[next++]);
+        return continue_bool_t::CONTINUE;
+    }
+    const region_map_t<binary_blob_t> *get_metainfo() THROWS_NOTHING {
+        return &metainfo;
+    }
+    void on_commit(const key_range_t::right_bound_t &threshold) THROWS_NOTHING {
+        committed = threshold;
+    }
+
+    key_range_t::right_bound_t committed;
+
+private:
+    region_map_t<binary_blob_t> metainfo;
+    std::vector<backfill_item_t> items;
+    size_t next;
+};
+
+/* Backfills the rows from `test_item_producer_t` into a store that already holds the
+rows `prefill_start` to `prefill_end - 1`, and checks the data and the sindex. */
+void run_receive_backfill_test(int prefill_start, int prefill_end) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE);
+
+    cond_t dummy_interruptor;
+
+    insert_rows(prefill_start, prefill_end, &store);
+    sindex_name_t sindex_name = create_sindex(&store);
+
+    test_item_producer_t producer;
+    ASSERT_EQ(continue_bool_t::CONTINUE,
+              store.receive_backfill(region_t::universe(), &producer,
+                                     &dummy_interruptor));
+    EXPECT_EQ(key_range_t::universe().right, producer.committed);
+
+    check_keys_are_present(&store, sindex_name);
+    for (int i = 0; i < TOTAL_KEYS_TO_INSERT; ++i) {
+        ASSERT_TRUE(primary_key_is_present(&store, i));
+    }
+
+    /* Rows that the sender doesn't have are gone from the table and the sindex. */
+    for (int i = std::max(prefill_start, TOTAL_KEYS_TO_INSERT); i < prefill_end; ++i) {
+        ASSERT_FALSE(primary_key_is_present(&store, i));
+        ASSERT_EQ(0u, read_row_via_sindex(&store, sindex_name, i * i).size());
+    }
+}
+
+TPTEST(RDBBtree, SindexReceiveBackfillIntoEmptyRange) {
+    /* This takes the bulk path, which splits the multi-key item across several
+    transactions. */
+    run_receive_backfill_test(0, 0);
+}
+
+TPTEST(RDBBtree, SindexReceiveBackfillIntoPartlyFilledRange) {
+    /* Half of the rows are already there, and there are some that the sender doesn't
+    have. */
+    run_receive_backfill_test(TOTAL_KEYS_TO_INSERT / 2, TOTAL_KEYS_TO_INSERT + 100);
+}
+
 } //namespace unittest
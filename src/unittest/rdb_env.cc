@@ -419,6 +419,7 @@ bool test_rdb_env_t::instance_t::table_create(
         UNUSED const table_generate_config_params_t &config_params,
         UNUSED const std::string &primary_key,
         UNUSED write_durability_t durability,
+        UNUSED size_t num_cpu_shards,
         UNUSED signal_t *local_interruptor,
         UNUSED ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -603,6 +604,7 @@ bool test_rdb_env_t::instance_t::table_rebalance(
         UNUSED auth::user_context_t const &user_context,
         UNUSED counted_t<const ql::db_t> db,
         UNUSED const name_string_t &name,
+        UNUSED rebalance_mode_t mode,
         UNUSED signal_t *local_interruptor,
         UNUSED ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -615,6 +617,7 @@ bool test_rdb_env_t::instance_t::table_rebalance(
 bool test_rdb_env_t::instance_t::db_rebalance(
         UNUSED auth::user_context_t const &user_context,
         UNUSED counted_t<const ql::db_t> db,
+        UNUSED rebalance_mode_t mode,
         UNUSED signal_t *local_interruptor,
         UNUSED ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -919,6 +919,7 @@ TPTEST(RDBProtocol, ArtificialChangefeeds) {
                               false,
                               false,
                               false,
+                              false,
                               ql::configured_limits_t(),
                               ql::datum_t::boolean(false),
                               keyspec_t::point_t{ql::datum_t(0.0)}),
@@ -934,6 +935,7 @@ TPTEST(RDBProtocol, ArtificialChangefeeds) {
                                false,
                                false,
                                false,
+                               false,
                                ql::configured_limits_t(),
                                ql::datum_t::boolean(false),
                                keyspec_t::point_t{ql::datum_t(10.0)}),
@@ -949,6 +951,7 @@ TPTEST(RDBProtocol, ArtificialChangefeeds) {
                             false,
                             false,
                             false,
+                            false,
                             ql::configured_limits_t(),
                             ql::datum_t::boolean(false),
                             keyspec_t::range_t{
@@ -3,9 +3,12 @@
 
 #include "unittest/gtest.hpp"
 
+#include "arch/timing.hpp"
 #include "clustering/administration/tables/split_points.hpp"
 #include "clustering/administration/tables/table_metadata.hpp"
 #include "btree/keys.hpp"
+#include "rdb_protocol/key_load_sampler.hpp"
+#include "unittest/unittest_utils.hpp"
 
 namespace unittest {
 
@@ -70,4 +73,152 @@ TEST(Rebalance, MaxKeyLength) {
     do_rebalance(distribution, 3);
 }
 
+TEST(Rebalance, LoadHotKey) {
+    std::map<store_key_t, double> loads;
+    for (char c = 'a'; c <= 'j'; ++c) {
+        loads[store_key_t(std::string(1, c))] = 1.0;
+    }
+    loads[store_key_t("e")] = 100.0;
+
+    table_shard_scheme_t old_split_points;
+    old_split_points.split_points = { store_key_t("m"), store_key_t("t") };
+    table_shard_scheme_t split_points;
+    ASSERT_TRUE(calculate_split_points_with_load(
+        loads, 3, old_split_points, &split_points));
+
+    /* The hot key gets a shard of its own. */
+    ASSERT_EQ(2u, split_points.split_points.size());
+    EXPECT_EQ(store_key_t("e"), split_points.split_points[0]);
+    EXPECT_EQ(store_key_t("f"), split_points.split_points[1]);
+    std::vector<double> shard_loads = calculate_shard_loads(loads, split_points);
+    EXPECT_EQ(std::vector<double>({4.0, 100.0, 5.0}), shard_loads);
+
+    /* That's as good as it gets, so doing it again doesn't change anything. */
+    table_shard_scheme_t split_points2;
+    EXPECT_FALSE(calculate_split_points_with_load(
+        loads, 3, split_points, &split_points2));
+}
+
+TEST(Rebalance, LoadHysteresis) {
+    std::map<store_key_t, double> loads;
+    for (char c = 'a'; c <= 'i'; ++c) {
+        loads[store_key_t(std::string(1, c))] = 10.0;
+    }
+    table_shard_scheme_t old_split_points;
+    old_split_points.split_points = { store_key_t("c"), store_key_t("g") };
+    table_shard_scheme_t split_points;
+
+    /* The shards have 20, 40 and 30 operations per second, which isn't worth moving
+    data around for. */
+    EXPECT_FALSE(calculate_split_points_with_load(
+        loads, 3, old_split_points, &split_points));
+
+    /* With 10, 50 and 30 it is. */
+    old_split_points.split_points = { store_key_t("b"), store_key_t("g") };
+    EXPECT_TRUE(calculate_split_points_with_load(
+        loads, 3, old_split_points, &split_points));
+
+    /* Changing the number of shards always produces new split points, but not if there
+    is hardly any load. */
+    EXPECT_TRUE(calculate_split_points_with_load(
+        loads, 2, old_split_points, &split_points));
+    EXPECT_EQ(1u, split_points.split_points.size());
+    for (auto &pair : loads) {
+        pair.second = 0.1;
+    }
+    EXPECT_FALSE(calculate_split_points_with_load(
+        loads, 2, old_split_points, &split_points));
+}
+
+TEST(Rebalance, LoadPrimaries) {
+    server_id_t s1 = server_id_t::generate_server_id();
+    server_id_t s2 = server_id_t::generate_server_id();
+    std::vector<table_config_t::shard_t> shards(2);
+    for (auto &shard : shards) {
+        shard.all_replicas = { s1, s2 };
+        shard.primary_replica = s1;
+    }
+
+    EXPECT_TRUE(choose_primaries_with_load({50.0, 40.0}, &shards));
+    EXPECT_NE(shards[0].primary_replica, shards[1].primary_replica);
+
+    /* Now the load is spread out already. */
+    std::vector<table_config_t::shard_t> old_shards = shards;
+    EXPECT_FALSE(choose_primaries_with_load({50.0, 40.0}, &shards));
+    EXPECT_TRUE(old_shards == shards);
+
+    /* A non-voting replica can't become the primary. */
+    for (auto &shard : shards) {
+        shard.nonvoting_replicas = { s2 };
+        shard.primary_replica = s1;
+    }
+    EXPECT_FALSE(choose_primaries_with_load({50.0, 40.0}, &shards));
+}
+
+TPTEST(Rebalance, KeyLoadSampler) {
+    key_load_sampler_t sampler;
+    for (int i = 0; i < 1000; ++i) {
+        sampler.record_write(store_key_t(strprintf("key%03d", i)));
+        sampler.record_read(store_key_t("hot"));
+    }
+    std::map<store_key_t, key_load_sampler_t::rates_t> rates =
+        sampler.get_rates(key_range_t::universe());
+
+    /* The cold keys have been merged into a limited number of buckets, but the hot key
+    still has one of its own. */
+    EXPECT_LE(rates.size(), 2 * KEY_LOAD_MAX_BUCKETS);
+    ASSERT_EQ(1u, rates.count(store_key_t("hot")));
+    double reads = 0, writes = 0;
+    for (const auto &pair : rates) {
+        reads += pair.second.reads_per_sec;
+        writes += pair.second.writes_per_sec;
+    }
+    EXPECT_EQ(reads, rates[store_key_t("hot")].reads_per_sec);
+    EXPECT_EQ(0, rates[store_key_t("hot")].writes_per_sec);
+    EXPECT_GT(writes, 0);
+    EXPECT_NEAR(reads, writes, writes * 0.01);
+
+    std::map<store_key_t, key_load_sampler_t::rates_t> some_rates =
+        sampler.get_rates(key_range_t(
+            key_range_t::closed, store_key_t("hot"),
+            key_range_t::open, store_key_t("key")));
+    EXPECT_EQ(1u, some_rates.size());
+}
+
+TPTEST(Rebalance, KeyLoadSamplerDecay) {
+    key_load_sampler_t sampler;
+    microtime_t start = current_microtime();
+
+    /* One hot key among many cold ones; the cold keys alone force many rounds of
+    merging. */
+    const int num_cold_keys = 10000;
+    for (int i = 0; i < num_cold_keys; ++i) {
+        sampler.record_write(store_key_t(strprintf("cold%05d", i)));
+        if (i % 10 == 0) {
+            sampler.record_read(store_key_t("hot"));
+        }
+    }
+    std::map<store_key_t, key_load_sampler_t::rates_t> rates =
+        sampler.get_rates(key_range_t::universe());
+    EXPECT_LE(rates.size(), 2 * KEY_LOAD_MAX_BUCKETS);
+    ASSERT_EQ(1u, rates.count(store_key_t("hot")));
+    EXPECT_EQ(0, rates[store_key_t("hot")].writes_per_sec);
+    EXPECT_GT(rates[store_key_t("hot")].reads_per_sec, 0);
+
+    /* With no further operations, the counts halve with every half-life. The rates
+    drop by more than that, because they're spread over a longer window. */
+    const microtime_t half_life = KEY_LOAD_HALF_LIFE_SECS * 1000 * 1000;
+    double previous = rates[store_key_t("hot")].reads_per_sec;
+    for (int i = 1; i <= 3; ++i) {
+        rates = sampler.get_rates(key_range_t::universe(), start + i * half_life);
+        ASSERT_EQ(1u, rates.count(store_key_t("hot")));
+        EXPECT_LT(rates[store_key_t("hot")].reads_per_sec, previous / 2);
+        previous = rates[store_key_t("hot")].reads_per_sec;
+    }
+
+    /* Eventually the counts decay so far that the buckets are dropped. */
+    rates = sampler.get_rates(key_range_t::universe(), start + 100 * half_life);
+    EXPECT_TRUE(rates.empty());
+}
+
 }  // namespace unittest
@@ -2,6 +2,7 @@
 #include "arch/timing.hpp"
 #include "clustering/administration/metadata.hpp"
 #include "rpc/connectivity/cluster.hpp"
+#include "rpc/directory/delta.hpp"
 #include "rpc/directory/map_read_manager.hpp"
 #include "rpc/directory/map_write_manager.hpp"
 #include "rpc/directory/read_manager.hpp"
@@ -120,6 +121,76 @@ TPTEST(RPCDirectoryTest, MapUpdate) {
         rm2.get_root_view()->get_key(std::make_pair(c1.get_me(), 102)));
 }
 
+/* `MapDeltaUpdate` tests that peers can follow a sequence of small changes to a large
+value, which the writer sends as deltas. */
+TPTEST(RPCDirectoryTest, MapDeltaUpdate) {
+    connectivity_cluster_t c1, c2;
+    directory_map_read_manager_t<int, std::string> rm1(&c1, 'D'), rm2(&c2, 'D');
+    watchable_map_var_t<int, std::string> w1, w2;
+    std::string value(1000, 'a');
+    w1.set_key(101, value);
+    directory_map_write_manager_t<int, std::string>
+        wm1(&c1, 'D', &w1), wm2(&c2, 'D', &w2);
+    test_cluster_run_t cr1(&c1);
+    test_cluster_run_t cr2(&c2);
+    cr2.join(get_cluster_local_address(&c1), 0);
+    let_stuff_happen();
+    ASSERT_TRUE(optional<std::string>(value) ==
+        rm2.get_root_view()->get_key(std::make_pair(c1.get_me(), 101)));
+    /* The peer has the initial value in full. */
+    EXPECT_EQ(0u, wm1.get_num_deltas_sent());
+    for (size_t i = 0; i < 10; ++i) {
+        value[i * 97] = 'b';
+        if (i % 3 == 0) {
+            value += "tail";
+        }
+        w1.set_key(101, value);
+        if (i % 2 == 0) {
+            let_stuff_happen();
+            ASSERT_TRUE(optional<std::string>(value) ==
+                rm2.get_root_view()->get_key(std::make_pair(c1.get_me(), 101)));
+        }
+        if (i == 0) {
+            /* The peer had the previous version, so it got a delta. Later changes
+            come in pairs, so the peer often misses a version and gets the full value
+            instead. */
+            EXPECT_EQ(1u, wm1.get_num_deltas_sent());
+        }
+    }
+    EXPECT_GT(wm1.get_num_deltas_sent(), 0u);
+    let_stuff_happen();
+    ASSERT_TRUE(optional<std::string>(value) ==
+        rm2.get_root_view()->get_key(std::make_pair(c1.get_me(), 101)));
+    w1.delete_key(101);
+    let_stuff_happen();
+    ASSERT_TRUE(optional<std::string>() ==
+        rm2.get_root_view()->get_key(std::make_pair(c1.get_me(), 101)));
+    w1.set_key(101, value);
+    let_stuff_happen();
+    ASSERT_TRUE(optional<std::string>(value) ==
+        rm2.get_root_view()->get_key(std::make_pair(c1.get_me(), 101)));
+}
+
+TEST(RPCDirectoryTest, Delta) {
+    std::vector<std::vector<char> > versions = {
+        {}, {'a'}, {'a', 'b', 'c'}, {'a', 'x', 'c'}, {'a', 'a', 'a', 'c'},
+        {'a', 'a', 'c'}, {'c'}, {}};
+    for (const auto &from : versions) {
+        for (const auto &to : versions) {
+            directory_delta_t delta = compute_directory_delta(from, to);
+            EXPECT_LE(delta.middle.size(), to.size());
+            std::vector<char> result;
+            ASSERT_TRUE(apply_directory_delta(from, delta, &result));
+            EXPECT_EQ(to, result);
+        }
+    }
+    directory_delta_t delta = compute_directory_delta({'a', 'b'}, {'a', 'c', 'b'});
+    EXPECT_EQ(1u, delta.prefix_size);
+    EXPECT_EQ(1u, delta.suffix_size);
+    std::vector<char> result;
+    EXPECT_FALSE(apply_directory_delta({'a'}, delta, &result));
+}
+
 /* `DestructorRace` tests a nasty race condition that we had at some point. */
 TPTEST(RPCDirectoryTest, DestructorRace) {
     connectivity_cluster_t c;
@@ -0,0 +1,123 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string.h>
+
+#include "concurrency/new_mutex.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/log/log_serializer.hpp"
+#include "serializer/shared.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/mock_file.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static void write_block(serializer_t *ser, block_id_t block_id, char fill) {
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser->max_block_size());
+    memset(buf.cache_data(), fill, ser->max_block_size().value());
+
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+    std::vector<counted_t<block_token_t> > tokens = ser->block_writes(
+        { buf_write_info_t(buf.ser_buffer(), buf.block_size(), block_id) },
+        DEFAULT_DISK_ACCOUNT, &cb);
+    cb.wait();
+
+    std::vector<index_write_op_t> write_ops;
+    write_ops.push_back(index_write_op_t(block_id, make_optional(tokens[0]),
+                                         make_optional(repli_timestamp_t::distant_past)));
+    new_mutex_in_line_t dummy_acq;
+    ser->index_write(&dummy_acq, []{ }, write_ops);
+}
+
+static char read_block(serializer_t *ser, block_id_t block_id) {
+    counted_t<block_token_t> token = ser->index_read(block_id);
+    if (!token.has()) {
+        return 0;
+    }
+    buf_ptr_t buf = ser->block_read(token, DEFAULT_DISK_ACCOUNT);
+    return static_cast<const char *>(buf.cache_data())[0];
+}
+
+TPTEST(SharedSerializerTest, NamespacesAndDrop) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    file_opener.move_serializer_file_to_permanent_location();
+
+    const block_id_t far_id = 5 * SHARED_SERIALIZER_CHUNK_SIZE + 3;
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &get_global_perfmon_collection());
+        shared_serializer_t::create(&ser);
+        shared_serializer_t shared(&ser);
+
+        scoped_ptr_t<namespace_serializer_t> a(shared.open_namespace(1));
+        scoped_ptr_t<namespace_serializer_t> b(shared.open_namespace(2));
+
+        // Both namespaces use the same block IDs without seeing each other's blocks.
+        write_block(a.get(), 0, 'a');
+        write_block(b.get(), 0, 'b');
+        write_block(a.get(), far_id, 'x');
+        write_block(b.get(), FIRST_AUX_BLOCK_ID, 'y');
+        EXPECT_EQ('a', read_block(a.get(), 0));
+        EXPECT_EQ('b', read_block(b.get(), 0));
+        EXPECT_EQ('x', read_block(a.get(), far_id));
+        EXPECT_EQ(0, read_block(b.get(), far_id));
+        EXPECT_EQ(far_id + 1, a->end_block_id());
+        EXPECT_EQ(1u, b->end_block_id());
+        EXPECT_EQ(FIRST_AUX_BLOCK_ID + 1, b->end_aux_block_id());
+        EXPECT_TRUE(a->get_delete_bit(1));
+        EXPECT_FALSE(a->get_delete_bit(far_id));
+
+        segmented_vector_t<repli_timestamp_t> recencies = a->get_all_recencies(0, 1);
+        ASSERT_EQ(far_id + 1, recencies.size());
+        EXPECT_EQ(repli_timestamp_t::distant_past, recencies[0]);
+        EXPECT_EQ(repli_timestamp_t::invalid, recencies[1]);
+        EXPECT_EQ(repli_timestamp_t::invalid, recencies[far_id - 1]);
+        EXPECT_EQ(repli_timestamp_t::distant_past, recencies[far_id]);
+        segmented_vector_t<repli_timestamp_t> odd_recencies = a->get_all_recencies(1, 2);
+        ASSERT_EQ((far_id + 1) / 2, odd_recencies.size());
+        EXPECT_EQ(repli_timestamp_t::distant_past, odd_recencies[far_id / 2]);
+    }
+
+    {
+        // The chunk table survives a restart.
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &get_global_perfmon_collection());
+        shared_serializer_t shared(&ser);
+        EXPECT_FALSE(shared.namespace_is_empty(1));
+        EXPECT_FALSE(shared.namespace_is_empty(2));
+        EXPECT_TRUE(shared.namespace_is_empty(3));
+
+        shared.drop_namespace(1);
+        EXPECT_TRUE(shared.namespace_is_empty(1));
+
+        scoped_ptr_t<namespace_serializer_t> a(shared.open_namespace(1));
+        scoped_ptr_t<namespace_serializer_t> b(shared.open_namespace(2));
+        EXPECT_EQ(0, read_block(a.get(), 0));
+        EXPECT_EQ(0u, a->end_block_id());
+        EXPECT_EQ('b', read_block(b.get(), 0));
+        EXPECT_EQ('y', read_block(b.get(), FIRST_AUX_BLOCK_ID));
+
+        // The dropped chunks are reused.
+        write_block(a.get(), 0, 'c');
+        EXPECT_EQ('c', read_block(a.get(), 0));
+        EXPECT_EQ('b', read_block(b.get(), 0));
+    }
+
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &get_global_perfmon_collection());
+        shared_serializer_t shared(&ser);
+        scoped_ptr_t<namespace_serializer_t> a(shared.open_namespace(1));
+        EXPECT_EQ('c', read_block(a.get(), 0));
+        EXPECT_EQ(0, read_block(a.get(), far_id));
+    }
+}
+
+}  // namespace unittest
@@ -0,0 +1,198 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "containers/intrusive_priority_queue.hpp"
+#include "containers/scoped.hpp"
+#include "containers/timer_wheel.hpp"
+#include "random.hpp"
+#include "time.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+struct test_timer_t : public timer_wheel_entry_t {
+    int64_t expiry;
+    size_t id;
+};
+
+TEST(TimerWheelTest, ExpiresInOrder) {
+    timer_wheel_t wheel(0);
+    std::vector<test_timer_t> timers(5);
+    const int64_t expiries[] = { 300, 7, 70000, 7, 256 };
+    for (size_t i = 0; i < timers.size(); ++i) {
+        timers[i].expiry = expiries[i];
+        wheel.insert(&timers[i], expiries[i]);
+    }
+    EXPECT_EQ(5u, wheel.size());
+    EXPECT_EQ(7, wheel.next_event_tick());
+
+    EXPECT_EQ(nullptr, wheel.pop_expired(6));
+    EXPECT_EQ(&timers[1], wheel.pop_expired(10));
+    EXPECT_EQ(&timers[3], wheel.pop_expired(10));
+    EXPECT_EQ(nullptr, wheel.pop_expired(10));
+
+    wheel.remove(&timers[0]);
+    EXPECT_EQ(&timers[4], wheel.pop_expired(1000));
+    EXPECT_EQ(nullptr, wheel.pop_expired(69999));
+    EXPECT_EQ(&timers[2], wheel.pop_expired(70000));
+    EXPECT_TRUE(wheel.empty());
+
+    // Entries that are already due expire right away.
+    wheel.insert(&timers[0], 5);
+    EXPECT_EQ(&timers[0], wheel.pop_expired(70001));
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, Overflow) {
+    timer_wheel_t wheel(100);
+    test_timer_t far, near;
+    const int64_t far_expiry = (static_cast<int64_t>(1) << 40) + 12345;
+    wheel.insert(&far, far_expiry);
+    wheel.insert(&near, 200);
+    EXPECT_EQ(&near, wheel.pop_expired(1000));
+    EXPECT_EQ(nullptr, wheel.pop_expired(far_expiry - 1));
+    EXPECT_EQ(far_expiry, wheel.next_event_tick());
+    EXPECT_EQ(&far, wheel.pop_expired(far_expiry));
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, Random) {
+    const size_t NUM_TIMERS = 5000;
+    std::vector<test_timer_t> timers(NUM_TIMERS);
+    std::vector<size_t> free_timers;
+    for (size_t i = 0; i < NUM_TIMERS; ++i) {
+        timers[i].id = i;
+        free_timers.push_back(i);
+    }
+    // The timers that are in the wheel, by expiry.
+    std::set<std::pair<int64_t, size_t> > active;
+
+    int64_t now = 12345;
+    timer_wheel_t wheel(now);
+    for (int step = 0; step < 100000; ++step) {
+        const int op = randint(10);
+        if (op < 5 && !free_timers.empty()) {
+            size_t id = free_timers.back();
+            free_timers.pop_back();
+            const uint64_t ranges[] =
+                { 10, 1000, 100000, 100000000, static_cast<uint64_t>(1) << 36 };
+            int range = randint(100) == 0 ? 4 : randint(4);
+            timers[id].expiry = now + 1 + randuint64(ranges[range]);
+            wheel.insert(&timers[id], timers[id].expiry);
+            active.insert(std::make_pair(timers[id].expiry, id));
+        } else if (op < 7 && !active.empty()) {
+            auto it = active.begin();
+            std::advance(it, randsize(active.size()));
+            wheel.remove(&timers[it->second]);
+            free_timers.push_back(it->second);
+            active.erase(it);
+        } else {
+            const uint64_t ranges[] = { 3, 300, 300000, 300000000 };
+            now += randuint64(ranges[randint(4)]);
+            int64_t last_expiry = -1;
+            while (timer_wheel_entry_t *entry = wheel.pop_expired(now)) {
+                test_timer_t *timer = static_cast<test_timer_t *>(entry);
+                ASSERT_LE(timer->expiry, now);
+                ASSERT_LE(last_expiry, timer->expiry);
+                last_expiry = timer->expiry;
+                ASSERT_EQ(1u, active.erase(std::make_pair(timer->expiry, timer->id)));
+                free_timers.push_back(timer->id);
+            }
+            ASSERT_TRUE(active.empty() || active.begin()->first > now);
+            if (!active.empty()) {
+                ASSERT_LE(wheel.next_event_tick(), active.begin()->first);
+            }
+        }
+        ASSERT_EQ(active.size(), wheel.size());
+    }
+    for (const auto &pair : active) {
+        wheel.remove(&timers[pair.second]);
+    }
+}
+
+#ifdef NDEBUG
+struct bench_pq_timer_t : public intrusive_priority_queue_node_t<bench_pq_timer_t> {
+    int64_t expiry;
+};
+
+bool left_is_higher_priority(const bench_pq_timer_t *left,
+                             const bench_pq_timer_t *right) {
+    return left->expiry < right->expiry;
+}
+
+/* Compares the timer wheel to the priority queue that `timer_handler_t` used to use,
+with a million outstanding timers of which half get canceled before they expire, as
+is typical for timeouts. */
+TEST(TimerWheelTest, Benchmark) {
+    const size_t NUM_TIMERS = 1000000;
+    const int64_t MAX_DELAY = 60000;
+    std::vector<int64_t> expiries;
+    std::vector<size_t> cancel_order;
+    for (size_t i = 0; i < NUM_TIMERS; ++i) {
+        expiries.push_back(1 + randint(MAX_DELAY));
+        if (i % 2 == 0) {
+            cancel_order.push_back(i);
+        }
+    }
+    std::random_shuffle(cancel_order.begin(), cancel_order.end(),
+                        [](size_t n) { return randsize(n); });
+
+    {
+        scoped_array_t<test_timer_t> timers(NUM_TIMERS);
+        timer_wheel_t wheel(0);
+        ticks_t start_ticks = get_ticks();
+        for (size_t i = 0; i < NUM_TIMERS; ++i) {
+            wheel.insert(&timers[i], expiries[i]);
+        }
+        ticks_t insert_ticks = get_ticks();
+        for (size_t i : cancel_order) {
+            wheel.remove(&timers[i]);
+        }
+        ticks_t cancel_ticks = get_ticks();
+        size_t num_expired = 0;
+        for (int64_t now = 0; now <= MAX_DELAY; ++now) {
+            while (wheel.pop_expired(now) != nullptr) {
+                ++num_expired;
+            }
+        }
+        ticks_t end_ticks = get_ticks();
+        EXPECT_EQ(NUM_TIMERS - cancel_order.size(), num_expired);
+        printf("Timer wheel: insert %f/s, cancel %f/s, expire %f/s\n",
+               NUM_TIMERS / ticks_to_secs(insert_ticks - start_ticks),
+               cancel_order.size() / ticks_to_secs(cancel_ticks - insert_ticks),
+               num_expired / ticks_to_secs(end_ticks - cancel_ticks));
+    }
+    {
+        scoped_array_t<bench_pq_timer_t> timers(NUM_TIMERS);
+        intrusive_priority_queue_t<bench_pq_timer_t> queue;
+        ticks_t start_ticks = get_ticks();
+        for (size_t i = 0; i < NUM_TIMERS; ++i) {
+            timers[i].expiry = expiries[i];
+            queue.push(&timers[i]);
+        }
+        ticks_t insert_ticks = get_ticks();
+        for (size_t i : cancel_order) {
+            queue.remove(&timers[i]);
+        }
+        ticks_t cancel_ticks = get_ticks();
+        size_t num_expired = 0;
+        for (int64_t now = 0; now <= MAX_DELAY; ++now) {
+            while (!queue.empty() && queue.peek()->expiry <= now) {
+                queue.pop();
+                ++num_expired;
+            }
+        }
+        ticks_t end_ticks = get_ticks();
+        EXPECT_EQ(NUM_TIMERS - cancel_order.size(), num_expired);
+        printf("Priority queue: insert %f/s, cancel %f/s, expire %f/s\n",
+               NUM_TIMERS / ticks_to_secs(insert_ticks - start_ticks),
+               cancel_order.size() / ticks_to_secs(cancel_ticks - insert_ticks),
+               num_expired / ticks_to_secs(end_ticks - cancel_ticks));
+    }
+}
+#endif  // NDEBUG
+
+}  // namespace unittest